@@ -1,5 +1,7 @@
 import 'dart:convert';
+import 'dart:io';
 import 'package:dio/dio.dart';
+import '../platform/platform_channel_service.dart';
 import '../utils/logger.dart';
 import '../utils/dev_mode.dart';
 import '../config/build_config.dart';
@@ -299,6 +301,21 @@ URL: $testUrl
       return null;
     }
 
+    // Windows: race all endpoints natively instead of waiting out a full
+    // timeout on each dead one in turn
+    if (Platform.isWindows && _endpoints.length > 1) {
+      final race = await PlatformChannelService.instance.raceEndpoints(
+        _endpoints.map((e) => e.url).toList(),
+        probePath: guestConfigEndpoint,
+        requiredKeys: BuildConfig.instance.isV2board
+            ? const ['data']
+            : const ['is_email_verify', 'app_description'],
+        userAgent: BuildConfig.instance.effectiveUserAgent,
+        timeout: AppConstants.pingTimeout,
+      );
+      if (race != null) return _applyRaceResult(race);
+    }
+
     for (var i = 0; i < _endpoints.length; i++) {
       final endpoint = _endpoints[i];
       DevMode.instance.log(
@@ -328,6 +345,44 @@ URL: $testUrl
     return null;
   }
 
+  /// Apply a native endpoint race result to the endpoint list
+  ApiEndpoint? _applyRaceResult(Map<String, dynamic> race) {
+    DevMode.instance.log(
+      'ApiManager',
+      '端点竞速完成',
+      detail: '胜出: ${race['url']} 耗时: ${race['total']}ms',
+    );
+
+    final attempts = (race['attempts'] as List?) ?? const [];
+    final now = DateTime.now();
+    for (final attempt in attempts.whereType<Map>()) {
+      final index = _endpoints.indexWhere((e) => e.url == attempt['url']);
+      if (index == -1 || attempt['started'] != true) continue;
+      if (attempt['cancelled'] == true) continue;
+
+      final valid = attempt['valid'] == true;
+      _endpoints[index] = _endpoints[index].copyWith(
+        lastChecked: now,
+        isActive: valid,
+        failCount: valid ? 0 : _endpoints[index].failCount + 1,
+      );
+    }
+
+    final winner = race['url'] as String? ?? '';
+    final index = _endpoints.indexWhere((e) => e.url == winner);
+    if (index == -1) {
+      VortexLogger.w('No active endpoints found');
+      DevMode.instance.log('ApiManager', '未找到可用端点', isError: true);
+      return null;
+    }
+
+    _activeEndpoint = _endpoints[index];
+    VortexLogger.i(
+      'Found active endpoint via race: $winner (${race['latency']}ms)',
+    );
+    return _activeEndpoint;
+  }
+
   /// Get the first active endpoint URL or poll if none active
   Future<String?> getActiveEndpointUrl() async {
     if (_activeEndpoint != null) {
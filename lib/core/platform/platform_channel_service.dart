@@ -1,9 +1,13 @@
 import 'dart:async';
+import 'dart:convert';
 import 'dart:io';
+import 'dart:typed_data';
 
+import 'package:flutter/painting.dart';
 import 'package:flutter/services.dart';
 import 'package:path_provider/path_provider.dart';
 import '../utils/logger.dart';
+import '../utils/tracing.dart';
 
 /// VPN 连接状态
 enum VpnState { disconnected, connecting, connected, disconnecting, error }
@@ -46,6 +50,716 @@ class TrafficStats {
   String get formattedDownloadSpeed => '${formatBytes(downloadSpeed)}/s';
 }
 
+/// 原生控制器流 (WebSocket) 推送的一批消息
+class ControllerStreamBatch {
+  final String name;
+  final List<String> messages;
+
+  /// Latest 模式下自上一批以来被覆盖的消息数
+  final int dropped;
+
+  ControllerStreamBatch({
+    required this.name,
+    required this.messages,
+    this.dropped = 0,
+  });
+
+  factory ControllerStreamBatch.fromMap(Map<String, dynamic> map) {
+    return ControllerStreamBatch(
+      name: map['name'] as String? ?? '',
+      messages: (map['messages'] as List?)?.cast<String>() ?? const [],
+      dropped: map['dropped'] as int? ?? 0,
+    );
+  }
+}
+
+/// 切换节点后的链路预热结果
+class PathWarmupResult {
+  final int id;
+
+  /// switch 或 connect
+  final String trigger;
+  final String node;
+
+  /// warming、ready 或 failed
+  final String state;
+  final int attempted;
+  final int succeeded;
+
+  /// 冷链路首字节耗时
+  final int coldMs;
+
+  /// 预热后同一目标的首字节耗时
+  final int warmMs;
+
+  /// 握手耗时估计 (coldMs - warmMs)，未知时为 -1
+  final int handshakeMs;
+  final int totalMs;
+  final String error;
+
+  PathWarmupResult({
+    this.id = 0,
+    this.trigger = '',
+    this.node = '',
+    this.state = '',
+    this.attempted = 0,
+    this.succeeded = 0,
+    this.coldMs = -1,
+    this.warmMs = -1,
+    this.handshakeMs = -1,
+    this.totalMs = 0,
+    this.error = '',
+  });
+
+  bool get isReady => state == 'ready';
+
+  factory PathWarmupResult.fromMap(Map<String, dynamic> map) {
+    return PathWarmupResult(
+      id: map['id'] as int? ?? 0,
+      trigger: map['trigger'] as String? ?? '',
+      node: map['node'] as String? ?? '',
+      state: map['state'] as String? ?? '',
+      attempted: map['attempted'] as int? ?? 0,
+      succeeded: map['succeeded'] as int? ?? 0,
+      coldMs: map['coldMs'] as int? ?? -1,
+      warmMs: map['warmMs'] as int? ?? -1,
+      handshakeMs: map['handshakeMs'] as int? ?? -1,
+      totalMs: map['totalMs'] as int? ?? 0,
+      error: map['error'] as String? ?? '',
+    );
+  }
+}
+
+/// 原生评分引擎中的节点排名
+class NodeScore {
+  final String id;
+  final String name;
+  final int rank;
+
+  /// 综合得分，越低越好
+  final double score;
+  final int p50;
+  final int p90;
+
+  /// 最近测试的失败比例 (0-1)
+  final double loss;
+
+  /// 无吞吐样本时为 -1
+  final double throughputMbps;
+  final double multiplier;
+  final int samples;
+
+  NodeScore({
+    required this.id,
+    required this.name,
+    required this.rank,
+    required this.score,
+    this.p50 = -1,
+    this.p90 = -1,
+    this.loss = 0,
+    this.throughputMbps = -1,
+    this.multiplier = 1.0,
+    this.samples = 0,
+  });
+
+  factory NodeScore.fromMap(Map<String, dynamic> map) {
+    return NodeScore(
+      id: map['id'] as String? ?? '',
+      name: map['name'] as String? ?? '',
+      rank: map['rank'] as int? ?? 0,
+      score: (map['score'] as num?)?.toDouble() ?? 0,
+      p50: map['p50'] as int? ?? -1,
+      p90: map['p90'] as int? ?? -1,
+      loss: (map['loss'] as num?)?.toDouble() ?? 0,
+      throughputMbps: (map['throughputMbps'] as num?)?.toDouble() ?? -1,
+      multiplier: (map['multiplier'] as num?)?.toDouble() ?? 1.0,
+      samples: map['samples'] as int? ?? 0,
+    );
+  }
+}
+
+/// 代理链中的一跳
+class ChainHop {
+  final String name;
+  final String type;
+
+  /// 该跳的 dialer-proxy，没有时为空
+  final String dialer;
+
+  /// 单独测试该跳的延迟，失败为 -1；覆盖从 [standaloneStart] 到该跳，
+  /// 即该跳自身的 dialer-proxy 链，不含 relay 中排在它前面的成员
+  final int standaloneMs;
+  final int standaloneStart;
+
+  /// 从第一跳到该跳为止的累计延迟，无法单独测试该前缀时为 -1
+  final int cumulativeMs;
+
+  /// 从 [legStart] 到该跳这一段的延迟
+  final int legMs;
+  final int legStart;
+
+  ChainHop({
+    required this.name,
+    this.type = '',
+    this.dialer = '',
+    this.standaloneMs = -1,
+    this.standaloneStart = -1,
+    this.cumulativeMs = -1,
+    this.legMs = -1,
+    this.legStart = -1,
+  });
+
+  factory ChainHop.fromMap(Map<String, dynamic> map) {
+    return ChainHop(
+      name: map['name'] as String? ?? '',
+      type: map['type'] as String? ?? '',
+      dialer: map['dialer'] as String? ?? '',
+      standaloneMs: map['standalone'] as int? ?? -1,
+      standaloneStart: map['standaloneStart'] as int? ?? -1,
+      cumulativeMs: map['cumulative'] as int? ?? -1,
+      legMs: map['leg'] as int? ?? -1,
+      legStart: map['legStart'] as int? ?? -1,
+    );
+  }
+}
+
+/// 代理链逐跳延迟分解结果
+class ChainProbeResult {
+  final String target;
+
+  /// 按拨号顺序，离本机最近的在前
+  final List<ChainHop> hops;
+
+  /// 整条链的延迟，失败为 -1
+  final int totalMs;
+  final int elapsedMs;
+  final String error;
+
+  ChainProbeResult({
+    required this.target,
+    this.hops = const [],
+    this.totalMs = -1,
+    this.elapsedMs = 0,
+    this.error = '',
+  });
+
+  factory ChainProbeResult.fromMap(Map<String, dynamic> map) {
+    return ChainProbeResult(
+      target: map['target'] as String? ?? '',
+      hops:
+          (map['hops'] as List?)
+              ?.whereType<Map>()
+              .map((e) => ChainHop.fromMap(Map<String, dynamic>.from(e)))
+              .toList() ??
+          const [],
+      totalMs: map['total'] as int? ?? -1,
+      elapsedMs: map['elapsed'] as int? ?? 0,
+      error: map['error'] as String? ?? '',
+    );
+  }
+}
+
+/// 单次 DNS 测试 (冷或热) 的延迟统计
+class DnsLatencyStats {
+  final int queries;
+  final int failures;
+  final double failureRate;
+
+  /// 延迟分位数 (ms)，全部失败时为 -1
+  final int p50Ms;
+  final int p90Ms;
+  final int p99Ms;
+  final double meanMs;
+
+  /// 各桶计数，桶上界见 [DnsBenchmarkResult.histogramBounds]，最后一桶为溢出
+  final List<int> histogram;
+
+  DnsLatencyStats({
+    this.queries = 0,
+    this.failures = 0,
+    this.failureRate = 0,
+    this.p50Ms = -1,
+    this.p90Ms = -1,
+    this.p99Ms = -1,
+    this.meanMs = -1,
+    this.histogram = const [],
+  });
+
+  factory DnsLatencyStats.fromMap(Map<String, dynamic> map) {
+    return DnsLatencyStats(
+      queries: map['queries'] as int? ?? 0,
+      failures: map['failures'] as int? ?? 0,
+      failureRate: (map['failureRate'] as num?)?.toDouble() ?? 0,
+      p50Ms: map['p50'] as int? ?? -1,
+      p90Ms: map['p90'] as int? ?? -1,
+      p99Ms: map['p99'] as int? ?? -1,
+      meanMs: (map['mean'] as num?)?.toDouble() ?? -1,
+      histogram: (map['histogram'] as List?)?.whereType<int>().toList() ?? const [],
+    );
+  }
+}
+
+/// 单个解析器 (内核或配置中的某个 nameserver) 的测试结果
+class DnsResolverResult {
+  final String name;
+
+  /// nameserver、fallback 或 default-nameserver
+  final String section;
+
+  /// core、udp、https，或不支持直接测试的协议
+  final String protocol;
+  final bool supported;
+  final DnsLatencyStats cold;
+  final DnsLatencyStats warm;
+
+  /// 热查询耗时不超过冷查询四分之一的域名占比
+  final double cacheHitRate;
+
+  /// 越低越好
+  final double score;
+
+  /// 在 nameserver 中的排名，从 1 开始，不支持时为 0
+  final int rank;
+  final String error;
+
+  DnsResolverResult({
+    required this.name,
+    this.section = '',
+    this.protocol = '',
+    this.supported = true,
+    required this.cold,
+    required this.warm,
+    this.cacheHitRate = 0,
+    this.score = 0,
+    this.rank = 0,
+    this.error = '',
+  });
+
+  factory DnsResolverResult.fromMap(Map<String, dynamic> map) {
+    DnsLatencyStats stats(Object? value) => value is Map
+        ? DnsLatencyStats.fromMap(Map<String, dynamic>.from(value))
+        : DnsLatencyStats();
+
+    return DnsResolverResult(
+      name: map['name'] as String? ?? '',
+      section: map['section'] as String? ?? '',
+      protocol: map['protocol'] as String? ?? '',
+      supported: map['supported'] as bool? ?? false,
+      cold: stats(map['cold']),
+      warm: stats(map['warm']),
+      cacheHitRate: (map['cacheHitRate'] as num?)?.toDouble() ?? 0,
+      score: (map['score'] as num?)?.toDouble() ?? 0,
+      rank: map['rank'] as int? ?? 0,
+      error: map['error'] as String? ?? '',
+    );
+  }
+}
+
+/// DNS 基准测试报告
+class DnsBenchmarkResult {
+  final DnsResolverResult core;
+
+  /// 已按得分排序，不支持的排在最后
+  final List<DnsResolverResult> nameservers;
+  final List<int> histogramBounds;
+  final int domains;
+  final int elapsedMs;
+  final String error;
+
+  DnsBenchmarkResult({
+    required this.core,
+    this.nameservers = const [],
+    this.histogramBounds = const [],
+    this.domains = 0,
+    this.elapsedMs = 0,
+    this.error = '',
+  });
+
+  factory DnsBenchmarkResult.fromMap(Map<String, dynamic> map) {
+    final core = map['core'];
+    return DnsBenchmarkResult(
+      core: core is Map
+          ? DnsResolverResult.fromMap(Map<String, dynamic>.from(core))
+          : DnsResolverResult(
+              name: 'core',
+              cold: DnsLatencyStats(),
+              warm: DnsLatencyStats(),
+            ),
+      nameservers:
+          (map['nameservers'] as List?)
+              ?.whereType<Map>()
+              .map((e) => DnsResolverResult.fromMap(Map<String, dynamic>.from(e)))
+              .toList() ??
+          const [],
+      histogramBounds:
+          (map['histogramBounds'] as List?)?.whereType<int>().toList() ?? const [],
+      domains: map['domains'] as int? ?? 0,
+      elapsedMs: map['elapsed'] as int? ?? 0,
+      error: map['error'] as String? ?? '',
+    );
+  }
+}
+
+/// 一轮 TCP 连接测速 (原生完成端口批量探测) 的结果
+class TcpPingResult {
+  /// 与目标一一对应，毫秒；失败或超时为 null
+  final List<int?> latencies;
+
+  /// completion (完成端口) 或 readiness (WSAPoll 回退)
+  final String backend;
+  final int probes;
+  final int succeeded;
+  final int timedOut;
+  final int resolveMs;
+  final int elapsedMs;
+
+  /// 探测线程在连接阶段占用的 CPU 时间
+  final int cpuMs;
+
+  /// 等待调用次数，每次等待取回一批完成的连接
+  final int waits;
+  final String error;
+
+  TcpPingResult({
+    this.latencies = const [],
+    this.backend = '',
+    this.probes = 0,
+    this.succeeded = 0,
+    this.timedOut = 0,
+    this.resolveMs = 0,
+    this.elapsedMs = 0,
+    this.cpuMs = 0,
+    this.waits = 0,
+    this.error = '',
+  });
+
+  factory TcpPingResult.fromMap(Map<String, dynamic> map) {
+    return TcpPingResult(
+      latencies:
+          (map['latencies'] as List?)
+              ?.map((e) => e is int && e >= 0 ? e : null)
+              .toList() ??
+          const [],
+      backend: map['backend'] as String? ?? '',
+      probes: map['probes'] as int? ?? 0,
+      succeeded: map['succeeded'] as int? ?? 0,
+      timedOut: map['timedOut'] as int? ?? 0,
+      resolveMs: map['resolveMs'] as int? ?? 0,
+      elapsedMs: map['elapsed'] as int? ?? 0,
+      cpuMs: map['cpuMs'] as int? ?? 0,
+      waits: map['waits'] as int? ?? 0,
+      error: map['error'] as String? ?? '',
+    );
+  }
+}
+
+/// 拓扑中的一个代理 (代理组本身也在其中)
+class TopologyProxy {
+  final String name;
+  final String type;
+
+  /// 最近一次测试的延迟，毫秒；0 为失败，-1 为未测试
+  int delay;
+
+  TopologyProxy(this.name, this.type, this.delay);
+}
+
+/// 拓扑中的一个代理组
+class TopologyGroup {
+  final String name;
+  final String type;
+
+  /// 当前选中的成员，没有选择的组为空
+  String now;
+  final List<String> members;
+
+  TopologyGroup(this.name, this.type, this.now, this.members);
+}
+
+/// 核心代理组拓扑的本地副本
+///
+/// 先用 [PlatformChannelService.getProxyTopology] 取得二进制快照，之后把
+/// [PlatformChannelService.proxyTopologyStream] 中的变更交给 [apply]；
+/// [apply] 返回 false 说明漏掉了变更，需要重新取快照。
+class ProxyTopology {
+  int version;
+  final Map<String, TopologyProxy> proxies;
+  final Map<String, TopologyGroup> groups;
+
+  ProxyTopology({
+    this.version = 0,
+    Map<String, TopologyProxy>? proxies,
+    Map<String, TopologyGroup>? groups,
+  }) : proxies = proxies ?? {},
+       groups = groups ?? {};
+
+  /// 解析原生端的快照 (VPT1：小端 LEB128 整数，字符串为长度加 UTF-8)
+  factory ProxyTopology.decode(Uint8List bytes) {
+    var offset = 0;
+    int varint() {
+      var value = 0;
+      var shift = 0;
+      while (true) {
+        final byte = bytes[offset++];
+        value |= (byte & 0x7f) << shift;
+        if (byte < 0x80) return value;
+        shift += 7;
+      }
+    }
+
+    String string() {
+      final length = varint();
+      final text = utf8.decode(
+        bytes.sublist(offset, offset + length),
+        allowMalformed: true,
+      );
+      offset += length;
+      return text;
+    }
+
+    if (bytes.length < 4 || utf8.decode(bytes.sublist(0, 4)) != 'VPT1') {
+      throw const FormatException('Not a proxy topology snapshot');
+    }
+    offset = 4;
+    final version = varint();
+    final table = List.generate(varint(), (_) {
+      final name = string();
+      final type = string();
+      return TopologyProxy(name, type, varint() - 1);
+    });
+    final groups = <String, TopologyGroup>{};
+    for (var count = varint(); count > 0; count--) {
+      final self = table[varint()];
+      final now = varint();
+      final members = List.generate(varint(), (_) => table[varint()].name);
+      groups[self.name] = TopologyGroup(
+        self.name,
+        self.type,
+        now == 0 ? '' : table[now - 1].name,
+        members,
+      );
+    }
+    return ProxyTopology(
+      version: version,
+      proxies: {for (final proxy in table) proxy.name: proxy},
+      groups: groups,
+    );
+  }
+
+  /// 应用一次 proxy_topology 事件；快照已包含的事件直接忽略，
+  /// base 与当前版本不符时不做修改并返回 false
+  bool apply(Map<String, dynamic> changes) {
+    final next = changes['version'];
+    if (next is int && next <= version) return true;
+    if (changes['base'] != version) return false;
+
+    for (final name in (changes['removedProxies'] as List? ?? const [])) {
+      proxies.remove(name);
+    }
+    for (final item in (changes['proxies'] as List? ?? const [])) {
+      final map = Map<String, dynamic>.from(item as Map);
+      final name = map['name'] as String;
+      proxies[name] = TopologyProxy(
+        name,
+        map['type'] as String? ?? '',
+        map['delay'] as int? ?? -1,
+      );
+    }
+    (changes['delays'] as Map?)?.forEach((name, delay) {
+      proxies[name]?.delay = delay as int;
+    });
+
+    for (final name in (changes['removedGroups'] as List? ?? const [])) {
+      groups.remove(name);
+    }
+    for (final item in (changes['groups'] as List? ?? const [])) {
+      final map = Map<String, dynamic>.from(item as Map);
+      final name = map['name'] as String;
+      groups[name] = TopologyGroup(
+        name,
+        map['type'] as String? ?? '',
+        map['now'] as String? ?? '',
+        (map['members'] as List?)?.whereType<String>().toList() ?? [],
+      );
+    }
+    (changes['selections'] as Map?)?.forEach((name, now) {
+      groups[name]?.now = now as String;
+    });
+
+    version = changes['version'] as int? ?? version;
+    return true;
+  }
+}
+
+/// 按主机或进程汇总的连接生命周期统计
+class ConnectionSummary {
+  /// 主机或进程名，总计为 *
+  final String key;
+
+  /// host 或 process，仅 churn 事件中有值
+  final String group;
+
+  /// 仅主机：打开该主机连接最多的进程
+  final String topProcess;
+  final int opened;
+  final int closed;
+  final int active;
+
+  /// 最近一分钟内每分钟新建连接数
+  final double openRate;
+
+  /// 最近一分钟内关闭的连接中短连接的占比
+  final double shortLived;
+  final double meanDurationMs;
+  final double meanBytes;
+
+  /// 时长与字节数直方图，桶上界见 [ConnectionStatsReport]，最后一桶为溢出
+  final List<int> durations;
+  final List<int> bytes;
+
+  /// 是否被判定为连接频繁创建销毁
+  final bool churning;
+
+  /// Unix 秒
+  final int lastSeen;
+
+  ConnectionSummary({
+    required this.key,
+    this.group = '',
+    this.topProcess = '',
+    this.opened = 0,
+    this.closed = 0,
+    this.active = 0,
+    this.openRate = 0,
+    this.shortLived = 0,
+    this.meanDurationMs = 0,
+    this.meanBytes = 0,
+    this.durations = const [],
+    this.bytes = const [],
+    this.churning = false,
+    this.lastSeen = 0,
+  });
+
+  factory ConnectionSummary.fromMap(Map<String, dynamic> map) {
+    return ConnectionSummary(
+      key: map['key'] as String? ?? '',
+      group: map['group'] as String? ?? '',
+      topProcess: map['topProcess'] as String? ?? '',
+      opened: map['opened'] as int? ?? 0,
+      closed: map['closed'] as int? ?? 0,
+      active: map['active'] as int? ?? 0,
+      openRate: (map['openRate'] as num?)?.toDouble() ?? 0,
+      shortLived: (map['shortLived'] as num?)?.toDouble() ?? 0,
+      meanDurationMs: (map['meanDurationMs'] as num?)?.toDouble() ?? 0,
+      meanBytes: (map['meanBytes'] as num?)?.toDouble() ?? 0,
+      durations: (map['durations'] as List?)?.whereType<int>().toList() ?? const [],
+      bytes: (map['bytes'] as List?)?.whereType<int>().toList() ?? const [],
+      churning: map['churning'] as bool? ?? false,
+      lastSeen: map['lastSeen'] as int? ?? 0,
+    );
+  }
+}
+
+/// 连接生命周期统计报告
+class ConnectionStatsReport {
+  final ConnectionSummary totals;
+
+  /// 按当前新建速率排序
+  final List<ConnectionSummary> hosts;
+  final List<ConnectionSummary> processes;
+  final List<ConnectionSummary> churningHosts;
+  final List<ConnectionSummary> churningProcesses;
+
+  /// 时长桶上界 (ms) 与字节数桶上界
+  final List<int> durationBounds;
+  final List<int> bytesBounds;
+
+  ConnectionStatsReport({
+    required this.totals,
+    this.hosts = const [],
+    this.processes = const [],
+    this.churningHosts = const [],
+    this.churningProcesses = const [],
+    this.durationBounds = const [],
+    this.bytesBounds = const [],
+  });
+
+  factory ConnectionStatsReport.fromMap(Map<String, dynamic> map) {
+    List<ConnectionSummary> list(Object? value) =>
+        (value as List?)
+            ?.whereType<Map>()
+            .map((e) => ConnectionSummary.fromMap(Map<String, dynamic>.from(e)))
+            .toList() ??
+        const [];
+    final totals = map['totals'];
+
+    return ConnectionStatsReport(
+      totals: totals is Map
+          ? ConnectionSummary.fromMap(Map<String, dynamic>.from(totals))
+          : ConnectionSummary(key: '*'),
+      hosts: list(map['hosts']),
+      processes: list(map['processes']),
+      churningHosts: list(map['churningHosts']),
+      churningProcesses: list(map['churningProcesses']),
+      durationBounds:
+          (map['durationBounds'] as List?)?.whereType<int>().toList() ?? const [],
+      bytesBounds:
+          (map['bytesBounds'] as List?)?.whereType<int>().toList() ?? const [],
+    );
+  }
+}
+
+/// invokeBatch 中单个调用的结果
+class BatchCallResult {
+  final bool ok;
+  final dynamic value;
+  final String? code;
+  final String? message;
+
+  BatchCallResult({required this.ok, this.value, this.code, this.message});
+
+  factory BatchCallResult.fromMap(Map<String, dynamic> map) {
+    return BatchCallResult(
+      ok: map['ok'] == true,
+      value: map['value'],
+      code: map['code'] as String?,
+      message: map['message'] as String?,
+    );
+  }
+}
+
+/// 原生协议描述表生成的 proxies 配置
+class ProxySerialization {
+  /// `proxies:` 下的条目，已按顶层缩进
+  final String yaml;
+
+  /// 写入的节点名，顺序与输入一致
+  final List<String> names;
+
+  /// 未通过校验而跳过的节点：name / type / error；
+  /// warning 为 true 的条目节点已写入，只是丢弃了无法传给原生的嵌套映射设置
+  final List<Map<String, dynamic>> errors;
+
+  ProxySerialization({
+    this.yaml = '',
+    this.names = const [],
+    this.errors = const [],
+  });
+
+  factory ProxySerialization.fromMap(Map<String, dynamic> map) {
+    return ProxySerialization(
+      yaml: map['yaml'] as String? ?? '',
+      names: (map['names'] as List?)?.whereType<String>().toList() ?? const [],
+      errors:
+          (map['errors'] as List?)
+              ?.whereType<Map>()
+              .map((e) => Map<String, dynamic>.from(e))
+              .toList() ??
+          const [],
+    );
+  }
+}
+
 /// 平台通道服务 - 用于与原生代码通信
 class PlatformChannelService {
   static const MethodChannel _channel = MethodChannel('com.vortex.app/core');
@@ -61,6 +775,9 @@ class PlatformChannelService {
 
   StreamSubscription? _eventSubscription;
   bool _isInitialized = false;
+
+  /// 上一个原生事件的序号，用于发现漏掉的事件
+  int? _lastEventSeq;
   VpnState _currentState = VpnState.disconnected;
   TrafficStats _trafficStats = TrafficStats();
 
@@ -71,6 +788,15 @@ class PlatformChannelService {
   final _stateController = StreamController<VpnState>.broadcast();
   final _trafficController = StreamController<TrafficStats>.broadcast();
   final _logController = StreamController<String>.broadcast();
+  final _controllerStreamController =
+      StreamController<ControllerStreamBatch>.broadcast();
+  final _pathWarmupController = StreamController<PathWarmupResult>.broadcast();
+  final _connectionChurnController =
+      StreamController<ConnectionSummary>.broadcast();
+  final _soakProgressController =
+      StreamController<Map<String, dynamic>>.broadcast();
+  final _proxyTopologyController =
+      StreamController<Map<String, dynamic>>.broadcast();
 
   /// 状态变化流
   Stream<VpnState> get stateStream => _stateController.stream;
@@ -81,6 +807,26 @@ class PlatformChannelService {
   /// 日志流
   Stream<String> get logStream => _logController.stream;
 
+  /// 原生控制器流消息，按 [ControllerStreamBatch.name] 区分订阅
+  Stream<ControllerStreamBatch> get controllerStream =>
+      _controllerStreamController.stream;
+
+  /// 链路预热进度，state 为 ready 时新节点链路已就绪
+  Stream<PathWarmupResult> get pathWarmupStream =>
+      _pathWarmupController.stream;
+
+  /// 主机或进程开始或停止频繁创建短连接时触发
+  Stream<ConnectionSummary> get connectionChurnStream =>
+      _connectionChurnController.stream;
+
+  /// 耐久测试每轮结束后的资源采样 (cycle、workingSet、handles、threads 等)
+  Stream<Map<String, dynamic>> get soakProgressStream =>
+      _soakProgressController.stream;
+
+  /// 代理组拓扑的增量变更，交给 [ProxyTopology.apply]
+  Stream<Map<String, dynamic>> get proxyTopologyStream =>
+      _proxyTopologyController.stream;
+
   /// 当前状态
   VpnState get currentState => _currentState;
 
@@ -112,8 +858,10 @@ class PlatformChannelService {
         },
       );
 
-      // 获取初始状态
-      await _syncState();
+      // 获取初始状态；Windows 在订阅时会收到 replay 事件，无需再查询
+      if (!Platform.isWindows) {
+        await _syncState();
+      }
 
       _isInitialized = true;
       VortexLogger.i('Platform channel initialized');
@@ -148,8 +896,14 @@ class PlatformChannelService {
     if (event is Map) {
       final type = event['type'] as String?;
       final data = event['data'];
+      _checkEventSeq(type, event['seq'] as int?);
 
       switch (type) {
+        case 'replay':
+          if (data is Map) {
+            _applyReplay(Map<String, dynamic>.from(data));
+          }
+          break;
         case 'vpn_state_changed':
           final newState = _parseVpnState(data.toString());
           _currentState = newState;
@@ -176,12 +930,141 @@ class PlatformChannelService {
           _currentState = VpnState.error;
           _stateController.add(_currentState);
           break;
+        case 'core_supervisor':
+          if (data is Map) {
+            final peakMb = ((data['peakBytes'] as int? ?? 0) / 1048576).round();
+            switch (data['type']) {
+              case 'memory_limit':
+                VortexLogger.w('Core reached its memory limit (peak ${peakMb}MB)');
+                break;
+              case 'exited':
+                VortexLogger.w('Core exited unexpectedly, code ${data['exitCode']}');
+                break;
+              case 'restarting':
+                VortexLogger.i(
+                  'Restarting core in ${data['delay']}ms (attempt ${data['attempt']})',
+                );
+                break;
+              case 'gave_up':
+                VortexLogger.e('Core keeps exiting, automatic restart stopped');
+                break;
+            }
+          }
+          break;
+        case 'memory_pressure':
+          if (data is Map) {
+            VortexLogger.w(
+              'Memory pressure (${data['level']}): load ${data['memoryLoad']}%, '
+              'available ${data['availableMb']}MB, core GC ${data['coreGc']}'
+              '${(data['coreGcError'] as String?)?.isNotEmpty == true ? ' (${data['coreGcError']})' : ''}',
+            );
+            // 同步释放 Dart 侧可重建的缓存
+            if (data['level'] == 'low') {
+              PaintingBinding.instance.imageCache.clear();
+            }
+          }
+          break;
+        case 'subscriptions_merged':
+          if (data is Map) {
+            VortexLogger.i(
+              'Subscriptions merged: ${data['total']} nodes, '
+              '+${(data['added'] as List?)?.length ?? 0} '
+              '-${(data['removed'] as List?)?.length ?? 0} '
+              '~${(data['changed'] as List?)?.length ?? 0}',
+            );
+          }
+          break;
+        case 'controller_stream':
+          if (data is Map) {
+            _controllerStreamController.add(
+              ControllerStreamBatch.fromMap(Map<String, dynamic>.from(data)),
+            );
+          }
+          break;
+        case 'path_warmup':
+          if (data is Map) {
+            final warmup = PathWarmupResult.fromMap(
+              Map<String, dynamic>.from(data),
+            );
+            if (warmup.state != 'warming') {
+              VortexLogger.i(
+                'Path warmup ${warmup.state} for ${warmup.node}: '
+                'handshake ${warmup.handshakeMs}ms, '
+                '${warmup.succeeded}/${warmup.attempted} targets',
+              );
+            }
+            _pathWarmupController.add(warmup);
+          }
+          break;
+        case 'connection_churn':
+          if (data is Map) {
+            final churn = ConnectionSummary.fromMap(
+              Map<String, dynamic>.from(data),
+            );
+            if (churn.churning) {
+              VortexLogger.w(
+                'Connection churn from ${churn.group} ${churn.key}: '
+                '${churn.openRate.toStringAsFixed(0)}/min, '
+                '${(churn.shortLived * 100).toStringAsFixed(0)}% short-lived'
+                '${churn.topProcess.isNotEmpty ? ' (${churn.topProcess})' : ''}',
+              );
+            }
+            _connectionChurnController.add(churn);
+          }
+          break;
+        case 'soak_progress':
+          if (data is Map) {
+            _soakProgressController.add(Map<String, dynamic>.from(data));
+          }
+          break;
+        case 'proxy_topology':
+          if (data is Map) {
+            _proxyTopologyController.add(Map<String, dynamic>.from(data));
+          }
+          break;
         default:
           VortexLogger.w('Unknown platform event: $type');
       }
     }
   }
 
+  /// 序号不连续说明有事件丢失，此时主动同步一次状态
+  void _checkEventSeq(String? type, int? seq) {
+    if (seq == null) return;
+    final last = _lastEventSeq;
+    _lastEventSeq = seq;
+    if (type == 'replay' || last == null) return;
+    if (seq != last + 1) {
+      VortexLogger.w('Missed ${seq - last - 1} platform events, resyncing');
+      _syncState();
+    }
+  }
+
+  /// 应用订阅时原生端回放的最新状态、流量和日志
+  void _applyReplay(Map<String, dynamic> data) {
+    _currentState = _parseVpnState(data['state']?.toString() ?? '');
+    _stateController.add(_currentState);
+
+    final traffic = data['traffic'];
+    if (traffic is Map) {
+      _trafficStats = TrafficStats.fromMap(Map<String, dynamic>.from(traffic));
+      _trafficController.add(_trafficStats);
+    }
+
+    final logs = data['logs'];
+    if (logs is List) {
+      for (final line in logs) {
+        _logController.add(line.toString());
+      }
+    }
+
+    final lastError = data['lastError'];
+    if (lastError != null) {
+      VortexLogger.w('[Core] Last error before subscribe: $lastError');
+    }
+    VortexLogger.d('Replayed native state: $_currentState');
+  }
+
   // 事件回调
   Function(dynamic)? _onVpnStateChanged;
   Function(dynamic)? _onTrafficUpdate;
@@ -225,10 +1108,13 @@ class PlatformChannelService {
         _stateController.add(_currentState);
       }
 
-      final result = await _channel.invokeMethod('startCore', {
-        'configPath': configPath,
-        'workDir': await getConfigDirectory(),
-      });
+      final result = await _channel.invokeMethod(
+        'startCore',
+        Tracing.channelArgs({
+          'configPath': configPath,
+          'workDir': await getConfigDirectory(),
+        }),
+      );
 
       if (result == true) {
         VortexLogger.i('Core started with config: $configPath');
@@ -256,7 +1142,7 @@ class PlatformChannelService {
 
       // 添加超时保护，防止原生代码卡住导致 UI 卡死
       final result = await _channel
-          .invokeMethod('stopCore')
+          .invokeMethod('stopCore', Tracing.channelArgs())
           .timeout(
             const Duration(seconds: 5),
             onTimeout: () {
@@ -299,9 +1185,10 @@ class PlatformChannelService {
   /// 重载配置
   Future<bool> reloadConfig(String configPath) async {
     try {
-      final result = await _channel.invokeMethod('reloadConfig', {
-        'configPath': configPath,
-      });
+      final result = await _channel.invokeMethod(
+        'reloadConfig',
+        Tracing.channelArgs({'configPath': configPath}),
+      );
       return result == true;
     } on PlatformException catch (e) {
       VortexLogger.e('Failed to reload config: ${e.message}');
@@ -354,11 +1241,14 @@ class PlatformChannelService {
     try {
       // 添加超时保护
       final result = await _channel
-          .invokeMethod('setSystemProxy', {
-            'enable': enable,
-            'host': '127.0.0.1',
-            'port': port,
-          })
+          .invokeMethod(
+            'setSystemProxy',
+            Tracing.channelArgs({
+              'enable': enable,
+              'host': '127.0.0.1',
+              'port': port,
+            }),
+          )
           .timeout(
             const Duration(seconds: 3),
             onTimeout: () {
@@ -568,11 +1458,1048 @@ class PlatformChannelService {
     }
   }
 
+  /// 并发竞速探测 API 端点 (Windows)
+  /// 所有端点错峰并发请求，返回第一个有效响应的端点，失败者会被取消
+  Future<Map<String, dynamic>?> raceEndpoints(
+    List<String> endpoints, {
+    required String probePath,
+    List<String> requiredKeys = const [],
+    String? userAgent,
+    Duration timeout = const Duration(seconds: 5),
+    Duration stagger = const Duration(milliseconds: 250),
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('raceEndpoints', {
+        'endpoints': endpoints,
+        'probePath': probePath,
+        'requiredKeys': requiredKeys,
+        if (userAgent != null) 'userAgent': userAgent,
+        'timeout': timeout.inMilliseconds,
+        'stagger': stagger.inMilliseconds,
+      });
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to race endpoints: ${e.message}');
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// 获取端点健康记录 (Windows)
+  Future<List<Map<String, dynamic>>> getEndpointHealth() async {
+    if (!Platform.isWindows) return [];
+
+    try {
+      final result = await _channel.invokeMethod('getEndpointHealth');
+      if (result is List) {
+        return result
+            .whereType<Map>()
+            .map((e) => Map<String, dynamic>.from(e))
+            .toList();
+      }
+      return [];
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get endpoint health: ${e.message}');
+      return [];
+    }
+  }
+
+  /// 用本机替身端点自检端点竞速 (Windows)
+  ///
+  /// 原生层在 127.0.0.1 上启动拒绝连接、挂起、慢速、无效和正常的替身端点，
+  /// 检查胜出者、失败者取消、响应校验和重启后的健康排序；
+  /// 返回 passed / checks(name, passed, detail) / elapsed / error
+  Future<Map<String, dynamic>?> checkEndpointRacer() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('checkEndpointRacer');
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to check endpoint racer: ${e.message}');
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// 自检内核的 Job Object 隔离 (Windows)
+  ///
+  /// 原生层在带小内存上限的独立 Job 中反复运行会不断申请内存的替身进程，
+  /// 检查内存超限事件、超限后替身退出，以及重启预算计入每次退出并在用尽后放弃；
+  /// 不影响正在运行的内核。返回 passed / checks(name, passed, detail) / elapsed / error
+  Future<Map<String, dynamic>?> checkCoreContainment() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('checkCoreContainment');
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to check core containment: ${e.message}');
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// 并发拉取并合并多个订阅 (Windows)
+  /// 返回 nodes / sources / diff / duplicates / total，失败时返回 null
+  Future<Map<String, dynamic>?> fetchSubscriptions(
+    List<String> urls, {
+    List<String> tags = const [],
+    String? userAgent,
+    Duration timeout = const Duration(seconds: 30),
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('fetchSubscriptions', {
+        'urls': urls,
+        'tags': tags,
+        if (userAgent != null) 'userAgent': userAgent,
+        'timeout': timeout.inMilliseconds,
+      });
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to fetch subscriptions: ${e.message}');
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// 用原生流式 YAML 读取器解析 Clash 配置或 provider 的 proxies (Windows)
+  /// 经过订阅管线：结果替换管线的节点表，作为下次 [fetchSubscriptions] 的差异基准
+  /// 返回 nodes (节点记录)、diff 以及 items/parsed/anchors/bytes/elapsed 统计；
+  /// 内容不是原生能读的格式时返回 null
+  Future<Map<String, dynamic>?> parseClashYaml(
+    String content, {
+    String source = '',
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('parseClashYaml', {
+        'content': content,
+        'source': source,
+      });
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to parse Clash YAML natively: ${e.message}');
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// 对原生 Clash YAML 读取器做基准测试 (Windows)
+  /// 生成 block、flow、anchors 三种写法各 count 个节点的文件并计时
+  Future<List<Map<String, dynamic>>> benchmarkClashYaml({int count = 10000}) async {
+    if (!Platform.isWindows) return const [];
+
+    try {
+      final result = await _channel.invokeMethod('benchmarkClashYaml', {
+        'count': count,
+      });
+      if (result is List) {
+        return result.map((e) => Map<String, dynamic>.from(e as Map)).toList();
+      }
+      return const [];
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to benchmark Clash YAML: ${e.message}');
+      return const [];
+    }
+  }
+
+  /// 按原生协议描述表校验节点并生成 mihomo 的 proxies 配置 (Windows)
+  /// 每个节点为 name / type / server / port / settings；
+  /// 设置键可以是 Clash 键或分享链接解析出的键
+  Future<ProxySerialization?> serializeProxies(
+    List<Map<String, dynamic>> nodes,
+  ) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('serializeProxies', {
+        'nodes': nodes,
+      });
+      if (result is Map) {
+        return ProxySerialization.fromMap(Map<String, dynamic>.from(result));
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to serialize proxies: ${e.message}');
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// 读取原生飞行记录器内容 (Windows)，包含上次崩溃前的记录
+  Future<String?> getFlightRecorder() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('getFlightRecorder');
+      return result as String?;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to read flight recorder: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 开关跨层追踪；[clear] 为 true 时同时清空两端已记录的 span
+  Future<void> setTracing(bool enabled, {bool clear = false}) async {
+    Tracing.enabled = enabled;
+    if (clear) Tracing.clear();
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('setTracing', {
+        'enabled': enabled,
+        'clear': clear,
+      });
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to set tracing: ${e.message}');
+    }
+  }
+
+  /// 将 Dart 与原生端的 span 合并导出为 Chrome trace JSON，返回文件路径
+  /// 用 chrome://tracing 或 Perfetto 打开，一次连接或切换的完整关键路径在同一文件中
+  Future<String?> exportTrace() async {
+    final events = <Object?>[...Tracing.events()];
+    if (Platform.isWindows) {
+      try {
+        final native = await _channel.invokeMethod('exportTraceEvents');
+        if (native is String && native.isNotEmpty) {
+          events.addAll(jsonDecode(native) as List);
+        }
+      } on PlatformException catch (e) {
+        VortexLogger.e('Failed to export native trace: ${e.message}');
+      }
+    }
+
+    try {
+      final dir = Directory('${await getConfigDirectory()}/traces');
+      await dir.create(recursive: true);
+      final file = File(
+        '${dir.path}/trace-${DateTime.now().millisecondsSinceEpoch}.json',
+      );
+      await file.writeAsString(
+        jsonEncode({'traceEvents': events, 'displayTimeUnit': 'ms'}),
+      );
+      VortexLogger.i('Trace exported to ${file.path}');
+      return file.path;
+    } catch (e) {
+      VortexLogger.e('Failed to write trace: $e');
+      return null;
+    }
+  }
+
+  /// 设置核心资源上限 (Windows Job Object)
+  /// memoryMb / cpuPercent 为 0 表示不限制，运行中的核心立即生效
+  Future<bool> setCoreLimits({int memoryMb = 0, int cpuPercent = 0}) async {
+    if (!Platform.isWindows) return false;
+
+    try {
+      final result = await _channel.invokeMethod('setCoreLimits', {
+        'memoryMb': memoryMb,
+        'cpuPercent': cpuPercent,
+      });
+      return result == true;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to set core limits: ${e.message}');
+      return false;
+    }
+  }
+
+  /// 立即释放原生缓存并触发核心 GC (Windows)
+  /// 核心只在 log-level 为 debug 时提供 GC 接口，否则 coreGc 为 false，
+  /// coreGcError 说明原因
+  Future<Map<String, dynamic>?> trimMemory() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('trimMemory');
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to trim memory: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 订阅核心的流式接口 (Windows，原生 WebSocket)
+  /// mode 为 'latest' 时只保留最新一条，'queue' 时保留全部并在积压
+  /// 达到 maxPending 时暂停读取；消息通过 [controllerStream] 推送
+  Future<bool> subscribeStream(
+    String name,
+    String path, {
+    String mode = 'latest',
+    int interval = 0,
+    int maxPending = 256,
+  }) async {
+    if (!Platform.isWindows) return false;
+
+    try {
+      final result = await _channel.invokeMethod('subscribeStream', {
+        'name': name,
+        'path': path,
+        'mode': mode,
+        'interval': interval,
+        'maxPending': maxPending,
+      });
+      return result == true;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to subscribe stream $path: ${e.message}');
+      return false;
+    }
+  }
+
+  /// 取消原生流订阅
+  Future<void> unsubscribeStream(String name) async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('unsubscribeStream', {'name': name});
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to unsubscribe stream $name: ${e.message}');
+    }
+  }
+
+  /// 原生流连接状态 (压缩、积压、重连次数等)
+  Future<List<Map<String, dynamic>>> getStreamStatus() async {
+    if (!Platform.isWindows) return [];
+
+    try {
+      final result = await _channel.invokeMethod('getStreamStatus');
+      if (result is List) {
+        return result
+            .whereType<Map>()
+            .map((e) => Map<String, dynamic>.from(e))
+            .toList();
+      }
+      return [];
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get stream status: ${e.message}');
+      return [];
+    }
+  }
+
+  /// 设置切换节点后的链路预热 (开关、预热目标、单次请求超时)
+  Future<bool> configurePathWarmup({
+    bool? enabled,
+    List<String>? targets,
+    int? timeout,
+  }) async {
+    if (!Platform.isWindows) return false;
+
+    try {
+      final result = await _channel.invokeMethod('configurePathWarmup', {
+        if (enabled != null) 'enabled': enabled,
+        if (targets != null) 'targets': targets,
+        if (timeout != null) 'timeout': timeout,
+      });
+      return result == true;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to configure path warmup: ${e.message}');
+      return false;
+    }
+  }
+
+  /// 通过本地代理端口预热到当前节点的链路，结果经 [pathWarmupStream] 返回
+  Future<bool> warmPath(String node) async {
+    if (!Platform.isWindows) return false;
+
+    try {
+      final result = await _channel.invokeMethod(
+        'warmPath',
+        Tracing.channelArgs({'node': node}),
+      );
+      return result == true;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to warm path: ${e.message}');
+      return false;
+    }
+  }
+
+  /// 最近一次链路预热结果
+  Future<PathWarmupResult?> getPathWarmup() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('getPathWarmup');
+      if (result is Map) {
+        return PathWarmupResult.fromMap(Map<String, dynamic>.from(result));
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get path warmup: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 设置参与评分的节点 (id、name、multiplier)，已有节点保留历史样本
+  Future<void> setScoredNodes(List<Map<String, dynamic>> nodes) async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('setScoredNodes', {'nodes': nodes});
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to set scored nodes: ${e.message}');
+    }
+  }
+
+  /// 提交测速样本：latencies 为节点 id 到延迟 (<= 0 表示失败)，
+  /// throughputs 为节点 id 到吞吐 (字节/秒)
+  Future<void> addNodeSamples({
+    Map<String, int> latencies = const {},
+    Map<String, double> throughputs = const {},
+  }) async {
+    if (!Platform.isWindows) return;
+    if (latencies.isEmpty && throughputs.isEmpty) return;
+
+    try {
+      await _channel.invokeMethod('addNodeSamples', {
+        'samples': [
+          for (final entry in latencies.entries)
+            {'id': entry.key, 'latency': entry.value},
+          for (final entry in throughputs.entries)
+            {'id': entry.key, 'throughput': entry.value},
+        ],
+      });
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to add node samples: ${e.message}');
+    }
+  }
+
+  /// 调整评分权重，未传的项保持不变
+  Future<void> setScoreWeights({
+    double? latency,
+    double? jitter,
+    double? loss,
+    double? throughput,
+    double? multiplier,
+  }) async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('setScoreWeights', {
+        if (latency != null) 'latency': latency,
+        if (jitter != null) 'jitter': jitter,
+        if (loss != null) 'loss': loss,
+        if (throughput != null) 'throughput': throughput,
+        if (multiplier != null) 'multiplier': multiplier,
+      });
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to set score weights: ${e.message}');
+    }
+  }
+
+  /// 得分最优的前 [limit] 个节点
+  Future<List<NodeScore>> getTopNodes({int limit = 10}) async {
+    if (!Platform.isWindows) return [];
+
+    try {
+      final result = await _channel.invokeMethod('getTopNodes', {
+        'limit': limit,
+      });
+      if (result is List) {
+        return result
+            .whereType<Map>()
+            .map((e) => NodeScore.fromMap(Map<String, dynamic>.from(e)))
+            .toList();
+      }
+      return [];
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get top nodes: ${e.message}');
+      return [];
+    }
+  }
+
+  /// 当前得分最优的节点 id，尚无测速结果时为 null
+  Future<String?> getBestNode() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      return await _channel.invokeMethod<String>('getBestNode');
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get best node: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 解析代理或代理组的完整链路 (relay 与 dialer-proxy)，逐跳测试延迟
+  /// 通过当前运行的核心 (已连接或后台测速核心) 测试，没有独立的探测核心；
+  /// 核心未运行时 error 不为空
+  Future<ChainProbeResult?> probeChain(
+    String target, {
+    String? url,
+    int timeout = 5000,
+    int samples = 3,
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('probeChain', {
+        'target': target,
+        if (url != null) 'url': url,
+        'timeout': timeout,
+        'samples': samples,
+      });
+      if (result is Map) {
+        return ChainProbeResult.fromMap(Map<String, dynamic>.from(result));
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to probe chain $target: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 并发解析一组域名 (冷、热各一轮)，测试内核解析器，
+  /// 并直接测试配置 dns 段中的各个 nameserver 后排名。
+  /// [domains] 为空时使用内置的常用域名列表，[nameservers] 为空时读取当前配置
+  Future<DnsBenchmarkResult?> benchmarkDns({
+    List<String> domains = const [],
+    String type = 'A',
+    int concurrency = 8,
+    int timeout = 3000,
+    bool direct = true,
+    List<String> nameservers = const [],
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('benchmarkDns', {
+        'domains': domains,
+        'type': type,
+        'concurrency': concurrency,
+        'timeout': timeout,
+        'direct': direct,
+        'nameservers': nameservers,
+      });
+      if (result is Map) {
+        return DnsBenchmarkResult.fromMap(Map<String, dynamic>.from(result));
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to benchmark DNS: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 在原生层一次性测量一组 "host:port" 的 TCP 连接延迟，
+  /// 单线程经完成端口批量收取结果；[backend] 为 auto、completion 或 readiness
+  Future<TcpPingResult?> tcpPing(
+    List<String> targets, {
+    int timeout = 5000,
+    int concurrency = 256,
+    String backend = 'auto',
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('tcpPing', {
+        'targets': targets,
+        'timeout': timeout,
+        'concurrency': concurrency,
+        'backend': backend,
+      });
+      if (result is Map) {
+        final ping = TcpPingResult.fromMap(Map<String, dynamic>.from(result));
+        return ping.error.isEmpty ? ping : null;
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to tcp ping: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 对本机回环监听并发 [counts] 个连接，分别用 WSAPoll 与完成端口测量，
+  /// 结果依次为每个数量的 readiness、completion 两轮 (不含逐个延迟)
+  Future<List<TcpPingResult>> benchmarkTcpPing({
+    List<int> counts = const [1000, 10000],
+    int timeout = 10000,
+  }) async {
+    if (!Platform.isWindows) return const [];
+
+    try {
+      final result = await _channel.invokeMethod('benchmarkTcpPing', {
+        'counts': counts,
+        'timeout': timeout,
+      });
+      if (result is! Map) return const [];
+      final error = result['error'] as String? ?? '';
+      if (error.isNotEmpty) {
+        VortexLogger.e('Failed to benchmark tcp ping: $error');
+        return const [];
+      }
+      return (result['runs'] as List?)
+              ?.whereType<Map>()
+              .map((e) => TcpPingResult.fromMap(Map<String, dynamic>.from(e)))
+              .toList() ??
+          const [];
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to benchmark tcp ping: ${e.message}');
+      return const [];
+    }
+  }
+
+  /// 原生层按顺序完成一次切换：核心未运行时用 [configPath] 启动，否则重载
+  /// (为空则保留当前配置)，切换 [selector] 到 [proxy]，测试节点可用后预热路径。
+  /// 超过 [deadline] 毫秒即放弃等待，error 为 deadline exceeded
+  Future<Map<String, dynamic>?> hotSwap({
+    String configPath = '',
+    required String selector,
+    required String proxy,
+    String url = 'http://www.gstatic.com/generate_204',
+    int timeout = 5000,
+    bool warm = true,
+    int deadline = 30000,
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod(
+        'hotSwap',
+        Tracing.channelArgs({
+          'configPath': configPath,
+          'selector': selector,
+          'proxy': proxy,
+          'url': url,
+          'timeout': timeout,
+          'warm': warm,
+          'deadline': deadline,
+        }),
+      );
+      if (result is Map) return Map<String, dynamic>.from(result);
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to hot swap to $proxy: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 经核心并发测试一组代理的延迟，每次 [concurrency] 个；
+  /// 结果的 delays 与 [proxies] 一一对应，失败或未测到为 -1
+  Future<Map<String, dynamic>?> probeDelays(
+    List<String> proxies, {
+    String url = 'http://www.gstatic.com/generate_204',
+    int timeout = 5000,
+    int concurrency = 8,
+    int deadline = 60000,
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('probeDelays', {
+        'proxies': proxies,
+        'url': url,
+        'timeout': timeout,
+        'concurrency': concurrency,
+        'deadline': deadline,
+      });
+      if (result is Map) return Map<String, dynamic>.from(result);
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to probe delays: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 代理组拓扑快照；[refresh] 为 true 时先从核心刷新一次
+  Future<ProxyTopology?> getProxyTopology({bool refresh = true}) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('getProxyTopology', {
+        'refresh': refresh,
+      });
+      if (result is Uint8List) return ProxyTopology.decode(result);
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get proxy topology: ${e.message}');
+      return null;
+    } on FormatException catch (e) {
+      VortexLogger.e('Failed to decode proxy topology: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 开始跟踪代理组变化：切换、重载和测速后立即刷新，另外每 [interval]
+  /// 毫秒轮询一次以发现 url-test / fallback 组自行切换；变更经
+  /// [proxyTopologyStream] 推送
+  Future<void> watchProxyTopology({int interval = 30000}) async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('watchProxyTopology', {
+        'interval': interval,
+      });
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to watch proxy topology: ${e.message}');
+    }
+  }
+
+  /// 停止跟踪代理组变化
+  Future<void> unwatchProxyTopology() async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('unwatchProxyTopology');
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to unwatch proxy topology: ${e.message}');
+    }
+  }
+
+  /// 取消所有进行中的 hotSwap / probeDelays，返回取消的数量
+  Future<int> cancelCoreTasks() async {
+    if (!Platform.isWindows) return 0;
+
+    try {
+      final result = await _channel.invokeMethod('cancelCoreTasks');
+      return result is int ? result : 0;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to cancel core tasks: ${e.message}');
+      return 0;
+    }
+  }
+
+  /// 规则命中统计 (命中最多的规则)、最近一次规则重排报告及规则集编译报告
+  Future<Map<String, dynamic>?> getRuleStats() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('getRuleStats');
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get rule stats: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 清空规则命中统计
+  Future<void> resetRuleStats() async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('resetRuleStats');
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to reset rule stats: ${e.message}');
+    }
+  }
+
+  /// 连接时长、字节数与新建速率统计 (按主机和进程)，以及被判定为频繁建连的对象
+  Future<ConnectionStatsReport?> getConnectionStats({int limit = 20}) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('getConnectionStats', {
+        'limit': limit,
+      });
+      if (result is Map) {
+        return ConnectionStatsReport.fromMap(Map<String, dynamic>.from(result));
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get connection stats: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 连接统计的 Prometheus 文本格式导出：总计及新建最频繁的 [limit] 个
+  /// 主机和进程的计数、速率与时长/字节直方图 (Windows)
+  Future<String?> getConnectionMetrics({int limit = 20}) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      return await _channel.invokeMethod<String>('getConnectionMetrics', {
+        'limit': limit,
+      });
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get connection metrics: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 调整频繁建连判定阈值：每分钟新建数下限、短连接占比下限及短连接时长
+  Future<bool> configureChurnDetection({
+    double? minOpenRate,
+    double? minShortLived,
+    int? shortLivedMs,
+  }) async {
+    if (!Platform.isWindows) return false;
+
+    try {
+      final result = await _channel.invokeMethod('configureChurnDetection', {
+        if (minOpenRate != null) 'minOpenRate': minOpenRate,
+        if (minShortLived != null) 'minShortLived': minShortLived,
+        if (shortLivedMs != null) 'shortLivedMs': shortLivedMs,
+      });
+      return result == true;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to configure churn detection: ${e.message}');
+      return false;
+    }
+  }
+
+  /// 清空连接生命周期统计
+  Future<void> resetConnectionStats() async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('resetConnectionStats');
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to reset connection stats: ${e.message}');
+    }
+  }
+
+  /// 开始录制控制器流量 (请求与流消息)，供 tool/trace/replay_server.dart 回放
+  /// [redact] 为 true 时密码、服务器、目标地址、代理名 (含路径与查询参数中的) 等
+  /// 替换为哈希令牌；请求体一并录制，需以 --send 重放到真实内核时应关闭
+  Future<Map<String, dynamic>?> startControllerTrace({
+    String? path,
+    bool redact = true,
+    int maxMb = 256,
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('startControllerTrace', {
+        if (path != null) 'path': path,
+        'redact': redact,
+        'maxMb': maxMb,
+      });
+      if (result is Map) return Map<String, dynamic>.from(result);
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to start controller trace: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 停止录制，返回最终的记录数与文件大小
+  Future<Map<String, dynamic>?> stopControllerTrace() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('stopControllerTrace');
+      if (result is Map) return Map<String, dynamic>.from(result);
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to stop controller trace: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 当前录制状态
+  Future<Map<String, dynamic>?> getControllerTrace() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('getControllerTrace');
+      if (result is Map) return Map<String, dynamic>.from(result);
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to get controller trace: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 自检控制器录制的脱敏 (Windows)
+  ///
+  /// 原生层以固定盐值在内存中脱敏示例路径与响应体，检查同一代理名无论如何转义，
+  /// 在路径、/proxies 与 /group 响应体、请求体和 chains 中都得到同一个令牌；
+  /// 返回 passed / checks(name, passed, detail) / elapsed / error
+  Future<Map<String, dynamic>?> checkControllerTrace() async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('checkControllerTrace');
+      if (result is Map) {
+        return Map<String, dynamic>.from(result);
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to check controller trace: ${e.message}');
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// 耐久测试：反复启动、重载、切换、停止核心并跟踪流接口，
+  /// 每轮停止后采样内存、句柄、线程和队列深度，单调增长即判定泄漏
+  /// 时钟不会加速，每轮代表一次重连；结果中的 elapsed 是实际耗时 (毫秒)
+  /// [corePath] 可指定替身核心 (如编译后的 tool/trace/replay_server.dart)，
+  /// 替身核心运行的配置不编译规则集
+  /// 核心正在使用时拒绝开始；运行期间 startCore、stopCore、reloadConfig、
+  /// switchProxy 与 hotSwap 返回 SOAK_RUNNING 错误，进度见 [soakProgressStream]
+  Future<Map<String, dynamic>?> runSoakTest({
+    String? configPath,
+    String? corePath,
+    int cycles = 500,
+    int cycleMs = 1000,
+    String? selector,
+    List<String> proxies = const [],
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('runSoakTest', {
+        if (configPath != null) 'configPath': configPath,
+        if (corePath != null) 'corePath': corePath,
+        'cycles': cycles,
+        'cycleMs': cycleMs,
+        if (selector != null) 'selector': selector,
+        'proxies': proxies,
+      });
+      if (result is Map) {
+        final report = Map<String, dynamic>.from(result);
+        if (report['passed'] != true) {
+          VortexLogger.w(
+            'Soak test failed after ${report['cycles']} cycles: '
+            '${report['error'] ?? ''}',
+          );
+        }
+        return report;
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to run soak test: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 在当前轮结束后中止耐久测试
+  Future<void> cancelSoakTest() async {
+    if (!Platform.isWindows) return;
+
+    try {
+      await _channel.invokeMethod('cancelSoakTest');
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to cancel soak test: ${e.message}');
+    }
+  }
+
+  /// 空闲开销测量：已连接但无流量时，在 [window] 内统计各子系统线程的唤醒次数
+  /// (上下文切换) 与 CPU 占用，以及运行器和核心的 I/O 次数，并与预算比较
+  /// [budgets] 覆盖默认预算，如 {'worker_pool': {'wakeups': 0.5, 'cpu': 0.2}}
+  Future<Map<String, dynamic>?> measureIdleBudget({
+    Duration window = const Duration(seconds: 30),
+    bool requireConnected = true,
+    Map<String, Map<String, double>>? budgets,
+  }) async {
+    if (!Platform.isWindows) return null;
+
+    try {
+      final result = await _channel.invokeMethod('measureIdleBudget', {
+        'window': window.inMilliseconds,
+        'requireConnected': requireConnected,
+        if (budgets != null) 'budgets': budgets,
+      });
+      if (result is Map) {
+        final report = Map<String, dynamic>.from(result);
+        if (report['passed'] != true) {
+          final over = (report['subsystems'] as List? ?? const [])
+              .whereType<Map>()
+              .where((e) => e['overBudget'] == true)
+              .map((e) => e['name'])
+              .join(', ');
+          VortexLogger.w(
+            'Idle budget exceeded${over.isNotEmpty ? ' by $over' : ''}'
+            '${report['error'] != '' ? ': ${report['error']}' : ''}',
+          );
+        }
+        return report;
+      }
+      return null;
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to measure idle budget: ${e.message}');
+      return null;
+    }
+  }
+
+  /// 一次通道往返执行多个方法调用，结果按传入顺序返回
+  /// 调用按顺序执行，每个都在之前的调用返回后开始；Windows 上相邻的
+  /// 只读调用在原生端并行执行 (同时最多 4 个)，其他平台逐个调用
+  Future<List<BatchCallResult>> invokeBatch(
+    List<(String, Map<String, dynamic>?)> calls,
+  ) async {
+    if (!Platform.isWindows) {
+      final results = <BatchCallResult>[];
+      for (final (method, args) in calls) {
+        try {
+          final value = await _channel.invokeMethod(method, args);
+          results.add(BatchCallResult(ok: true, value: value));
+        } on PlatformException catch (e) {
+          results.add(
+            BatchCallResult(ok: false, code: e.code, message: e.message),
+          );
+        } on MissingPluginException {
+          results.add(BatchCallResult(ok: false, code: 'NOT_IMPLEMENTED'));
+        }
+      }
+      return results;
+    }
+
+    try {
+      final result = await _channel.invokeMethod('invokeBatch', {
+        'calls': [
+          for (final (method, args) in calls)
+            {'method': method, if (args != null) 'args': args},
+        ],
+      });
+      if (result is List) {
+        return result
+            .whereType<Map>()
+            .map((e) => BatchCallResult.fromMap(Map<String, dynamic>.from(e)))
+            .toList();
+      }
+    } on PlatformException catch (e) {
+      VortexLogger.e('Failed to invoke batch: ${e.message}');
+    }
+    return [
+      for (final _ in calls)
+        BatchCallResult(ok: false, code: 'BATCH_FAILED'),
+    ];
+  }
+
   /// 释放资源
   void dispose() {
     _eventSubscription?.cancel();
     _stateController.close();
     _trafficController.close();
     _logController.close();
+    _controllerStreamController.close();
+    _pathWarmupController.close();
+    _connectionChurnController.close();
+    _soakProgressController.close();
+    _proxyTopologyController.close();
   }
 }
@@ -6,7 +6,9 @@ import 'package:dio/dio.dart';
 import 'package:path_provider/path_provider.dart';
 
 import '../../shared/models/proxy_node.dart';
+import '../platform/platform_channel_service.dart';
 import '../utils/logger.dart';
+import '../utils/tracing.dart';
 
 /// Mihomo (Clash.Meta) Core Service
 /// 通过 RESTful API 与 Mihomo 核心通信
@@ -63,6 +65,16 @@ class MihomoService {
       ),
     );
 
+    // 追踪中的请求把上下文带给控制器
+    _dio.interceptors.add(
+      InterceptorsWrapper(
+        onRequest: (options, handler) {
+          options.headers.addAll(Tracing.headers);
+          return handler.next(options);
+        },
+      ),
+    );
+
     VortexLogger.i('MihomoService initialized: $apiBaseUrl');
   }
 
@@ -201,9 +213,12 @@ class MihomoService {
   /// 切换代理
   Future<bool> selectProxy(String groupName, String proxyName) async {
     try {
-      await _dio.put(
-        '/proxies/${Uri.encodeComponent(groupName)}',
-        data: {'name': proxyName},
+      await Tracing.span(
+        'selectProxy',
+        () => _dio.put(
+          '/proxies/${Uri.encodeComponent(groupName)}',
+          data: {'name': proxyName},
+        ),
       );
       VortexLogger.i('Proxy selected: $groupName -> $proxyName');
       return true;
@@ -356,8 +371,48 @@ class MihomoService {
     }
   }
 
+  /// 通过原生 WebSocket 订阅流式接口 (Windows)
+  /// 取消监听时同时取消原生订阅
+  Stream<Map<String, dynamic>> _nativeStream(
+    String name,
+    String path, {
+    String mode = 'latest',
+  }) {
+    final platform = PlatformChannelService.instance;
+    StreamSubscription<ControllerStreamBatch>? subscription;
+    late final StreamController<Map<String, dynamic>> controller;
+
+    controller = StreamController<Map<String, dynamic>>(
+      onListen: () {
+        subscription = platform.controllerStream
+            .where((batch) => batch.name == name)
+            .listen((batch) {
+          for (final message in batch.messages) {
+            try {
+              controller.add(jsonDecode(message) as Map<String, dynamic>);
+            } catch (_) {}
+          }
+        });
+        platform.subscribeStream(name, path, mode: mode).then((ok) {
+          if (!ok) {
+            controller.addError(StateError('Failed to subscribe $path'));
+          }
+        });
+      },
+      onCancel: () async {
+        await subscription?.cancel();
+        await platform.unsubscribeStream(name);
+      },
+    );
+    return controller.stream;
+  }
+
   /// 获取流量统计
   Future<Stream<Map<String, dynamic>>> getTrafficStream() async {
+    if (Platform.isWindows) {
+      return _nativeStream('dart.traffic', '/traffic');
+    }
+
     final controller = StreamController<Map<String, dynamic>>();
 
     try {
@@ -394,6 +449,14 @@ class MihomoService {
   Future<Stream<Map<String, dynamic>>> getLogsStream({
     String level = 'info',
   }) async {
+    if (Platform.isWindows) {
+      return _nativeStream(
+        'dart.logs.$level',
+        '/logs?level=$level',
+        mode: 'queue',
+      );
+    }
+
     final controller = StreamController<Map<String, dynamic>>();
 
     try {
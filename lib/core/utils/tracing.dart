@@ -0,0 +1,130 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:developer' as developer;
+import 'dart:io';
+import 'dart:math';
+
+/// 一次追踪中的位置：追踪 ID 与当前 span ID (16 位十六进制)
+class TraceContext {
+  final String traceId;
+  final String spanId;
+
+  const TraceContext(this.traceId, this.spanId);
+
+  /// 平台通道参数中的 _trace 字段
+  Map<String, String> toArgs() => {'id': traceId, 'parent': spanId};
+
+  /// 控制器请求的 X-Vortex-Trace 头
+  String get header => '$traceId-$spanId';
+}
+
+/// 跨层请求追踪
+///
+/// 一次连接或切换从 Dart 开始追踪，上下文随 Zone 传递给其中的异步调用，
+/// 经平台通道参数 (_trace) 和控制器请求头 (X-Vortex-Trace) 传到原生层。
+/// Dart 端的 span 同时写入 Timeline (DevTools 可见) 和本地环形缓冲，
+/// 导出时与原生端的 span 合并为一个 Chrome trace JSON 文件
+/// (chrome://tracing 或 Perfetto 打开)。时间戳均为 Unix 微秒。
+class Tracing {
+  Tracing._();
+
+  static const int _capacity = 4096;
+  static const _zoneKey = #vortexTrace;
+  static final _random = Random.secure();
+  static final Queue<Map<String, Object?>> _events = Queue();
+
+  /// 关闭时 span 直接执行，不记录也不传递上下文
+  static bool enabled = false;
+
+  static TraceContext? get current =>
+      enabled ? Zone.current[_zoneKey] as TraceContext? : null;
+
+  static String _newId() {
+    final high = _random.nextInt(1 << 32);
+    final low = _random.nextInt(1 << 32);
+    return high.toRadixString(16).padLeft(8, '0') +
+        low.toRadixString(16).padLeft(8, '0');
+  }
+
+  /// 在一个 span 中执行 [body]；没有外层追踪时开启新的追踪
+  static Future<T> span<T>(
+    String name,
+    Future<T> Function() body, {
+    String category = 'dart',
+  }) async {
+    if (!enabled) return body();
+
+    final parent = current;
+    final context = TraceContext(parent?.traceId ?? _newId(), _newId());
+    final task = developer.TimelineTask()
+      ..start(name, arguments: {'trace': context.traceId});
+    final start = DateTime.now().microsecondsSinceEpoch;
+    try {
+      return await runZoned(body, zoneValues: {_zoneKey: context});
+    } finally {
+      task.finish();
+      _record(
+        name,
+        category,
+        context,
+        parent?.spanId ?? '0000000000000000',
+        start,
+        DateTime.now().microsecondsSinceEpoch,
+      );
+    }
+  }
+
+  /// 给平台通道参数加上当前追踪上下文
+  static Map<String, Object?>? channelArgs([Map<String, Object?>? args]) {
+    final context = current;
+    if (context == null) return args;
+    return {...?args, '_trace': context.toArgs()};
+  }
+
+  /// 控制器请求需要附加的追踪头
+  static Map<String, String> get headers {
+    final context = current;
+    return context == null ? const {} : {'X-Vortex-Trace': context.header};
+  }
+
+  static void _record(
+    String name,
+    String category,
+    TraceContext context,
+    String parentSpan,
+    int start,
+    int end,
+  ) {
+    _events.add({
+      'ph': 'X',
+      'name': name,
+      'cat': category,
+      'ts': start,
+      'dur': end - start,
+      'pid': pid,
+      'tid': 0,
+      'args': {
+        'trace': context.traceId,
+        'span': context.spanId,
+        'parent': parentSpan,
+      },
+    });
+    while (_events.length > _capacity) {
+      _events.removeFirst();
+    }
+  }
+
+  /// Dart 端记录的 span 与进程名元数据，供导出时与原生事件合并
+  static List<Map<String, Object?>> events() => [
+    {
+      'ph': 'M',
+      'name': 'thread_name',
+      'pid': pid,
+      'tid': 0,
+      'args': {'name': 'dart'},
+    },
+    ..._events,
+  ];
+
+  static void clear() => _events.clear();
+}
@@ -6,6 +6,7 @@ import '../config/config_validator.dart';
 import '../platform/platform_channel_service.dart';
 import '../proxy/mihomo_service.dart';
 import '../utils/logger.dart';
+import '../utils/tracing.dart';
 
 /// VPN 服务管理器 - 管理 VPN 连接的完整生命周期
 class VpnService {
@@ -32,6 +33,14 @@ class VpnService {
   final int _controllerPort = 9090;
   final String _controllerSecret = '';
 
+  // 吞吐采样：只在下载繁忙时测量，空闲时的低速率不代表节点能力
+  static const _throughputMinBytesPerSecond = 256 * 1024;
+  static const _throughputInterval = Duration(seconds: 30);
+  static const _throughputWindow = Duration(seconds: 3);
+  StreamSubscription<TrafficStats>? _trafficSubscription;
+  DateTime? _lastThroughputSample;
+  bool _samplingThroughput = false;
+
   /// 获取当前状态
   VpnState get currentState => _platformChannel.currentState;
 
@@ -84,6 +93,10 @@ class VpnService {
         secret: _controllerSecret,
       );
 
+      if (Platform.isWindows) {
+        _trafficSubscription = trafficStream.listen(_onTraffic);
+      }
+
       _isInitialized = true;
       VortexLogger.i('VPN service initialized');
     } catch (e) {
@@ -169,6 +182,16 @@ class VpnService {
   void setNodes(List<ProxyNode> nodes) {
     _nodes = nodes;
     VortexLogger.i('Loaded ${nodes.length} nodes');
+
+    // 原生评分引擎按 id 保留已有节点的测速历史
+    if (Platform.isWindows) {
+      unawaited(
+        _platformChannel.setScoredNodes([
+          for (final node in nodes)
+            {'id': node.id, 'name': node.name, 'multiplier': node.multiplier},
+        ]),
+      );
+    }
   }
 
   /// 连接到指定节点
@@ -177,14 +200,17 @@ class VpnService {
   /// 1. 生成配置文件
   /// 2. 验证配置
   /// 3. 启动核心
-  Future<bool> connect({ProxyNode? node}) async {
+  Future<bool> connect({ProxyNode? node}) =>
+      Tracing.span('connect', () => _connect(node: node));
+
+  Future<bool> _connect({ProxyNode? node}) async {
     if (!_isInitialized) {
       await init();
     }
 
     try {
       // 选择节点
-      final targetNode = node ?? _selectBestNode();
+      final targetNode = node ?? await _selectBestNode();
       if (targetNode == null) {
         throw Exception('没有可用的节点');
       }
@@ -192,11 +218,15 @@ class VpnService {
       VortexLogger.i('Connecting to ${targetNode.name}...');
 
       // 1. Draft - 生成并写入配置文件
-      _currentConfigPath = await _writeConfig(targetNode);
+      _currentConfigPath = await Tracing.span(
+        'writeConfig',
+        () => _writeConfig(targetNode),
+      );
 
       // 2. Validate - 验证配置（参考 Clash Verge Rev）
-      final validationResult = await _configValidator.validateConfig(
-        _currentConfigPath!,
+      final validationResult = await Tracing.span(
+        'validateConfig',
+        () => _configValidator.validateConfig(_currentConfigPath!),
       );
       if (!validationResult.isValid) {
         VortexLogger.e(
@@ -301,7 +331,10 @@ class VpnService {
   }
 
   /// 切换节点
-  Future<bool> switchNode(ProxyNode node) async {
+  Future<bool> switchNode(ProxyNode node) =>
+      Tracing.span('switch', () => _switchNode(node));
+
+  Future<bool> _switchNode(ProxyNode node) async {
     if (_currentNode?.id == node.id) {
       return true; // 已经连接到该节点
     }
@@ -318,6 +351,11 @@ class VpnService {
           await _mihomoService.closeAllConnections();
           VortexLogger.i('Closed all existing connections');
 
+          // 3. 预热到新节点的链路，首个真实请求不再承担握手开销
+          if (Platform.isWindows) {
+            unawaited(_platformChannel.warmPath(node.name));
+          }
+
           _currentNode = node;
           VortexLogger.i('Switched to ${node.name} via API');
           return true;
@@ -356,16 +394,18 @@ class VpnService {
   /// 如果核心未运行，会临时启动核心进行测试
   Future<int> testNodeDelay(ProxyNode node, {int timeout = 10000}) async {
     // 如果核心运行中，直接使用 API 测试
+    final int delay;
     if (isConnected) {
-      final delay = await _mihomoService.testProxyDelay(
-        node.name,
-        timeout: timeout,
-      );
-      return delay ?? -1;
+      delay =
+          await _mihomoService.testProxyDelay(node.name, timeout: timeout) ??
+          -1;
+    } else {
+      // 核心未运行，需要临时启动进行测试
+      delay = await _testDelayWithTempCore(node, timeout: timeout);
     }
 
-    // 核心未运行，需要临时启动进行测试
-    return await _testDelayWithTempCore(node, timeout: timeout);
+    unawaited(_platformChannel.addNodeSamples(latencies: {node.id: delay}));
+    return delay;
   }
 
   /// 临时启动核心测试延迟
@@ -649,6 +689,13 @@ class VpnService {
           completed++;
           onProgress?.call(completed, total, entry.key, entry.value);
         }
+
+        // 每批结果送入原生评分引擎，排名随之增量更新
+        unawaited(
+          _platformChannel.addNodeSamples(
+            latencies: Map.fromEntries(batchResults),
+          ),
+        );
       } catch (e) {
         VortexLogger.e('Batch test error at index $i', e);
         // 继续下一批
@@ -737,6 +784,12 @@ class VpnService {
           completed++;
           onProgress?.call(completed, total, entry.key, entry.value);
         }
+
+        unawaited(
+          _platformChannel.addNodeSamples(
+            latencies: Map.fromEntries(batchResults),
+          ),
+        );
       } catch (e) {
         VortexLogger.e('Batch test error at index $i', e);
       }
@@ -751,6 +804,76 @@ class VpnService {
     return results;
   }
 
+  /// 下载繁忙时测量当前节点的吞吐并送入评分引擎
+  ///
+  /// 总流量包含直连流量，因此改为对比前后两次连接快照中链路经过该节点
+  /// 的连接的下载量；每 [_throughputInterval] 最多测一次
+  void _onTraffic(TrafficStats stats) {
+    final node = _currentNode;
+    if (node == null || !isConnected || _samplingThroughput) return;
+    if (stats.downloadSpeed < _throughputMinBytesPerSecond) return;
+    final last = _lastThroughputSample;
+    if (last != null && DateTime.now().difference(last) < _throughputInterval) {
+      return;
+    }
+    unawaited(_sampleThroughput(node));
+  }
+
+  Future<void> _sampleThroughput(ProxyNode node) async {
+    _samplingThroughput = true;
+    _lastThroughputSample = DateTime.now();
+    try {
+      final before = _downloadedThrough(
+        node.name,
+        await _mihomoService.getConnections(),
+      );
+      final started = DateTime.now();
+      await Future.delayed(_throughputWindow);
+      final after = _downloadedThrough(
+        node.name,
+        await _mihomoService.getConnections(),
+      );
+      if (_currentNode?.id != node.id || after == null || before == null) {
+        return;
+      }
+
+      // 窗口内新建的连接从 0 计起，关闭的连接不计
+      var bytes = 0;
+      after.forEach((id, downloaded) {
+        bytes += downloaded - (before[id] ?? 0);
+      });
+      final seconds =
+          DateTime.now().difference(started).inMilliseconds / 1000.0;
+      final bytesPerSecond = bytes / seconds;
+      if (bytesPerSecond < _throughputMinBytesPerSecond) return;
+
+      await _platformChannel.addNodeSamples(
+        throughputs: {node.id: bytesPerSecond},
+      );
+    } finally {
+      _samplingThroughput = false;
+    }
+  }
+
+  /// 连接 id 到下载字节数，只含链路经过 [nodeName] 的连接
+  Map<String, int>? _downloadedThrough(
+    String nodeName,
+    Map<String, dynamic>? snapshot,
+  ) {
+    final connections = snapshot?['connections'];
+    if (connections is! List) return null;
+    final result = <String, int>{};
+    for (final connection in connections) {
+      if (connection is! Map) continue;
+      final chains = connection['chains'];
+      if (chains is! List || !chains.contains(nodeName)) continue;
+      final id = connection['id'];
+      final download = connection['download'];
+      if (id is String && download is num) result[id] = download.toInt();
+    }
+    return result;
+  }
+
   /// 获取连接信息
   Future<Map<String, dynamic>?> getConnections() async {
     if (!isConnected) return null;
@@ -780,9 +903,18 @@ class VpnService {
   }
 
   /// 选择最佳节点（延迟最低）
-  ProxyNode? _selectBestNode() {
+  Future<ProxyNode?> _selectBestNode() async {
     if (_nodes.isEmpty) return null;
-    // 简单返回第一个节点，后续可以实现智能选择
+
+    // Windows 上由原生评分引擎给出综合得分最优的节点
+    final bestId = await _platformChannel.getBestNode();
+    if (bestId != null) {
+      for (final node in _nodes) {
+        if (node.id == bestId) return node;
+      }
+    }
+
+    // 尚无测速结果时返回第一个节点
     return _nodes.first;
   }
 
@@ -801,8 +933,32 @@ class VpnService {
     final configDir = await _ensureConfigDirectory();
     final configPath = '$configDir/config.yaml';
 
+    // 节点优先由原生协议描述表生成，未通过校验的节点不写入
+    final nodes = _nodes.isNotEmpty ? _nodes : [node];
+    ProxySerialization? proxies = await _platformChannel.serializeProxies(
+      nodes
+          .map((n) => {
+                'name': n.name,
+                'type': _getProxyType(n.protocol),
+                'server': n.server,
+                'port': n.port,
+                'settings': n.settings,
+              })
+          .toList(),
+    );
+    if (proxies != null) {
+      for (final error in proxies.errors) {
+        if (error['warning'] == true) {
+          VortexLogger.w('Node ${error['name']}: ${error['error']}');
+        } else {
+          VortexLogger.w('Skipping node ${error['name']}: ${error['error']}');
+        }
+      }
+      if (proxies.names.isEmpty) proxies = null;
+    }
+
     // 生成配置
-    final config = _generateConfig(node);
+    final config = _generateConfig(node, proxies);
 
     // 写入文件
     final file = File(configPath);
@@ -812,8 +968,8 @@ class VpnService {
     return configPath;
   }
 
-  /// 生成 Mihomo 配置
-  String _generateConfig(ProxyNode node) {
+  /// 生成 Mihomo 配置，proxies 为空时节点部分由 Dart 生成
+  String _generateConfig(ProxyNode node, [ProxySerialization? proxies]) {
     final buffer = StringBuffer();
 
     // 基础配置
@@ -861,7 +1017,7 @@ class VpnService {
 
     // 代理配置
     buffer.writeln('proxies:');
-    buffer.write(_generateProxyConfig(node));
+    buffer.write(proxies?.yaml ?? _generateProxyConfig(node));
     buffer.writeln();
 
     // 代理组配置 - 包含所有节点
@@ -869,11 +1025,19 @@ class VpnService {
     buffer.writeln('  - name: Proxy');
     buffer.writeln('    type: select');
     buffer.writeln('    proxies:');
-    for (final n in _nodes) {
-      buffer.writeln('      - ${n.name}');
-    }
-    if (_nodes.isEmpty) {
-      buffer.writeln('      - ${node.name}');
+    if (proxies != null) {
+      // 与原生生成的节点名写法一致 (双引号)
+      for (final name in proxies.names) {
+        final escaped = name.replaceAll('\\', '\\\\').replaceAll('"', '\\"');
+        buffer.writeln('      - "$escaped"');
+      }
+    } else {
+      for (final n in _nodes) {
+        buffer.writeln('      - ${n.name}');
+      }
+      if (_nodes.isEmpty) {
+        buffer.writeln('      - ${node.name}');
+      }
     }
     buffer.writeln();
 
@@ -965,6 +1129,7 @@ class VpnService {
 
   /// 释放资源
   void dispose() {
+    _trafficSubscription?.cancel();
     _cleanup();
   }
 }
@@ -1,3 +1,5 @@
+import 'dart:io';
+
 import 'package:flutter/material.dart';
 import 'package:flutter/services.dart';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
@@ -6,6 +8,7 @@ import '../../../../core/utils/dev_mode.dart';
 import '../../../../core/utils/logger.dart';
 import '../../../../core/config/build_config.dart';
 import '../../../../core/api/api_manager.dart';
+import '../../../../core/platform/platform_channel_service.dart';
 
 /// 调试面板 - 用于显示配置信息和日志
 /// 长按 Logo 5 次可以打开
@@ -35,7 +38,34 @@ class _DebugPanelState extends ConsumerState<DebugPanel>
   }
 
   Future<void> _loadFileLogs() async {
-    final logs = await VortexLogger.exportLogs();
+    var logs = await VortexLogger.exportLogs();
+    if (Platform.isWindows) {
+      // 原生诊断信息一次往返取回：核心版本、流状态、飞行记录器、连接指标
+      final results = await PlatformChannelService.instance.invokeBatch([
+        ('getCoreVersion', null),
+        ('getStreamStatus', null),
+        ('getFlightRecorder', null),
+        ('getConnectionMetrics', {'limit': 10}),
+      ]);
+      if (results[0].ok) {
+        logs += '\n\nCore version: ${results[0].value}';
+      }
+      if (results[1].ok && results[1].value is List) {
+        logs += '\n\n===== Controller streams =====\n';
+        for (final status in results[1].value as List) {
+          logs += '$status\n';
+        }
+      }
+      // 附加原生飞行记录器（含上次崩溃前的记录）
+      final recorder = results[2].value;
+      if (results[2].ok && recorder is String && recorder.isNotEmpty) {
+        logs += '\n\n===== Flight recorder =====\n$recorder';
+      }
+      final metrics = results[3].value;
+      if (results[3].ok && metrics is String && metrics.isNotEmpty) {
+        logs += '\n\n===== Connection metrics =====\n$metrics';
+      }
+    }
     if (mounted) {
       setState(() {
         _fileLogs = logs;
@@ -3,6 +3,7 @@ import 'dart:io';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 
 import '../../../shared/models/proxy_node.dart';
+import '../../../core/platform/platform_channel_service.dart';
 import '../../../core/vpn/vpn_service.dart';
 import '../../../core/subscription/subscription_parser.dart';
 import '../../../shared/services/storage_service.dart';
@@ -83,15 +84,23 @@ class NodesNotifier extends StateNotifier<NodesState> {
     }
   }
 
-  /// 从URL刷新节点列表
+  /// 从URL刷新节点列表，与多订阅共用 [refreshNodesFromUrls] 的管线
   Future<void> refreshNodesFromUrl(
     String subscribeUrl, {
     String? subType,
+  }) {
+    return refreshNodesFromUrls([subscribeUrl], subType: subType);
+  }
+
+  /// 从多个订阅URL并发刷新节点列表
+  Future<void> refreshNodesFromUrls(
+    List<String> subscribeUrls, {
+    String? subType,
   }) async {
     state = state.copyWith(isLoading: true, error: null);
 
     try {
-      final nodes = await _parser.parseFromUrl(subscribeUrl, subType: subType);
+      final nodes = await _parser.parseFromUrls(subscribeUrls, subType: subType);
 
       if (nodes.isEmpty) {
         throw Exception(ErrorMessages.noNodes);
@@ -106,10 +115,12 @@ class NodesNotifier extends StateNotifier<NodesState> {
       state = state.copyWith(
         nodes: nodes,
         isLoading: false,
-        subscribeUrl: subscribeUrl,
+        subscribeUrl: subscribeUrls.first,
       );
 
-      VortexLogger.i('Loaded ${nodes.length} nodes from subscription');
+      VortexLogger.i(
+        'Loaded ${nodes.length} nodes from ${subscribeUrls.length} subscriptions',
+      );
     } catch (e) {
       VortexLogger.e('Failed to refresh nodes', e);
       state = state.copyWith(isLoading: false, error: e.toString());
@@ -122,7 +133,7 @@ class NodesNotifier extends StateNotifier<NodesState> {
     state = state.copyWith(isLoading: true, error: null);
 
     try {
-      final nodes = _parser.parse(content);
+      final nodes = await _parser.parseContent(content);
 
       if (nodes.isEmpty) {
         throw Exception(ErrorMessages.noNodes);
@@ -235,6 +246,8 @@ class NodesNotifier extends StateNotifier<NodesState> {
 
   /// 使用 TCP ping 测试延迟（不需要启动核心）
   Future<void> _testLatenciesWithTcpPing() async {
+    if (Platform.isWindows && await _testLatenciesWithNativeTcpPing()) return;
+
     final allLatencies = <String, int?>{};
     int completed = 0;
     final total = state.nodes.length;
@@ -279,6 +292,51 @@ class NodesNotifier extends StateNotifier<NodesState> {
     VortexLogger.i('TCP ping test completed: ${allLatencies.length} nodes');
   }
 
+  /// Windows 上由原生层批量测速，每批一次平台调用；
+  /// 首批即不可用时返回 false，回退到逐个 Socket.connect
+  Future<bool> _testLatenciesWithNativeTcpPing() async {
+    const chunkSize = 256;
+    final allLatencies = <String, int?>{};
+    final nodes = state.nodes;
+
+    for (var i = 0; i < nodes.length; i += chunkSize) {
+      final chunk = nodes.skip(i).take(chunkSize).toList();
+      final result = await PlatformChannelService.instance.tcpPing(
+        chunk
+            .map(
+              (node) => node.server.contains(':')
+                  ? '[${node.server}]:${node.port}'
+                  : '${node.server}:${node.port}',
+            )
+            .toList(),
+        concurrency: chunkSize,
+      );
+      if (result == null || result.latencies.length != chunk.length) {
+        if (i == 0) return false;
+        for (final node in chunk) {
+          allLatencies[node.id] = null;
+        }
+      } else {
+        for (var j = 0; j < chunk.length; j++) {
+          allLatencies[chunk[j].id] = result.latencies[j];
+        }
+        VortexLogger.d(
+          'Native TCP ping (${result.backend}): ${result.succeeded}/${result.probes} '
+          'in ${result.elapsedMs}ms, ${result.waits} waits',
+        );
+      }
+      state = state.copyWith(latencies: Map<String, int?>.from(allLatencies));
+    }
+
+    state = state.copyWith(
+      latencies: Map<String, int?>.from(allLatencies),
+      isTesting: false,
+    );
+
+    VortexLogger.i('TCP ping test completed: ${allLatencies.length} nodes');
+    return true;
+  }
+
   /// TCP ping 单个节点
   Future<int?> _tcpPing(String host, int port) async {
     final stopwatch = Stopwatch()..start();
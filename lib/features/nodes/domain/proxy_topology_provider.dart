@@ -0,0 +1,98 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:flutter_riverpod/flutter_riverpod.dart';
+
+import '../../../core/platform/platform_channel_service.dart';
+import '../../../core/vpn/vpn_service.dart';
+import '../../../core/utils/logger.dart';
+
+/// 节点页使用的代理组拓扑
+///
+/// [ProxyTopology] 是原地修改的，每次变更都换一个新的 state 并带上版本号，
+/// 以便 Riverpod 通知页面重建
+class TopologyState {
+  final ProxyTopology? topology;
+  final int version;
+
+  const TopologyState({this.topology, this.version = 0});
+
+  /// 核心报告的代理组；核心未运行或拓扑不可用时为空
+  Iterable<TopologyGroup> get groups =>
+      topology?.groups.values ?? const <TopologyGroup>[];
+
+  /// 核心最近一次测得的延迟；0 为失败，未测试或未知时为 null
+  int? delayOf(String name) {
+    final delay = topology?.proxies[name]?.delay;
+    if (delay == null || delay < 0) return null;
+    return delay;
+  }
+}
+
+/// 以原生拓扑快照为初值，之后只应用 proxy_topology 增量事件；
+/// 漏掉变更或核心重新连接时重新取快照
+class ProxyTopologyNotifier extends StateNotifier<TopologyState> {
+  StreamSubscription? _changesSubscription;
+  StreamSubscription? _stateSubscription;
+  bool _loading = false;
+
+  ProxyTopologyNotifier() : super(const TopologyState()) {
+    _init();
+  }
+
+  Future<void> _init() async {
+    if (!Platform.isWindows) return;
+
+    _changesSubscription = PlatformChannelService.instance.proxyTopologyStream
+        .listen(_onChanges);
+    _stateSubscription = VpnService.instance.stateStream.listen((vpnState) {
+      if (vpnState == VpnState.connected) reload();
+    });
+
+    await PlatformChannelService.instance.watchProxyTopology();
+    await reload();
+  }
+
+  /// 重新取快照
+  Future<void> reload() async {
+    if (_loading) return;
+    _loading = true;
+    try {
+      final topology = await PlatformChannelService.instance.getProxyTopology();
+      if (!mounted) return;
+      state = TopologyState(
+        topology: topology,
+        version: topology?.version ?? 0,
+      );
+    } finally {
+      _loading = false;
+    }
+  }
+
+  void _onChanges(Map<String, dynamic> changes) {
+    final topology = state.topology;
+    if (topology == null) {
+      reload();
+      return;
+    }
+    if (!topology.apply(changes)) {
+      VortexLogger.d('Proxy topology missed a change, reloading snapshot');
+      reload();
+      return;
+    }
+    state = TopologyState(topology: topology, version: topology.version);
+  }
+
+  @override
+  void dispose() {
+    _changesSubscription?.cancel();
+    _stateSubscription?.cancel();
+    PlatformChannelService.instance.unwatchProxyTopology();
+    super.dispose();
+  }
+}
+
+final proxyTopologyProvider =
+    StateNotifierProvider<ProxyTopologyNotifier, TopologyState>((ref) {
+      return ProxyTopologyNotifier();
+    });
@@ -6,6 +6,7 @@ import 'package:google_fonts/google_fonts.dart';
 import '../../../../shared/models/proxy_node.dart';
 import '../../../../shared/themes/app_theme.dart';
 import '../../domain/nodes_provider.dart';
+import '../../domain/proxy_topology_provider.dart';
 import '../../../dashboard/domain/connection_provider.dart';
 
 class NodesPage extends ConsumerWidget {
@@ -15,6 +16,7 @@ class NodesPage extends ConsumerWidget {
   Widget build(BuildContext context, WidgetRef ref) {
     final nodesState = ref.watch(nodesProvider);
     final connectionState = ref.watch(connectionProvider);
+    final topologyState = ref.watch(proxyTopologyProvider);
     final theme = Theme.of(context);
 
     return Scaffold(
@@ -91,7 +93,13 @@ class NodesPage extends ConsumerWidget {
                   ? const Center(child: CircularProgressIndicator())
                   : nodesState.nodes.isEmpty
                   ? _buildEmptyState(context)
-                  : _buildNodesList(context, ref, nodesState, connectionState),
+                  : _buildNodesList(
+                      context,
+                      ref,
+                      nodesState,
+                      connectionState,
+                      topologyState,
+                    ),
             ),
           ],
         ),
@@ -129,10 +137,27 @@ class NodesPage extends ConsumerWidget {
     WidgetRef ref,
     NodesState nodesState,
     VpnConnectionState connectionState,
+    TopologyState topologyState,
   ) {
-    // Group nodes by group name
+    // 核心运行时按其代理组分组，组内顺序和当前选择都来自拓扑；
+    // 不在任何代理组里的节点仍按订阅分组
+    final byName = {for (final node in nodesState.nodes) node.name: node};
     final groupedNodes = <String, List<ProxyNode>>{};
+    final selections = <String, String>{};
+    final placed = <String>{};
+    for (final group in topologyState.groups) {
+      if (group.name == 'GLOBAL') continue;
+      final members = group.members
+          .map((name) => byName[name])
+          .whereType<ProxyNode>()
+          .toList();
+      if (members.isEmpty) continue;
+      groupedNodes[group.name] = members;
+      selections[group.name] = group.now;
+      placed.addAll(members.map((node) => node.id));
+    }
     for (final node in nodesState.nodes) {
+      if (placed.contains(node.id)) continue;
       final group = node.group ?? '默认分组';
       groupedNodes.putIfAbsent(group, () => []).add(node);
     }
@@ -150,7 +175,9 @@ class NodesPage extends ConsumerWidget {
             Padding(
               padding: const EdgeInsets.symmetric(vertical: 16),
               child: Text(
-                group,
+                (selections[group] ?? '').isEmpty
+                    ? group
+                    : '$group · ${selections[group]}',
                 style: GoogleFonts.outfit(
                   fontSize: 14,
                   fontWeight: FontWeight.w600,
@@ -165,9 +192,13 @@ class NodesPage extends ConsumerWidget {
                         node: node,
                         isConnected:
                             connectionState.connectedNode?.id == node.id,
-                        latency: nodesState.latencies[node.id],
+                        latency: nodesState.latencies.containsKey(node.id)
+                            ? nodesState.latencies[node.id]
+                            : _topologyLatency(topologyState, node),
                         isTesting: nodesState.isTesting,
-                        hasTested: nodesState.latencies.containsKey(node.id),
+                        hasTested:
+                            nodesState.latencies.containsKey(node.id) ||
+                            topologyState.delayOf(node.name) != null,
                         onTap: () {
                           ref
                               .read(connectionProvider.notifier)
@@ -184,6 +215,12 @@ class NodesPage extends ConsumerWidget {
       },
     );
   }
+
+  /// 核心报告的延迟；0 表示测试失败，与本地测速一样显示为超时
+  int? _topologyLatency(TopologyState topologyState, ProxyNode node) {
+    final delay = topologyState.delayOf(node.name);
+    return delay == null || delay == 0 ? null : delay;
+  }
 }
 
 class _NodeTile extends StatelessWidget {
@@ -0,0 +1,933 @@
+// ignore_for_file: avoid_print
+
+/// 端到端 mixed-port 基准测试
+///
+/// 测量用户真正感受到的数据路径：负载生成器 → mixed-port → 内核 →
+/// 本地 SOCKS5 上游 → 本地 HTTP 源站。每个配置档位 (profile) 生成一份
+/// 内核配置，启动内核，以 N 个并发连接持续请求，输出请求延迟分位数、
+/// 吞吐量以及内核进程的 CPU 与 RSS，便于客观比较规则、DNS、嗅探等
+/// 配置生成改动的影响。
+///
+/// 只依赖 dart:io，可在 Linux 上直接运行：
+///
+///   dart run tool/bench/mixed_port_bench.dart --core ./mihomo \
+///       --profiles baseline,rules,dns,sniffing --concurrency 32 --duration 15
+///
+/// 不指定 --core 时启动一个本地替身代理 (只转发，不解析配置)，
+/// 用于验证测试链路本身或得到不含内核开销的基线。
+///
+/// --idle 模式不施加负载，只测量内核空闲时每个线程的唤醒次数
+/// (/proc/<pid>/task/*/status 中的上下文切换)、CPU 与读写类系统调用，
+/// 超出 --idle-wakeups / --idle-cpu / --idle-syscalls 预算时以非零状态退出：
+///
+///   dart run tool/bench/mixed_port_bench.dart --core ./mihomo \
+///       --idle 30 --idle-wakeups 20 --idle-cpu 1
+library;
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+/// 配置档位：在基础配置之上追加的顶层配置和位于 MATCH 之前的规则
+class BenchProfile {
+  final String name;
+  final String description;
+  final String extra;
+  final List<String> rules;
+
+  const BenchProfile(
+    this.name,
+    this.description, {
+    this.extra = '',
+    this.rules = const [],
+  });
+}
+
+final Map<String, BenchProfile> _profiles = {
+  'baseline': const BenchProfile('baseline', '无 DNS、无额外规则'),
+  'rules': BenchProfile(
+    'rules',
+    '3000 条域名后缀与 1000 条 IP-CIDR 规则 (需要解析)',
+    rules: [
+      for (var i = 0; i < 3000; i++) 'DOMAIN-SUFFIX,bench-$i.example,DIRECT',
+      for (var i = 0; i < 1000; i++)
+        'IP-CIDR,10.${i ~/ 256}.${i % 256}.0/24,DIRECT',
+    ],
+  ),
+  'dns': const BenchProfile(
+    'dns',
+    '启用内核 DNS (fake-ip) 并要求解析目标',
+    extra: '''
+dns:
+  enable: true
+  enhanced-mode: fake-ip
+  fake-ip-range: 198.18.0.1/16
+  fake-ip-filter:
+    - localhost
+  nameserver:
+    - system
+''',
+    rules: ['IP-CIDR,10.255.0.0/16,DIRECT'],
+  ),
+  'sniffing': const BenchProfile(
+    'sniffing',
+    '启用 HTTP/TLS 嗅探',
+    extra: '''
+sniffer:
+  enable: true
+  force-dns-mapping: true
+  parse-pure-ip: true
+  sniff:
+    HTTP:
+      ports: [1-65535]
+      override-destination: false
+    TLS:
+      ports: [443]
+''',
+  ),
+};
+
+class _Options {
+  String? corePath;
+  List<String> profiles = ['baseline'];
+  int concurrency = 16;
+  Duration duration = const Duration(seconds: 10);
+  Duration warmup = const Duration(seconds: 2);
+  int responseBytes = 16 * 1024;
+  bool keepAlive = true;
+  String host = 'localhost';
+  String? jsonPath;
+
+  /// 空闲测量时长，设置后不施加负载
+  Duration? idle;
+  double? idleWakeups;
+  double? idleCpu;
+  double? idleSyscalls;
+}
+
+Future<void> main(List<String> args) async {
+  if (args.isNotEmpty && args.first == '--stand-in') {
+    await _runStandIn(int.parse(args[1]), int.parse(args[2]));
+    return;
+  }
+
+  final options = _parseArgs(args);
+  if (options == null) {
+    _printUsage();
+    exitCode = 64;
+    return;
+  }
+
+  final upstream = await _Upstream.start();
+  print(
+    'Origin on :${upstream.originPort}, SOCKS5 upstream on :${upstream.socksPort}',
+  );
+
+  final results = <Map<String, Object?>>[];
+  try {
+    for (final name in options.profiles) {
+      final profile = _profiles[name]!;
+      final result = await _runProfile(profile, options, upstream);
+      results.add(result);
+      if (options.idle != null) {
+        _printIdleResult(result);
+      } else {
+        _printResult(result);
+      }
+    }
+  } finally {
+    upstream.stop();
+  }
+
+  if (options.idle != null) {
+    if (results.any((r) => (r['overBudget'] as List).isNotEmpty)) {
+      exitCode = 1;
+    }
+  } else if (results.length > 1) {
+    _printTable(results);
+  }
+  if (options.jsonPath != null) {
+    await File(
+      options.jsonPath!,
+    ).writeAsString(const JsonEncoder.withIndent('  ').convert(results));
+    print('Results written to ${options.jsonPath}');
+  }
+}
+
+_Options? _parseArgs(List<String> args) {
+  final options = _Options();
+  for (var i = 0; i < args.length; i++) {
+    final arg = args[i];
+    String value() {
+      if (i + 1 >= args.length) throw FormatException('$arg needs a value');
+      return args[++i];
+    }
+
+    try {
+      switch (arg) {
+        case '--core':
+          options.corePath = value();
+        case '--profiles':
+          options.profiles = value().split(',').map((e) => e.trim()).toList();
+        case '--concurrency':
+          options.concurrency = int.parse(value());
+        case '--duration':
+          options.duration = Duration(seconds: int.parse(value()));
+        case '--warmup':
+          options.warmup = Duration(seconds: int.parse(value()));
+        case '--size':
+          options.responseBytes = int.parse(value());
+        case '--no-keep-alive':
+          options.keepAlive = false;
+        case '--host':
+          options.host = value();
+        case '--json':
+          options.jsonPath = value();
+        case '--idle':
+          options.idle = Duration(seconds: int.parse(value()));
+        case '--idle-wakeups':
+          options.idleWakeups = double.parse(value());
+        case '--idle-cpu':
+          options.idleCpu = double.parse(value());
+        case '--idle-syscalls':
+          options.idleSyscalls = double.parse(value());
+        default:
+          print('Unknown option $arg');
+          return null;
+      }
+    } on FormatException catch (e) {
+      print(e.message);
+      return null;
+    }
+  }
+
+  for (final name in options.profiles) {
+    if (!_profiles.containsKey(name)) {
+      print('Unknown profile $name');
+      return null;
+    }
+  }
+  if (options.concurrency < 1 || options.duration.inSeconds < 1) return null;
+  if (options.idle != null && options.idle!.inSeconds < 1) return null;
+  return options;
+}
+
+void _printUsage() {
+  print('''
+Usage: dart run tool/bench/mixed_port_bench.dart [options]
+
+  --core <path>        mihomo binary; without it a stand-in proxy is used
+  --profiles <a,b>     ${_profiles.keys.join(', ')} (default baseline)
+  --concurrency <n>    Concurrent connections (default 16)
+  --duration <s>       Measured seconds per profile (default 10)
+  --warmup <s>         Unmeasured seconds before that (default 2)
+  --size <bytes>       Response body size (default 16384)
+  --no-keep-alive      New connection for every request
+  --host <name>        Host used in request URLs (default localhost)
+  --json <file>        Also write the results as JSON
+  --idle <s>           Measure the idle core for s seconds instead of loading it
+  --idle-wakeups <n>   Fail when its threads wake more than n times per second
+  --idle-cpu <pct>     Fail above this CPU percentage
+  --idle-syscalls <n>  Fail above n read/write syscalls per second
+''');
+}
+
+// ---------------------------------------------------------------------------
+// 上游：源站与 SOCKS5 代理在独立 isolate 中运行，避免与负载生成器争用
+
+class _Upstream {
+  final Isolate isolate;
+  final int originPort;
+  final int socksPort;
+
+  _Upstream(this.isolate, this.originPort, this.socksPort);
+
+  static Future<_Upstream> start() async {
+    final ready = ReceivePort();
+    final isolate = await Isolate.spawn(_serveUpstream, ready.sendPort);
+    final ports = (await ready.first as List).cast<int>();
+    return _Upstream(isolate, ports[0], ports[1]);
+  }
+
+  void stop() => isolate.kill(priority: Isolate.immediate);
+}
+
+Future<void> _serveUpstream(SendPort ready) async {
+  final payloads = <int, Uint8List>{};
+
+  final origin = await HttpServer.bind(InternetAddress.loopbackIPv4, 0);
+  origin.listen((request) async {
+    // /bytes/<n> 返回 n 字节
+    final segments = request.uri.pathSegments;
+    final size = segments.length == 2 && segments[0] == 'bytes'
+        ? int.tryParse(segments[1]) ?? 0
+        : 0;
+    final body = payloads.putIfAbsent(size, () => Uint8List(size));
+    request.response
+      ..headers.contentType = ContentType.binary
+      ..contentLength = body.length
+      ..add(body);
+    await request.response.close();
+  });
+
+  final socks = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+  socks.listen(_handleSocks);
+
+  ready.send([origin.port, socks.port]);
+}
+
+/// 按需读取固定字节数，剩余数据留给后续转发
+class _SocketReader {
+  final StreamIterator<Uint8List> _iterator;
+  final BytesBuilder _buffer = BytesBuilder(copy: false);
+
+  _SocketReader(Stream<Uint8List> stream)
+    : _iterator = StreamIterator(stream);
+
+  Future<Uint8List?> read(int count) async {
+    while (_buffer.length < count) {
+      if (!await _iterator.moveNext()) return null;
+      _buffer.add(_iterator.current);
+    }
+    final all = _buffer.takeBytes();
+    _buffer.add(Uint8List.sublistView(all, count));
+    return Uint8List.sublistView(all, 0, count);
+  }
+
+  /// 读到 \r\n\r\n 为止 (HTTP 请求头)
+  Future<Uint8List?> readHead() async {
+    while (true) {
+      final bytes = _buffer.toBytes();
+      for (var i = 3; i < bytes.length; i++) {
+        if (bytes[i - 3] == 13 &&
+            bytes[i - 2] == 10 &&
+            bytes[i - 1] == 13 &&
+            bytes[i] == 10) {
+          return read(i + 1);
+        }
+      }
+      if (bytes.length > 64 * 1024) return null;
+      if (!await _iterator.moveNext()) return null;
+      _buffer.add(_iterator.current);
+    }
+  }
+
+  /// 把已缓冲的数据和之后的全部数据写入 [sink]
+  Future<void> pipeTo(Socket sink) async {
+    if (_buffer.isNotEmpty) sink.add(_buffer.takeBytes());
+    try {
+      while (await _iterator.moveNext()) {
+        sink.add(_iterator.current);
+      }
+    } catch (_) {}
+    await sink.close().catchError((_) {});
+  }
+}
+
+Future<void> _handleSocks(Socket client) async {
+  final reader = _SocketReader(client);
+  Socket? target;
+  try {
+    // 问候：只接受无认证
+    final greeting = await reader.read(2);
+    if (greeting == null || greeting[0] != 5) throw const SocketException('bad greeting');
+    if (await reader.read(greeting[1]) == null) throw const SocketException('eof');
+    client.add([5, 0]);
+
+    final request = await reader.read(4);
+    if (request == null || request[1] != 1) throw const SocketException('not CONNECT');
+
+    late final String host;
+    switch (request[3]) {
+      case 1:
+        host = InternetAddress.fromRawAddress((await reader.read(4))!).address;
+      case 3:
+        final length = (await reader.read(1))![0];
+        host = ascii.decode((await reader.read(length))!);
+      case 4:
+        host = InternetAddress.fromRawAddress((await reader.read(16))!).address;
+      default:
+        throw const SocketException('bad address type');
+    }
+    final portBytes = (await reader.read(2))!;
+    final port = (portBytes[0] << 8) | portBytes[1];
+
+    target = await Socket.connect(host, port);
+    target.setOption(SocketOption.tcpNoDelay, true);
+    client.add([5, 0, 0, 1, 0, 0, 0, 0, 0, 0]);
+
+    await Future.wait([reader.pipeTo(target), _pipe(target, client)]);
+  } catch (_) {
+    target?.destroy();
+    client.destroy();
+  }
+}
+
+Future<void> _pipe(Socket from, Socket to) async {
+  try {
+    await to.addStream(from);
+  } catch (_) {}
+  await to.close().catchError((_) {});
+}
+
+// ---------------------------------------------------------------------------
+// 替身代理：mixed-port 的最小实现 (HTTP CONNECT 与绝对 URI 转发)，经 SOCKS5 上游出站
+
+Future<void> _runStandIn(int port, int socksPort) async {
+  final server = await ServerSocket.bind(InternetAddress.loopbackIPv4, port);
+  await for (final client in server) {
+    unawaited(_handleStandIn(client, socksPort));
+  }
+}
+
+Future<void> _handleStandIn(Socket client, int socksPort) async {
+  final reader = _SocketReader(client);
+  Socket? upstream;
+  try {
+    final head = await reader.readHead();
+    if (head == null) throw const SocketException('no request');
+    final requestLine = latin1.decode(head).split('\r\n').first.split(' ');
+    if (requestLine.length < 2) throw const SocketException('bad request');
+
+    final isConnect = requestLine[0] == 'CONNECT';
+    final uri = isConnect
+        ? Uri.parse('tcp://${requestLine[1]}')
+        : Uri.parse(requestLine[1]);
+    final port = uri.hasPort ? uri.port : 80;
+
+    upstream = await Socket.connect(InternetAddress.loopbackIPv4, socksPort);
+    upstream.setOption(SocketOption.tcpNoDelay, true);
+    final hostBytes = ascii.encode(uri.host);
+    // 问候与 CONNECT 请求一并发出
+    upstream.add([5, 1, 0]);
+    upstream.add([5, 1, 0, 3, hostBytes.length, ...hostBytes]);
+    upstream.add([port >> 8, port & 0xFF]);
+    final upstreamReader = _SocketReader(upstream);
+    final reply = await upstreamReader.read(2 + 10);
+    if (reply == null || reply[3] != 0) throw const SocketException('upstream refused');
+
+    // 同一连接上的后续请求假定发往同一源站，原样转发
+    if (isConnect) {
+      client.add(latin1.encode('HTTP/1.1 200 Connection established\r\n\r\n'));
+    } else {
+      upstream.add(head);
+    }
+    await Future.wait([reader.pipeTo(upstream), upstreamReader.pipeTo(client)]);
+  } catch (_) {
+    upstream?.destroy();
+    client.destroy();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// 单个档位：生成配置、启动内核、施加负载、采样资源
+
+Future<Map<String, Object?>> _runProfile(
+  BenchProfile profile,
+  _Options options,
+  _Upstream upstream,
+) async {
+  final mixedPort = await _freePort();
+  final workDir = await Directory.systemTemp.createTemp('vortex_bench_');
+  Process? core;
+
+  try {
+    final Process process;
+    if (options.corePath != null) {
+      final controllerPort = await _freePort();
+      final configPath = '${workDir.path}/config.yaml';
+      await File(configPath).writeAsString(
+        _buildConfig(profile, mixedPort, controllerPort, upstream.socksPort),
+      );
+      process = await Process.start(options.corePath!, [
+        '-d',
+        workDir.path,
+        '-f',
+        configPath,
+      ]);
+    } else {
+      process = await Process.start(Platform.resolvedExecutable, [
+        Platform.script.toFilePath(),
+        '--stand-in',
+        '$mixedPort',
+        '${upstream.socksPort}',
+      ]);
+    }
+    core = process;
+    final coreOutput = StringBuffer();
+    process.stdout.transform(utf8.decoder).listen(coreOutput.write);
+    process.stderr.transform(utf8.decoder).listen(coreOutput.write);
+
+    if (!await _waitForPort(mixedPort, const Duration(seconds: 15))) {
+      throw StateError('core did not open mixed-port:\n$coreOutput');
+    }
+
+    if (options.idle != null) {
+      await Future.delayed(options.warmup);
+      return {
+        'profile': profile.name,
+        'description': profile.description,
+        'core': options.corePath ?? 'stand-in',
+        ...await _measureIdle(process.pid, options),
+      };
+    }
+
+    final sampler = _ProcessSampler(process.pid);
+    final url = Uri.parse(
+      'http://${options.host}:${upstream.originPort}/bytes/${options.responseBytes}',
+    );
+    final load = await _generateLoad(url, mixedPort, options, sampler);
+
+    return {
+      'profile': profile.name,
+      'description': profile.description,
+      'core': options.corePath ?? 'stand-in',
+      'concurrency': options.concurrency,
+      'keepAlive': options.keepAlive,
+      'responseBytes': options.responseBytes,
+      ...load,
+      ...sampler.summary(),
+    };
+  } finally {
+    final process = core;
+    if (process != null) {
+      process.kill();
+      await process.exitCode.timeout(
+        const Duration(seconds: 5),
+        onTimeout: () {
+          process.kill(ProcessSignal.sigkill);
+          return -1;
+        },
+      );
+    }
+    await workDir.delete(recursive: true).catchError((_) => workDir);
+  }
+}
+
+String _buildConfig(
+  BenchProfile profile,
+  int mixedPort,
+  int controllerPort,
+  int socksPort,
+) {
+  final buffer = StringBuffer();
+  buffer.writeln('# Vortex Bench Config (${profile.name})');
+  buffer.writeln('mixed-port: $mixedPort');
+  buffer.writeln('allow-lan: false');
+  buffer.writeln('mode: rule');
+  buffer.writeln('log-level: error');
+  buffer.writeln('external-controller: 127.0.0.1:$controllerPort');
+  buffer.writeln();
+  if (profile.extra.isNotEmpty) {
+    buffer.writeln(profile.extra);
+  }
+  buffer.writeln('proxies:');
+  buffer.writeln('  - name: upstream');
+  buffer.writeln('    type: socks5');
+  buffer.writeln('    server: 127.0.0.1');
+  buffer.writeln('    port: $socksPort');
+  buffer.writeln();
+  buffer.writeln('rules:');
+  for (final rule in profile.rules) {
+    buffer.writeln('  - $rule');
+  }
+  buffer.writeln('  - MATCH,upstream');
+  return buffer.toString();
+}
+
+Future<int> _freePort() async {
+  final socket = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+  final port = socket.port;
+  await socket.close();
+  return port;
+}
+
+Future<bool> _waitForPort(int port, Duration timeout) async {
+  final deadline = DateTime.now().add(timeout);
+  while (DateTime.now().isBefore(deadline)) {
+    try {
+      final socket = await Socket.connect(
+        InternetAddress.loopbackIPv4,
+        port,
+        timeout: const Duration(milliseconds: 200),
+      );
+      socket.destroy();
+      return true;
+    } on SocketException {
+      await Future.delayed(const Duration(milliseconds: 100));
+    }
+  }
+  return false;
+}
+
+Future<Map<String, Object?>> _generateLoad(
+  Uri url,
+  int proxyPort,
+  _Options options,
+  _ProcessSampler sampler,
+) async {
+  final latencies = <int>[]; // 微秒
+  var bytes = 0;
+  var errors = 0;
+  var measuring = false;
+
+  final warmupEnd = DateTime.now().add(options.warmup);
+  final deadline = warmupEnd.add(options.duration);
+
+  Future<void> worker() async {
+    final client = HttpClient()
+      ..findProxy = ((_) => 'PROXY 127.0.0.1:$proxyPort')
+      ..maxConnectionsPerHost = 1
+      ..connectionTimeout = const Duration(seconds: 10);
+    final stopwatch = Stopwatch();
+    try {
+      while (DateTime.now().isBefore(deadline)) {
+        stopwatch
+          ..reset()
+          ..start();
+        try {
+          final request = await client.getUrl(url);
+          request.persistentConnection = options.keepAlive;
+          final response = await request.close();
+          var received = 0;
+          await for (final chunk in response) {
+            received += chunk.length;
+          }
+          stopwatch.stop();
+          if (!measuring) continue;
+          if (response.statusCode != 200 || received != options.responseBytes) {
+            errors++;
+            continue;
+          }
+          latencies.add(stopwatch.elapsedMicroseconds);
+          bytes += received;
+        } catch (_) {
+          if (measuring) errors++;
+        }
+      }
+    } finally {
+      client.close(force: true);
+    }
+  }
+
+  final workers = [for (var i = 0; i < options.concurrency; i++) worker()];
+
+  await Future.delayed(options.warmup);
+  measuring = true;
+  final measured = Stopwatch()..start();
+  sampler.start();
+  await Future.wait(workers);
+  measured.stop();
+  await sampler.stop();
+
+  latencies.sort();
+  double percentile(int p) {
+    if (latencies.isEmpty) return -1;
+    final rank = (latencies.length * p + 99) ~/ 100;
+    return latencies[(rank < 1 ? 1 : rank) - 1] / 1000.0;
+  }
+
+  final seconds = measured.elapsedMicroseconds / 1e6;
+  return {
+    'requests': latencies.length,
+    'errors': errors,
+    'p50Ms': percentile(50),
+    'p90Ms': percentile(90),
+    'p99Ms': percentile(99),
+    'maxMs': latencies.isEmpty ? -1 : latencies.last / 1000.0,
+    'requestsPerSecond': latencies.length / seconds,
+    'throughputMBps': bytes / seconds / (1024 * 1024),
+  };
+}
+
+// ---------------------------------------------------------------------------
+// 空闲开销 (/proc/<pid>/task)
+
+class _TaskCounters {
+  final String name;
+  final int switches;
+  final int cpuTicks;
+
+  _TaskCounters(this.name, this.switches, this.cpuTicks);
+}
+
+/// 每个线程的名称、自愿与非自愿上下文切换之和以及 utime + stime
+Map<int, _TaskCounters> _readTasks(int pid) {
+  final tasks = <int, _TaskCounters>{};
+  final dir = Directory('/proc/$pid/task');
+  if (!dir.existsSync()) return tasks;
+  for (final entry in dir.listSync()) {
+    final tid = int.tryParse(entry.path.split('/').last);
+    if (tid == null) continue;
+    try {
+      var name = '';
+      var switches = 0;
+      for (final line in File('${entry.path}/status').readAsLinesSync()) {
+        if (line.startsWith('Name:')) {
+          name = line.substring(5).trim();
+        } else if (line.startsWith('voluntary_ctxt_switches:') ||
+            line.startsWith('nonvoluntary_ctxt_switches:')) {
+          switches += int.parse(line.split(RegExp(r'\s+'))[1]);
+        }
+      }
+      final stat = File('${entry.path}/stat').readAsStringSync();
+      final fields = stat.substring(stat.lastIndexOf(')') + 2).split(' ');
+      tasks[tid] = _TaskCounters(
+        name,
+        switches,
+        int.parse(fields[11]) + int.parse(fields[12]),
+      );
+    } catch (_) {
+      // 线程在读取期间退出
+    }
+  }
+  return tasks;
+}
+
+/// read/write 类系统调用次数 (/proc/<pid>/io 的 syscr + syscw)
+int? _readSyscalls(int pid) {
+  try {
+    var total = 0;
+    for (final line in File('/proc/$pid/io').readAsLinesSync()) {
+      if (line.startsWith('syscr:') || line.startsWith('syscw:')) {
+        total += int.parse(line.split(RegExp(r'\s+'))[1]);
+      }
+    }
+    return total;
+  } catch (_) {
+    return null;
+  }
+}
+
+Future<Map<String, Object?>> _measureIdle(int pid, _Options options) async {
+  if (!Platform.isLinux) {
+    throw UnsupportedError('--idle reads /proc and needs Linux');
+  }
+  final clock = await Process.run('getconf', ['CLK_TCK']);
+  final clockTicks = int.tryParse(clock.stdout.toString().trim()) ?? 100;
+
+  final before = _readTasks(pid);
+  final syscallsBefore = _readSyscalls(pid);
+  final elapsed = Stopwatch()..start();
+  await Future.delayed(options.idle!);
+  elapsed.stop();
+  final after = _readTasks(pid);
+  final syscallsAfter = _readSyscalls(pid);
+  final seconds = elapsed.elapsedMicroseconds / 1e6;
+
+  // 按线程名汇总；窗口内新建的线程从零计起
+  final byName = <String, List<num>>{};
+  var switches = 0;
+  var ticks = 0;
+  after.forEach((tid, task) {
+    final base = before[tid];
+    final deltaSwitches = task.switches - (base?.switches ?? 0);
+    final deltaTicks = task.cpuTicks - (base?.cpuTicks ?? 0);
+    switches += deltaSwitches;
+    ticks += deltaTicks;
+    final group = byName.putIfAbsent(task.name, () => [0, 0, 0]);
+    group[0] += 1;
+    group[1] += deltaSwitches;
+    group[2] += deltaTicks;
+  });
+
+  final wakeups = switches / seconds;
+  final cpu = ticks / clockTicks / seconds * 100;
+  final syscalls = syscallsBefore == null || syscallsAfter == null
+      ? null
+      : (syscallsAfter - syscallsBefore) / seconds;
+
+  final overBudget = <String>[
+    if (options.idleWakeups != null && wakeups > options.idleWakeups!)
+      'wakeups',
+    if (options.idleCpu != null && cpu > options.idleCpu!) 'cpu',
+    if (options.idleSyscalls != null &&
+        syscalls != null &&
+        syscalls > options.idleSyscalls!)
+      'syscalls',
+  ];
+
+  final threads = byName.entries.toList()
+    ..sort((a, b) => b.value[1].compareTo(a.value[1]));
+  return {
+    'idleSeconds': seconds,
+    'threads': after.length,
+    'wakeupsPerSecond': wakeups,
+    'cpuPercent': cpu,
+    'syscallsPerSecond': syscalls,
+    'byThreadName': [
+      for (final entry in threads)
+        {
+          'name': entry.key,
+          'threads': entry.value[0],
+          'wakeupsPerSecond': entry.value[1] / seconds,
+          'cpuPercent': entry.value[2] / clockTicks / seconds * 100,
+        },
+    ],
+    'budget': {
+      'wakeupsPerSecond': options.idleWakeups,
+      'cpuPercent': options.idleCpu,
+      'syscallsPerSecond': options.idleSyscalls,
+    },
+    'overBudget': overBudget,
+  };
+}
+
+// ---------------------------------------------------------------------------
+// 进程资源采样 (/proc)
+
+class _ProcessSampler {
+  final int pid;
+  final List<int> _rssKb = [];
+  Timer? _timer;
+  int _clockTicks = 100;
+  int? _startTicks;
+  int? _endTicks;
+  final Stopwatch _elapsed = Stopwatch();
+
+  _ProcessSampler(this.pid);
+
+  void start() {
+    if (!Platform.isLinux) return;
+    Process.run('getconf', ['CLK_TCK']).then((result) {
+      _clockTicks = int.tryParse(result.stdout.toString().trim()) ?? 100;
+    }).catchError((_) {});
+    _startTicks = _cpuTicks();
+    _elapsed.start();
+    _timer = Timer.periodic(const Duration(milliseconds: 250), (_) {
+      final rss = _rss();
+      if (rss != null) _rssKb.add(rss);
+    });
+  }
+
+  Future<void> stop() async {
+    _timer?.cancel();
+    _elapsed.stop();
+    _endTicks = _cpuTicks();
+  }
+
+  Map<String, Object?> summary() {
+    if (!Platform.isLinux || _startTicks == null || _endTicks == null) {
+      return {'cpuPercent': null, 'rssMeanMB': null, 'rssPeakMB': null};
+    }
+    final seconds = _elapsed.elapsedMicroseconds / 1e6;
+    final cpu = (_endTicks! - _startTicks!) / _clockTicks / seconds * 100;
+    final mean = _rssKb.isEmpty
+        ? 0.0
+        : _rssKb.reduce((a, b) => a + b) / _rssKb.length / 1024;
+    final peak = _rssKb.isEmpty
+        ? 0.0
+        : _rssKb.reduce((a, b) => a > b ? a : b) / 1024;
+    return {'cpuPercent': cpu, 'rssMeanMB': mean, 'rssPeakMB': peak};
+  }
+
+  /// utime + stime，字段位于进程名之后
+  int? _cpuTicks() {
+    try {
+      final stat = File('/proc/$pid/stat').readAsStringSync();
+      final fields = stat.substring(stat.lastIndexOf(')') + 2).split(' ');
+      return int.parse(fields[11]) + int.parse(fields[12]);
+    } catch (_) {
+      return null;
+    }
+  }
+
+  int? _rss() {
+    try {
+      for (final line in File('/proc/$pid/status').readAsLinesSync()) {
+        if (line.startsWith('VmRSS:')) {
+          return int.parse(line.split(RegExp(r'\s+'))[1]);
+        }
+      }
+    } catch (_) {}
+    return null;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// 输出
+
+String _fixed(Object? value, [int digits = 1]) =>
+    value is num ? value.toStringAsFixed(digits) : '-';
+
+void _printResult(Map<String, Object?> result) {
+  print('');
+  print('[${result['profile']}] ${result['description']}');
+  print(
+    '  requests ${result['requests']}, errors ${result['errors']}, '
+    '${_fixed(result['requestsPerSecond'])} req/s, '
+    '${_fixed(result['throughputMBps'], 2)} MB/s',
+  );
+  print(
+    '  latency p50 ${_fixed(result['p50Ms'], 2)} ms, '
+    'p90 ${_fixed(result['p90Ms'], 2)} ms, '
+    'p99 ${_fixed(result['p99Ms'], 2)} ms, '
+    'max ${_fixed(result['maxMs'], 2)} ms',
+  );
+  print(
+    '  core cpu ${_fixed(result['cpuPercent'])}%, '
+    'rss mean ${_fixed(result['rssMeanMB'])} MB, '
+    'peak ${_fixed(result['rssPeakMB'])} MB',
+  );
+}
+
+void _printIdleResult(Map<String, Object?> result) {
+  print('');
+  print('[${result['profile']}] idle ${_fixed(result['idleSeconds'])} s');
+  print(
+    '  ${result['threads']} threads, '
+    '${_fixed(result['wakeupsPerSecond'], 2)} wakeups/s, '
+    'cpu ${_fixed(result['cpuPercent'], 2)}%, '
+    '${_fixed(result['syscallsPerSecond'])} read/write syscalls/s',
+  );
+  for (final group in (result['byThreadName'] as List).take(8)) {
+    final entry = group as Map<String, Object?>;
+    print(
+      '    ${'${entry['name']}'.padRight(16)} x${entry['threads']}  '
+      '${_fixed(entry['wakeupsPerSecond'], 2)} wakeups/s, '
+      'cpu ${_fixed(entry['cpuPercent'], 2)}%',
+    );
+  }
+  final over = result['overBudget'] as List;
+  if (over.isNotEmpty) {
+    print('  BUDGET EXCEEDED: ${over.join(', ')}');
+  }
+}
+
+void _printTable(List<Map<String, Object?>> results) {
+  const header = [
+    'profile', 'req/s', 'MB/s', 'p50', 'p90', 'p99', 'err', 'cpu%', 'rss MB',
+  ];
+  final rows = [
+    for (final r in results)
+      [
+        '${r['profile']}',
+        _fixed(r['requestsPerSecond']),
+        _fixed(r['throughputMBps'], 2),
+        _fixed(r['p50Ms'], 2),
+        _fixed(r['p90Ms'], 2),
+        _fixed(r['p99Ms'], 2),
+        '${r['errors']}',
+        _fixed(r['cpuPercent']),
+        _fixed(r['rssPeakMB']),
+      ],
+  ];
+  final widths = [
+    for (var i = 0; i < header.length; i++)
+      [header[i], ...rows.map((row) => row[i])]
+          .map((cell) => cell.length)
+          .reduce((a, b) => a > b ? a : b),
+  ];
+  String line(List<String> cells) => [
+    for (var i = 0; i < cells.length; i++)
+      i == 0 ? cells[i].padRight(widths[i]) : cells[i].padLeft(widths[i]),
+  ].join('  ');
+
+  print('');
+  print(line(header));
+  for (final row in rows) {
+    print(line(row));
+  }
+}
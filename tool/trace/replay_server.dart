@@ -0,0 +1,495 @@
+// ignore_for_file: avoid_print
+
+/// 控制器流量回放服务器
+///
+/// 读取原生端 ControllerTrace 录制的 .vxtr 文件 (格式见
+/// windows/runner/controller_trace.h)，在本地扮演内核控制器：
+/// - 普通请求按方法与路径返回录制的状态码与响应体，同一路径多次录制时依次轮换；
+///   修改类请求优先返回请求体相同的那次录制 (版本 2 起录制请求体)
+/// - /connections、/logs、/traffic 等流按录制时的间隔推送，可加速或循环，
+///   WebSocket 与普通 HTTP (逐行 JSON) 两种方式均支持
+///
+/// 只依赖 dart:io，可在 Linux 上运行：
+///
+///   dart run tool/trace/replay_server.dart trace.vxtr --port 9090 --speed 4 --loop
+///   dart run tool/trace/replay_server.dart trace.vxtr --summary
+///
+/// --send 反过来把录制的请求 (含 PUT/PATCH 的请求体) 按录制间隔重新发往一个
+/// 真实控制器，并对比状态码。脱敏录制中的代理名等已是哈希令牌，真实内核不认识，
+/// 这种用法需以 redact: false 录制：
+///
+///   dart run tool/trace/replay_server.dart trace.vxtr --send http://127.0.0.1:9090
+///
+/// 也可编译为替身核心供原生耐久测试 (SoakTest) 启动：此时按内核的 -d/-f 参数
+/// 运行，从配置的 external-controller 读取端口，回放 -d 目录下的 replay.vxtr
+/// (或环境变量 VORTEX_REPLAY_TRACE 指定的文件)，未录制的修改类请求返回 204：
+///
+///   dart compile exe tool/trace/replay_server.dart -o mihomo-replay.exe
+library;
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+const _methods = ['GET', 'PUT', 'POST', 'DELETE', 'PATCH'];
+
+class TraceRecord {
+  /// 1 为请求，2 为流消息
+  final int kind;
+
+  /// 距录制开始的毫秒数
+  final int timeMs;
+  final String path;
+  final String method;
+  final int status;
+  final int durationMs;
+
+  /// 请求体；流消息与版本 1 的录制为空
+  final Uint8List requestBody;
+
+  /// 请求的响应体或流消息
+  final Uint8List body;
+
+  TraceRecord({
+    required this.kind,
+    required this.timeMs,
+    required this.path,
+    this.method = 'GET',
+    this.status = 0,
+    this.durationMs = 0,
+    Uint8List? requestBody,
+    required this.body,
+  }) : requestBody = requestBody ?? Uint8List(0);
+
+  bool get isRequest => kind == 1;
+}
+
+List<TraceRecord> readTrace(Uint8List data) {
+  if (data.length < 5 || ascii.decode(data.sublist(0, 4)) != 'VXTR') {
+    throw const FormatException('not a controller trace');
+  }
+  final version = data[4];
+  if (version != 1 && version != 2) {
+    throw FormatException('unsupported trace version $version');
+  }
+
+  var at = 5;
+  int varint() {
+    var result = 0;
+    var shift = 0;
+    while (true) {
+      if (at >= data.length) throw const FormatException('truncated trace');
+      final byte = data[at++];
+      result |= (byte & 0x7F) << shift;
+      if (byte < 0x80) return result;
+      shift += 7;
+    }
+  }
+
+  Uint8List bytes(int length) {
+    if (at + length > data.length) throw const FormatException('truncated trace');
+    final result = Uint8List.sublistView(data, at, at + length);
+    at += length;
+    return result;
+  }
+
+  final paths = <String>[];
+  final records = <TraceRecord>[];
+  var time = 0;
+  while (at < data.length) {
+    final kind = data[at++];
+    time += varint();
+    final index = varint();
+    if (index == paths.length) {
+      paths.add(utf8.decode(bytes(varint())));
+    } else if (index > paths.length) {
+      throw const FormatException('bad path index');
+    }
+
+    var method = 'GET';
+    var status = 0;
+    var duration = 0;
+    Uint8List? requestBody;
+    if (kind == 1) {
+      final code = data[at++];
+      method = code < _methods.length ? _methods[code] : 'GET';
+      status = varint();
+      duration = varint();
+      if (version >= 2) requestBody = bytes(varint());
+    }
+    records.add(
+      TraceRecord(
+        kind: kind,
+        timeMs: time,
+        path: paths[index],
+        method: method,
+        status: status,
+        durationMs: duration,
+        requestBody: requestBody,
+        body: bytes(varint()),
+      ),
+    );
+  }
+  return records;
+}
+
+class _Options {
+  late String tracePath;
+  int port = 9090;
+
+  /// 以替身核心方式运行 (收到 -f 参数)
+  bool asCore = false;
+  double speed = 1;
+  bool loop = false;
+  bool timing = false;
+  bool summary = false;
+
+  /// 非空时把录制的请求发往该控制器而不是监听
+  String? sendTo;
+  String? secret;
+}
+
+Future<void> main(List<String> args) async {
+  final options = _parseArgs(args);
+  if (options == null) {
+    print('''
+Usage: dart run tool/trace/replay_server.dart <trace.vxtr> [options]
+
+  --port <n>       Listen on 127.0.0.1:<n> (default 9090)
+  --speed <x>      Replay streams x times faster; 0 sends without delay (default 1)
+  --loop           Restart streams from the beginning when they run out
+  --timing         Delay request replies by their recorded duration
+  --summary        Print what the trace holds and exit
+  --send <url>     Re-issue the recorded requests, bodies included, against the
+                   controller at <url> and compare status codes
+  --secret <s>     Controller secret for --send
+''');
+    exitCode = 64;
+    return;
+  }
+
+  final records = readTrace(await File(options.tracePath).readAsBytes());
+  if (options.summary) {
+    _printSummary(records);
+    return;
+  }
+  if (options.sendTo != null) {
+    exitCode = await _sendRequests(records, options);
+    return;
+  }
+
+  final server = _ReplayServer(records, options);
+  await server.listen();
+}
+
+_Options? _parseArgs(List<String> args) {
+  final options = _Options();
+  String? trace;
+  String? workDir;
+  String? config;
+  for (var i = 0; i < args.length; i++) {
+    final arg = args[i];
+    String? value() => i + 1 < args.length ? args[++i] : null;
+
+    switch (arg) {
+      case '--port':
+        final port = int.tryParse(value() ?? '');
+        if (port == null) return null;
+        options.port = port;
+      case '--speed':
+        final speed = double.tryParse(value() ?? '');
+        if (speed == null || speed < 0) return null;
+        options.speed = speed;
+      case '--loop':
+        options.loop = true;
+      case '--timing':
+        options.timing = true;
+      case '--summary':
+        options.summary = true;
+      case '--send':
+        final url = value();
+        if (url == null || Uri.tryParse(url)?.hasAuthority != true) return null;
+        options.sendTo = url.endsWith('/')
+            ? url.substring(0, url.length - 1)
+            : url;
+      case '--secret':
+        options.secret = value();
+      case '-d':
+        workDir = value();
+      case '-f':
+        config = value();
+      default:
+        if (arg.startsWith('--') || trace != null) return null;
+        trace = arg;
+    }
+  }
+
+  if (config != null) {
+    // 与内核相同的调用方式：端口取自配置，录制文件取自工作目录
+    options.asCore = true;
+    options.loop = true;
+    final port = _controllerPort(config);
+    if (port == null) return null;
+    options.port = port;
+    trace ??=
+        Platform.environment['VORTEX_REPLAY_TRACE'] ??
+        '${workDir ?? File(config).parent.path}${Platform.pathSeparator}replay.vxtr';
+  }
+
+  if (trace == null) return null;
+  options.tracePath = trace;
+  return options;
+}
+
+int? _controllerPort(String configPath) {
+  final file = File(configPath);
+  if (!file.existsSync()) return null;
+  final match = RegExp(
+    r'''external-controller:\s*['"]?[^'":\s]*:(\d+)''',
+  ).firstMatch(file.readAsStringSync());
+  return match == null ? 9090 : int.parse(match.group(1)!);
+}
+
+void _printSummary(List<TraceRecord> records) {
+  final byPath = <String, List<TraceRecord>>{};
+  for (final record in records) {
+    final key = record.isRequest
+        ? '${record.method} ${record.path}'
+        : 'STREAM ${record.path}';
+    byPath.putIfAbsent(key, () => []).add(record);
+  }
+
+  final span = records.isEmpty ? 0 : records.last.timeMs - records.first.timeMs;
+  print('${records.length} records over ${(span / 1000).toStringAsFixed(1)} s');
+  final keys = byPath.keys.toList()
+    ..sort((a, b) => byPath[b]!.length.compareTo(byPath[a]!.length));
+  for (final key in keys) {
+    final list = byPath[key]!;
+    final bytes = list.fold<int>(0, (sum, r) => sum + r.body.length);
+    print(
+      '  ${list.length.toString().padLeft(7)}  '
+      '${(bytes / 1024).toStringAsFixed(1).padLeft(10)} KB  $key',
+    );
+  }
+}
+
+/// 按录制顺序与间隔 (受 --speed 影响) 重发请求；返回进程退出码，
+/// 有状态码与录制不一致的请求时为 1
+Future<int> _sendRequests(List<TraceRecord> records, _Options options) async {
+  final requests = records.where((r) => r.isRequest).toList();
+  final client = HttpClient();
+  var mismatched = 0;
+  var previous = requests.isEmpty ? 0 : requests.first.timeMs;
+  try {
+    for (final record in requests) {
+      final gap = record.timeMs - previous;
+      previous = record.timeMs;
+      if (options.speed > 0 && gap > 0) {
+        await Future.delayed(
+          Duration(microseconds: (gap * 1000 / options.speed).round()),
+        );
+      }
+
+      int status;
+      try {
+        final request = await client.openUrl(
+          record.method,
+          Uri.parse('${options.sendTo}${record.path}'),
+        );
+        if (options.secret != null) {
+          request.headers.set(
+            HttpHeaders.authorizationHeader,
+            'Bearer ${options.secret}',
+          );
+        }
+        if (record.requestBody.isNotEmpty) {
+          request.headers.contentType = ContentType.json;
+          request.add(record.requestBody);
+        }
+        final response = await request.close();
+        await response.drain<void>();
+        status = response.statusCode;
+      } on IOException catch (e) {
+        print('${record.method} ${record.path}: $e');
+        return 1;
+      }
+
+      if (status != record.status) {
+        mismatched++;
+        print(
+          '${record.method} ${record.path}: $status (recorded ${record.status})',
+        );
+      }
+    }
+  } finally {
+    client.close(force: true);
+  }
+  print('Sent ${requests.length} requests, $mismatched with a different status');
+  return mismatched > 0 ? 1 : 0;
+}
+
+class _ReplayServer {
+  final _Options options;
+
+  /// 请求回放："METHOD path" → 录制的响应，轮换使用
+  final Map<String, List<TraceRecord>> _responses = {};
+  final Map<String, int> _nextResponse = {};
+
+  /// 流回放：路径 → 按时间排序的消息
+  final Map<String, List<TraceRecord>> _streams = {};
+
+  _ReplayServer(List<TraceRecord> records, this.options) {
+    for (final record in records) {
+      if (record.isRequest) {
+        _responses
+            .putIfAbsent('${record.method} ${record.path}', () => [])
+            .add(record);
+      } else {
+        _streams.putIfAbsent(record.path, () => []).add(record);
+      }
+    }
+  }
+
+  Future<void> listen() async {
+    final server = await HttpServer.bind(
+      InternetAddress.loopbackIPv4,
+      options.port,
+    );
+    print(
+      'Replaying ${_responses.length} endpoints and ${_streams.length} streams '
+      'on http://127.0.0.1:${server.port}',
+    );
+    await for (final request in server) {
+      unawaited(_handle(request));
+    }
+  }
+
+  Future<void> _handle(HttpRequest request) async {
+    final path = request.uri.toString();
+    final streamPath = request.uri.path;
+    try {
+      if (_streams.containsKey(streamPath) &&
+          WebSocketTransformer.isUpgradeRequest(request)) {
+        final socket = await WebSocketTransformer.upgrade(request);
+        // 客户端不发送消息，但需要监听才能得知连接关闭
+        socket.listen((_) {}, onDone: () {}, cancelOnError: true);
+        await _replayStream(streamPath, (data) {
+          if (socket.closeCode != null) return false;
+          socket.add(utf8.decode(data));
+          return true;
+        });
+        await socket.close();
+        return;
+      }
+
+      final recorded =
+          _responses['${request.method} $path'] ??
+          _responses['${request.method} $streamPath'];
+      if (recorded != null) {
+        final record =
+            await _matchBody(request, recorded) ??
+            _rotate(request.method, recorded);
+
+        if (options.timing && record.durationMs > 0) {
+          await Future.delayed(
+            Duration(milliseconds: record.durationMs),
+          );
+        }
+        request.response
+          ..statusCode = record.status > 0 ? record.status : HttpStatus.ok
+          ..headers.contentType = ContentType.json
+          ..add(record.body);
+        await request.response.close();
+        return;
+      }
+
+      if (_streams.containsKey(streamPath)) {
+        // 内核的流接口不升级时返回逐行 JSON
+        request.response
+          ..headers.contentType = ContentType.json
+          ..bufferOutput = false;
+        var open = true;
+        request.response.done.whenComplete(() => open = false).ignore();
+        await _replayStream(streamPath, (data) {
+          if (!open) return false;
+          request.response
+            ..add(data)
+            ..write('\n');
+          return true;
+        });
+        await request.response.close();
+        return;
+      }
+
+      // 替身核心需让未录制的重载、切换等请求成功
+      request.response.statusCode =
+          options.asCore && request.method != 'GET'
+          ? HttpStatus.noContent
+          : HttpStatus.notFound;
+      await request.response.close();
+    } catch (_) {
+      // 客户端提前断开
+    }
+  }
+
+  TraceRecord _rotate(String method, List<TraceRecord> recorded) {
+    final key = '$method ${recorded.first.path}';
+    final index = _nextResponse[key] ?? 0;
+    _nextResponse[key] = (index + 1) % recorded.length;
+    return recorded[index];
+  }
+
+  /// 修改类请求取请求体相同的录制；请求体中的敏感值被脱敏改写时不会命中
+  Future<TraceRecord?> _matchBody(
+    HttpRequest request,
+    List<TraceRecord> recorded,
+  ) async {
+    if (request.method == 'GET' ||
+        recorded.every((r) => r.requestBody.isEmpty)) {
+      return null;
+    }
+    final body = await request.fold<BytesBuilder>(
+      BytesBuilder(copy: false),
+      (builder, chunk) => builder..add(chunk),
+    );
+    final bytes = body.takeBytes();
+    for (final record in recorded) {
+      if (_sameBytes(record.requestBody, bytes)) return record;
+    }
+    return null;
+  }
+
+  static bool _sameBytes(Uint8List a, Uint8List b) {
+    if (a.length != b.length) return false;
+    for (var i = 0; i < a.length; i++) {
+      if (a[i] != b[i]) return false;
+    }
+    return true;
+  }
+
+  /// [send] 返回 false 表示客户端已断开
+  Future<void> _replayStream(
+    String path,
+    bool Function(Uint8List data) send,
+  ) async {
+    final messages = _streams[path]!;
+    var sent = 0;
+    do {
+      var previous = messages.first.timeMs;
+      for (final message in messages) {
+        final gap = message.timeMs - previous;
+        previous = message.timeMs;
+        if (options.speed > 0 && gap > 0) {
+          await Future.delayed(
+            Duration(microseconds: (gap * 1000 / options.speed).round()),
+          );
+        } else if (++sent % 64 == 0) {
+          // 不限速时也让出事件循环，以便写出数据和处理断开
+          await Future<void>.delayed(Duration.zero);
+        }
+        if (!send(message.body)) return;
+      }
+    } while (options.loop);
+  }
+}
@@ -0,0 +1,184 @@
+// chain_prober.cpp - Proxy chain prober implementation
+#include "chain_prober.h"
+#include "json_reader.h"
+#include "mihomo_core.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace {
+
+// Guards against dialer-proxy cycles and absurdly deep nesting
+constexpr int kMaxDepth = 16;
+
+struct ProxyInfo {
+    std::string type;
+    std::string now;
+    std::string dialer;
+    std::vector<std::string> all;
+};
+
+bool ParseProxies(const std::string& json, std::map<std::string, ProxyInfo>* out) {
+    JsonReader reader(json.data(), json.data() + json.size());
+    if (!reader.Consume('{')) return false;
+    if (reader.Consume('}')) return true;
+    do {
+        std::string key;
+        if (!reader.String(&key) || !reader.Consume(':')) return false;
+        if (key != "proxies") {
+            if (!reader.Skip()) return false;
+            continue;
+        }
+
+        if (!reader.Consume('{')) return false;
+        if (reader.Consume('}')) continue;
+        do {
+            std::string name;
+            if (!reader.String(&name) || !reader.Consume(':') || !reader.Consume('{')) return false;
+            ProxyInfo& info = (*out)[name];
+            if (reader.Consume('}')) continue;
+            do {
+                std::string field;
+                if (!reader.String(&field) || !reader.Consume(':')) return false;
+                bool ok;
+                if (field == "type" && reader.Peek('"')) ok = reader.String(&info.type);
+                else if (field == "now" && reader.Peek('"')) ok = reader.String(&info.now);
+                else if (field == "dialer-proxy" && reader.Peek('"')) ok = reader.String(&info.dialer);
+                else if (field == "all") ok = reader.StringArray(&info.all);
+                else ok = reader.Skip();
+                if (!ok) return false;
+            } while (reader.Consume(','));
+            if (!reader.Consume('}')) return false;
+        } while (reader.Consume(','));
+        if (!reader.Consume('}')) return false;
+    } while (reader.Consume(','));
+    return reader.Consume('}');
+}
+
+bool Resolve(const std::map<std::string, ProxyInfo>& proxies, const std::string& name, int depth,
+             std::set<std::string>* path, std::vector<ChainProber::Hop>* hops, std::string* error) {
+    if (depth > kMaxDepth || path->count(name) != 0) {
+        *error = "chain loops through " + name;
+        return false;
+    }
+
+    auto it = proxies.find(name);
+    if (it == proxies.end()) {
+        *error = "unknown proxy " + name;
+        return false;
+    }
+    const ProxyInfo& info = it->second;
+
+    path->insert(name);
+    bool ok = true;
+    if (info.type == "Relay") {
+        for (const auto& member : info.all) {
+            if (!(ok = Resolve(proxies, member, depth + 1, path, hops, error))) break;
+        }
+    } else if (!info.now.empty()) {
+        // Selector, URLTest and Fallback dial through their current choice
+        ok = Resolve(proxies, info.now, depth + 1, path, hops, error);
+    } else {
+        // Testing this proxy alone dials its dialer chain too, which starts
+        // here; relay members before it are not part of that test
+        size_t start = hops->size();
+        if (!info.dialer.empty()) {
+            ok = Resolve(proxies, info.dialer, depth + 1, path, hops, error);
+        }
+        if (ok) {
+            ChainProber::Hop hop;
+            hop.name = name;
+            hop.type = info.type;
+            hop.dialer = info.dialer;
+            hop.standaloneStart = static_cast<int>(start);
+            hops->push_back(std::move(hop));
+        }
+    }
+    path->erase(name);
+    return ok;
+}
+
+// Median of successful tests, -1 when all failed
+int64_t MedianDelay(const std::string& proxy, const std::string& url, int timeoutMs, int samples) {
+    std::vector<int64_t> delays;
+    for (int i = 0; i < samples; i++) {
+        int delay = MihomoCore::GetInstance().TestDelay(PercentEncode(proxy), PercentEncode(url), timeoutMs);
+        if (delay > 0) delays.push_back(delay);
+    }
+    if (delays.empty()) return -1;
+    std::sort(delays.begin(), delays.end());
+    return delays[delays.size() / 2];
+}
+
+}  // namespace
+
+bool ChainProber::ResolveChain(const std::string& proxiesJson, const std::string& target,
+                               std::vector<Hop>* hops, std::string* error) {
+    std::map<std::string, ProxyInfo> proxies;
+    if (!ParseProxies(proxiesJson, &proxies)) {
+        *error = "unreadable /proxies response";
+        return false;
+    }
+    std::set<std::string> path;
+    hops->clear();
+    if (!Resolve(proxies, target, 0, &path, hops, error)) return false;
+    if (hops->empty()) {
+        *error = "empty chain";
+        return false;
+    }
+    return true;
+}
+
+ChainProber::Result ChainProber::Probe(const std::string& target, const std::string& url,
+                                       int timeoutMs, int samples) {
+    auto started = std::chrono::steady_clock::now();
+    Result result;
+    result.target = target;
+    samples = std::max(1, std::min(samples, 9));
+
+    std::string json = MihomoCore::GetInstance().GetProxies();
+    if (json.empty()) {
+        result.error = "controller unavailable";
+        return result;
+    }
+    if (!ResolveChain(json, target, &result.hops, &result.error)) return result;
+
+    // Every hop and the whole chain are tested at the same time
+    std::vector<std::thread> threads;
+    for (auto& hop : result.hops) {
+        threads.emplace_back([&hop, &url, timeoutMs, samples]() {
+            hop.standaloneMs = MedianDelay(hop.name, url, timeoutMs, samples);
+        });
+    }
+    threads.emplace_back([&result, &target, &url, timeoutMs, samples]() {
+        result.totalMs = MedianDelay(target, url, timeoutMs, samples);
+    });
+    for (auto& thread : threads) thread.join();
+
+    // A hop's own test covers its prefix only when its dialer chain starts
+    // at the first hop
+    auto& hops = result.hops;
+    for (size_t i = 0; i < hops.size(); i++) {
+        if (hops[i].standaloneStart == 0) hops[i].cumulativeMs = hops[i].standaloneMs;
+    }
+    hops.back().cumulativeMs = result.totalMs;
+
+    int previous = -1;
+    int64_t previousMs = 0;
+    for (size_t i = 0; i < hops.size(); i++) {
+        if (hops[i].cumulativeMs < 0) continue;
+        hops[i].legStart = previous + 1;
+        hops[i].legMs = std::max<int64_t>(hops[i].cumulativeMs - previousMs, 0);
+        previous = static_cast<int>(i);
+        previousMs = hops[i].cumulativeMs;
+    }
+
+    result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return result;
+}
@@ -0,0 +1,60 @@
+// chain_prober.h - Per-hop latency breakdown for proxy chains for Windows
+#ifndef CHAIN_PROBER_H_
+#define CHAIN_PROBER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Resolves what a proxy or group dials through, using the core's /proxies
+// view: selector-style groups follow their current choice, relay groups
+// expand to their members in order, and a proxy with dialer-proxy is
+// preceded by its dialer's chain. Every hop is then delay-tested through
+// whichever core is running, the connected one or the background core kept
+// for delay tests; there is no separate probe core, so the chain must exist
+// in that core's config.
+//
+// Two numbers are collected per hop:
+//   standalone - the hop's own delay test, reaching the target from this
+//                machine through that hop and its own dialer chain, if any;
+//                the hops it covers start at standaloneStart
+//   cumulative - the delay of the chain up to and including the hop, where
+//                the core can test that prefix: the hop's standalone test
+//                when its dialer chain starts at the first hop, and the
+//                whole chain for the last hop. A relay member with its own
+//                dialer-proxy further down the chain only covers its
+//                dialer's hops, not the relay members before them.
+// A hop's leg is its cumulative delay minus the previous known cumulative
+// delay; it covers every hop since that one.
+class ChainProber {
+public:
+    struct Hop {
+        std::string name;
+        std::string type;          // As reported by the core, e.g. "Shadowsocks"
+        std::string dialer;        // dialer-proxy, when the hop has one
+        int64_t standaloneMs = -1; // -1 when the test failed
+        int standaloneStart = -1;  // First hop the standalone test dials through
+        int64_t cumulativeMs = -1; // -1 when the prefix cannot be tested
+        int64_t legMs = -1;
+        int legStart = -1;         // First hop covered by legMs
+    };
+
+    struct Result {
+        std::string target;        // The proxy or group that was resolved
+        std::vector<Hop> hops;     // In dial order, nearest first
+        int64_t totalMs = -1;      // Delay of the whole chain
+        int64_t elapsedMs = 0;
+        std::string error;
+    };
+
+    // Blocks while the hops are tested. samples is the number of delay
+    // tests per hop; the median is reported.
+    static Result Probe(const std::string& target, const std::string& url,
+                        int timeoutMs, int samples);
+
+    // Exposed for reuse: resolves the chain without testing it
+    static bool ResolveChain(const std::string& proxiesJson, const std::string& target,
+                             std::vector<Hop>* hops, std::string* error);
+};
+
+#endif  // CHAIN_PROBER_H_
@@ -0,0 +1,793 @@
+// clash_yaml.cpp - Streaming Clash YAML proxy reader implementation
+#include "clash_yaml.h"
+#include "node_parser.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace {
+
+// Nested mappings are flattened this deep at most; also stops alias loops
+constexpr int kMaxDepth = 8;
+
+constexpr size_t kBenchmarkChunk = 64 * 1024;
+
+// A provider file of count proxies in one style, followed by the sections
+// a full config carries after them
+std::string BenchmarkDocument(const std::string& style, size_t count) {
+    std::string text;
+    text.reserve(count * 220 + 4096);
+    text += "# generated provider\nmixed-port: 7890\nmode: rule\n";
+    if (style == "anchors") {
+        text += "x-ss: &ss {type: ss, cipher: aes-128-gcm, udp: true}\n";
+        text += "x-ws: &ws\n  network: ws\n  tls: true\n  ws-opts:\n    path: /ray\n";
+    }
+    text += "proxies:\n";
+    for (size_t i = 0; i < count; i++) {
+        std::string n = std::to_string(i);
+        std::string server = "node" + n + ".example.com";
+        std::string port = std::to_string(10000 + i % 50000);
+        if (style == "flow") {
+            text += "  - {name: \"HK " + n + "\", type: ss, server: " + server + ", port: " + port +
+                    ", cipher: chacha20-ietf-poly1305, password: \"pw" + n + "\", udp: true}\n";
+        } else if (style == "anchors") {
+            if (i % 2 == 0) {
+                text += "  - <<: *ss\n    name: SS " + n + "\n    server: " + server + "\n    port: " + port +
+                        "\n    password: pw" + n + "\n";
+            } else {
+                text += "  - name: VM " + n + "\n    <<: *ws\n    type: vmess\n    server: " + server +
+                        "\n    port: " + port + "\n    uuid: 6b0f3c1e-0000-4000-8000-" + std::string(12 - std::min<size_t>(12, n.size()), '0') + n +
+                        "\n    alterId: 0\n    cipher: auto\n";
+            }
+        } else {
+            switch (i % 3) {
+                case 0:
+                    text += "  - name: \"VM " + n + "\"\n    type: vmess\n    server: " + server + "\n    port: " + port +
+                            "\n    uuid: 6b0f3c1e-0000-4000-8000-" + std::string(12 - std::min<size_t>(12, n.size()), '0') + n +
+                            "\n    alterId: 0\n    cipher: auto\n    network: ws\n    tls: true\n"
+                            "    ws-opts:\n      path: /ray\n      headers:\n        Host: " + server + "\n";
+                    break;
+                case 1:
+                    text += "  - name: SS " + n + "\n    type: ss\n    server: " + server + "\n    port: " + port +
+                            "\n    cipher: aes-256-gcm\n    password: 'pw" + n + "'  # comment\n    udp: true\n";
+                    break;
+                default:
+                    text += "  - name: TJ " + n + "\n    type: trojan\n    server: " + server + "\n    port: " + port +
+                            "\n    password: pw" + n + "\n    sni: " + server + "\n    alpn:\n      - h2\n      - http/1.1\n";
+                    break;
+            }
+        }
+    }
+    text += "proxy-groups:\n  - name: Proxy\n    type: select\n    proxies:\n      - DIRECT\n";
+    text += "rules:\n  - DOMAIN-SUFFIX,example.com,Proxy\n  - MATCH,DIRECT\n";
+    return text;
+}
+
+bool IsItem(const std::string& content) {
+    return !content.empty() && content[0] == '-' && (content.size() == 1 || content[1] == ' ');
+}
+
+// A quote only opens a quoted scalar at the start of a token
+bool OpensQuote(const std::string& text, size_t at) {
+    if (text[at] != '"' && text[at] != '\'') return false;
+    if (at == 0) return true;
+    char before = text[at - 1];
+    return before == ' ' || before == '\t' || before == '[' || before == '{' || before == ',' || before == ':';
+}
+
+// Index just past the quoted scalar opening at at, or npos when it does
+// not close on this text
+size_t SkipQuoted(const std::string& text, size_t at) {
+    char quote = text[at];
+    for (size_t i = at + 1; i < text.size(); i++) {
+        if (quote == '"' && text[i] == '\\') {
+            i++;
+        } else if (text[i] == quote) {
+            // '' is an escaped quote inside single quotes
+            if (quote == '\'' && i + 1 < text.size() && text[i + 1] == '\'') {
+                i++;
+                continue;
+            }
+            return i + 1;
+        }
+    }
+    return std::string::npos;
+}
+
+std::string StripComment(const std::string& text) {
+    if (text.find('#') == std::string::npos) return text;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (OpensQuote(text, i)) {
+            size_t end = SkipQuoted(text, i);
+            if (end == std::string::npos) return text;
+            i = end - 1;
+        } else if (text[i] == '#' && (i == 0 || text[i - 1] == ' ' || text[i - 1] == '\t')) {
+            return text.substr(0, i);
+        }
+    }
+    return text;
+}
+
+// Position of the ':' ending a block mapping key, npos when the content is
+// not a key
+size_t FindKeyColon(const std::string& content) {
+    size_t i = 0;
+    if (content.empty() || content[0] == '[' || content[0] == '{' || content[0] == '#') {
+        return std::string::npos;
+    }
+    if (content[0] == '"' || content[0] == '\'') {
+        i = SkipQuoted(content, 0);
+        if (i == std::string::npos) return std::string::npos;
+    }
+    for (; i < content.size(); i++) {
+        char c = content[i];
+        if (c == '#' && i > 0 && (content[i - 1] == ' ' || content[i - 1] == '\t')) break;
+        if (c == ':' && (i + 1 == content.size() || content[i + 1] == ' ' || content[i + 1] == '\t')) return i;
+    }
+    return std::string::npos;
+}
+
+std::string DecodeQuoted(const std::string& text, size_t at, size_t* end) {
+    char quote = text[at];
+    std::string out;
+    size_t i = at + 1;
+    for (; i < text.size(); i++) {
+        char c = text[i];
+        if (c == quote) {
+            if (quote == '\'' && i + 1 < text.size() && text[i + 1] == '\'') {
+                out.push_back('\'');
+                i++;
+                continue;
+            }
+            i++;
+            break;
+        }
+        if (quote == '"' && c == '\\' && i + 1 < text.size()) {
+            char e = text[++i];
+            switch (e) {
+                case 'n': out.push_back('\n'); break;
+                case 't': out.push_back('\t'); break;
+                case 'r': out.push_back('\r'); break;
+                case '0': out.push_back('\0'); break;
+                case 'u': {
+                    if (i + 4 >= text.size()) break;
+                    uint32_t code = static_cast<uint32_t>(strtoul(text.substr(i + 1, 4).c_str(), nullptr, 16));
+                    i += 4;
+                    if (code < 0x80) {
+                        out.push_back(static_cast<char>(code));
+                    } else if (code < 0x800) {
+                        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    } else {
+                        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    break;
+                }
+                default: out.push_back(e); break;
+            }
+            continue;
+        }
+        out.push_back(c);
+    }
+    if (end) *end = i;
+    return out;
+}
+
+// Whether a logical line continues on the next physical line: an open flow
+// collection or an unterminated quoted scalar as its value
+bool NeedsMore(const std::string& content) {
+    // Most lines are plain key: value
+    if (content.find_first_of("[{\"'") == std::string::npos) return false;
+    size_t at = 0;
+    while (at < content.size() && IsItem(content.substr(at, 2))) {
+        at = content.find_first_not_of(' ', at + 1);
+        if (at == std::string::npos) return false;
+    }
+    std::string rest = content.substr(at);
+    size_t colon = FindKeyColon(rest);
+    if (colon != std::string::npos) {
+        size_t value = rest.find_first_not_of(" \t", colon + 1);
+        if (value == std::string::npos) return false;
+        rest = rest.substr(value);
+    }
+    // Anchors and tags come before the value
+    while (!rest.empty() && (rest[0] == '&' || rest[0] == '!')) {
+        size_t space = rest.find_first_of(" \t");
+        if (space == std::string::npos) return false;
+        rest = Trim(rest.substr(space));
+    }
+    if (rest.empty()) return false;
+    if (rest[0] == '"' || rest[0] == '\'') return SkipQuoted(rest, 0) == std::string::npos;
+    if (rest[0] != '[' && rest[0] != '{') return false;
+
+    int depth = 0;
+    for (size_t i = 0; i < rest.size(); i++) {
+        char c = rest[i];
+        if (OpensQuote(rest, i)) {
+            size_t end = SkipQuoted(rest, i);
+            if (end == std::string::npos) return true;
+            i = end - 1;
+        } else if (c == '[' || c == '{') {
+            depth++;
+        } else if (c == ']' || c == '}') {
+            depth--;
+        } else if (c == '#' && i > 0 && rest[i - 1] == ' ') {
+            break;
+        }
+    }
+    return depth > 0;
+}
+
+}  // namespace
+
+struct ClashYamlReader::Node {
+    enum class Kind { Null, Scalar, Map, Seq };
+
+    Kind kind = Kind::Null;
+    std::string scalar;
+    bool quoted = false;
+    std::vector<std::pair<std::string, NodePtr>> entries;  // Map, in document order
+    std::vector<NodePtr> items;                            // Seq
+
+    // A repeated key replaces the earlier entry
+    void Set(const std::string& key, NodePtr value) {
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->first == key) {
+                entries.erase(it);
+                break;
+            }
+        }
+        entries.emplace_back(key, std::move(value));
+    }
+
+    bool Has(const std::string& key) const {
+        for (const auto& entry : entries) {
+            if (entry.first == key) return true;
+        }
+        return false;
+    }
+};
+
+struct ClashYamlReader::Frame {
+    int indent = -1;
+    NodePtr node;          // Map or Seq
+    bool pending = false;  // The last entry or item waits for a nested value
+    std::string anchor;    // Of the pending value
+};
+
+// Reads one flow value: [a, b], {k: v}, a quoted or plain scalar, an alias
+class ClashYamlReader::FlowParser {
+public:
+    FlowParser(ClashYamlReader* reader, const std::string& text) : reader_(reader), text_(text) {}
+
+    NodePtr Parse(int depth = 0) {
+        Space();
+        auto node = std::make_shared<Node>();
+        if (at_ >= text_.size() || depth > kMaxDepth) return node;
+
+        char c = text_[at_];
+        if (c == '&' || c == '!') {
+            std::string name = Token();
+            Space();
+            NodePtr value = Parse(depth);
+            if (c == '&') reader_->Anchor(name.substr(1), value);
+            return value;
+        }
+        if (c == '*') {
+            std::string name = Token().substr(1);
+            auto found = reader_->anchors_.find(name);
+            return found != reader_->anchors_.end() ? found->second : node;
+        }
+        if (c == '[') {
+            at_++;
+            node->kind = Node::Kind::Seq;
+            for (;;) {
+                Space();
+                if (at_ >= text_.size()) break;
+                if (text_[at_] == ']') {
+                    at_++;
+                    break;
+                }
+                node->items.push_back(Parse(depth + 1));
+                Space();
+                if (at_ < text_.size() && text_[at_] == ',') {
+                    at_++;
+                } else if (at_ >= text_.size() || text_[at_] != ']') {
+                    break;
+                }
+            }
+            return node;
+        }
+        if (c == '{') {
+            at_++;
+            node->kind = Node::Kind::Map;
+            for (;;) {
+                Space();
+                if (at_ >= text_.size()) break;
+                if (text_[at_] == '}') {
+                    at_++;
+                    break;
+                }
+                std::string key = Key();
+                Space();
+                NodePtr value;
+                if (at_ < text_.size() && text_[at_] == ':') {
+                    at_++;
+                    value = Parse(depth + 1);
+                } else {
+                    value = std::make_shared<Node>();
+                }
+                if (key == "<<") {
+                    Merge(node, value);
+                } else {
+                    node->Set(key, value);
+                }
+                Space();
+                if (at_ < text_.size() && text_[at_] == ',') {
+                    at_++;
+                } else if (at_ >= text_.size() || text_[at_] != '}') {
+                    break;
+                }
+            }
+            return node;
+        }
+
+        node->kind = Node::Kind::Scalar;
+        if (c == '"' || c == '\'') {
+            node->quoted = true;
+            node->scalar = DecodeQuoted(text_, at_, &at_);
+            return node;
+        }
+        size_t start = at_;
+        while (at_ < text_.size() && text_[at_] != ',' && text_[at_] != ']' && text_[at_] != '}') at_++;
+        node->scalar = Trim(text_.substr(start, at_ - start));
+        return node;
+    }
+
+    // Merge keys take a mapping or a list of them; keys already present win
+    static void Merge(const NodePtr& into, const NodePtr& from) {
+        if (!from) return;
+        if (from->kind == Node::Kind::Seq) {
+            for (const auto& item : from->items) Merge(into, item);
+            return;
+        }
+        if (from->kind != Node::Kind::Map) return;
+        for (const auto& entry : from->entries) {
+            if (!into->Has(entry.first)) into->entries.push_back(entry);
+        }
+    }
+
+private:
+    void Space() {
+        while (at_ < text_.size() && (text_[at_] == ' ' || text_[at_] == '\t')) at_++;
+    }
+
+    std::string Token() {
+        size_t start = at_;
+        while (at_ < text_.size() && text_[at_] != ' ' && text_[at_] != '\t' && text_[at_] != ',' &&
+               text_[at_] != ']' && text_[at_] != '}') {
+            at_++;
+        }
+        return text_.substr(start, at_ - start);
+    }
+
+    std::string Key() {
+        if (at_ < text_.size() && (text_[at_] == '"' || text_[at_] == '\'')) {
+            return DecodeQuoted(text_, at_, &at_);
+        }
+        size_t start = at_;
+        while (at_ < text_.size() && text_[at_] != ',' && text_[at_] != '}') {
+            if (text_[at_] == ':' && (at_ + 1 >= text_.size() || text_[at_ + 1] == ' ' ||
+                                      text_[at_ + 1] == ',' || text_[at_ + 1] == '}')) {
+                break;
+            }
+            at_++;
+        }
+        return Trim(text_.substr(start, at_ - start));
+    }
+
+    ClashYamlReader* reader_;
+    const std::string& text_;
+    size_t at_ = 0;
+};
+
+
+ClashYamlReader::ClashYamlReader(NodeCallback callback) : callback_(std::move(callback)) {}
+
+ClashYamlReader::~ClashYamlReader() = default;
+
+void ClashYamlReader::Feed(const char* data, size_t size) {
+    stats_.bytes += static_cast<int64_t>(size);
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(memchr(data, '\n', end - data));
+        if (!newline) {
+            partial_.append(data, end - data);
+            return;
+        }
+        partial_.append(data, newline - data);
+        std::string line;
+        line.swap(partial_);
+        Line(std::move(line));
+        data = newline + 1;
+    }
+}
+
+void ClashYamlReader::Finish() {
+    if (!partial_.empty()) {
+        std::string line;
+        line.swap(partial_);
+        Line(std::move(line));
+    }
+    if (!flow_.empty()) {
+        // An unbalanced flow collection at the end is read as far as it goes
+        std::string text;
+        text.swap(flow_);
+        Logical(flowIndent_, text);
+    }
+    EndSection();
+}
+
+void ClashYamlReader::Line(std::string line) {
+    stats_.lines++;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    size_t first = line.find_first_not_of(" \t");
+
+    if (blockScalar_) {
+        if (first == std::string::npos) {
+            blockBlank_++;
+            return;
+        }
+        if (static_cast<int>(first) > blockParentIndent_) {
+            if (blockIndent_ < 0) blockIndent_ = static_cast<int>(first);
+            std::string& text = blockScalar_->scalar;
+            if (!text.empty() || blockBlank_ > 0) {
+                if (blockFolded_ && blockBlank_ == 0) {
+                    text.push_back(' ');
+                } else {
+                    text.append(static_cast<size_t>(blockBlank_) + (text.empty() ? 0 : 1), '\n');
+                }
+            }
+            blockBlank_ = 0;
+            text.append(line, std::min<size_t>(first, static_cast<size_t>(blockIndent_)), std::string::npos);
+            return;
+        }
+        EndBlockScalar();
+    }
+
+    if (!flow_.empty()) {
+        if (first == std::string::npos) return;
+        flow_.push_back(' ');
+        flow_.append(line, first, std::string::npos);
+        if (NeedsMore(flow_)) return;
+        std::string text;
+        text.swap(flow_);
+        Logical(flowIndent_, text);
+        return;
+    }
+
+    if (first == std::string::npos || line[first] == '#') return;
+    if (first == 0 && (line.compare(0, 3, "---") == 0 || line.compare(0, 3, "...") == 0) &&
+        (line.size() == 3 || line[3] == ' ')) {
+        EndSection();
+        return;
+    }
+
+    line.erase(0, first);
+    if (NeedsMore(line)) {
+        flow_ = std::move(line);
+        flowIndent_ = static_cast<int>(first);
+        return;
+    }
+    Logical(static_cast<int>(first), line);
+}
+
+void ClashYamlReader::Logical(int indent, const std::string& content) {
+    // A top-level key starts a new section
+    if (indent == 0 && !IsItem(content)) {
+        EndSection();
+        size_t colon = FindKeyColon(content);
+        if (colon == std::string::npos) return;
+        std::string key = content.substr(0, colon);
+        if (!key.empty() && (key[0] == '"' || key[0] == '\'')) key = DecodeQuoted(key, 0, nullptr);
+        key = Trim(key);
+
+        if (key != "proxies") {
+            section_ = Section::Other;
+            if (content.find('&') != std::string::npos) {
+                BeginCapture(0);
+                Build(0, content);
+            }
+            return;
+        }
+
+        section_ = Section::Proxies;
+        std::string anchor;
+        bool blockScalar = false;
+        NodePtr inline_ = Value(content.substr(colon + 1), &anchor, &blockScalar);
+        if (inline_) {
+            // proxies: [{...}, {...}]
+            if (inline_->kind == Node::Kind::Seq) {
+                for (const auto& item : inline_->items) Emit(item);
+            }
+            section_ = Section::None;
+            return;
+        }
+        Start(true);
+        return;
+    }
+
+    switch (section_) {
+        case Section::Proxies:
+            Build(indent, content);
+            break;
+        case Section::Other:
+            if (capturing_ && indent <= captureIndent_) EndCapture();
+            if (!capturing_ && content.find('&') != std::string::npos) BeginCapture(indent);
+            if (capturing_) Build(indent, content);
+            break;
+        case Section::None:
+            break;
+    }
+}
+
+void ClashYamlReader::Build(int indent, const std::string& content) {
+    while (stack_.size() > 1 && stack_.back().indent > indent) stack_.pop_back();
+    // A sequence may sit at the indentation of the key owning it; the first
+    // line there that is not an item closes it
+    if (stack_.size() > 1 && stack_.back().indent == indent &&
+        stack_.back().node->kind == Node::Kind::Seq && !IsItem(content)) {
+        stack_.pop_back();
+    }
+    if (stack_.empty()) return;
+
+    if (IsItem(content)) {
+        Frame* top = &stack_.back();
+        if (top->node->kind != Node::Kind::Seq || top->indent != indent) {
+            // Nowhere to put it: malformed, skipped
+            if (!top->pending) return;
+            OpenSlot(indent, true);
+            top = &stack_.back();
+        }
+        if (emitItems_ && top->node == root_->items[0]) FlushItems();
+        top->node->items.push_back(std::make_shared<Node>());
+        top->pending = true;
+        top->anchor.clear();
+        size_t rest = content.find_first_not_of(' ', 1);
+        if (rest != std::string::npos) Build(indent + static_cast<int>(rest), content.substr(rest));
+        return;
+    }
+
+    size_t colon = FindKeyColon(content);
+    if (colon != std::string::npos) {
+        Frame* top = &stack_.back();
+        if (top->node->kind != Node::Kind::Map || top->indent != indent) {
+            if (!top->pending) return;
+            OpenSlot(indent, false);
+            top = &stack_.back();
+        }
+        std::string key = content.substr(0, colon);
+        if (!key.empty() && (key[0] == '"' || key[0] == '\'')) key = DecodeQuoted(key, 0, nullptr);
+        key = Trim(key);
+
+        std::string anchor;
+        bool blockScalar = false;
+        NodePtr value = Value(content.substr(colon + 1), &anchor, &blockScalar);
+        top->pending = false;
+        top->anchor.clear();
+        if (key == "<<") {
+            FlowParser::Merge(top->node, value);
+            return;
+        }
+        if (value) {
+            if (!anchor.empty()) Anchor(anchor, value);
+            top->node->Set(key, value);
+            return;
+        }
+        auto slot = std::make_shared<Node>();
+        top->node->Set(key, slot);
+        if (blockScalar) {
+            slot->kind = Node::Kind::Scalar;
+            slot->quoted = true;
+            blockScalar_ = slot;
+            blockParentIndent_ = indent;
+            if (!anchor.empty()) Anchor(anchor, slot);
+            return;
+        }
+        // The value follows on deeper lines
+        top->pending = true;
+        top->anchor = anchor;
+        return;
+    }
+
+    // A scalar on its own line: the value of the pending key or item
+    Frame& top = stack_.back();
+    if (!top.pending) return;
+    std::string anchor;
+    bool blockScalar = false;
+    NodePtr value = Value(content, &anchor, &blockScalar);
+    if (!value) {
+        if (!anchor.empty()) top.anchor = anchor;
+        return;
+    }
+    if (!anchor.empty()) Anchor(anchor, value);
+    if (!top.anchor.empty()) Anchor(top.anchor, value);
+    SetSlot(value);
+    top.pending = false;
+    top.anchor.clear();
+}
+
+void ClashYamlReader::Start(bool emitItems) {
+    stack_.clear();
+    root_ = std::make_shared<Node>();
+    root_->kind = Node::Kind::Seq;
+    root_->items.push_back(std::make_shared<Node>());
+    Frame frame;
+    frame.node = root_;
+    frame.pending = true;
+    stack_.push_back(std::move(frame));
+    emitItems_ = emitItems;
+}
+
+void ClashYamlReader::BeginCapture(int indent) {
+    capturing_ = true;
+    captureIndent_ = indent;
+    Start(false);
+}
+
+void ClashYamlReader::EndCapture() {
+    // What was anchored stays reachable through anchors_
+    capturing_ = false;
+    stack_.clear();
+    root_.reset();
+}
+
+void ClashYamlReader::EndSection() {
+    EndBlockScalar();
+    if (section_ == Section::Proxies) FlushItems();
+    EndCapture();
+    emitItems_ = false;
+    section_ = Section::None;
+}
+
+void ClashYamlReader::EndBlockScalar() {
+    if (!blockScalar_) return;
+    // Trailing line breaks are dropped
+    std::string& text = blockScalar_->scalar;
+    while (!text.empty() && text.back() == '\n') text.pop_back();
+    blockScalar_.reset();
+    blockIndent_ = -1;
+    blockBlank_ = 0;
+}
+
+void ClashYamlReader::OpenSlot(int indent, bool sequence) {
+    auto node = std::make_shared<Node>();
+    node->kind = sequence ? Node::Kind::Seq : Node::Kind::Map;
+    Frame& top = stack_.back();
+    if (!top.anchor.empty()) Anchor(top.anchor, node);
+    SetSlot(node);
+    top.pending = false;
+    top.anchor.clear();
+
+    Frame frame;
+    frame.indent = indent;
+    frame.node = std::move(node);
+    stack_.push_back(std::move(frame));
+}
+
+void ClashYamlReader::SetSlot(NodePtr node) {
+    Node& parent = *stack_.back().node;
+    if (parent.kind == Node::Kind::Map && !parent.entries.empty()) {
+        parent.entries.back().second = std::move(node);
+    } else if (parent.kind == Node::Kind::Seq && !parent.items.empty()) {
+        parent.items.back() = std::move(node);
+    }
+}
+
+void ClashYamlReader::Anchor(const std::string& name, const NodePtr& node) {
+    if (name.empty()) return;
+    anchors_[name] = node;
+    stats_.anchors++;
+}
+
+ClashYamlReader::NodePtr ClashYamlReader::Value(const std::string& text, std::string* anchor, bool* blockScalar) {
+    std::string value = Trim(StripComment(text));
+    while (!value.empty() && (value[0] == '&' || value[0] == '!')) {
+        size_t space = value.find_first_of(" \t");
+        if (value[0] == '&') *anchor = value.substr(1, space == std::string::npos ? std::string::npos : space - 1);
+        value = space == std::string::npos ? std::string() : Trim(value.substr(space));
+    }
+    if (value.empty()) return nullptr;
+    if (value[0] == '|' || value[0] == '>') {
+        *blockScalar = true;
+        blockFolded_ = value[0] == '>';
+        return nullptr;
+    }
+    if (value[0] == '[' || value[0] == '{' || value[0] == '*' || value[0] == '"' || value[0] == '\'') {
+        FlowParser parser(this, value);
+        return parser.Parse();
+    }
+    auto node = std::make_shared<Node>();
+    node->kind = Node::Kind::Scalar;
+    node->scalar = std::move(value);
+    return node;
+}
+
+void ClashYamlReader::FlushItems() {
+    if (!root_ || root_->items.empty()) return;
+    NodePtr sequence = root_->items[0];
+    if (!sequence || sequence->kind != Node::Kind::Seq) return;
+    for (const auto& item : sequence->items) Emit(item);
+    sequence->items.clear();
+}
+
+void ClashYamlReader::Emit(const NodePtr& item) {
+    stats_.items++;
+    if (!item || item->kind != Node::Kind::Map) return;
+
+    std::map<std::string, NodeValue> props;
+    Flatten(*item, &props, 0);
+    NodeRecord record;
+    if (!NodeParser::ClashPropsToRecord(std::move(props), &record)) return;
+    stats_.nodes++;
+    if (callback_) callback_(std::move(record));
+}
+
+void ClashYamlReader::Flatten(const Node& map, std::map<std::string, NodeValue>* props, int depth) {
+    for (const auto& [key, value] : map.entries) {
+        if (!value) continue;
+        switch (value->kind) {
+            case Node::Kind::Scalar:
+                (*props)[key] = value->quoted ? NodeValue(value->scalar) : NodeParser::ScalarValue(value->scalar);
+                break;
+            case Node::Kind::Seq: {
+                std::vector<std::string> list;
+                for (const auto& item : value->items) {
+                    if (item && item->kind == Node::Kind::Scalar) list.push_back(item->scalar);
+                }
+                (*props)[key] = std::move(list);
+                break;
+            }
+            case Node::Kind::Map:
+                // Same as the block parser: nested keys join the item's own
+                if (depth < kMaxDepth) Flatten(*value, props, depth + 1);
+                break;
+            case Node::Kind::Null:
+                break;
+        }
+    }
+}
+
+std::vector<ClashYamlReader::BenchmarkRun> ClashYamlReader::Benchmark(size_t count) {
+    std::vector<BenchmarkRun> runs;
+    for (const char* style : {"block", "flow", "anchors"}) {
+        std::string text = BenchmarkDocument(style, count);
+
+        size_t nodes = 0;
+        ClashYamlReader reader([&nodes](NodeRecord) { nodes++; });
+        auto start = std::chrono::steady_clock::now();
+        for (size_t at = 0; at < text.size(); at += kBenchmarkChunk) {
+            reader.Feed(text.data() + at, std::min(kBenchmarkChunk, text.size() - at));
+        }
+        reader.Finish();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        BenchmarkRun run;
+        run.style = style;
+        run.bytes = static_cast<int64_t>(text.size());
+        run.proxies = reader.GetStats().items;
+        run.nodes = nodes;
+        run.elapsedMs = std::chrono::duration<double, std::milli>(elapsed).count();
+        if (run.elapsedMs > 0) {
+            run.mbPerSec = static_cast<double>(run.bytes) / (1024.0 * 1024.0) / (run.elapsedMs / 1000.0);
+        }
+        runs.push_back(std::move(run));
+    }
+    return runs;
+}
@@ -0,0 +1,500 @@
+// connection_stats.cpp - Connection lifecycle statistics implementation
+#include "connection_stats.h"
+#include "controller_streams.h"
+#include "flight_recorder.h"
+#include "json_reader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+const char kStreamName[] = "core.connection_stats";
+
+// Keys kept per group; the least recently seen idle one makes room
+constexpr size_t kMaxKeys = 2048;
+
+// Processes remembered per host for attribution
+constexpr size_t kMaxProcessesPerHost = 16;
+
+const char* FindKey(const char* at, const char* end, const char* key) {
+    std::string needle = std::string("\"") + key + "\":";
+    const char* found = std::search(at, end, needle.begin(), needle.end());
+    if (found == end) return nullptr;
+    found += needle.size();
+    while (found < end && *found == ' ') found++;
+    return found;
+}
+
+int64_t FindJsonInt(const char* at, const char* end, const char* key) {
+    const char* value = FindKey(at, end, key);
+    if (!value) return 0;
+    int64_t result = 0;
+    for (; value < end && *value >= '0' && *value <= '9'; value++) {
+        result = result * 10 + (*value - '0');
+    }
+    return result;
+}
+
+size_t Bucket(const std::vector<int64_t>& bounds, int64_t value) {
+    return std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+}
+
+int64_t UnixNow() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+// One labelled series per summary: totals carry no label, hosts and
+// processes their key
+struct MetricSeries {
+    std::string labels;  // Without braces, empty for the totals
+    const ConnectionStats::Summary* summary;
+};
+
+std::string LabelValue(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+std::string FormatNumber(double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.6g", value);
+    return buffer;
+}
+
+void AppendHeader(std::string* out, const char* name, const char* type, const char* help) {
+    *out += std::string("# HELP ") + name + " " + help + "\n";
+    *out += std::string("# TYPE ") + name + " " + type + "\n";
+}
+
+void AppendSample(std::string* out, const std::string& name, const std::string& labels,
+                  const std::string& value) {
+    *out += name;
+    if (!labels.empty()) *out += "{" + labels + "}";
+    *out += " " + value + "\n";
+}
+
+void AppendMetric(std::string* out, const char* name, const char* type, const char* help,
+                  const std::vector<MetricSeries>& series,
+                  double (*value)(const ConnectionStats::Summary& summary)) {
+    AppendHeader(out, name, type, help);
+    for (const auto& item : series) AppendSample(out, name, item.labels, FormatNumber(value(*item.summary)));
+}
+
+void AppendHistogram(std::string* out, const char* name, const char* help,
+                     const std::vector<MetricSeries>& series, const std::vector<int64_t>& bounds,
+                     bool durations) {
+    AppendHeader(out, name, "histogram", help);
+    for (const auto& item : series) {
+        const ConnectionStats::Summary& summary = *item.summary;
+        const std::vector<int64_t>& counts = durations ? summary.durations : summary.bytes;
+        std::string prefix = item.labels.empty() ? "" : item.labels + ",";
+        int64_t cumulative = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            cumulative += counts[i];
+            std::string le = i < bounds.size() ? std::to_string(bounds[i]) : "+Inf";
+            AppendSample(out, std::string(name) + "_bucket", prefix + "le=\"" + le + "\"",
+                         std::to_string(cumulative));
+        }
+        double mean = durations ? summary.meanDurationMs : summary.meanBytes;
+        AppendSample(out, std::string(name) + "_sum", item.labels,
+                     std::to_string(std::llround(mean * summary.closed)));
+        AppendSample(out, std::string(name) + "_count", item.labels, std::to_string(summary.closed));
+    }
+}
+
+}  // namespace
+
+const std::vector<int64_t>& ConnectionStats::DurationBounds() {
+    static const std::vector<int64_t> bounds = {
+        1000, 2000, 5000, 10000, 30000, 60000, 300000, 1800000,
+    };
+    return bounds;
+}
+
+const std::vector<int64_t>& ConnectionStats::BytesBounds() {
+    static const std::vector<int64_t> bounds = {
+        1 << 10, 4 << 10, 16 << 10, 64 << 10, 256 << 10, 1 << 20, 4 << 20, 16 << 20, 64 << 20,
+    };
+    return bounds;
+}
+
+ConnectionStats& ConnectionStats::GetInstance() {
+    static ConnectionStats instance;
+    return instance;
+}
+
+ConnectionStats::ConnectionStats() {
+    totals_.durations.assign(DurationBounds().size() + 1, 0);
+    totals_.bytes.assign(BytesBounds().size() + 1, 0);
+}
+
+void ConnectionStats::Start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_.clear();
+        baseline_ = true;
+    }
+
+    ControllerStreams::StreamOptions options;
+    options.path = "/connections";
+    options.mode = ControllerStreams::Mode::Latest;
+    ControllerStreams::GetInstance().Subscribe(kStreamName, options,
+        [this](const ControllerStreams::Batch& batch) {
+            int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            for (const auto& message : batch.messages) {
+                Ingest(message.data(), message.size(), nowMs);
+            }
+        });
+}
+
+void ConnectionStats::Stop() {
+    ControllerStreams::GetInstance().Unsubscribe(kStreamName);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Whatever is still open was cut by the stop, not closed by its owner
+    for (const auto& item : open_) {
+        if (item.second.baseline) continue;
+        auto host = hosts_.find(item.second.host);
+        if (host != hosts_.end() && host->second.active > 0) host->second.active--;
+        auto process = processes_.find(item.second.process);
+        if (process != processes_.end() && process->second.active > 0) process->second.active--;
+        if (totals_.active > 0) totals_.active--;
+    }
+    open_.clear();
+}
+
+void ConnectionStats::Ingest(const char* data, size_t size, int64_t nowMs) {
+    const char* end = data + size;
+    const std::string idKey = "\"id\":";
+    int64_t now = UnixNow();
+    std::vector<ChurnEvent> events;
+    ChurnCallback callback;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool baseline = baseline_;
+        baseline_ = false;
+        lastSnapshotMs_ = nowMs;
+
+        // Each connection object starts with its id; its fields lie before
+        // the next id
+        const char* at = std::search(data, end, idKey.begin(), idKey.end());
+        while (at != end) {
+            std::string id;
+            const char* next = ReadJsonString(at + idKey.size(), end, &id);
+            if (!next) break;
+            const char* objectEnd = std::search(next, end, idKey.begin(), idKey.end());
+
+            int64_t bytes = FindJsonInt(next, objectEnd, "upload") + FindJsonInt(next, objectEnd, "download");
+            auto existing = open_.find(id);
+            if (existing != open_.end()) {
+                existing->second.lastSeenMs = nowMs;
+                existing->second.bytes = bytes;
+            } else {
+                Open open;
+                if (!FindJsonString(next, objectEnd, "host", &open.host) || open.host.empty()) {
+                    FindJsonString(next, objectEnd, "destinationIP", &open.host);
+                }
+                FindJsonString(next, objectEnd, "process", &open.process);
+                open.firstSeenMs = nowMs;
+                open.lastSeenMs = nowMs;
+                open.bytes = bytes;
+                open.baseline = baseline;
+
+                if (!baseline) {
+                    Entry& host = Touch(hosts_, open.host, now);
+                    RecordOpen(host, nowMs, now);
+                    if (host.processes.size() < kMaxProcessesPerHost || host.processes.count(open.process)) {
+                        host.processes[open.process]++;
+                    }
+                    RecordOpen(Touch(processes_, open.process, now), nowMs, now);
+                    RecordOpen(totals_, nowMs, now);
+                }
+                open_.emplace(std::move(id), std::move(open));
+            }
+            at = objectEnd;
+        }
+
+        // Whatever this snapshot no longer lists has closed
+        for (auto it = open_.begin(); it != open_.end();) {
+            if (it->second.lastSeenMs == nowMs) {
+                ++it;
+                continue;
+            }
+            const Open& open = it->second;
+            if (!open.baseline) {
+                RecordClose(Touch(hosts_, open.host, now), open, nowMs);
+                RecordClose(Touch(processes_, open.process, now), open, nowMs);
+                RecordClose(totals_, open, nowMs);
+            }
+            it = open_.erase(it);
+        }
+
+        Evaluate(Group::Host, hosts_, nowMs, &events);
+        Evaluate(Group::Process, processes_, nowMs, &events);
+        callback = callback_;
+    }
+
+    for (const auto& event : events) {
+        FlightRecorder::Record(FlightRecorder::Category::Network,
+                               event.summary.churning ? FlightRecorder::Level::Warning
+                                                      : FlightRecorder::Level::Info,
+                               (event.summary.churning ? "churn " : "churn over ") + event.summary.key,
+                               static_cast<int64_t>(event.summary.openRate));
+        if (callback) callback(event);
+    }
+}
+
+ConnectionStats::Entry& ConnectionStats::Touch(std::unordered_map<std::string, Entry>& entries,
+                                               const std::string& key, int64_t now) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        if (entries.size() >= kMaxKeys) {
+            auto oldest = entries.end();
+            for (auto candidate = entries.begin(); candidate != entries.end(); ++candidate) {
+                if (candidate->second.active > 0) continue;
+                if (oldest == entries.end() || candidate->second.lastSeen < oldest->second.lastSeen) {
+                    oldest = candidate;
+                }
+            }
+            if (oldest != entries.end()) entries.erase(oldest);
+        }
+        it = entries.emplace(key, Entry()).first;
+        it->second.durations.assign(DurationBounds().size() + 1, 0);
+        it->second.bytes.assign(BytesBounds().size() + 1, 0);
+    }
+    it->second.lastSeen = now;
+    return it->second;
+}
+
+void ConnectionStats::RecordOpen(Entry& entry, int64_t nowMs, int64_t now) {
+    int64_t slice = nowMs / kSliceMs;
+    int index = static_cast<int>(slice % kSlices);
+    Window& window = entry.window;
+    if (window.slice[index] != slice) {
+        window.slice[index] = slice;
+        window.opens[index] = 0;
+        window.closes[index] = 0;
+        window.shortCloses[index] = 0;
+    }
+    window.opens[index]++;
+    entry.opened++;
+    entry.active++;
+    entry.lastSeen = now;
+}
+
+void ConnectionStats::RecordClose(Entry& entry, const Open& open, int64_t nowMs) {
+    int64_t durationMs = open.lastSeenMs - open.firstSeenMs;
+    entry.durations[Bucket(DurationBounds(), durationMs)]++;
+    entry.bytes[Bucket(BytesBounds(), open.bytes)]++;
+    entry.totalDurationMs += durationMs;
+    entry.totalBytes += open.bytes;
+    entry.closed++;
+    if (entry.active > 0) entry.active--;
+
+    int64_t slice = nowMs / kSliceMs;
+    int index = static_cast<int>(slice % kSlices);
+    Window& window = entry.window;
+    if (window.slice[index] != slice) {
+        window.slice[index] = slice;
+        window.opens[index] = 0;
+        window.closes[index] = 0;
+        window.shortCloses[index] = 0;
+    }
+    window.closes[index]++;
+    if (durationMs < options_.shortLivedMs) window.shortCloses[index]++;
+}
+
+void ConnectionStats::Evaluate(Group group, std::unordered_map<std::string, Entry>& entries,
+                               int64_t nowMs, std::vector<ChurnEvent>* events) {
+    for (auto& item : entries) {
+        Entry& entry = item.second;
+        if (!entry.churning && entry.window.slice[(nowMs / kSliceMs) % kSlices] != nowMs / kSliceMs) {
+            continue;  // Quiet in the current slice and not flagged: nothing can change
+        }
+
+        Summary summary = Summarize(item.first, entry, nowMs);
+        bool churning = entry.churning
+            ? summary.openRate >= options_.minOpenRate / 2
+            : summary.openRate >= options_.minOpenRate && summary.shortLived >= options_.minShortLived;
+        if (churning == entry.churning) continue;
+
+        entry.churning = churning;
+        summary.churning = churning;
+        ChurnEvent event;
+        event.group = group;
+        event.summary = std::move(summary);
+        events->push_back(std::move(event));
+    }
+}
+
+ConnectionStats::Summary ConnectionStats::Summarize(const std::string& key, const Entry& entry,
+                                                    int64_t nowMs) const {
+    Summary summary;
+    summary.key = key;
+    summary.opened = entry.opened;
+    summary.closed = entry.closed;
+    summary.active = entry.active;
+    summary.durations = entry.durations;
+    summary.bytes = entry.bytes;
+    summary.churning = entry.churning;
+    summary.lastSeen = entry.lastSeen;
+    if (entry.closed > 0) {
+        summary.meanDurationMs = static_cast<double>(entry.totalDurationMs) / entry.closed;
+        summary.meanBytes = static_cast<double>(entry.totalBytes) / entry.closed;
+    }
+
+    int64_t current = nowMs / kSliceMs;
+    int64_t opens = 0;
+    int64_t closes = 0;
+    int64_t shortCloses = 0;
+    for (int i = 0; i < kSlices; i++) {
+        if (entry.window.slice[i] <= current - kSlices || entry.window.slice[i] > current) continue;
+        opens += entry.window.opens[i];
+        closes += entry.window.closes[i];
+        shortCloses += entry.window.shortCloses[i];
+    }
+    summary.openRate = static_cast<double>(opens) * 60000.0 / (kSlices * kSliceMs);
+    summary.shortLived = closes > 0 ? static_cast<double>(shortCloses) / closes : 0;
+
+    int64_t topCount = 0;
+    for (const auto& process : entry.processes) {
+        if (process.second > topCount) {
+            topCount = process.second;
+            summary.topProcess = process.first;
+        }
+    }
+    return summary;
+}
+
+ConnectionStats::Summary ConnectionStats::GetTotals() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Summarize("*", totals_, lastSnapshotMs_);
+}
+
+std::vector<ConnectionStats::Summary> ConnectionStats::GetTop(Group group, size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto& entries = group == Group::Host ? hosts_ : processes_;
+    std::vector<Summary> result;
+    result.reserve(entries.size());
+    for (const auto& item : entries) result.push_back(Summarize(item.first, item.second, lastSnapshotMs_));
+
+    std::sort(result.begin(), result.end(), [](const Summary& a, const Summary& b) {
+        if (a.openRate != b.openRate) return a.openRate > b.openRate;
+        return a.opened > b.opened;
+    });
+    if (result.size() > limit) result.resize(limit);
+    return result;
+}
+
+std::vector<ConnectionStats::Summary> ConnectionStats::GetChurning(Group group) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto& entries = group == Group::Host ? hosts_ : processes_;
+    std::vector<Summary> result;
+    for (const auto& item : entries) {
+        if (item.second.churning) result.push_back(Summarize(item.first, item.second, lastSnapshotMs_));
+    }
+    std::sort(result.begin(), result.end(), [](const Summary& a, const Summary& b) {
+        return a.openRate > b.openRate;
+    });
+    return result;
+}
+
+std::string ConnectionStats::ExportMetrics(size_t limit) {
+    Summary totals = GetTotals();
+    std::vector<Summary> hosts = GetTop(Group::Host, limit);
+    std::vector<Summary> processes = GetTop(Group::Process, limit);
+
+    std::vector<MetricSeries> series;
+    series.push_back({"", &totals});
+    for (const auto& host : hosts) series.push_back({"host=\"" + LabelValue(host.key) + "\"", &host});
+    for (const auto& process : processes) {
+        series.push_back({"process=\"" + LabelValue(process.key) + "\"", &process});
+    }
+
+    std::string out;
+    AppendMetric(&out, "vortex_connections_opened_total", "counter", "Connections seen opening.", series,
+                [](const Summary& summary) { return static_cast<double>(summary.opened); });
+    AppendMetric(&out, "vortex_connections_closed_total", "counter", "Connections seen closing.", series,
+                [](const Summary& summary) { return static_cast<double>(summary.closed); });
+    AppendMetric(&out, "vortex_connections_active", "gauge", "Connections open in the last snapshot.", series,
+                [](const Summary& summary) { return static_cast<double>(summary.active); });
+    AppendMetric(&out, "vortex_connections_open_rate", "gauge",
+                "Connections opened per minute over the sliding window.", series,
+                [](const Summary& summary) { return summary.openRate; });
+    AppendMetric(&out, "vortex_connections_short_lived_ratio", "gauge",
+                "Share of the window's closes that were short-lived.", series,
+                [](const Summary& summary) { return summary.shortLived; });
+    AppendMetric(&out, "vortex_connections_churning", "gauge", "1 while flagged for churn.", series,
+                [](const Summary& summary) { return summary.churning ? 1.0 : 0.0; });
+    AppendHistogram(&out, "vortex_connection_duration_ms", "Lifetime of closed connections.", series,
+                    DurationBounds(), true);
+    AppendHistogram(&out, "vortex_connection_bytes", "Bytes moved by closed connections.", series,
+                    BytesBounds(), false);
+    return out;
+}
+
+void ConnectionStats::SetOptions(const Options& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+ConnectionStats::Options ConnectionStats::GetOptions() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+void ConnectionStats::SetCallback(ChurnCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = std::move(callback);
+}
+
+size_t ConnectionStats::Trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (auto* entries : {&hosts_, &processes_}) {
+        for (auto it = entries->begin(); it != entries->end();) {
+            const Entry& entry = it->second;
+            if (entry.active > 0 || entry.churning) {
+                ++it;
+                continue;
+            }
+            bytes += sizeof(Entry) + it->first.capacity() +
+                     (entry.durations.capacity() + entry.bytes.capacity()) * sizeof(int64_t);
+            for (const auto& process : entry.processes) {
+                bytes += sizeof(std::pair<const std::string, int64_t>) + process.first.capacity();
+            }
+            it = entries->erase(it);
+        }
+        entries->rehash(0);
+    }
+    return bytes;
+}
+
+void ConnectionStats::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hosts_.clear();
+    processes_.clear();
+    totals_ = Entry();
+    totals_.durations.assign(DurationBounds().size() + 1, 0);
+    totals_.bytes.assign(BytesBounds().size() + 1, 0);
+
+    // Connections open now were opened before the reset
+    for (auto& item : open_) item.second.baseline = true;
+}
@@ -0,0 +1,151 @@
+// connection_stats.h - Connection lifecycle histograms and churn detection for Windows
+#ifndef CONNECTION_STATS_H_
+#define CONNECTION_STATS_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Follows the core's /connections stream and diffs consecutive snapshots:
+// an id that appears is an open, an id that disappears is a close. Closed
+// connections feed a duration and a bytes histogram, and opens feed a
+// sliding-window rate, kept per destination host and per process.
+//
+// A host or process is flagged as churning while it opens connections
+// faster than Options::minOpenRate and most of the ones it closes in the
+// window were short-lived. The flag clears once the rate falls under half
+// the threshold. Every change of the flag is reported through the callback
+// and the flight recorder.
+//
+// The stream is a snapshot per second, so durations have that resolution
+// and connections that open and close between two snapshots are never
+// seen; real churn is at least what is reported here.
+class ConnectionStats {
+public:
+    enum class Group { Host, Process };
+
+    struct Options {
+        double minOpenRate = 30;       // Opens per minute
+        double minShortLived = 0.5;    // Fraction of closes in the window
+        int64_t shortLivedMs = 2000;
+    };
+
+    // Upper bounds; the last bucket counts everything larger
+    static const std::vector<int64_t>& DurationBounds();  // ms
+    static const std::vector<int64_t>& BytesBounds();
+
+    struct Summary {
+        std::string key;             // Host or process; "*" for the totals
+        std::string topProcess;      // Hosts only: the process opening most of them
+        int64_t opened = 0;
+        int64_t closed = 0;
+        int64_t active = 0;
+        double openRate = 0;         // Per minute, over the window
+        double shortLived = 0;       // Fraction of closes in the window
+        double meanDurationMs = 0;
+        double meanBytes = 0;
+        std::vector<int64_t> durations;  // DurationBounds().size() + 1 buckets
+        std::vector<int64_t> bytes;      // BytesBounds().size() + 1 buckets
+        bool churning = false;
+        int64_t lastSeen = 0;        // Unix seconds
+    };
+
+    struct ChurnEvent {
+        Group group = Group::Host;
+        Summary summary;
+    };
+
+    using ChurnCallback = std::function<void(const ChurnEvent& event)>;
+
+    static ConnectionStats& GetInstance();
+
+    // Start and stop following the stream; counts survive a restart
+    void Start();
+    void Stop();
+
+    // Feeds one /connections snapshot taken at nowMs (steady clock).
+    // Exposed so recorded snapshots can be replayed.
+    void Ingest(const char* data, size_t size, int64_t nowMs);
+
+    Summary GetTotals();
+
+    // Busiest first, by current open rate and then by total opens
+    std::vector<Summary> GetTop(Group group, size_t limit);
+    std::vector<Summary> GetChurning(Group group);
+
+    // Totals and the top limit hosts and processes in the Prometheus text
+    // exposition format: counters and gauges per key, and the duration and
+    // bytes histograms with cumulative buckets
+    std::string ExportMetrics(size_t limit);
+
+    void SetOptions(const Options& options);
+    Options GetOptions();
+    void SetCallback(ChurnCallback callback);
+    void Reset();
+
+    // Forgets hosts and processes with nothing open that are not flagged;
+    // the totals stay. Returns the approximate bytes released.
+    size_t Trim();
+
+private:
+    // Opens, closes and short-lived closes per slice of the window
+    static constexpr int kSlices = 12;
+    static constexpr int64_t kSliceMs = 5000;
+
+    struct Window {
+        int64_t slice[kSlices] = {};
+        int32_t opens[kSlices] = {};
+        int32_t closes[kSlices] = {};
+        int32_t shortCloses[kSlices] = {};
+    };
+
+    struct Entry {
+        int64_t opened = 0;
+        int64_t closed = 0;
+        int64_t active = 0;
+        int64_t totalDurationMs = 0;
+        int64_t totalBytes = 0;
+        std::vector<int64_t> durations;
+        std::vector<int64_t> bytes;
+        Window window;
+        std::map<std::string, int64_t> processes;  // Hosts only
+        bool churning = false;
+        int64_t lastSeen = 0;
+    };
+
+    struct Open {
+        std::string host;
+        std::string process;
+        int64_t firstSeenMs = 0;
+        int64_t lastSeenMs = 0;
+        int64_t bytes = 0;
+        bool baseline = false;  // Already open when tracking started
+    };
+
+    ConnectionStats();
+    ConnectionStats(const ConnectionStats&) = delete;
+    ConnectionStats& operator=(const ConnectionStats&) = delete;
+
+    Entry& Touch(std::unordered_map<std::string, Entry>& entries, const std::string& key, int64_t now);
+    void RecordOpen(Entry& entry, int64_t nowMs, int64_t now);
+    void RecordClose(Entry& entry, const Open& open, int64_t nowMs);
+    void Evaluate(Group group, std::unordered_map<std::string, Entry>& entries, int64_t nowMs,
+                  std::vector<ChurnEvent>* events);
+    Summary Summarize(const std::string& key, const Entry& entry, int64_t nowMs) const;
+
+    std::mutex mutex_;
+    Options options_;
+    ChurnCallback callback_;
+    std::unordered_map<std::string, Open> open_;  // By connection id
+    std::unordered_map<std::string, Entry> hosts_;
+    std::unordered_map<std::string, Entry> processes_;
+    Entry totals_;
+    bool baseline_ = true;  // The next snapshot only records what is open
+    int64_t lastSnapshotMs_ = 0;
+};
+
+#endif  // CONNECTION_STATS_H_
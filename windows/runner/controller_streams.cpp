@@ -0,0 +1,422 @@
+// controller_streams.cpp - Streaming controller endpoints implementation
+// winsock2.h must come before anything that pulls in windows.h
+#include <winsock2.h>
+
+#include "controller_streams.h"
+#include "controller_trace.h"
+#include "flight_recorder.h"
+#include "idle_budget.h"
+#include "websocket.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr int kInitialBackoffMs = 500;
+constexpr int kMaxBackoffMs = 30000;
+
+// WSAWaitForMultipleEvents takes at most 64 events, one is the wake event
+constexpr size_t kMaxConnections = 63;
+
+}  // namespace
+
+struct ControllerStreams::Subscriber {
+    std::string name;
+    StreamOptions options;
+    MessageCallback callback;
+
+    std::string latest;                 // Latest mode
+    bool hasLatest = false;
+    std::vector<std::string> pending;   // Queue mode
+    int64_t dropped = 0;                // Since the last batch
+    int64_t droppedTotal = 0;
+    uint64_t lastDelivery = 0;
+
+    bool HasData() const { return hasLatest || !pending.empty(); }
+};
+
+struct ControllerStreams::Connection {
+    std::string path;
+    WebSocketConnection socket;
+    WSAEVENT event = WSA_INVALID_EVENT;
+    WebSocketConnection::MessageHandler handler;
+    std::vector<std::shared_ptr<Subscriber>> subscribers;
+
+    uint64_t retryAt = 0;
+    int backoffMs = 0;
+    bool paused = false;
+    int reconnects = 0;
+    std::string lastError;
+
+    bool QueueFull() const {
+        for (const auto& subscriber : subscribers) {
+            if (subscriber->options.mode == Mode::Queue &&
+                subscriber->pending.size() >= subscriber->options.maxPending) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool QueueDrained() const {
+        for (const auto& subscriber : subscribers) {
+            if (subscriber->options.mode == Mode::Queue &&
+                subscriber->pending.size() > subscriber->options.maxPending / 2) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+ControllerStreams& ControllerStreams::GetInstance() {
+    static ControllerStreams instance;
+    return instance;
+}
+
+ControllerStreams::~ControllerStreams() {
+    Shutdown();
+}
+
+void ControllerStreams::SetEndpoint(const std::string& host, int port, const std::string& secret) {
+    // A wildcard listen address is reached through loopback
+    std::string target = host;
+    if (target.empty() || target == "0.0.0.0") target = "127.0.0.1";
+    if (target == "::" || target == "[::]") target = "::1";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (target == host_ && port == port_ && secret == secret_) return;
+    host_ = target;
+    port_ = port;
+    secret_ = secret;
+    endpointChanged_ = true;
+    Wake();
+}
+
+bool ControllerStreams::Subscribe(const std::string& name, const StreamOptions& options,
+                                  MessageCallback callback) {
+    if (name.empty() || options.path.empty() || options.path[0] != '/') return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!EnsureStarted()) return false;
+
+    // Drop any previous subscription under this name
+    for (auto& connection : connections_) {
+        auto& subscribers = connection->subscribers;
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+            [&](const std::shared_ptr<Subscriber>& s) { return s->name == name; }), subscribers.end());
+    }
+
+    Connection* target = nullptr;
+    for (auto& connection : connections_) {
+        if (connection->path == options.path) {
+            target = connection.get();
+            break;
+        }
+    }
+
+    if (!target) {
+        if (connections_.size() >= kMaxConnections) return false;
+
+        auto connection = std::make_unique<Connection>();
+        connection->path = options.path;
+        connection->event = WSACreateEvent();
+        if (connection->event == WSA_INVALID_EVENT) return false;
+
+        // Runs on the reader thread with mutex_ held
+        Connection* self = connection.get();
+        connection->handler = [self](const char* data, size_t size) {
+            self->backoffMs = 0;
+            ControllerTrace::RecordMessage(self->path, data, size);
+            for (auto& subscriber : self->subscribers) {
+                if (subscriber->options.mode == Mode::Latest) {
+                    if (subscriber->hasLatest) {
+                        subscriber->dropped++;
+                        subscriber->droppedTotal++;
+                    }
+                    subscriber->latest.assign(data, size);
+                    subscriber->hasLatest = true;
+                } else {
+                    subscriber->pending.emplace_back(data, size);
+                }
+            }
+            return !self->QueueFull();
+        };
+
+        target = connection.get();
+        connections_.push_back(std::move(connection));
+    }
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->name = name;
+    subscriber->options = options;
+    subscriber->options.maxPending = std::max<size_t>(options.maxPending, 1);
+    subscriber->callback = std::move(callback);
+    target->subscribers.push_back(std::move(subscriber));
+
+    Wake();
+    return true;
+}
+
+void ControllerStreams::Unsubscribe(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& connection : connections_) {
+        auto& subscribers = connection->subscribers;
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+            [&](const std::shared_ptr<Subscriber>& s) { return s->name == name; }), subscribers.end());
+    }
+    // The reader thread closes connections left without subscribers; it may
+    // be waiting on their events right now
+    Wake();
+}
+
+void ControllerStreams::Reconnect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& connection : connections_) {
+        if (connection->socket.state() == WebSocketConnection::State::Closed) {
+            connection->retryAt = 0;
+            connection->backoffMs = 0;
+        }
+    }
+    Wake();
+}
+
+std::vector<ControllerStreams::StreamStatus> ControllerStreams::GetStatus() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<StreamStatus> result;
+    for (const auto& connection : connections_) {
+        std::string state;
+        switch (connection->socket.state()) {
+            case WebSocketConnection::State::Open: state = "open"; break;
+            case WebSocketConnection::State::Closed: state = host_.empty() ? "idle" : "waiting"; break;
+            default: state = "connecting"; break;
+        }
+
+        const auto& stats = connection->socket.stats();
+        for (const auto& subscriber : connection->subscribers) {
+            StreamStatus status;
+            status.name = subscriber->name;
+            status.path = connection->path;
+            status.state = state;
+            status.deflate = connection->socket.deflate();
+            status.paused = connection->paused;
+            status.messages = stats.messages;
+            status.wireBytes = stats.wireBytes;
+            status.messageBytes = stats.messageBytes;
+            status.dropped = subscriber->droppedTotal;
+            status.reconnects = connection->reconnects;
+            status.lastError = connection->lastError;
+            result.push_back(status);
+        }
+    }
+    return result;
+}
+
+void ControllerStreams::Shutdown() {
+    if (running_) {
+        running_ = false;
+        Wake();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& connection : connections_) {
+        connection->socket.Close();
+        WSACloseEvent(connection->event);
+    }
+    connections_.clear();
+
+    if (wakeEvent_) {
+        WSACloseEvent(static_cast<WSAEVENT>(wakeEvent_));
+        wakeEvent_ = nullptr;
+    }
+    if (winsockReady_) {
+        WSACleanup();
+        winsockReady_ = false;
+    }
+}
+
+bool ControllerStreams::EnsureStarted() {
+    if (running_) return true;
+
+    if (!winsockReady_) {
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) return false;
+        winsockReady_ = true;
+    }
+
+    if (!wakeEvent_) {
+        wakeEvent_ = WSACreateEvent();
+        if (wakeEvent_ == WSA_INVALID_EVENT) {
+            wakeEvent_ = nullptr;
+            return false;
+        }
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+}
+
+size_t ControllerStreams::Trim() {
+    size_t bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& connection : connections_) {
+            for (auto& subscriber : connection->subscribers) {
+                if (subscriber->pending.empty()) continue;
+                for (const auto& message : subscriber->pending) bytes += sizeof(std::string) + message.capacity();
+                subscriber->dropped += static_cast<int64_t>(subscriber->pending.size());
+                subscriber->droppedTotal += static_cast<int64_t>(subscriber->pending.size());
+                std::vector<std::string>().swap(subscriber->pending);
+            }
+        }
+    }
+    // A paused connection resumes on the next pass
+    if (bytes > 0) Wake();
+    return bytes;
+}
+
+void ControllerStreams::Wake() {
+    if (wakeEvent_) WSASetEvent(static_cast<WSAEVENT>(wakeEvent_));
+}
+
+void ControllerStreams::Run() {
+    IdleBudget::TagThread("controller_streams");
+    std::vector<WSAEVENT> events;
+    std::vector<std::pair<MessageCallback, Batch>> ready;
+
+    while (running_) {
+        // Wait for socket activity, a wake-up, or the nearest retry or
+        // delivery deadline
+        DWORD timeout = WSA_INFINITE;
+        events.clear();
+        events.push_back(static_cast<WSAEVENT>(wakeEvent_));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t now = GetTickCount64();
+            auto waitUntil = [&](uint64_t due) {
+                DWORD wait = due > now ? static_cast<DWORD>(due - now) : 0;
+                timeout = std::min(timeout, wait);
+            };
+
+            for (const auto& connection : connections_) {
+                events.push_back(connection->event);
+                if (connection->socket.state() == WebSocketConnection::State::Closed && !host_.empty()) {
+                    waitUntil(connection->retryAt);
+                }
+                for (const auto& subscriber : connection->subscribers) {
+                    if (subscriber->HasData()) {
+                        waitUntil(subscriber->lastDelivery + subscriber->options.minIntervalMs);
+                    }
+                }
+            }
+        }
+
+        WSAWaitForMultipleEvents(static_cast<DWORD>(events.size()), events.data(), FALSE, timeout, FALSE);
+        WSAResetEvent(static_cast<WSAEVENT>(wakeEvent_));
+        if (!running_) break;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t now = GetTickCount64();
+
+            for (auto it = connections_.begin(); it != connections_.end();) {
+                if ((*it)->subscribers.empty()) {
+                    (*it)->socket.Close();
+                    WSACloseEvent((*it)->event);
+                    it = connections_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            if (endpointChanged_) {
+                endpointChanged_ = false;
+                for (auto& connection : connections_) {
+                    connection->socket.Close();
+                    connection->paused = false;
+                    connection->retryAt = 0;
+                    connection->backoffMs = 0;
+                }
+            }
+
+            for (auto& connection : connections_) {
+                ProcessConnection(*connection, now);
+            }
+
+            for (auto& connection : connections_) {
+                for (auto& subscriber : connection->subscribers) {
+                    if (!subscriber->HasData() ||
+                        now < subscriber->lastDelivery + subscriber->options.minIntervalMs) {
+                        continue;
+                    }
+
+                    Batch batch;
+                    batch.name = subscriber->name;
+                    if (subscriber->options.mode == Mode::Latest) {
+                        batch.messages.push_back(std::move(subscriber->latest));
+                        subscriber->latest.clear();
+                        subscriber->hasLatest = false;
+                    } else {
+                        batch.messages.swap(subscriber->pending);
+                    }
+                    batch.dropped = subscriber->dropped;
+                    subscriber->dropped = 0;
+                    subscriber->lastDelivery = now;
+                    ready.emplace_back(subscriber->callback, std::move(batch));
+                }
+
+                // Whatever this reads is delivered on the next pass
+                if (connection->paused && connection->QueueDrained()) {
+                    connection->paused = false;
+                    if (!connection->socket.Resume(connection->handler)) {
+                        ScheduleRetry(*connection, now);
+                    } else {
+                        connection->paused = connection->QueueFull();
+                    }
+                }
+            }
+        }
+
+        for (auto& item : ready) {
+            if (item.first) item.first(item.second);
+        }
+        ready.clear();
+    }
+}
+
+bool ControllerStreams::ProcessConnection(Connection& connection, uint64_t now) {
+    auto& socket = connection.socket;
+
+    if (socket.state() == WebSocketConnection::State::Closed) {
+        if (host_.empty() || now < connection.retryAt) return false;
+        if (!socket.Connect(host_, port_, connection.path, secret_, true, connection.event)) {
+            ScheduleRetry(connection, now);
+            return false;
+        }
+        return true;
+    }
+
+    if (!socket.Process(connection.handler, !connection.paused)) {
+        ScheduleRetry(connection, now);
+        return false;
+    }
+    connection.paused = connection.QueueFull();
+    return true;
+}
+
+void ControllerStreams::ScheduleRetry(Connection& connection, uint64_t now) {
+    connection.lastError = connection.socket.error();
+    connection.paused = false;
+    connection.reconnects++;
+    connection.backoffMs = connection.backoffMs == 0
+        ? kInitialBackoffMs
+        : std::min(connection.backoffMs * 2, kMaxBackoffMs);
+    connection.retryAt = now + connection.backoffMs;
+
+    FlightRecorder::Record(FlightRecorder::Category::Controller, FlightRecorder::Level::Warning,
+                           "ws " + connection.path + " " + connection.lastError, connection.backoffMs);
+}
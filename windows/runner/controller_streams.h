@@ -0,0 +1,107 @@
+// controller_streams.h - Streaming controller endpoints over WebSocket for Windows
+#ifndef CONTROLLER_STREAMS_H_
+#define CONTROLLER_STREAMS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps the core's streaming endpoints (/traffic, /logs, /connections,
+// /memory) open as WebSocket connections served by a single reader thread.
+// Subscribers that ask for the same path share one connection. Each
+// subscriber picks how it is fed:
+//   Latest - only the newest message is kept, at most one batch per interval
+//   Queue  - every message is kept; once maxPending are waiting the socket
+//            is no longer read, which pushes back on the core, and reading
+//            resumes when the backlog falls to half
+// Dropped connections are retried with exponential backoff.
+class ControllerStreams {
+public:
+    enum class Mode { Latest, Queue };
+
+    struct StreamOptions {
+        std::string path;
+        Mode mode = Mode::Latest;
+        int minIntervalMs = 0;    // Minimum spacing between batches
+        size_t maxPending = 256;  // Queue mode only
+    };
+
+    struct Batch {
+        std::string name;
+        std::vector<std::string> messages;
+        int64_t dropped = 0;  // Superseded in Latest mode since the last batch
+    };
+
+    // Called on the reader thread, outside any lock
+    using MessageCallback = std::function<void(const Batch& batch)>;
+
+    struct StreamStatus {
+        std::string name;
+        std::string path;
+        std::string state;  // "connecting", "open", "waiting" or "idle"
+        bool deflate = false;
+        bool paused = false;
+        int64_t messages = 0;
+        int64_t wireBytes = 0;
+        int64_t messageBytes = 0;
+        int64_t dropped = 0;
+        int reconnects = 0;
+        std::string lastError;
+    };
+
+    static ControllerStreams& GetInstance();
+
+    // Where the core's controller listens. A changed endpoint reconnects
+    // every stream.
+    void SetEndpoint(const std::string& host, int port, const std::string& secret);
+
+    // Replaces an existing subscription with the same name
+    bool Subscribe(const std::string& name, const StreamOptions& options, MessageCallback callback);
+    void Unsubscribe(const std::string& name);
+
+    // Retries waiting connections now instead of after their backoff
+    void Reconnect();
+
+    std::vector<StreamStatus> GetStatus();
+
+    // Drops messages queued for delivery, counting them as dropped, and
+    // wakes paused connections. Latest values are kept. Returns the
+    // approximate bytes released.
+    size_t Trim();
+
+    void Shutdown();
+
+private:
+    struct Subscriber;
+    struct Connection;
+
+    ControllerStreams() = default;
+    ~ControllerStreams();
+    ControllerStreams(const ControllerStreams&) = delete;
+    ControllerStreams& operator=(const ControllerStreams&) = delete;
+
+    bool EnsureStarted();
+    void Run();
+    void Wake();
+    bool ProcessConnection(Connection& connection, uint64_t now);
+    void ScheduleRetry(Connection& connection, uint64_t now);
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+    std::string host_;
+    int port_ = 0;
+    std::string secret_;
+    bool endpointChanged_ = false;
+
+    void* wakeEvent_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    bool winsockReady_ = false;
+};
+
+#endif  // CONTROLLER_STREAMS_H_
@@ -0,0 +1,575 @@
+// controller_trace.cpp - Controller traffic recorder implementation
+#include "controller_trace.h"
+#include "flight_recorder.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
+#include <random>
+
+namespace {
+
+const char kMagic[] = "VXTR";
+constexpr uint8_t kVersion = 2;
+
+constexpr uint8_t kKindRequest = 1;
+constexpr uint8_t kKindMessage = 2;
+
+// Values hashed when redacting: credentials, servers, and who connected
+// where. String arrays under these keys are hashed item by item.
+const char* const kSensitiveKeys[] = {
+    "password", "uuid", "private-key", "pre-shared-key", "public-key", "short-id",
+    "auth", "auth-str", "token", "username", "psk", "obfs-password", "secret",
+    "server", "servername", "sni", "host", "sniffHost", "sourceIP", "destinationIP",
+    "remoteDestination", "inboundIP", "process", "processPath", "rulePayload", "chains",
+};
+
+// Answers from /dns/query name the domain looked up and what it resolved to;
+// elsewhere these keys are too common to hash
+const char* const kDnsKeys[] = {"name", "data"};
+
+// In /proxies, /group and /providers/proxies bodies: proxy, group and
+// provider names. all is a string array.
+const char* const kNameKeys[] = {"name", "now", "all"};
+
+// Objects keyed by proxy or provider name in the same bodies
+const char* const kNameMapKeys[] = {"proxies", "providers"};
+
+// Path segments kept as they are: the controller's own routes. Anything
+// else in a path is a proxy, group, provider or connection name.
+const char* const kPathWords[] = {
+    "proxies", "providers", "rules", "connections", "configs", "traffic", "logs",
+    "memory", "version", "delay", "healthcheck", "group", "dns", "query", "debug",
+    "gc", "cache", "fakeip", "flush", "restart", "upgrade", "geo", "ui",
+};
+
+// Query parameters whose values are kept; every other value is hashed
+const char* const kPlainQueryKeys[] = {"timeout", "expected", "type", "force", "level"};
+
+// Log text, which mixes addresses and hosts, becomes filler
+const char kLogKey[] = "payload";
+
+template <size_t N>
+bool IsListed(const char* const (&list)[N], const char* key, size_t length) {
+    for (const char* listed : list) {
+        if (strlen(listed) == length && memcmp(listed, key, length) == 0) return true;
+    }
+    return false;
+}
+
+void AppendVarint(std::string* out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+// Position after the string starting at the quote at, or end
+size_t SkipString(const char* data, size_t at, size_t end) {
+    for (at++; at < end; at++) {
+        if (data[at] == '\\') {
+            at++;
+        } else if (data[at] == '"') {
+            return at + 1;
+        }
+    }
+    return end;
+}
+
+size_t SkipSpace(const char* data, size_t at, size_t end) {
+    while (at < end && (data[at] == ' ' || data[at] == '\t' || data[at] == '\r' || data[at] == '\n')) at++;
+    return at;
+}
+
+// "r-" and 12 hex digits; safe unquoted in JSON strings, paths and queries
+std::string Token(uint64_t salt, const char* value, size_t length) {
+    uint64_t hash = 14695981039346656037ull ^ salt;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(value[i]);
+        hash *= 1099511628211ull;
+    }
+    static const char kHex[] = "0123456789abcdef";
+    std::string token = "r-";
+    for (int shift = 44; shift >= 0; shift -= 4) token.push_back(kHex[(hash >> shift) & 0xF]);
+    return token;
+}
+
+bool ReadHex4(const char* value, uint32_t* unit) {
+    *unit = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = value[i];
+        if (!isxdigit(static_cast<uint8_t>(c))) return false;
+        *unit = *unit * 16 + static_cast<uint32_t>(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    return true;
+}
+
+void AppendUtf8(uint32_t point, std::string* out) {
+    if (point < 0x80) {
+        out->push_back(static_cast<char>(point));
+    } else if (point < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (point >> 6)));
+        out->push_back(static_cast<char>(0x80 | (point & 0x3F)));
+    } else if (point < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (point >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (point & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | (point >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((point >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (point & 0x3F)));
+    }
+}
+
+// The text of a JSON string's contents. Body strings are hashed as text, as
+// path segments are after percent decoding, so a name gets one token
+// however it was escaped.
+std::string JsonUnescape(const char* value, size_t length) {
+    std::string out;
+    out.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        if (value[i] != '\\' || i + 1 >= length) {
+            out.push_back(value[i]);
+            continue;
+        }
+        char escaped = value[++i];
+        uint32_t unit = 0;
+        switch (escaped) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u':
+                if (i + 4 >= length || !ReadHex4(value + i + 1, &unit)) {
+                    out.push_back(escaped);
+                    break;
+                }
+                i += 4;
+                // A surrogate pair is one code point
+                if (unit >= 0xD800 && unit < 0xDC00 && i + 6 < length && value[i + 1] == '\\' &&
+                    value[i + 2] == 'u') {
+                    uint32_t low = 0;
+                    if (ReadHex4(value + i + 3, &low) && low >= 0xDC00 && low < 0xE000) {
+                        unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                AppendUtf8(unit, &out);
+                break;
+            default:
+                out.push_back(escaped);  // \" \\ and \/
+        }
+    }
+    return out;
+}
+
+// Appends the token for the JSON string starting at the quote at; returns
+// the position after it
+size_t AppendStringToken(const char* data, size_t at, size_t size, uint64_t salt, std::string* out) {
+    size_t end = SkipString(data, at, size);
+    size_t length = end - at >= 2 ? end - at - 2 : 0;
+    const char* text = data + at + 1;
+    out->push_back('"');
+    if (memchr(text, '\\', length)) {
+        std::string unescaped = JsonUnescape(text, length);
+        out->append(Token(salt, unescaped.data(), unescaped.size()));
+    } else {
+        out->append(Token(salt, text, length));
+    }
+    out->push_back('"');
+    return end;
+}
+
+// Segments are hashed decoded, like body strings, so a proxy name in a path
+// gets the same token as the same name in a body
+std::string PercentDecode(const char* value, size_t length) {
+    std::string out;
+    out.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        if (value[i] == '%' && i + 2 < length && isxdigit(static_cast<uint8_t>(value[i + 1])) &&
+            isxdigit(static_cast<uint8_t>(value[i + 2]))) {
+            char hex[3] = {value[i + 1], value[i + 2], 0};
+            out.push_back(static_cast<char>(strtol(hex, nullptr, 16)));
+            i += 2;
+        } else {
+            out.push_back(value[i]);
+        }
+    }
+    return out;
+}
+
+// Hashes every segment that is not a controller route and every query
+// value except the plain ones, e.g. /proxies/<node>/delay?url=<url>
+std::string RedactPath(const std::string& path, uint64_t salt) {
+    size_t query = path.find('?');
+    std::string out;
+    out.reserve(path.size());
+
+    size_t at = 0;
+    size_t pathEnd = query == std::string::npos ? path.size() : query;
+    while (at < pathEnd) {
+        size_t next = path.find('/', at);
+        if (next == std::string::npos || next > pathEnd) next = pathEnd;
+        if (next > at && !IsListed(kPathWords, path.data() + at, next - at)) {
+            std::string segment = PercentDecode(path.data() + at, next - at);
+            out.append(Token(salt, segment.data(), segment.size()));
+        } else {
+            out.append(path, at, next - at);
+        }
+        if (next < pathEnd) out.push_back('/');
+        at = next + 1;
+    }
+    if (query == std::string::npos) return out;
+
+    out.push_back('?');
+    at = query + 1;
+    while (at < path.size()) {
+        size_t next = path.find('&', at);
+        if (next == std::string::npos) next = path.size();
+        size_t equals = path.find('=', at);
+        if (equals == std::string::npos || equals > next ||
+            IsListed(kPlainQueryKeys, path.data() + at, equals - at)) {
+            out.append(path, at, next - at);
+        } else {
+            out.append(path, at, equals + 1 - at);
+            std::string value = PercentDecode(path.data() + equals + 1, next - equals - 1);
+            out.append(Token(salt, value.data(), value.size()));
+        }
+        if (next < path.size()) out.push_back('&');
+        at = next + 1;
+    }
+    return out;
+}
+
+// What a body names besides credentials and addresses, by its path
+enum class Scope {
+    kPlain,
+    kDns,         // /dns/query answers
+    kProxies,     // /proxies, /group and /providers/proxies
+    kGroupDelay,  // /group/<name>/delay: an object keyed by proxy name
+};
+
+Scope ScopeOf(const std::string& path) {
+    std::string route = path.substr(0, path.find('?'));
+    auto startsWith = [&route](const char* prefix) {
+        return route.compare(0, strlen(prefix), prefix) == 0;
+    };
+    if (startsWith("/dns/")) return Scope::kDns;
+    if (startsWith("/group/") && route.size() > 13 && route.compare(route.size() - 6, 6, "/delay") == 0) {
+        return Scope::kGroupDelay;
+    }
+    if (startsWith("/proxies") || startsWith("/group") || startsWith("/providers/proxies")) {
+        return Scope::kProxies;
+    }
+    return Scope::kPlain;
+}
+
+// Copies JSON text to out, rewriting the string values of sensitive keys
+// and, in proxy scopes, every proxy name: name, now and all values and the
+// keys of the objects under proxies and providers. Anything that is not
+// JSON passes through unchanged.
+void Redact(const char* data, size_t size, uint64_t salt, Scope scope, std::string* out) {
+    out->clear();
+    out->reserve(size);
+    bool names = scope == Scope::kProxies || scope == Scope::kGroupDelay;
+    // Strings are consumed whole, so brackets outside them give the nesting
+    int depth = 0;
+    // Depth of the object keyed by names, -1 when outside one
+    int nameMap = scope == Scope::kGroupDelay ? 1 : -1;
+    size_t at = 0;
+    while (at < size) {
+        char c = data[at];
+        if (c != '"') {
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (depth == nameMap) nameMap = -1;
+                depth--;
+            }
+            out->push_back(c);
+            at++;
+            continue;
+        }
+
+        size_t keyEnd = SkipString(data, at, size);
+        size_t colon = SkipSpace(data, keyEnd, size);
+        if (colon >= size || data[colon] != ':') {
+            out->append(data + at, keyEnd - at);
+            at = keyEnd;
+            continue;
+        }
+        if (depth == nameMap) {
+            AppendStringToken(data, at, size, salt, out);
+        } else {
+            out->append(data + at, keyEnd - at);
+        }
+        size_t value = SkipSpace(data, colon + 1, size);
+        if (value >= size) {
+            at = keyEnd;
+            continue;
+        }
+
+        const char* key = data + at + 1;
+        size_t keyLength = keyEnd - at - 2;
+        if (names && nameMap < 0 && data[value] == '{' && IsListed(kNameMapKeys, key, keyLength)) {
+            nameMap = depth + 1;
+        }
+        if (data[value] != '"' && data[value] != '[') {
+            at = keyEnd;
+            continue;
+        }
+
+        bool log = keyLength == sizeof(kLogKey) - 1 && memcmp(key, kLogKey, keyLength) == 0;
+        bool sensitive = IsListed(kSensitiveKeys, key, keyLength) ||
+                         (scope == Scope::kDns && IsListed(kDnsKeys, key, keyLength)) ||
+                         (names && IsListed(kNameKeys, key, keyLength));
+        if ((!log && !sensitive) || (log && data[value] != '"')) {
+            at = keyEnd;
+            continue;
+        }
+
+        out->append(data + keyEnd, value - keyEnd);
+        if (data[value] == '[') {
+            // Only the strings of a flat array are rewritten
+            out->push_back('[');
+            depth++;
+            at = value + 1;
+            while (at < size && data[at] != ']') {
+                if (data[at] == '"') {
+                    at = AppendStringToken(data, at, size, salt, out);
+                } else if (data[at] == '[' || data[at] == '{') {
+                    break;
+                } else {
+                    out->push_back(data[at++]);
+                }
+            }
+            continue;
+        }
+        if (log) {
+            size_t valueEnd = SkipString(data, value, size);
+            out->push_back('"');
+            out->append(valueEnd - value >= 2 ? valueEnd - value - 2 : 0, '*');
+            out->push_back('"');
+            at = valueEnd;
+        } else {
+            at = AppendStringToken(data, value, size, salt, out);
+        }
+    }
+}
+
+int MethodCode(const wchar_t* verb) {
+    if (wcscmp(verb, L"PUT") == 0) return 1;
+    if (wcscmp(verb, L"POST") == 0) return 2;
+    if (wcscmp(verb, L"DELETE") == 0) return 3;
+    if (wcscmp(verb, L"PATCH") == 0) return 4;
+    return 0;
+}
+
+}  // namespace
+
+ControllerTrace& ControllerTrace::GetInstance() {
+    static ControllerTrace instance;
+    return instance;
+}
+
+bool ControllerTrace::Start(const std::string& path, bool redact, int64_t maxBytes) {
+    Stop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ignored;
+    // path is UTF-8; a narrow path would go through the ANSI code page
+    std::filesystem::path file(std::u8string(path.begin(), path.end()));
+    std::filesystem::create_directories(file.parent_path(), ignored);
+    file_.open(file, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) return false;
+
+    file_.write(kMagic, 4);
+    file_.put(static_cast<char>(kVersion));
+
+    status_ = Status();
+    status_.recording = true;
+    status_.path = path;
+    status_.redact = redact;
+    status_.bytes = 5;
+    maxBytes_ = maxBytes > 0 ? maxBytes : INT64_MAX;
+    salt_ = (static_cast<uint64_t>(std::random_device()()) << 32) | std::random_device()();
+    lastMs_ = GetTickCount64();
+    paths_.clear();
+    recording_ = true;
+
+    FlightRecorder::Record(FlightRecorder::Category::Controller, FlightRecorder::Level::Info,
+                           "trace started");
+    return true;
+}
+
+ControllerTrace::Status ControllerTrace::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recording_) return status_;
+    recording_ = false;
+    file_.close();
+    status_.recording = false;
+    paths_.clear();
+    scratch_.clear();
+    scratch_.shrink_to_fit();
+
+    FlightRecorder::Record(FlightRecorder::Category::Controller, FlightRecorder::Level::Info,
+                           "trace stopped", status_.records);
+    return status_;
+}
+
+ControllerTrace::Status ControllerTrace::GetStatus() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+void ControllerTrace::RecordRequest(const wchar_t* verb, const std::string& path, int status,
+                                    const std::string& requestBody, const std::string& body,
+                                    int64_t durationMs) {
+    auto& trace = GetInstance();
+    if (!trace.recording_) return;
+    trace.Write(kKindRequest, path, MethodCode(verb), status, durationMs, &requestBody,
+                body.data(), body.size());
+}
+
+void ControllerTrace::RecordMessage(const std::string& path, const char* data, size_t size) {
+    auto& trace = GetInstance();
+    if (!trace.recording_) return;
+    trace.Write(kKindMessage, path, 0, 0, 0, nullptr, data, size);
+}
+
+void ControllerTrace::Write(uint8_t kind, const std::string& rawPath, int method, int status,
+                            int64_t durationMs, const std::string* requestBody,
+                            const char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recording_) return;
+
+    std::string path;
+    std::string request;
+    std::string body;
+    if (status_.redact) {
+        Scope scope = ScopeOf(rawPath);
+        path = RedactPath(rawPath, salt_);
+        if (requestBody) Redact(requestBody->data(), requestBody->size(), salt_, scope, &request);
+        Redact(data, size, salt_, scope, &body);
+    } else {
+        path = rawPath;
+        if (requestBody) request = *requestBody;
+        body.assign(data, size);
+    }
+
+    uint64_t now = GetTickCount64();
+    scratch_.clear();
+    scratch_.push_back(static_cast<char>(kind));
+    AppendVarint(&scratch_, now - lastMs_);
+    bool newPath = WritePath(path);
+    if (kind == kKindRequest) {
+        scratch_.push_back(static_cast<char>(method));
+        AppendVarint(&scratch_, static_cast<uint64_t>(status > 0 ? status : 0));
+        AppendVarint(&scratch_, static_cast<uint64_t>(durationMs > 0 ? durationMs : 0));
+        AppendVarint(&scratch_, request.size());
+        scratch_.append(request);
+    }
+    AppendVarint(&scratch_, body.size());
+
+    if (status_.bytes + static_cast<int64_t>(scratch_.size() + body.size()) > maxBytes_) {
+        status_.dropped++;
+        return;
+    }
+    if (newPath) paths_.emplace(path, paths_.size());
+
+    file_.write(scratch_.data(), static_cast<std::streamsize>(scratch_.size()));
+    file_.write(body.data(), static_cast<std::streamsize>(body.size()));
+    lastMs_ = now;
+    status_.records++;
+    status_.bytes += static_cast<int64_t>(scratch_.size() + body.size());
+}
+
+bool ControllerTrace::WritePath(const std::string& path) {
+    auto it = paths_.find(path);
+    if (it != paths_.end()) {
+        AppendVarint(&scratch_, it->second);
+        return false;
+    }
+    // The entry is added once the record is actually written
+    AppendVarint(&scratch_, paths_.size());
+    AppendVarint(&scratch_, path.size());
+    scratch_.append(path);
+    return true;
+}
+
+ControllerTrace::CheckReport ControllerTrace::SelfCheck() {
+    CheckReport report;
+    auto started = std::chrono::steady_clock::now();
+    const uint64_t salt = 0x5eed;
+
+    auto check = [&](const std::string& name, bool passed, const std::string& detail) {
+        report.checks.push_back({name, passed, detail});
+    };
+    auto redact = [salt](const std::string& path, const std::string& body) {
+        std::string out;
+        Redact(body.data(), body.size(), salt, ScopeOf(path), &out);
+        return out;
+    };
+    auto token = [salt](const std::string& text) { return Token(salt, text.data(), text.size()); };
+
+    // HK "01" 香港/é as text, percent-encoded, and JSON-escaped two ways
+    const std::string name = "HK \"01\" \xe9\xa6\x99\xe6\xb8\xaf/\xc3\xa9";
+    const std::string encoded = "HK%20%2201%22%20%E9%A6%99%E6%B8%AF%2F%C3%A9";
+    const std::string raw = "HK \\\"01\\\" \xe9\xa6\x99\xe6\xb8\xaf/\xc3\xa9";
+    const std::string escaped = "HK \\u002201\\u0022 \\u9999\\u6e2f\\/\\u00e9";
+    // A group named 🇭🇰 HK, outside the basic plane
+    const std::string group = "\xf0\x9f\x87\xad\xf0\x9f\x87\xb0 HK";
+    const std::string groupEncoded = "%F0%9F%87%AD%F0%9F%87%B0%20HK";
+    const std::string groupEscaped = "\\ud83c\\udded\\ud83c\\uddf0 HK";
+    const std::string t = token(name);
+    const std::string g = token(group);
+    const std::string direct = token("DIRECT");
+
+    std::string path = RedactPath("/proxies/" + encoded + "/delay?timeout=5000", salt);
+    check("path segments", path == "/proxies/" + t + "/delay?timeout=5000", path);
+
+    std::string body = redact("/proxies",
+        "{\"proxies\":{\"" + raw + "\":{\"name\":\"" + escaped + "\",\"type\":\"Selector\",\"now\":\"" +
+        raw + "\",\"all\":[\"" + escaped + "\",\"DIRECT\"],\"history\":[]}}}");
+    check("/proxies names and keys", body ==
+        "{\"proxies\":{\"" + t + "\":{\"name\":\"" + t + "\",\"type\":\"Selector\",\"now\":\"" + t +
+        "\",\"all\":[\"" + t + "\",\"" + direct + "\"],\"history\":[]}}}", body);
+
+    std::string request = redact("/proxies/" + groupEncoded, "{\"name\":\"" + escaped + "\"}");
+    check("switch request body", request == "{\"name\":\"" + t + "\"}", request);
+
+    std::string groupPath = RedactPath("/group/" + groupEncoded + "/delay", salt);
+    std::string delays = redact("/group/" + groupEncoded + "/delay",
+                                "{\"" + raw + "\":120,\"DIRECT\":5}");
+    std::string groups = redact("/group", "{\"proxies\":[{\"name\":\"" + groupEscaped +
+                                "\",\"now\":\"" + raw + "\"}]}");
+    check("/group path and bodies",
+          groupPath == "/group/" + g + "/delay" &&
+              delays == "{\"" + t + "\":120,\"" + direct + "\":5}" &&
+              groups == "{\"proxies\":[{\"name\":\"" + g + "\",\"now\":\"" + t + "\"}]}",
+          groupPath + " " + delays + " " + groups);
+
+    std::string chains = redact("/connections",
+        "{\"connections\":[{\"chains\":[\"" + escaped + "\",\"" + group + "\"],\"rule\":\"Match\"}]}");
+    check("connection chains", chains ==
+        "{\"connections\":[{\"chains\":[\"" + t + "\",\"" + g + "\"],\"rule\":\"Match\"}]}", chains);
+
+    std::string plain = "{\"name\":\"" + raw + "\",\"type\":\"Selector\"}";
+    std::string kept = redact("/configs", plain);
+    check("names kept outside proxy bodies", kept == plain, kept);
+
+    report.passed = std::all_of(report.checks.begin(), report.checks.end(),
+                                [](const Check& item) { return item.passed; });
+    report.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return report;
+}
@@ -0,0 +1,108 @@
+// controller_trace.h - Controller traffic recorder for Windows
+#ifndef CONTROLLER_TRACE_H_
+#define CONTROLLER_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Records what the runner exchanges with the core's controller - each
+// request MihomoCore makes with its status and response body, and every
+// message of the streams ControllerStreams follows - into a compact binary
+// trace, so a user's
+// real /proxies, /connections and /logs volumes can be replayed later by
+// tool/trace/replay_server.dart.
+//
+// File layout, all integers unsigned LEB128 varints:
+//   "VXTR" version(1 byte)
+//   record*:
+//     kind(1 byte)      1 = request, 2 = stream message
+//     delta             ms since the previous record
+//     path              index into the path table; an index equal to the
+//                       table size adds a new entry: length, bytes
+//     request only:     method(1 byte: 0 GET, 1 PUT, 2 POST, 3 DELETE,
+//                       4 PATCH), status, duration ms,
+//                       request body: length, bytes (version 2 on)
+//     body              length, bytes (the response for a request)
+//
+// With redaction on (the default) the values of keys that identify the
+// user, their servers or their destinations are replaced by salted hash
+// tokens, in request and response bodies alike. So are path segments that
+// are not controller routes, query values other than timeouts and the like,
+// and the proxy, group and provider names in /proxies, /group and
+// /providers/proxies bodies, object keys included. Strings are hashed as
+// decoded text, so a name has one token in paths, bodies and chains. Equal
+// values map to equal tokens within one trace, so the cardinality that
+// parsing and tracking depend on is kept; the salt is never written. Log
+// lines are replaced by filler of the same length.
+class ControllerTrace {
+public:
+    struct Status {
+        bool recording = false;
+        std::string path;
+        int64_t records = 0;
+        int64_t bytes = 0;
+        int64_t dropped = 0;  // Records not written after the size cap
+        bool redact = true;
+    };
+
+    struct Check {
+        std::string name;
+        bool passed = false;
+        std::string detail;
+    };
+
+    struct CheckReport {
+        std::vector<Check> checks;
+        bool passed = false;
+        int64_t elapsedMs = 0;
+        std::string error;
+    };
+
+    static ControllerTrace& GetInstance();
+
+    // Redacts sample paths and bodies with a fixed salt, in memory, and
+    // checks that one proxy name, escaped differently in each, gets one token
+    // in paths, /proxies and /group bodies, request bodies and chains, and
+    // that names stay readable outside proxy bodies. Leaves any recording
+    // alone.
+    static CheckReport SelfCheck();
+
+    // Starts a new trace at path, replacing a recording in progress
+    bool Start(const std::string& path, bool redact, int64_t maxBytes);
+    Status Stop();
+    Status GetStatus();
+
+    // Cheap when not recording; safe from any thread
+    static void RecordRequest(const wchar_t* verb, const std::string& path, int status,
+                              const std::string& requestBody, const std::string& body,
+                              int64_t durationMs);
+    static void RecordMessage(const std::string& path, const char* data, size_t size);
+
+private:
+    ControllerTrace() = default;
+    ControllerTrace(const ControllerTrace&) = delete;
+    ControllerTrace& operator=(const ControllerTrace&) = delete;
+
+    // requestBody is null for stream messages
+    void Write(uint8_t kind, const std::string& rawPath, int method, int status, int64_t durationMs,
+               const std::string* requestBody, const char* data, size_t size);
+    // Appends the path reference to scratch_; true when it is a new entry
+    bool WritePath(const std::string& path);
+
+    std::atomic<bool> recording_{false};
+    std::mutex mutex_;
+    std::ofstream file_;
+    Status status_;
+    int64_t maxBytes_ = 0;
+    uint64_t salt_ = 0;
+    uint64_t lastMs_ = 0;
+    std::unordered_map<std::string, uint64_t> paths_;
+    std::string scratch_;
+};
+
+#endif  // CONTROLLER_TRACE_H_
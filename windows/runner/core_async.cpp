@@ -0,0 +1,225 @@
+// core_async.cpp - Coroutine API for the core manager implementation
+#include "core_async.h"
+#include "mihomo_core.h"
+#include "path_warmer.h"
+#include "utils.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr int kMaxProbeConcurrency = 32;
+
+}  // namespace
+
+bool CancelToken::IsCancelled() const {
+    if (!state_) return false;
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->cancelled;
+}
+
+std::string CancelToken::Reason() const {
+    if (!state_) return "";
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->reason;
+}
+
+uint64_t CancelToken::Subscribe(Callback callback) const {
+    if (!state_) return 0;
+    std::string reason;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->cancelled) {
+            uint64_t id = state_->nextId++;
+            state_->callbacks.emplace(id, std::move(callback));
+            return id;
+        }
+        reason = state_->reason;
+    }
+    callback(reason);
+    return 0;
+}
+
+void CancelToken::Unsubscribe(uint64_t id) const {
+    if (!state_ || id == 0) return;
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->callbacks.erase(id);
+}
+
+CancelSource::CancelSource() : state_(std::make_shared<CancelToken::State>()) {}
+
+void CancelSource::Cancel(const std::string& reason) {
+    std::map<uint64_t, CancelToken::Callback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->cancelled) return;
+        state_->cancelled = true;
+        state_->reason = reason;
+        callbacks.swap(state_->callbacks);
+    }
+    // Outside the lock: callbacks may subscribe or unsubscribe again
+    for (auto& [id, callback] : callbacks) callback(reason);
+}
+
+void CancelSource::CancelAfter(int timeoutMs) {
+    // The timer does not keep an abandoned source alive
+    std::weak_ptr<CancelToken::State> weak = state_;
+    EventLoop::GetInstance().PostAfter(timeoutMs, [weak]() {
+        if (auto state = weak.lock()) CancelSource(state).Cancel("deadline exceeded");
+    });
+}
+
+CoreAsync::BridgeAwaiter<bool> CoreAsync::Start(const std::string& configPath, CancelToken token) {
+    return BridgeAwaiter<bool>(
+        [configPath](BridgeAwaiter<bool>::Complete complete) {
+            MihomoCore::GetInstance().StartAsync(configPath, [complete](bool success) { complete(success); });
+        },
+        std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<bool> CoreAsync::Stop(CancelToken token) {
+    return Offload<bool>([]() { return MihomoCore::GetInstance().Stop(); }, std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<bool> CoreAsync::ReloadConfig(const std::string& configPath, CancelToken token) {
+    return Offload<bool>([configPath]() { return MihomoCore::GetInstance().ReloadConfig(configPath); },
+                         std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<std::string> CoreAsync::GetVersion(CancelToken token) {
+    return Offload<std::string>([]() { return MihomoCore::GetInstance().GetVersion(); }, std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<int> CoreAsync::TestDelay(const std::string& proxy, const std::string& url,
+                                                   int timeoutMs, CancelToken token) {
+    return Offload<int>(
+        [proxy, url, timeoutMs]() { return MihomoCore::GetInstance().TestDelay(proxy, url, timeoutMs); },
+        std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<bool> CoreAsync::SwitchProxy(const std::string& selector, const std::string& proxy,
+                                                      CancelToken token) {
+    return Offload<bool>([selector, proxy]() { return MihomoCore::GetInstance().SwitchProxy(selector, proxy); },
+                         std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<std::string> CoreAsync::GetConnections(CancelToken token) {
+    return Offload<std::string>([]() { return MihomoCore::GetInstance().GetConnections(); }, std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<std::string> CoreAsync::GetProxies(CancelToken token) {
+    return Offload<std::string>([]() { return MihomoCore::GetInstance().GetProxies(); }, std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<std::string> CoreAsync::QueryDns(const std::string& name, const std::string& type,
+                                                          CancelToken token) {
+    return Offload<std::string>([name, type]() { return MihomoCore::GetInstance().QueryDns(name, type); },
+                                std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<bool> CoreAsync::FreeMemory(CancelToken token) {
+    return Offload<bool>([]() { return MihomoCore::GetInstance().FreeMemory(); }, std::move(token));
+}
+
+CoreAsync::BridgeAwaiter<bool> CoreAsync::Delay(int delayMs, CancelToken token) {
+    return BridgeAwaiter<bool>(
+        [delayMs](BridgeAwaiter<bool>::Complete complete) {
+            EventLoop::GetInstance().PostAfter(delayMs, [complete]() { complete(true); });
+        },
+        std::move(token));
+}
+
+Task<CoreAsync::HotSwapReport> CoreAsync::HotSwap(HotSwapOptions options, CancelToken token) {
+    auto started = std::chrono::steady_clock::now();
+    HotSwapReport report;
+    auto& core = MihomoCore::GetInstance();
+
+    if (!core.IsRunning()) {
+        if (options.configPath.empty()) {
+            report.error = "core not running";
+            co_return report;
+        }
+        auto start = co_await Start(options.configPath, token);
+        if (!start.Ok() || !start.value) {
+            report.error = start.Ok() ? "start failed" : start.error;
+            report.elapsedMs = ElapsedMs(started);
+            co_return report;
+        }
+        report.started = true;
+    } else if (!options.configPath.empty()) {
+        auto reload = co_await ReloadConfig(options.configPath, token);
+        if (!reload.Ok() || !reload.value) {
+            report.error = reload.Ok() ? "reload failed" : reload.error;
+            report.elapsedMs = ElapsedMs(started);
+            co_return report;
+        }
+        report.reloaded = true;
+    }
+
+    if (!options.selector.empty() && !options.proxy.empty()) {
+        auto switched = co_await SwitchProxy(options.selector, options.proxy, token);
+        if (!switched.Ok() || !switched.value) {
+            report.error = switched.Ok() ? "switch failed" : switched.error;
+            report.elapsedMs = ElapsedMs(started);
+            co_return report;
+        }
+        report.switched = true;
+    }
+
+    std::string target = options.proxy.empty() ? options.selector : options.proxy;
+    if (!target.empty()) {
+        auto delay = co_await TestDelay(target, options.url, options.timeoutMs, token);
+        if (!delay.Ok()) {
+            report.error = delay.error;
+        } else if (delay.value <= 0) {
+            report.error = "node did not answer";
+        } else {
+            report.delayMs = delay.value;
+            if (options.warm) {
+                report.warming = PathWarmer::GetInstance().Warm("switch", target, core.GetProxyPort());
+            }
+        }
+    }
+    report.elapsedMs = ElapsedMs(started);
+    co_return report;
+}
+
+// Shared by the lanes of one ProbeDelays; only touched on the loop thread
+struct CoreAsync::ProbeState {
+    ProbeOptions options;
+    std::vector<int> delays;
+    size_t next = 0;
+    int probed = 0;
+};
+
+Task<bool> CoreAsync::ProbeLane(std::shared_ptr<ProbeState> state, CancelToken token) {
+    while (state->next < state->options.proxies.size()) {
+        size_t index = state->next++;
+        auto delay = co_await TestDelay(state->options.proxies[index], state->options.url,
+                                        state->options.timeoutMs, token);
+        if (!delay.Ok()) co_return false;
+        state->delays[index] = delay.value > 0 ? delay.value : -1;
+        state->probed++;
+    }
+    co_return true;
+}
+
+Task<CoreAsync::ProbeReport> CoreAsync::ProbeDelays(ProbeOptions options, CancelToken token) {
+    auto started = std::chrono::steady_clock::now();
+    auto state = std::make_shared<ProbeState>();
+    state->delays.assign(options.proxies.size(), -1);
+    int lanes = std::max(1, std::min(options.concurrency, kMaxProbeConcurrency));
+    lanes = std::min<int>(lanes, static_cast<int>(options.proxies.size()));
+    state->options = std::move(options);
+
+    std::vector<Task<bool>> tasks;
+    for (int i = 0; i < lanes; i++) tasks.push_back(ProbeLane(state, token));
+    co_await WhenAll(std::move(tasks));
+
+    ProbeReport report;
+    report.delays = std::move(state->delays);
+    report.probed = state->probed;
+    report.error = token.Reason();
+    report.elapsedMs = ElapsedMs(started);
+    co_return report;
+}
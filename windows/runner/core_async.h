@@ -0,0 +1,361 @@
+// core_async.h - Coroutine API for the core manager on Windows
+#ifndef CORE_ASYNC_H_
+#define CORE_ASYNC_H_
+
+#include "event_loop.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Awaitable versions of MihomoCore's lifecycle and controller operations,
+// so flows that chain several of them (start or reload, switch, verify,
+// warm; probe a list of proxies a few at a time) read top to bottom without
+// holding a thread for the whole flow or nesting callbacks.
+//
+// Coroutines run on the EventLoop thread. Operations that block inside
+// MihomoCore (WinHTTP calls, process start and stop) run on a thread of
+// their own and resume their awaiter on the loop when done, so the loop
+// never blocks. Tasks are lazy: nothing runs until a Task is awaited or
+// handed to Spawn.
+//
+// Cancellation is cooperative. Cancelling a CancelSource, or its deadline
+// passing, resumes every operation awaiting one of its tokens at once with
+// the reason in error; a late result is dropped. The abandoned call still
+// runs to its own timeout inside MihomoCore, so cancelling a start does not
+// stop a core that comes up afterwards.
+
+class CancelToken {
+public:
+    using Callback = std::function<void(const std::string& reason)>;
+
+    // A token that is never cancelled
+    CancelToken() = default;
+
+    bool IsCancelled() const;
+    std::string Reason() const;
+
+    // Runs callback once when the token is cancelled, at once if it already
+    // is. Returns an id for Unsubscribe, 0 when there is nothing to remove.
+    uint64_t Subscribe(Callback callback) const;
+    void Unsubscribe(uint64_t id) const;
+
+private:
+    friend class CancelSource;
+
+    struct State {
+        std::mutex mutex;
+        bool cancelled = false;
+        std::string reason;
+        uint64_t nextId = 1;
+        std::map<uint64_t, Callback> callbacks;
+    };
+
+    explicit CancelToken(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<State> state_;
+};
+
+class CancelSource {
+public:
+    CancelSource();
+
+    CancelToken Token() const { return CancelToken(state_); }
+
+    void Cancel(const std::string& reason = "cancelled");
+
+    // Cancels with "deadline exceeded" once timeoutMs has passed
+    void CancelAfter(int timeoutMs);
+
+private:
+    explicit CancelSource(std::shared_ptr<CancelToken::State> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<CancelToken::State> state_;
+};
+
+template <typename T>
+struct AsyncResult {
+    T value{};
+    std::string error;  // Set only when cancelled or past the deadline
+
+    bool Ok() const { return error.empty(); }
+};
+
+// A lazily started coroutine producing a T. Awaiting it starts it and
+// resumes the awaiter when it returns (symmetric transfer, so long chains
+// do not grow the stack).
+template <typename T>
+class Task {
+public:
+    struct promise_type {
+        T value{};
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                std::coroutine_handle<> next = handle.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_value(T result) { value = std::move(result); }
+
+        // The runner is built without exceptions
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return std::move(handle_.promise().value); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+class CoreAsync {
+public:
+    // Moves the awaiting coroutine onto the loop thread
+    struct ScheduleAwaiter {
+        bool await_ready() const { return EventLoop::GetInstance().IsLoopThread(); }
+        void await_suspend(std::coroutine_handle<> handle) const {
+            EventLoop::GetInstance().Post([handle]() { handle.resume(); });
+        }
+        void await_resume() const {}
+    };
+    static ScheduleAwaiter Schedule() { return {}; }
+
+    // Runs task on the loop without waiting for it; done gets its result
+    template <typename T>
+    static void Spawn(Task<T> task, std::function<void(T)> done = nullptr) {
+        RunDetached(std::move(task), std::move(done));
+    }
+
+    // Awaits a callback-style operation: begin starts it and is handed the
+    // function that completes it, which may be called from any thread
+    template <typename T>
+    class BridgeAwaiter {
+    public:
+        using Complete = std::function<void(T)>;
+        using Begin = std::function<void(Complete)>;
+
+        BridgeAwaiter(Begin begin, CancelToken token) : begin_(std::move(begin)), token_(std::move(token)) {}
+
+        bool await_ready() const { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            if (token_.IsCancelled()) {
+                result_.error = token_.Reason();
+                return false;
+            }
+            auto state = std::make_shared<State>();
+            state->handle = handle;
+            state_ = state;
+
+            // Whichever of completion and cancellation comes first resumes
+            subscription_ = token_.Subscribe([state](const std::string& reason) {
+                if (state->claimed.exchange(true)) return;
+                state->error = reason;
+                EventLoop::GetInstance().Post([state]() { state->handle.resume(); });
+            });
+            begin_([state](T value) {
+                if (state->claimed.exchange(true)) return;
+                state->value = std::move(value);
+                EventLoop::GetInstance().Post([state]() { state->handle.resume(); });
+            });
+            return true;
+        }
+
+        AsyncResult<T> await_resume() {
+            token_.Unsubscribe(subscription_);
+            if (state_) {
+                result_.value = std::move(state_->value);
+                result_.error = std::move(state_->error);
+            }
+            return std::move(result_);
+        }
+
+    private:
+        struct State {
+            std::atomic<bool> claimed{false};
+            std::coroutine_handle<> handle;
+            T value{};
+            std::string error;
+        };
+
+        Begin begin_;
+        CancelToken token_;
+        std::shared_ptr<State> state_;
+        uint64_t subscription_ = 0;
+        AsyncResult<T> result_;
+    };
+
+    // Runs blocking work on its own thread
+    template <typename T>
+    static BridgeAwaiter<T> Offload(std::function<T()> work, CancelToken token = {}) {
+        return BridgeAwaiter<T>(
+            [work = std::move(work)](typename BridgeAwaiter<T>::Complete complete) {
+                std::thread([work, complete]() { complete(work()); }).detach();
+            },
+            std::move(token));
+    }
+
+    // Starts every task and resumes once all have finished, results in order
+    template <typename T>
+    static Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks) {
+        auto join = std::make_shared<JoinState<T>>();
+        JoinAwaiter<T> awaiter{join, &tasks};
+        co_await awaiter;
+        co_return std::move(join->results);
+    }
+
+    // Lifecycle. These and the controller calls are awaitables that start
+    // the operation when awaited; value is the operation's own result and
+    // error is set only when the token cancelled the wait.
+    static BridgeAwaiter<bool> Start(const std::string& configPath, CancelToken token = {});
+    static BridgeAwaiter<bool> Stop(CancelToken token = {});
+    static BridgeAwaiter<bool> ReloadConfig(const std::string& configPath, CancelToken token = {});
+
+    // Controller
+    static BridgeAwaiter<std::string> GetVersion(CancelToken token = {});
+    static BridgeAwaiter<int> TestDelay(const std::string& proxy, const std::string& url, int timeoutMs,
+                                        CancelToken token = {});
+    static BridgeAwaiter<bool> SwitchProxy(const std::string& selector, const std::string& proxy,
+                                           CancelToken token = {});
+    static BridgeAwaiter<std::string> GetConnections(CancelToken token = {});
+    static BridgeAwaiter<std::string> GetProxies(CancelToken token = {});
+    static BridgeAwaiter<std::string> QueryDns(const std::string& name, const std::string& type,
+                                               CancelToken token = {});
+    static BridgeAwaiter<bool> FreeMemory(CancelToken token = {});
+
+    // Resumes after delayMs, or early with error set when cancelled
+    static BridgeAwaiter<bool> Delay(int delayMs, CancelToken token = {});
+
+    struct HotSwapOptions {
+        std::string configPath;  // Starts the core if it is stopped, else reloads; empty keeps the config
+        std::string selector;
+        std::string proxy;
+        std::string url = "http://www.gstatic.com/generate_204";
+        int timeoutMs = 5000;  // For the delay check
+        bool warm = true;      // Warm the path through the new node once it answers
+    };
+
+    struct HotSwapReport {
+        bool started = false;
+        bool reloaded = false;
+        bool switched = false;
+        int delayMs = -1;
+        bool warming = false;
+        int64_t elapsedMs = 0;
+        std::string error;
+    };
+
+    // Start or reload, switch, check the node answers, warm the path
+    static Task<HotSwapReport> HotSwap(HotSwapOptions options, CancelToken token = {});
+
+    struct ProbeOptions {
+        std::vector<std::string> proxies;
+        std::string url = "http://www.gstatic.com/generate_204";
+        int timeoutMs = 5000;
+        int concurrency = 8;
+    };
+
+    struct ProbeReport {
+        std::vector<int> delays;  // In proxy order; -1 when failed or not reached
+        int probed = 0;
+        int64_t elapsedMs = 0;
+        std::string error;
+    };
+
+    // Delay tests across the list, concurrency at a time
+    static Task<ProbeReport> ProbeDelays(ProbeOptions options, CancelToken token = {});
+
+private:
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    template <typename T>
+    static Detached RunDetached(Task<T> task, std::function<void(T)> done) {
+        co_await Schedule();
+        T result = co_await std::move(task);
+        if (done) done(std::move(result));
+    }
+
+    template <typename T>
+    struct JoinState {
+        std::vector<T> results;
+        size_t remaining = 0;
+        std::coroutine_handle<> parent;
+    };
+
+    template <typename T>
+    struct JoinAwaiter {
+        std::shared_ptr<JoinState<T>> join;
+        std::vector<Task<T>>* tasks;
+
+        bool await_ready() const { return tasks->empty(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            join->parent = handle;
+            join->results.resize(tasks->size());
+            join->remaining = tasks->size();
+            for (size_t i = 0; i < tasks->size(); i++) {
+                // Children finish on the loop thread, one at a time
+                std::shared_ptr<JoinState<T>> shared = join;
+                Spawn<T>(std::move((*tasks)[i]), [shared, i](T result) {
+                    shared->results[i] = std::move(result);
+                    if (--shared->remaining == 0) {
+                        EventLoop::GetInstance().Post([shared]() { shared->parent.resume(); });
+                    }
+                });
+            }
+        }
+        void await_resume() const {}
+    };
+
+    struct ProbeState;
+    static Task<bool> ProbeLane(std::shared_ptr<ProbeState> state, CancelToken token);
+};
+
+#endif  // CORE_ASYNC_H_
@@ -0,0 +1,166 @@
+// core_job.cpp - Job Object containment implementation
+#include "core_job.h"
+#include "idle_budget.h"
+
+#include <cstring>
+
+namespace {
+
+// Completion key of the job itself; anything else posted to the port is a
+// request to stop the notification thread
+constexpr ULONG_PTR kJobKey = 1;
+constexpr ULONG_PTR kQuitKey = 2;
+
+}  // namespace
+
+CoreJob::~CoreJob() {
+    Close();
+}
+
+bool CoreJob::Create(const Limits& limits, EventCallback callback) {
+    Close();
+
+    job_ = CreateJobObjectW(nullptr, nullptr);
+    if (!job_) return false;
+
+    port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (!port_) {
+        Close();
+        return false;
+    }
+
+    JOBOBJECT_ASSOCIATE_COMPLETION_PORT association = {};
+    association.CompletionKey = reinterpret_cast<void*>(kJobKey);
+    association.CompletionPort = port_;
+    if (!SetInformationJobObject(job_, JobObjectAssociateCompletionPortInformation,
+                                 &association, sizeof(association))) {
+        Close();
+        return false;
+    }
+
+    if (!Apply(limits)) {
+        Close();
+        return false;
+    }
+
+    callback_ = callback;
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+}
+
+bool CoreJob::Assign(HANDLE process) {
+    return job_ && AssignProcessToJobObject(job_, process);
+}
+
+bool CoreJob::Update(const Limits& limits) {
+    return job_ && Apply(limits);
+}
+
+void CoreJob::Close() {
+    if (thread_.joinable()) {
+        PostQueuedCompletionStatus(port_, 0, kQuitKey, nullptr);
+        thread_.join();
+    }
+    if (job_) {
+        CloseHandle(job_);
+        job_ = nullptr;
+    }
+    if (port_) {
+        CloseHandle(port_);
+        port_ = nullptr;
+    }
+    callback_ = nullptr;
+}
+
+int CoreJob::RunAllocatingStub() {
+    // Like the core's own runtime, give up on the first refused commit
+    constexpr SIZE_T kStep = 4 * 1024 * 1024;
+    constexpr SIZE_T kCeiling = 1024 * 1024 * 1024;
+    for (SIZE_T committed = 0; committed < kCeiling; committed += kStep) {
+        void* block = VirtualAlloc(nullptr, kStep, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!block) return kStubOutOfMemory;
+        std::memset(block, 1, kStep);
+    }
+    return 0;
+}
+
+int64_t CoreJob::PeakMemory() const {
+    if (!job_) return 0;
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION info = {};
+    if (!QueryInformationJobObject(job_, JobObjectExtendedLimitInformation,
+                                   &info, sizeof(info), nullptr)) {
+        return 0;
+    }
+    return static_cast<int64_t>(info.PeakJobMemoryUsed);
+}
+
+bool CoreJob::Apply(const Limits& limits) {
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION info = {};
+    info.BasicLimitInformation.LimitFlags =
+        JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE | JOB_OBJECT_LIMIT_DIE_ON_UNHANDLED_EXCEPTION;
+    if (limits.memoryMb > 0) {
+        info.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_JOB_MEMORY;
+        info.JobMemoryLimit = static_cast<SIZE_T>(limits.memoryMb) * 1024 * 1024;
+    }
+    if (!SetInformationJobObject(job_, JobObjectExtendedLimitInformation, &info, sizeof(info))) {
+        return false;
+    }
+
+    // CPU rate is in 1/100 of a percent; a zero flag set removes the cap
+    JOBOBJECT_CPU_RATE_CONTROL_INFORMATION cpu = {};
+    if (limits.cpuPercent > 0 && limits.cpuPercent < 100) {
+        cpu.ControlFlags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE | JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+        cpu.CpuRate = static_cast<DWORD>(limits.cpuPercent) * 100;
+    }
+    if (!SetInformationJobObject(job_, JobObjectCpuRateControlInformation, &cpu, sizeof(cpu)) &&
+        cpu.ControlFlags != 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(limitsMutex_);
+    limits_ = limits;
+    return true;
+}
+
+void CoreJob::Run() {
+    IdleBudget::TagThread("core_job");
+    while (true) {
+        DWORD message = 0;
+        ULONG_PTR key = 0;
+        LPOVERLAPPED overlapped = nullptr;
+        if (!GetQueuedCompletionStatus(port_, &message, &key, &overlapped, INFINITE)) {
+            break;
+        }
+        if (key != kJobKey) break;
+
+        Event event;
+        // For process messages the overlapped pointer carries the process id
+        event.processId = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(overlapped));
+
+        switch (message) {
+            case JOB_OBJECT_MSG_JOB_MEMORY_LIMIT:
+            case JOB_OBJECT_MSG_PROCESS_MEMORY_LIMIT:
+                event.type = "memory_limit";
+                break;
+            case JOB_OBJECT_MSG_EXIT_PROCESS:
+                event.type = "exit";
+                break;
+            case JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS:
+                event.type = "abnormal_exit";
+                break;
+            default:
+                continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(limitsMutex_);
+            event.limitBytes = limits_.memoryMb * 1024 * 1024;
+        }
+        event.peakBytes = PeakMemory();
+
+        if (callback_) {
+            callback_(event);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+// core_job.h - Job Object containment for the core process on Windows
+#ifndef CORE_JOB_H_
+#define CORE_JOB_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Owns the Job Object the core process runs in. The job always kills the
+// core when the runner goes away and reports process exits; the memory cap
+// and CPU hard cap are applied only when set. Job notifications arrive on an
+// I/O completion port drained by a dedicated thread.
+class CoreJob {
+public:
+    struct Limits {
+        int64_t memoryMb = 0;  // Committed memory cap for the whole job, 0 = none
+        int cpuPercent = 0;    // Hard cap across all CPUs (1-100), 0 = none
+    };
+
+    struct Event {
+        std::string type;        // "memory_limit", "exit" or "abnormal_exit"
+        DWORD processId = 0;
+        int64_t limitBytes = 0;
+        int64_t peakBytes = 0;   // Peak committed memory of the job so far
+    };
+
+    using EventCallback = std::function<void(const Event& event)>;
+
+    // The runner started with kStubArgument runs RunAllocatingStub instead of
+    // the app: a stand-in for a leaking core in containment checks
+    static constexpr wchar_t kStubArgument[] = L"--core-job-stub";
+    static constexpr int kStubOutOfMemory = 3;
+
+    // Commits and touches memory until a commit is refused, then returns
+    // kStubOutOfMemory; returns 0 after 1 GB when nothing limits it
+    static int RunAllocatingStub();
+
+    CoreJob() = default;
+    ~CoreJob();
+
+    // Creates the job with the given limits. The callback runs on the
+    // notification thread.
+    bool Create(const Limits& limits, EventCallback callback);
+
+    // Must be called before the process runs (create it suspended)
+    bool Assign(HANDLE process);
+
+    // Changes limits of a live job
+    bool Update(const Limits& limits);
+
+    // Stops notifications and closes the job, terminating the processes in it
+    void Close();
+
+    bool IsActive() const { return job_ != nullptr; }
+
+    int64_t PeakMemory() const;
+
+private:
+    CoreJob(const CoreJob&) = delete;
+    CoreJob& operator=(const CoreJob&) = delete;
+
+    bool Apply(const Limits& limits);
+    void Run();
+
+    HANDLE job_ = nullptr;
+    HANDLE port_ = nullptr;
+    std::thread thread_;
+
+    std::mutex limitsMutex_;
+    Limits limits_;
+    EventCallback callback_;
+};
+
+#endif  // CORE_JOB_H_
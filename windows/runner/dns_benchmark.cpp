@@ -0,0 +1,526 @@
+// dns_benchmark.cpp - DNS resolver benchmark implementation
+#include "dns_benchmark.h"
+
+// winsock2.h must come before anything that pulls in windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include "http_fetch.h"
+#include "mihomo_core.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+const char* const kDefaultDomains[] = {
+    "www.google.com", "www.youtube.com", "www.facebook.com", "www.wikipedia.org",
+    "www.amazon.com", "twitter.com", "www.instagram.com", "www.reddit.com",
+    "github.com", "www.netflix.com", "www.microsoft.com", "www.apple.com",
+    "www.cloudflare.com", "telegram.org", "www.baidu.com", "www.qq.com",
+    "www.bilibili.com", "www.taobao.com", "www.jd.com", "www.zhihu.com",
+};
+
+constexpr int kMaxConcurrency = 64;
+
+// A warm lookup at most this fraction of the cold one is taken as a cache hit
+constexpr int64_t kCacheHitRatio = 4;
+
+constexpr size_t kMaxResponse = 4096;
+
+std::string Unquote(const std::string& value) {
+    std::string trimmed = Trim(value);
+    if (trimmed.size() >= 2 && (trimmed.front() == '"' || trimmed.front() == '\'') &&
+        trimmed.back() == trimmed.front()) {
+        return trimmed.substr(1, trimmed.size() - 2);
+    }
+    return trimmed;
+}
+
+// Drops a trailing " # comment" outside of quotes
+std::string StripComment(const std::string& line) {
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '#' && (i == 0 || line[i - 1] == ' ' || line[i - 1] == '\t')) {
+            return line.substr(0, i);
+        }
+    }
+    return line;
+}
+
+size_t Indent(const std::string& line) {
+    size_t indent = 0;
+    while (indent < line.size() && line[indent] == ' ') indent++;
+    return indent;
+}
+
+std::string Base64Url(const std::string& data) {
+    static const char kAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        uint32_t n = (static_cast<uint8_t>(data[i]) << 16) |
+                     (static_cast<uint8_t>(data[i + 1]) << 8) |
+                     static_cast<uint8_t>(data[i + 2]);
+        out.push_back(kAlphabet[(n >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(n >> 12) & 0x3F]);
+        out.push_back(kAlphabet[(n >> 6) & 0x3F]);
+        out.push_back(kAlphabet[n & 0x3F]);
+    }
+    // RFC 8484 uses the unpadded form
+    if (i + 1 == data.size()) {
+        uint32_t n = static_cast<uint8_t>(data[i]) << 16;
+        out.push_back(kAlphabet[(n >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(n >> 12) & 0x3F]);
+    } else if (i + 2 == data.size()) {
+        uint32_t n = (static_cast<uint8_t>(data[i]) << 16) | (static_cast<uint8_t>(data[i + 1]) << 8);
+        out.push_back(kAlphabet[(n >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(n >> 12) & 0x3F]);
+        out.push_back(kAlphabet[(n >> 6) & 0x3F]);
+    }
+    return out;
+}
+
+// Wire-format query with recursion desired and a single question
+std::string BuildQuery(uint16_t id, const std::string& domain, uint16_t qtype) {
+    std::string query;
+    query.push_back(static_cast<char>(id >> 8));
+    query.push_back(static_cast<char>(id & 0xFF));
+    query.append("\x01\x00", 2);          // RD
+    query.append("\x00\x01", 2);          // QDCOUNT
+    query.append("\x00\x00\x00\x00\x00\x00", 6);
+
+    size_t start = 0;
+    while (start < domain.size()) {
+        size_t dot = domain.find('.', start);
+        if (dot == std::string::npos) dot = domain.size();
+        size_t length = std::min<size_t>(dot - start, 63);
+        if (length > 0) {
+            query.push_back(static_cast<char>(length));
+            query.append(domain, start, length);
+        }
+        start = dot + 1;
+    }
+    query.push_back('\0');
+    query.push_back(static_cast<char>(qtype >> 8));
+    query.push_back(static_cast<char>(qtype & 0xFF));
+    query.append("\x00\x01", 2);          // IN
+    return query;
+}
+
+// NOERROR and NXDOMAIN are both answers; anything else is a failure
+bool AnswerOk(const char* response, size_t size, std::string* error) {
+    if (size < 12) {
+        *error = "short response";
+        return false;
+    }
+    if ((static_cast<uint8_t>(response[2]) & 0x80) == 0) {
+        *error = "not a response";
+        return false;
+    }
+    int rcode = static_cast<uint8_t>(response[3]) & 0x0F;
+    if (rcode != 0 && rcode != 3) {
+        *error = "rcode " + std::to_string(rcode);
+        return false;
+    }
+    return true;
+}
+
+struct Server {
+    std::string protocol;  // udp, https or the unsupported scheme
+    std::string host;
+    std::string port = "53";
+    std::string url;       // https only
+};
+
+Server ParseServer(const std::string& raw) {
+    Server server;
+    // mihomo appends options after '#', e.g. "https://x/dns-query#PROXY"
+    std::string value = Trim(raw.substr(0, raw.find('#')));
+
+    size_t scheme = value.find("://");
+    if (scheme != std::string::npos) {
+        server.protocol = value.substr(0, scheme);
+        std::transform(server.protocol.begin(), server.protocol.end(), server.protocol.begin(),
+                       [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        value = value.substr(scheme + 3);
+    } else {
+        server.protocol = value == "system" ? "system" : "udp";
+    }
+    if (server.protocol == "https") {
+        server.url = "https://" + value;
+        return server;
+    }
+    if (server.protocol != "udp") return server;
+
+    value = value.substr(0, value.find('/'));
+    if (!value.empty() && value.front() == '[') {
+        size_t close = value.find(']');
+        server.host = value.substr(1, close == std::string::npos ? std::string::npos : close - 1);
+        if (close != std::string::npos && close + 1 < value.size() && value[close + 1] == ':') {
+            server.port = value.substr(close + 2);
+        }
+    } else if (std::count(value.begin(), value.end(), ':') == 1) {
+        size_t colon = value.find(':');
+        server.host = value.substr(0, colon);
+        server.port = value.substr(colon + 1);
+    } else {
+        // Bare IPv6 address or plain host
+        server.host = value;
+    }
+    return server;
+}
+
+using Query = std::function<bool(const std::string& domain, std::string* error)>;
+
+Query CoreQuery(const std::string& type) {
+    return [type](const std::string& domain, std::string* error) {
+        std::string body = MihomoCore::GetInstance().QueryDns(PercentEncode(domain), type);
+        if (body.empty()) {
+            *error = "no answer from core";
+            return false;
+        }
+        size_t status = body.find("\"Status\":");
+        if (status == std::string::npos) {
+            *error = "unreadable answer";
+            return false;
+        }
+        int rcode = atoi(body.c_str() + status + 9);
+        if (rcode != 0 && rcode != 3) {
+            *error = "rcode " + std::to_string(rcode);
+            return false;
+        }
+        return true;
+    };
+}
+
+Query UdpQuery(const Server& server, uint16_t qtype, int timeoutMs) {
+    return [server, qtype, timeoutMs](const std::string& domain, std::string* error) {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        hints.ai_protocol = IPPROTO_UDP;
+        addrinfo* address = nullptr;
+        if (getaddrinfo(server.host.c_str(), server.port.c_str(), &hints, &address) != 0 || !address) {
+            *error = "resolve failed";
+            return false;
+        }
+
+        SOCKET sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (sock == INVALID_SOCKET) {
+            freeaddrinfo(address);
+            *error = "socket failed";
+            return false;
+        }
+        DWORD timeout = static_cast<DWORD>(timeoutMs);
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+        // A connected UDP socket drops datagrams from other sources
+        int connected = connect(sock, address->ai_addr, static_cast<int>(address->ai_addrlen));
+        freeaddrinfo(address);
+        if (connected != 0) {
+            closesocket(sock);
+            *error = "connect failed";
+            return false;
+        }
+
+        static std::atomic<uint16_t> nextId{static_cast<uint16_t>(GetTickCount64())};
+        uint16_t id = nextId++;
+        std::string query = BuildQuery(id, domain, qtype);
+        if (send(sock, query.data(), static_cast<int>(query.size()), 0) != static_cast<int>(query.size())) {
+            closesocket(sock);
+            *error = "send failed";
+            return false;
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        char response[kMaxResponse];
+        bool ok = false;
+        *error = "timeout";
+        while (ElapsedMs(started) < timeoutMs) {
+            int received = recv(sock, response, sizeof(response), 0);
+            if (received == SOCKET_ERROR) break;
+            if (received < 2 || static_cast<uint8_t>(response[0]) != (id >> 8) ||
+                static_cast<uint8_t>(response[1]) != (id & 0xFF)) {
+                continue;  // Late answer to someone else's query
+            }
+            error->clear();
+            ok = AnswerOk(response, static_cast<size_t>(received), error);
+            break;
+        }
+        closesocket(sock);
+        return ok;
+    };
+}
+
+Query HttpsQuery(const Server& server, uint16_t qtype, int timeoutMs) {
+    return [server, qtype, timeoutMs](const std::string& domain, std::string* error) {
+        // RFC 8484 recommends ID 0 so identical GETs stay cacheable
+        std::string url = server.url;
+        url += url.find('?') == std::string::npos ? "?dns=" : "&dns=";
+        url += Base64Url(BuildQuery(0, domain, qtype));
+
+        HttpFetch fetch;
+        fetch.SetTimeout(timeoutMs);
+        fetch.AddHeader("Accept: application/dns-message");
+        HttpFetch::Response response = fetch.Get(url);
+        if (!response.error.empty()) {
+            *error = response.error;
+            return false;
+        }
+        if (response.statusCode != 200) {
+            *error = "HTTP " + std::to_string(response.statusCode);
+            return false;
+        }
+        return AnswerOk(response.body.data(), response.body.size(), error);
+    };
+}
+
+// Latency per domain, -1 for failed lookups
+std::vector<int64_t> RunPass(const std::vector<std::string>& domains, int concurrency,
+                             const Query& query, std::string* lastError) {
+    std::vector<int64_t> latencies(domains.size(), -1);
+    std::atomic<size_t> next{0};
+    std::mutex errorMutex;
+
+    int workers = std::max(1, std::min(concurrency, static_cast<int>(domains.size())));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; i++) {
+        threads.emplace_back([&]() {
+            for (size_t index = next++; index < domains.size(); index = next++) {
+                std::string error;
+                auto started = std::chrono::steady_clock::now();
+                bool ok = query(domains[index], &error);
+                int64_t elapsed = ElapsedMs(started);
+                if (ok) {
+                    latencies[index] = elapsed;
+                } else {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    *lastError = domains[index] + ": " + error;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    return latencies;
+}
+
+DnsBenchmark::Stats Summarize(const std::vector<int64_t>& latencies) {
+    const auto& bounds = DnsBenchmark::HistogramBounds();
+    DnsBenchmark::Stats stats;
+    stats.queries = static_cast<int>(latencies.size());
+    stats.histogram.assign(bounds.size() + 1, 0);
+
+    std::vector<int64_t> answered;
+    for (int64_t latency : latencies) {
+        if (latency < 0) {
+            stats.failures++;
+            continue;
+        }
+        answered.push_back(latency);
+        size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), latency) - bounds.begin();
+        stats.histogram[bucket]++;
+    }
+    if (stats.queries > 0) {
+        stats.failureRate = static_cast<double>(stats.failures) / stats.queries;
+    }
+    if (answered.empty()) return stats;
+
+    // Nearest-rank percentiles
+    std::sort(answered.begin(), answered.end());
+    auto percentile = [&answered](size_t p) {
+        size_t rank = (answered.size() * p + 99) / 100;
+        return answered[std::max<size_t>(rank, 1) - 1];
+    };
+    stats.p50Ms = percentile(50);
+    stats.p90Ms = percentile(90);
+    stats.p99Ms = percentile(99);
+
+    int64_t total = 0;
+    for (int64_t latency : answered) total += latency;
+    stats.meanMs = static_cast<double>(total) / answered.size();
+    return stats;
+}
+
+void Measure(const std::vector<std::string>& domains, const DnsBenchmark::Options& options,
+             const Query& query, DnsBenchmark::Target* target) {
+    std::vector<int64_t> cold = RunPass(domains, options.concurrency, query, &target->lastError);
+    std::vector<int64_t> warm = RunPass(domains, options.concurrency, query, &target->lastError);
+    target->cold = Summarize(cold);
+    target->warm = Summarize(warm);
+
+    int hits = 0;
+    for (size_t i = 0; i < domains.size(); i++) {
+        if (cold[i] >= 0 && warm[i] >= 0 && warm[i] * kCacheHitRatio <= cold[i]) hits++;
+    }
+    target->cacheHitRate = domains.empty() ? 0 : static_cast<double>(hits) / domains.size();
+
+    // Half-and-half latency, plus a full timeout for every failed lookup
+    int64_t coldMs = target->cold.p50Ms >= 0 ? target->cold.p50Ms : options.timeoutMs;
+    int64_t warmMs = target->warm.p50Ms >= 0 ? target->warm.p50Ms : options.timeoutMs;
+    int queries = target->cold.queries + target->warm.queries;
+    double failureRate = queries > 0
+        ? static_cast<double>(target->cold.failures + target->warm.failures) / queries
+        : 0;
+    target->score = (coldMs + warmMs) / 2.0 + failureRate * options.timeoutMs;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return "";
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+}  // namespace
+
+const std::vector<int>& DnsBenchmark::HistogramBounds() {
+    static const std::vector<int> bounds = {5, 10, 20, 50, 100, 200, 500, 1000, 2000};
+    return bounds;
+}
+
+std::vector<std::pair<std::string, std::string>> DnsBenchmark::ReadNameservers(const std::string& config) {
+    std::vector<std::pair<std::string, std::string>> servers;
+    std::istringstream stream(config);
+    std::string line;
+
+    bool inDns = false;
+    size_t dnsIndent = std::string::npos;  // Indent of the dns: block's keys
+    std::string section;                   // List being read, empty when none
+    size_t sectionIndent = 0;
+
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::string content = StripComment(line);
+        std::string trimmed = Trim(content);
+        if (trimmed.empty()) continue;
+        size_t indent = Indent(content);
+
+        if (indent == 0) {
+            inDns = trimmed == "dns:";
+            dnsIndent = std::string::npos;
+            section.clear();
+            continue;
+        }
+        if (!inDns) continue;
+        if (dnsIndent == std::string::npos) dnsIndent = indent;
+
+        if (!section.empty() && trimmed[0] == '-' && indent >= sectionIndent) {
+            std::string value = Unquote(trimmed.substr(1));
+            if (!value.empty()) servers.emplace_back(section, value);
+            continue;
+        }
+        if (indent != dnsIndent) continue;
+
+        section.clear();
+        size_t colon = trimmed.find(':');
+        if (colon == std::string::npos) continue;
+        std::string key = Trim(trimmed.substr(0, colon));
+        if (key != "nameserver" && key != "fallback" && key != "default-nameserver") continue;
+
+        std::string rest = Trim(trimmed.substr(colon + 1));
+        if (rest.empty()) {
+            section = key;
+            sectionIndent = indent;
+        } else if (rest.front() == '[') {
+            std::string items = rest.substr(1, rest.rfind(']') == std::string::npos ? std::string::npos
+                                                                                   : rest.rfind(']') - 1);
+            std::istringstream list(items);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                std::string value = Unquote(item);
+                if (!value.empty()) servers.emplace_back(key, value);
+            }
+        }
+    }
+    return servers;
+}
+
+DnsBenchmark::Report DnsBenchmark::Run(const Options& requested) {
+    auto started = std::chrono::steady_clock::now();
+    Report report;
+
+    Options options = requested;
+    options.concurrency = std::max(1, std::min(options.concurrency, kMaxConcurrency));
+    options.timeoutMs = std::max(100, options.timeoutMs);
+    if (options.type != "AAAA") options.type = "A";
+    uint16_t qtype = options.type == "AAAA" ? 28 : 1;
+
+    std::vector<std::string> domains = options.domains;
+    if (domains.empty()) {
+        domains.assign(std::begin(kDefaultDomains), std::end(kDefaultDomains));
+    }
+    report.domains = static_cast<int>(domains.size());
+
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        report.error = "winsock unavailable";
+        return report;
+    }
+
+    report.core.name = "core";
+    report.core.protocol = "core";
+    if (MihomoCore::GetInstance().IsRunning()) {
+        Measure(domains, options, CoreQuery(options.type), &report.core);
+    } else {
+        report.core.supported = false;
+        report.core.lastError = "core not running";
+    }
+
+    if (options.direct) {
+        std::vector<std::pair<std::string, std::string>> servers;
+        if (!options.nameservers.empty()) {
+            for (const auto& server : options.nameservers) servers.emplace_back("nameserver", server);
+        } else {
+            servers = ReadNameservers(ReadFile(MihomoCore::GetInstance().GetConfigPath()));
+        }
+
+        for (const auto& entry : servers) {
+            Target target;
+            target.section = entry.first;
+            target.name = entry.second;
+
+            Server server = ParseServer(entry.second);
+            target.protocol = server.protocol;
+            if (server.protocol == "udp" && !server.host.empty()) {
+                Measure(domains, options, UdpQuery(server, qtype, options.timeoutMs), &target);
+            } else if (server.protocol == "https") {
+                Measure(domains, options, HttpsQuery(server, qtype, options.timeoutMs), &target);
+            } else {
+                target.supported = false;
+                target.lastError = "unsupported protocol";
+            }
+            report.nameservers.push_back(std::move(target));
+        }
+
+        std::stable_sort(report.nameservers.begin(), report.nameservers.end(),
+                         [](const Target& a, const Target& b) {
+                             if (a.supported != b.supported) return a.supported;
+                             return a.supported && a.score < b.score;
+                         });
+        int rank = 0;
+        for (auto& target : report.nameservers) {
+            if (target.supported) target.rank = ++rank;
+        }
+    }
+
+    WSACleanup();
+    report.elapsedMs = ElapsedMs(started);
+    return report;
+}
@@ -0,0 +1,74 @@
+// dns_benchmark.h - DNS resolver benchmark for Windows
+#ifndef DNS_BENCHMARK_H_
+#define DNS_BENCHMARK_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Resolves a list of domains concurrently through the core's resolver
+// (/dns/query on the controller) and, optionally, directly against each
+// nameserver listed in the config's dns: section. Every target gets two
+// passes over the list: the cold pass pays for upstream lookups, the warm
+// pass shows what the cache saves. Nameservers are ranked by a score that
+// combines their latency with their failure rate.
+//
+// Direct queries support plain UDP servers ("1.1.1.1", "udp://...") and
+// DoH ("https://..."); tls://, quic://, tcp://, dhcp:// and system are
+// reported as unsupported.
+class DnsBenchmark {
+public:
+    struct Options {
+        std::vector<std::string> domains;      // Empty uses a built-in list
+        std::string type = "A";                // A or AAAA
+        int concurrency = 8;
+        int timeoutMs = 3000;
+        bool direct = true;                    // Also query each nameserver
+        std::vector<std::string> nameservers;  // Empty reads them from the config
+    };
+
+    // Upper bounds in ms; the last bucket counts everything slower
+    static const std::vector<int>& HistogramBounds();
+
+    struct Stats {
+        int queries = 0;
+        int failures = 0;
+        double failureRate = 0;
+        int64_t p50Ms = -1;
+        int64_t p90Ms = -1;
+        int64_t p99Ms = -1;
+        double meanMs = -1;
+        std::vector<int> histogram;  // HistogramBounds().size() + 1 buckets
+    };
+
+    struct Target {
+        std::string name;     // "core" or the nameserver as written
+        std::string section;  // nameserver, fallback or default-nameserver
+        std::string protocol; // core, udp, https or the unsupported scheme
+        bool supported = true;
+        Stats cold;
+        Stats warm;
+        double cacheHitRate = 0;  // Domains whose warm lookup took under a quarter of the cold one
+        double score = 0;         // Lower is better
+        int rank = 0;             // Among nameservers, 1-based
+        std::string lastError;
+    };
+
+    struct Report {
+        Target core;
+        std::vector<Target> nameservers;  // Ranked, unsupported ones last
+        int domains = 0;
+        int64_t elapsedMs = 0;
+        std::string error;
+    };
+
+    // Blocks until every pass has finished
+    static Report Run(const Options& options);
+
+    // Entries of the nameserver, fallback and default-nameserver lists of
+    // a config's dns: section, as (section, server) pairs
+    static std::vector<std::pair<std::string, std::string>> ReadNameservers(const std::string& config);
+};
+
+#endif  // DNS_BENCHMARK_H_
@@ -0,0 +1,497 @@
+// endpoint_racer.cpp - Concurrent panel API endpoint racer implementation
+#include "endpoint_racer.h"
+
+// winsock2.h must come before anything that pulls in windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include "flight_recorder.h"
+#include "http_fetch.h"
+#include "json_reader.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace {
+
+const char kHealthFileName[] = "endpoint_health.tsv";
+const char kHealthHeader[] = "# vortex endpoint health v1";
+const double kLatencyAlpha = 0.3;
+
+std::string HostOf(const std::string& url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    size_t end = url.find_first_of(":/?#", start);
+    return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// One endpoint of SelfCheck: a single-purpose HTTP server on 127.0.0.1 that
+// answers every request with the same status and body after a delay, or
+// accepts and never answers
+class StandIn {
+public:
+    StandIn(int status, std::string body, int delayMs = 0, bool hang = false)
+        : status_(status), body_(std::move(body)), delayMs_(delayMs), hang_(hang) {}
+
+    ~StandIn() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+        if (listener_ != INVALID_SOCKET) closesocket(listener_);
+        for (SOCKET held : held_) closesocket(held);
+    }
+
+    bool Start() {
+        listener_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listener_ == INVALID_SOCKET) return false;
+        port_ = BindLoopback(listener_);
+        if (port_ == 0 || listen(listener_, 8) != 0) return false;
+        thread_ = std::thread([this]() { Serve(); });
+        return true;
+    }
+
+    std::string Url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+    // A loopback port nothing listens on, so connecting is refused
+    static std::string RefusedUrl() {
+        SOCKET probe = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        int port = probe == INVALID_SOCKET ? 0 : BindLoopback(probe);
+        if (probe != INVALID_SOCKET) closesocket(probe);
+        return "http://127.0.0.1:" + std::to_string(port == 0 ? 1 : port);
+    }
+
+private:
+    static int BindLoopback(SOCKET socket) {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int length = sizeof(address);
+        if (bind(socket, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+            getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return 0;
+        }
+        return ntohs(address.sin_port);
+    }
+
+    void Serve() {
+        while (!stop_) {
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listener_, &readable);
+            timeval wait = {0, 50 * 1000};
+            if (select(0, &readable, nullptr, nullptr, &wait) <= 0) continue;
+
+            SOCKET client = accept(listener_, nullptr, nullptr);
+            if (client == INVALID_SOCKET) continue;
+            if (hang_) {
+                held_.push_back(client);
+                continue;
+            }
+
+            // The request itself does not matter, only that it arrived
+            DWORD timeout = 2000;
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+            std::string request;
+            char buffer[1024];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                int received = recv(client, buffer, sizeof(buffer), 0);
+                if (received <= 0) break;
+                request.append(buffer, received);
+            }
+
+            for (int waited = 0; waited < delayMs_ && !stop_; waited += 10) Sleep(10);
+            std::string response = "HTTP/1.1 " + std::to_string(status_) + " Stand-in\r\n"
+                "Content-Type: application/json\r\n"
+                "Content-Length: " + std::to_string(body_.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body_;
+            send(client, response.data(), static_cast<int>(response.size()), 0);
+            closesocket(client);
+        }
+    }
+
+    int status_;
+    std::string body_;
+    int delayMs_;
+    bool hang_;
+    SOCKET listener_ = INVALID_SOCKET;
+    int port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+    std::vector<SOCKET> held_;  // Connections a hanging stand-in never answers
+};
+
+}  // namespace
+
+EndpointRacer& EndpointRacer::GetInstance() {
+    static EndpointRacer instance;
+    return instance;
+}
+
+void EndpointRacer::Init(const std::string& workDir) {
+    std::lock_guard<std::mutex> lock(healthMutex_);
+    healthPath_ = workDir + "\\" + kHealthFileName;
+    loaded_ = false;
+}
+
+EndpointRacer::Result EndpointRacer::Race(const std::vector<std::string>& urls,
+                                          const Options& options) {
+    std::lock_guard<std::mutex> raceLock(raceMutex_);
+
+    Result result;
+    auto started = std::chrono::steady_clock::now();
+    result.attempts.resize(urls.size());
+    for (size_t i = 0; i < urls.size(); i++) {
+        result.attempts[i].url = urls[i];
+    }
+    if (urls.empty()) return result;
+
+    std::vector<size_t> order = OrderByHealth(urls);
+
+    std::mutex stateMutex;
+    std::condition_variable cv;
+    int winner = -1;
+    size_t launched = 0;
+    size_t finished = 0;
+    std::vector<std::unique_ptr<HttpFetch>> fetches(urls.size());
+    std::vector<std::thread> workers;
+    workers.reserve(urls.size());
+
+    auto launch = [&](size_t index) {
+        auto fetch = std::make_unique<HttpFetch>();
+        fetch->SetTimeout(options.timeoutMs);
+        fetch->SetUserAgent(options.userAgent);
+        fetch->AddHeader("Accept: application/json");
+        HttpFetch* raw = fetch.get();
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            fetches[index] = std::move(fetch);
+            Attempt& attempt = result.attempts[index];
+            attempt.started = true;
+            attempt.order = static_cast<int>(launched);
+            attempt.startOffsetMs = ElapsedMs(started);
+            launched++;
+        }
+
+        workers.emplace_back([&, index, raw]() {
+            auto attemptStart = std::chrono::steady_clock::now();
+            HttpFetch::Response response = raw->Get(urls[index] + options.probePath);
+            bool valid = response.error.empty() &&
+                IsValidResponse(response.statusCode, response.body, options.requiredKeys);
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            Attempt& attempt = result.attempts[index];
+            attempt.finished = true;
+            attempt.valid = valid;
+            attempt.cancelled = raw->IsCancelled();
+            attempt.statusCode = response.statusCode;
+            attempt.latencyMs = ElapsedMs(attemptStart);
+            if (!valid) {
+                attempt.error = response.error.empty() ? "invalid response" : response.error;
+            }
+            if (valid && winner < 0) {
+                winner = static_cast<int>(index);
+            }
+            finished++;
+            cv.notify_all();
+        });
+    };
+
+    // Happy-eyeballs: start the next endpoint after the stagger delay, or
+    // immediately once every attempt started so far has already failed.
+    for (size_t next = 0; next < order.size(); next++) {
+        launch(order[next]);
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        if (next + 1 < order.size()) {
+            cv.wait_for(lock, std::chrono::milliseconds(options.staggerMs),
+                [&]() { return winner >= 0 || finished == launched; });
+        }
+        if (winner >= 0) break;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        cv.wait_for(lock, std::chrono::milliseconds(options.timeoutMs),
+            [&]() { return winner >= 0 || finished == launched; });
+    }
+
+    // Abort the losers; cancelled attempts unblock and finish promptly.
+    for (size_t i = 0; i < fetches.size(); i++) {
+        if (fetches[i] && static_cast<int>(i) != winner) {
+            bool done;
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                done = result.attempts[i].finished;
+            }
+            if (!done) fetches[i]->Cancel();
+        }
+    }
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+
+    for (const auto& attempt : result.attempts) {
+        RecordOutcome(attempt);
+    }
+    SaveHealth();
+
+    result.winner = winner;
+    if (winner >= 0) {
+        result.url = urls[winner];
+        result.latencyMs = result.attempts[winner].latencyMs;
+    }
+    result.totalMs = ElapsedMs(started);
+
+    if (winner >= 0) {
+        FlightRecorder::Record(FlightRecorder::Category::Network, FlightRecorder::Level::Info,
+                               "race won " + HostOf(result.url), result.latencyMs);
+    } else {
+        FlightRecorder::Record(FlightRecorder::Category::Network, FlightRecorder::Level::Error,
+                               "race failed", static_cast<int64_t>(urls.size()));
+    }
+    return result;
+}
+
+EndpointRacer::CheckReport EndpointRacer::SelfCheck(const std::string& workDir) {
+    CheckReport report;
+    auto started = std::chrono::steady_clock::now();
+
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        report.error = "winsock unavailable";
+        return report;
+    }
+
+    const std::string valid = "{\"data\":{\"app_description\":\"stand-in\"}}";
+    StandIn fast(200, valid);
+    StandIn slow(200, valid, 800);
+    StandIn hang(200, valid, 0, true);
+    StandIn failing(500, valid);
+    StandIn nested(200, "{\"config\":{\"data\":1},\"note\":\"\\\"data\\\": 1\"}");
+    if (!fast.Start() || !slow.Start() || !hang.Start() || !failing.Start() || !nested.Start()) {
+        WSACleanup();
+        report.error = "could not listen on 127.0.0.1";
+        return report;
+    }
+    std::string refused = StandIn::RefusedUrl();
+
+    Options options;
+    options.requiredKeys = {"data"};
+    options.timeoutMs = 3000;
+    options.staggerMs = 150;
+
+    auto check = [&](const std::string& name, bool passed, const std::string& detail) {
+        report.checks.push_back({name, passed, detail});
+    };
+    auto describe = [](const Result& result) {
+        std::string text = "winner " + std::to_string(result.winner) + " in " +
+            std::to_string(result.totalMs) + "ms";
+        for (const auto& attempt : result.attempts) {
+            text += "; " + attempt.url + (attempt.valid ? " valid" : "") +
+                (attempt.cancelled ? " cancelled" : "") +
+                (attempt.error.empty() ? "" : " " + attempt.error);
+        }
+        return text;
+    };
+
+    check("top-level keys only",
+          IsValidResponse(200, valid, options.requiredKeys) &&
+              !IsValidResponse(200, "{\"data\":null}", options.requiredKeys) &&
+              !IsValidResponse(200, "{\"config\":{\"data\":1}}", options.requiredKeys) &&
+              !IsValidResponse(200, "{\"note\":\"\\\"data\\\": 1\"}", options.requiredKeys) &&
+              !IsValidResponse(200, "[{\"data\":1}]", options.requiredKeys) &&
+              !IsValidResponse(500, valid, options.requiredKeys),
+          "nested, quoted, null and non-object matches are rejected");
+
+    DeleteFileA((workDir + "\\" + kHealthFileName).c_str());
+    std::vector<std::string> urls = {failing.Url(), slow.Url(), fast.Url()};
+    {
+        EndpointRacer racer;
+        racer.Init(workDir);
+        Result result = racer.Race(urls, options);
+        check("first valid responder wins",
+              result.winner == 2 && result.attempts[1].cancelled, describe(result));
+    }
+    {
+        // A new instance stands for the next launch reading the health file
+        EndpointRacer racer;
+        racer.Init(workDir);
+        std::vector<size_t> order = racer.OrderByHealth(urls);
+        check("health survives a restart", order.front() == 2 && order.back() == 0,
+              "order " + std::to_string(order[0]) + "," + std::to_string(order[1]) + "," +
+                  std::to_string(order[2]));
+    }
+    {
+        EndpointRacer racer;
+        racer.Init(workDir);
+        Result result = racer.Race({hang.Url(), fast.Url()}, options);
+        check("hanging loser is cancelled",
+              result.winner == 1 && result.attempts[0].cancelled && result.totalMs < options.timeoutMs,
+              describe(result));
+    }
+    {
+        EndpointRacer racer;
+        racer.Init(workDir);
+        Result result = racer.Race({refused, failing.Url(), nested.Url()}, options);
+        check("invalid responders never win",
+              result.winner < 0 && std::none_of(result.attempts.begin(), result.attempts.end(),
+                                                [](const Attempt& attempt) { return attempt.valid; }),
+              describe(result));
+    }
+    DeleteFileA((workDir + "\\" + kHealthFileName).c_str());
+    WSACleanup();
+
+    report.passed = std::all_of(report.checks.begin(), report.checks.end(),
+                                [](const Check& item) { return item.passed; });
+    report.elapsedMs = ElapsedMs(started);
+    return report;
+}
+
+std::vector<EndpointRacer::Health> EndpointRacer::GetHealth() {
+    std::lock_guard<std::mutex> lock(healthMutex_);
+    LoadHealth();
+    std::vector<Health> entries;
+    for (const auto& entry : health_) {
+        entries.push_back(entry.second);
+    }
+    return entries;
+}
+
+void EndpointRacer::ResetHealth() {
+    std::lock_guard<std::mutex> lock(healthMutex_);
+    health_.clear();
+    loaded_ = true;
+    if (!healthPath_.empty()) {
+        DeleteFileA(healthPath_.c_str());
+    }
+}
+
+std::vector<size_t> EndpointRacer::OrderByHealth(const std::vector<std::string>& urls) {
+    std::lock_guard<std::mutex> lock(healthMutex_);
+    LoadHealth();
+
+    // 0: answered last time, fastest first
+    // 1: never seen, keep configured order
+    // 2: currently failing, fewest consecutive failures first
+    auto bucket = [&](const std::string& url, double* key) {
+        auto it = health_.find(url);
+        if (it == health_.end() || (it->second.successes == 0 && it->second.failures == 0)) {
+            *key = 0;
+            return 1;
+        }
+        if (it->second.consecutiveFailures == 0) {
+            *key = it->second.latencyMs;
+            return 0;
+        }
+        *key = it->second.consecutiveFailures;
+        return 2;
+    };
+
+    std::vector<size_t> order(urls.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        double keyA = 0, keyB = 0;
+        int bucketA = bucket(urls[a], &keyA);
+        int bucketB = bucket(urls[b], &keyB);
+        if (bucketA != bucketB) return bucketA < bucketB;
+        return keyA < keyB;
+    });
+    return order;
+}
+
+void EndpointRacer::RecordOutcome(const Attempt& attempt) {
+    // Losers aborted by the race say nothing about the endpoint's health
+    if (!attempt.started || !attempt.finished || attempt.cancelled) return;
+
+    std::lock_guard<std::mutex> lock(healthMutex_);
+    Health& entry = health_[attempt.url];
+    entry.url = attempt.url;
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+
+    if (attempt.valid) {
+        entry.successes++;
+        entry.consecutiveFailures = 0;
+        entry.lastSuccess = now;
+        double sample = static_cast<double>(attempt.latencyMs);
+        entry.latencyMs = entry.successes == 1
+            ? sample
+            : entry.latencyMs + kLatencyAlpha * (sample - entry.latencyMs);
+    } else {
+        entry.failures++;
+        entry.consecutiveFailures++;
+        entry.lastFailure = now;
+    }
+}
+
+void EndpointRacer::LoadHealth() {
+    if (loaded_ || healthPath_.empty()) return;
+    loaded_ = true;
+
+    std::ifstream file(healthPath_);
+    if (!file.is_open()) return;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        Health entry;
+        if (!std::getline(fields, entry.url, '\t')) continue;
+        fields >> entry.successes >> entry.failures >> entry.consecutiveFailures
+               >> entry.latencyMs >> entry.lastSuccess >> entry.lastFailure;
+        if (fields.fail() || entry.url.empty()) continue;
+        health_[entry.url] = entry;
+    }
+}
+
+void EndpointRacer::SaveHealth() {
+    std::lock_guard<std::mutex> lock(healthMutex_);
+    if (healthPath_.empty()) return;
+
+    // Write to a temp file and swap it in so a crash never leaves half a file
+    std::string tempPath = healthPath_ + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file.is_open()) return;
+        file << kHealthHeader << "\n";
+        for (const auto& item : health_) {
+            const Health& entry = item.second;
+            file << entry.url << '\t' << entry.successes << '\t' << entry.failures << '\t'
+                 << entry.consecutiveFailures << '\t' << static_cast<int64_t>(entry.latencyMs) << '\t'
+                 << entry.lastSuccess << '\t' << entry.lastFailure << "\n";
+        }
+    }
+    MoveFileExA(tempPath.c_str(), healthPath_.c_str(), MOVEFILE_REPLACE_EXISTING);
+}
+
+bool EndpointRacer::IsValidResponse(int statusCode, const std::string& body,
+                                    const std::vector<std::string>& requiredKeys) {
+    if (statusCode != 200) return false;
+    if (requiredKeys.empty()) return true;
+
+    // Mirrors the Dart-side check: the guest config must be a JSON object
+    // carrying at least one of the expected top-level keys with a non-null
+    // value. Keys inside nested objects or string values do not count.
+    JsonReader reader(body.data(), body.data() + body.size());
+    if (!reader.Consume('{')) return false;
+    if (reader.Consume('}')) return false;
+    bool found = false;
+    do {
+        std::string key;
+        if (!reader.String(&key) || !reader.Consume(':')) return false;
+        if (!found && !reader.Peek('n') &&
+            std::find(requiredKeys.begin(), requiredKeys.end(), key) != requiredKeys.end()) {
+            found = true;
+        }
+        if (!reader.Skip()) return false;
+    } while (reader.Consume(','));
+    return found && reader.Consume('}');
+}
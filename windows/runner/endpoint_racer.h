@@ -0,0 +1,108 @@
+// endpoint_racer.h - Concurrent panel API endpoint racer for Windows
+#ifndef ENDPOINT_RACER_H_
+#define ENDPOINT_RACER_H_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Probes every configured panel endpoint in parallel with happy-eyeballs
+// style staggered starts and returns the first one that answers with a valid
+// guest config. Per-endpoint health and latency survive restarts in a small
+// tab-separated file so the next launch tries the historically best endpoint
+// first and delays the ones that keep failing.
+class EndpointRacer {
+public:
+    struct Options {
+        std::string probePath;                  // Appended to each endpoint, e.g. "/guest_config.txt"
+        std::vector<std::string> requiredKeys;  // Any of these JSON keys must be present and non-null
+        std::string userAgent = "Vortex/1.0";
+        int timeoutMs = 5000;                   // Per-attempt timeout
+        int staggerMs = 250;                    // Delay before the next attempt starts
+    };
+
+    struct Attempt {
+        std::string url;
+        int order = -1;          // Start position after health ordering
+        bool started = false;
+        bool finished = false;
+        bool valid = false;
+        bool cancelled = false;  // Lost the race and was aborted
+        int statusCode = 0;
+        int64_t startOffsetMs = 0;
+        int64_t latencyMs = -1;
+        std::string error;
+    };
+
+    struct Result {
+        int winner = -1;  // Index into urls, -1 if no endpoint answered
+        std::string url;
+        int64_t latencyMs = -1;
+        int64_t totalMs = 0;
+        std::vector<Attempt> attempts;  // Same order as the input urls
+    };
+
+    struct Health {
+        std::string url;
+        int successes = 0;
+        int failures = 0;
+        int consecutiveFailures = 0;
+        double latencyMs = 0;  // Exponentially weighted moving average
+        int64_t lastSuccess = 0;  // Unix seconds
+        int64_t lastFailure = 0;
+    };
+
+    struct Check {
+        std::string name;
+        bool passed = false;
+        std::string detail;
+    };
+
+    struct CheckReport {
+        std::vector<Check> checks;
+        bool passed = false;
+        int64_t elapsedMs = 0;
+        std::string error;
+    };
+
+    static EndpointRacer& GetInstance();
+
+    // Races local HTTP stand-ins (refused, hanging, slow, invalid and healthy
+    // endpoints on 127.0.0.1) with a private racer whose health file lives in
+    // workDir, and checks the winner, cancellation of losers, the response
+    // validation and the health ordering on the next launch. Leaves the
+    // shared instance and its health file alone.
+    static CheckReport SelfCheck(const std::string& workDir);
+
+    // Set the directory holding the health file
+    void Init(const std::string& workDir);
+
+    // Race all urls. Blocks until a winner is found or every attempt failed.
+    Result Race(const std::vector<std::string>& urls, const Options& options);
+
+    std::vector<Health> GetHealth();
+    void ResetHealth();
+
+private:
+    EndpointRacer() = default;
+    EndpointRacer(const EndpointRacer&) = delete;
+    EndpointRacer& operator=(const EndpointRacer&) = delete;
+
+    std::vector<size_t> OrderByHealth(const std::vector<std::string>& urls);
+    void RecordOutcome(const Attempt& attempt);
+    void LoadHealth();
+    void SaveHealth();
+
+    static bool IsValidResponse(int statusCode, const std::string& body,
+                                const std::vector<std::string>& requiredKeys);
+
+    std::mutex raceMutex_;    // Serializes races
+    std::mutex healthMutex_;  // Guards health_
+    std::string healthPath_;
+    std::map<std::string, Health> health_;
+    bool loaded_ = false;
+};
+
+#endif  // ENDPOINT_RACER_H_
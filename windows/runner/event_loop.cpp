@@ -0,0 +1,71 @@
+// event_loop.cpp - Single-threaded task loop implementation
+#include "event_loop.h"
+#include "idle_budget.h"
+
+EventLoop& EventLoop::GetInstance() {
+    static EventLoop instance;
+    return instance;
+}
+
+EventLoop::~EventLoop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void EventLoop::EnsureStarted() {
+    if (thread_.joinable() || stopping_) return;
+    thread_ = std::thread([this]() { Run(); });
+    threadId_ = thread_.get_id();
+}
+
+void EventLoop::Post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EnsureStarted();
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void EventLoop::PostAfter(int delayMs, Task task) {
+    auto due = Clock::now() + std::chrono::milliseconds(delayMs > 0 ? delayMs : 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EnsureStarted();
+        timers_.emplace(due, std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void EventLoop::Run() {
+    IdleBudget::TagThread("event_loop");
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // Due timers join the queue behind work that was already posted
+        auto now = Clock::now();
+        while (!timers_.empty() && timers_.begin()->first <= now) {
+            tasks_.push_back(std::move(timers_.begin()->second));
+            timers_.erase(timers_.begin());
+        }
+
+        if (tasks_.empty()) {
+            if (stopping_) return;
+            if (timers_.empty()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, timers_.begin()->first);
+            }
+            continue;
+        }
+
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
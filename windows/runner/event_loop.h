@@ -0,0 +1,54 @@
+// event_loop.h - Single-threaded task loop for native coroutines on Windows
+#ifndef EVENT_LOOP_H_
+#define EVENT_LOOP_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// One thread that runs posted tasks in order and fires timers. The core's
+// coroutine API (core_async.h) resumes every coroutine here, so coroutine
+// bodies never run concurrently with each other. Tasks must not block;
+// blocking work belongs on its own thread, which posts back when done.
+//
+// The thread starts with the first Post and sleeps on a condition variable
+// while there is nothing to run or no timer due.
+class EventLoop {
+public:
+    using Task = std::function<void()>;
+
+    static EventLoop& GetInstance();
+
+    void Post(Task task);
+
+    // Runs task on the loop once delayMs has passed
+    void PostAfter(int delayMs, Task task);
+
+    bool IsLoopThread() const { return std::this_thread::get_id() == threadId_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    EventLoop() = default;
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void EnsureStarted();  // Called with mutex_ held
+    void Run();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    std::multimap<Clock::time_point, Task> timers_;
+    std::thread thread_;
+    std::atomic<std::thread::id> threadId_;
+    bool stopping_ = false;
+};
+
+#endif  // EVENT_LOOP_H_
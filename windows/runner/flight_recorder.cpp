@@ -0,0 +1,192 @@
+// flight_recorder.cpp - Crash-safe binary event ring implementation
+#include "flight_recorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x52465856;  // "VXFR"
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kCapacity = 8192;     // 512 KB of entries
+
+// 100ns ticks between 1601-01-01 and 1970-01-01
+constexpr uint64_t kEpochDelta = 116444736000000000ULL;
+
+uint64_t NowMicros() {
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t ticks = (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    return (ticks - kEpochDelta) / 10;
+}
+
+const char* CategoryName(uint16_t category) {
+    switch (category) {
+        case 1: return "runner";
+        case 2: return "method";
+        case 3: return "event";
+        case 4: return "state";
+        case 5: return "controller";
+        case 6: return "supervisor";
+        case 7: return "memory";
+        case 8: return "network";
+        default: return "unknown";
+    }
+}
+
+const char* LevelName(uint16_t level) {
+    switch (level) {
+        case 1: return "W";
+        case 2: return "E";
+        default: return "I";
+    }
+}
+
+}  // namespace
+
+struct FlightRecorder::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entrySize;
+    uint32_t capacity;
+    volatile LONG64 next;  // Total entries ever claimed
+    uint8_t reserved[40];
+};
+
+// `sequence` is written last: it is the claimed index + 1, so a slot whose
+// sequence does not match its position was torn by a crash mid-write.
+struct FlightRecorder::Entry {
+    volatile uint64_t sequence;
+    uint64_t timeUs;
+    int64_t value;
+    uint32_t threadId;
+    uint16_t category;
+    uint16_t level;
+    char text[32];
+};
+
+FlightRecorder& FlightRecorder::GetInstance() {
+    static FlightRecorder instance;
+    return instance;
+}
+
+FlightRecorder::~FlightRecorder() {
+    if (header_) {
+        FlushViewOfFile(header_, 0);
+        UnmapViewOfFile(header_);
+    }
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ && file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+}
+
+bool FlightRecorder::Init(const std::string& workDir) {
+    static_assert(sizeof(Entry) == 64, "flight recorder entry must stay 64 bytes");
+    if (header_) return true;
+
+    std::string path = workDir + "\\flight_recorder.bin";
+    DWORD size = static_cast<DWORD>(sizeof(Header) + sizeof(Entry) * kCapacity);
+
+    file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        return false;
+    }
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, 0, size, nullptr);
+    if (!mapping_) return false;
+
+    void* view = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view) return false;
+
+    Header* header = static_cast<Header*>(view);
+    if (header->magic != kMagic || header->version != kVersion ||
+        header->entrySize != sizeof(Entry) || header->capacity != kCapacity) {
+        memset(view, 0, size);
+        header->magic = kMagic;
+        header->version = kVersion;
+        header->entrySize = sizeof(Entry);
+        header->capacity = kCapacity;
+    }
+
+    entries_ = reinterpret_cast<Entry*>(static_cast<char*>(view) + sizeof(Header));
+    header_ = header;
+
+    previousFilter_ = SetUnhandledExceptionFilter(&FlightRecorder::OnUnhandledException);
+    Record(Category::Runner, Level::Info, "session start", GetCurrentProcessId());
+    return true;
+}
+
+void FlightRecorder::Record(Category category, Level level, const char* text, int64_t value) {
+    FlightRecorder& recorder = GetInstance();
+    if (!recorder.header_) return;
+
+    uint64_t index = static_cast<uint64_t>(InterlockedIncrement64(&recorder.header_->next)) - 1;
+    Entry& entry = recorder.entries_[index % kCapacity];
+
+    entry.sequence = 0;
+    entry.timeUs = NowMicros();
+    entry.value = value;
+    entry.threadId = GetCurrentThreadId();
+    entry.category = static_cast<uint16_t>(category);
+    entry.level = static_cast<uint16_t>(level);
+    size_t length = text ? strnlen(text, sizeof(entry.text) - 1) : 0;
+    memcpy(entry.text, text ? text : "", length);
+    entry.text[length] = '\0';
+    MemoryBarrier();
+    entry.sequence = index + 1;
+}
+
+std::string FlightRecorder::Decode() const {
+    if (!header_) return "Flight recorder not available\n";
+
+    std::vector<Entry> entries;
+    entries.reserve(kCapacity);
+    for (uint32_t i = 0; i < kCapacity; i++) {
+        Entry entry = entries_[i];
+        if (entry.sequence == 0 || (entry.sequence - 1) % kCapacity != i) continue;
+        entries.push_back(entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.sequence < b.sequence;
+    });
+
+    std::string out;
+    char line[160];
+    for (const auto& entry : entries) {
+        time_t seconds = static_cast<time_t>(entry.timeUs / 1000000);
+        struct tm local;
+        localtime_s(&local, &seconds);
+        char text[sizeof(entry.text)];
+        memcpy(text, entry.text, sizeof(text));
+        text[sizeof(text) - 1] = '\0';
+
+        snprintf(line, sizeof(line), "%04d-%02d-%02d %02d:%02d:%02d.%06d %s %-10s [%5u] %s",
+                 local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                 local.tm_hour, local.tm_min, local.tm_sec,
+                 static_cast<int>(entry.timeUs % 1000000),
+                 LevelName(entry.level), CategoryName(entry.category),
+                 entry.threadId, text);
+        out += line;
+        if (entry.value != 0) {
+            out += " (" + std::to_string(entry.value) + ")";
+        }
+        out += "\n";
+    }
+    return out;
+}
+
+LONG WINAPI FlightRecorder::OnUnhandledException(EXCEPTION_POINTERS* info) {
+    DWORD code = info && info->ExceptionRecord ? info->ExceptionRecord->ExceptionCode : 0;
+    Record(Category::Runner, Level::Error, "unhandled exception", static_cast<int64_t>(code));
+
+    FlightRecorder& recorder = GetInstance();
+    FlushViewOfFile(recorder.header_, 0);
+    if (recorder.previousFilter_) {
+        return recorder.previousFilter_(info);
+    }
+    return EXCEPTION_CONTINUE_SEARCH;
+}
@@ -0,0 +1,64 @@
+// flight_recorder.h - Crash-safe binary event ring for Windows
+#ifndef FLIGHT_RECORDER_H_
+#define FLIGHT_RECORDER_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <string>
+
+// Fixed-size ring of compact binary entries kept in a memory-mapped file.
+// Writers claim a slot with one interlocked increment and copy 64 bytes, so
+// recording is cheap enough for every subsystem to use unconditionally.
+// The pages belong to the file mapping, not the process, so whatever was
+// recorded up to a crash (of the runner or the core) is still in the file on
+// the next launch and ends up in the diagnostic export.
+class FlightRecorder {
+public:
+    enum class Category : uint16_t {
+        Runner = 1,      // Session start, crashes
+        Method,          // Platform channel method calls
+        Event,           // Events sent to Dart
+        State,           // Core state transitions
+        Controller,      // Controller API errors
+        Supervisor,      // Core exits, limits, restarts
+        Memory,          // Memory pressure responses
+        Network,         // Endpoint races, subscription fetches
+    };
+
+    enum class Level : uint16_t { Info = 0, Warning, Error };
+
+    static FlightRecorder& GetInstance();
+
+    // Maps <workDir>\flight_recorder.bin, keeping entries from earlier runs
+    bool Init(const std::string& workDir);
+
+    // Safe to call from any thread, before Init it does nothing. Text longer
+    // than 31 bytes is truncated.
+    static void Record(Category category, Level level, const char* text, int64_t value = 0);
+    static void Record(Category category, Level level, const std::string& text, int64_t value = 0) {
+        Record(category, level, text.c_str(), value);
+    }
+
+    // Oldest to newest, one line per entry
+    std::string Decode() const;
+
+private:
+    FlightRecorder() = default;
+    ~FlightRecorder();
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    static LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS* info);
+
+    struct Header;
+    struct Entry;
+
+    HANDLE file_ = nullptr;
+    HANDLE mapping_ = nullptr;
+    Header* header_ = nullptr;
+    Entry* entries_ = nullptr;
+    LPTOP_LEVEL_EXCEPTION_FILTER previousFilter_ = nullptr;
+};
+
+#endif  // FLIGHT_RECORDER_H_
@@ -0,0 +1,276 @@
+// http_fetch.cpp - Cancellable WinHTTP GET helper implementation
+#include "http_fetch.h"
+#include "utils.h"
+
+#include <chrono>
+
+#pragma comment(lib, "winhttp.lib")
+
+namespace {
+
+// Extra wait on top of the WinHTTP timeouts before a stuck call is abandoned
+constexpr int kAwaitSlackMs = 1000;
+
+}  // namespace
+
+HttpFetch::HttpFetch()
+    : session_(nullptr),
+      connect_(nullptr),
+      cancelled_(false),
+      status_(0),
+      info_(0),
+      error_(0),
+      closing_(false),
+      timeoutMs_(5000),
+      userAgent_("Vortex/1.0") {}
+
+HttpFetch::~HttpFetch() {
+    CloseConnection();
+}
+
+std::wstring HttpFetch::Widen(const std::string& utf8) {
+    if (utf8.empty()) return std::wstring();
+    int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(),
+        static_cast<int>(utf8.size()), nullptr, 0);
+    if (length <= 0) return std::wstring(utf8.begin(), utf8.end());
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()),
+        &wide[0], length);
+    return wide;
+}
+
+HttpFetch::Response HttpFetch::Get(const std::string& url, ChunkCallback onChunk) {
+    Response response;
+    auto started = std::chrono::steady_clock::now();
+
+    if (cancelled_) {
+        response.error = "cancelled";
+        return response;
+    }
+
+    std::wstring wUrl = Widen(url);
+    URL_COMPONENTS parts = {0};
+    parts.dwStructSize = sizeof(parts);
+    parts.dwSchemeLength = static_cast<DWORD>(-1);
+    parts.dwHostNameLength = static_cast<DWORD>(-1);
+    parts.dwUrlPathLength = static_cast<DWORD>(-1);
+    parts.dwExtraInfoLength = static_cast<DWORD>(-1);
+    if (!WinHttpCrackUrl(wUrl.c_str(), 0, 0, &parts)) {
+        response.error = "invalid url";
+        return response;
+    }
+
+    std::wstring host(parts.lpszHostName, parts.dwHostNameLength);
+    std::wstring path(parts.lpszUrlPath, parts.dwUrlPathLength);
+    if (parts.dwExtraInfoLength > 0) {
+        path.append(parts.lpszExtraInfo, parts.dwExtraInfoLength);
+    }
+    if (path.empty()) path = L"/";
+    bool secure = parts.nScheme == INTERNET_SCHEME_HTTPS;
+
+    // Keep the session and connection when the previous request went to the
+    // same place, so WinHTTP can hand out its pooled keep-alive connection
+    std::wstring target = Widen(proxy_) + L"|" + (secure ? L"https://" : L"http://") + host +
+        L":" + std::to_wstring(parts.nPort);
+    if (target != target_) {
+        CloseConnection();
+
+        std::wstring proxy = Widen(proxy_);
+        session_ = WinHttpOpen(Widen(userAgent_).c_str(),
+            proxy.empty() ? WINHTTP_ACCESS_TYPE_DEFAULT_PROXY : WINHTTP_ACCESS_TYPE_NAMED_PROXY,
+            proxy.empty() ? WINHTTP_NO_PROXY_NAME : proxy.c_str(),
+            WINHTTP_NO_PROXY_BYPASS, WINHTTP_FLAG_ASYNC);
+        if (!session_) {
+            response.error = "WinHttpOpen failed";
+            return response;
+        }
+        // Handles opened below inherit the callback
+        if (WinHttpSetStatusCallback(session_, OnStatus,
+                WINHTTP_CALLBACK_FLAG_ALL_COMPLETIONS | WINHTTP_CALLBACK_FLAG_HANDLES, 0) ==
+            WINHTTP_INVALID_STATUS_CALLBACK) {
+            CloseConnection();
+            response.error = "WinHttpSetStatusCallback failed";
+            return response;
+        }
+
+        connect_ = WinHttpConnect(session_, host.c_str(), parts.nPort, 0);
+        if (!connect_) {
+            CloseConnection();
+            response.error = "WinHttpConnect failed";
+            return response;
+        }
+        target_ = target;
+    }
+
+    HINTERNET request = WinHttpOpenRequest(connect_, L"GET", path.c_str(),
+        nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+        secure ? WINHTTP_FLAG_SECURE : 0);
+    if (!request) {
+        response.error = "WinHttpOpenRequest failed";
+        return response;
+    }
+
+    // Callbacks for the session and connection carry no context and are
+    // ignored; only the request's reach this object
+    DWORD_PTR context = reinterpret_cast<DWORD_PTR>(this);
+    if (!WinHttpSetOption(request, WINHTTP_OPTION_CONTEXT_VALUE, &context, sizeof(context))) {
+        WinHttpCloseHandle(request);
+        response.error = "WinHttpSetOption failed";
+        return response;
+    }
+    WinHttpSetTimeouts(request, timeoutMs_, timeoutMs_, timeoutMs_, timeoutMs_);
+    for (const auto& header : headers_) {
+        std::wstring wHeader = Widen(header);
+        WinHttpAddRequestHeaders(request, wHeader.c_str(), static_cast<DWORD>(-1),
+            WINHTTP_ADDREQ_FLAG_ADD);
+    }
+
+    DWORD info = 0;
+    DWORD error = 0;
+    auto fail = [&](const std::string& what) {
+        if (cancelled_) {
+            response.error = "cancelled";
+        } else if (error == 0 || error == ERROR_WINHTTP_TIMEOUT) {
+            response.error = what + " (timeout)";
+        } else {
+            response.error = what + " (" + std::to_string(error) + ")";
+        }
+    };
+
+    if (!Await([&]() {
+            return WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
+                WINHTTP_NO_REQUEST_DATA, 0, 0, context);
+        }, &info, &error) ||
+        !Await([&]() { return WinHttpReceiveResponse(request, nullptr); }, &info, &error)) {
+        fail("request failed");
+        CloseRequest(request);
+        response.elapsedMs = ElapsedMs(started);
+        return response;
+    }
+    response.firstByteMs = ElapsedMs(started);
+
+    DWORD statusCode = 0;
+    DWORD statusSize = sizeof(statusCode);
+    WinHttpQueryHeaders(request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+        WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &statusSize, WINHTTP_NO_HEADER_INDEX);
+    response.statusCode = static_cast<int>(statusCode);
+
+    std::vector<char> buffer;
+    for (;;) {
+        DWORD available = 0;
+        if (!Await([&]() { return WinHttpQueryDataAvailable(request, nullptr); }, &available, &error)) {
+            fail("read failed");
+            break;
+        }
+        if (available == 0) break;
+
+        buffer.resize(available);
+        DWORD read = 0;
+        if (!Await([&]() { return WinHttpReadData(request, buffer.data(), available, nullptr); },
+                &read, &error)) {
+            fail("read failed");
+            break;
+        }
+        if (read == 0) break;
+
+        if (onChunk) {
+            if (!onChunk(buffer.data(), read)) {
+                response.error = "aborted";
+                break;
+            }
+        } else {
+            response.body.append(buffer.data(), read);
+        }
+    }
+
+    CloseRequest(request);
+    response.elapsedMs = ElapsedMs(started);
+    return response;
+}
+
+void HttpFetch::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    cv_.notify_all();
+}
+
+bool HttpFetch::Await(const std::function<BOOL()>& call, DWORD* info, DWORD* error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) return false;
+        status_ = 0;
+        info_ = 0;
+        error_ = 0;
+    }
+    if (!call()) {
+        *error = GetLastError();
+        return false;
+    }
+
+    // WinHTTP's own timeouts end a stalled call with an error; the extra
+    // deadline only guards against a completion that never arrives
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool done = cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs_ + kAwaitSlackMs),
+        [this]() { return status_ != 0 || cancelled_; });
+    *info = info_;
+    *error = error_;
+    if (!done || cancelled_) return false;
+    return status_ != WINHTTP_CALLBACK_STATUS_REQUEST_ERROR;
+}
+
+void HttpFetch::CloseRequest(HINTERNET request) {
+    // Closing cancels any outstanding call; once the closing notification has
+    // arrived no further callback refers to this object
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    WinHttpCloseHandle(request);
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !closing_; });
+}
+
+void HttpFetch::CloseConnection() {
+    if (connect_) {
+        WinHttpCloseHandle(connect_);
+        connect_ = nullptr;
+    }
+    if (session_) {
+        WinHttpCloseHandle(session_);
+        session_ = nullptr;
+    }
+    target_.clear();
+}
+
+void CALLBACK HttpFetch::OnStatus(HINTERNET handle, DWORD_PTR context, DWORD status,
+                                  LPVOID info, DWORD length) {
+    (void)handle;
+    auto* self = reinterpret_cast<HttpFetch*>(context);
+    if (!self) return;
+
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    switch (status) {
+        case WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE:
+        case WINHTTP_CALLBACK_STATUS_HEADERS_AVAILABLE:
+            self->status_ = status;
+            break;
+        case WINHTTP_CALLBACK_STATUS_DATA_AVAILABLE:
+            self->status_ = status;
+            self->info_ = info ? *static_cast<DWORD*>(info) : 0;
+            break;
+        case WINHTTP_CALLBACK_STATUS_READ_COMPLETE:
+            self->status_ = status;
+            self->info_ = length;
+            break;
+        case WINHTTP_CALLBACK_STATUS_REQUEST_ERROR:
+            self->status_ = status;
+            self->error_ = info ? static_cast<WINHTTP_ASYNC_RESULT*>(info)->dwError : 0;
+            break;
+        case WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING:
+            self->closing_ = false;
+            break;
+        default:
+            return;
+    }
+    self->cv_.notify_all();
+}
@@ -0,0 +1,88 @@
+// http_fetch.h - Cancellable WinHTTP GET helper for Windows
+#ifndef HTTP_FETCH_H_
+#define HTTP_FETCH_H_
+
+#include <windows.h>
+#include <winhttp.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// HTTP(S) GET against an arbitrary URL. Unlike MihomoCore::HttpGet, which
+// always talks to the local controller, this cracks the URL itself, honours a
+// per-request timeout and can be cancelled from another thread. WinHTTP runs
+// in asynchronous mode and Get() waits for each completion, so Cancel() only
+// signals: the handles are opened and closed on the thread calling Get().
+// Sequential Get() calls to the same host share one session and connection,
+// so the second one reuses the pooled TCP/TLS (or proxy tunnel).
+class HttpFetch {
+public:
+    struct Response {
+        int statusCode = 0;
+        std::string body;
+        std::string error;     // Empty on transport success
+        int64_t elapsedMs = 0; // Time until the last byte was read
+        int64_t firstByteMs = 0;
+    };
+
+    // Receives the body as it arrives. Returning false aborts the transfer.
+    using ChunkCallback = std::function<bool(const char* data, size_t size)>;
+
+    HttpFetch();
+    ~HttpFetch();
+    HttpFetch(const HttpFetch&) = delete;
+    HttpFetch& operator=(const HttpFetch&) = delete;
+
+    void SetTimeout(int timeoutMs) { timeoutMs_ = timeoutMs; }
+    void SetUserAgent(const std::string& userAgent) { userAgent_ = userAgent; }
+    void AddHeader(const std::string& header) { headers_.push_back(header); }
+
+    // Send the request through an HTTP proxy, e.g. "127.0.0.1:7890",
+    // instead of the system proxy settings
+    void SetProxy(const std::string& proxy) { proxy_ = proxy; }
+
+    // Blocking GET. When onChunk is set the body is streamed to it instead of
+    // being collected in Response::body. Calls must not overlap.
+    Response Get(const std::string& url, ChunkCallback onChunk = nullptr);
+
+    // Thread-safe. Makes a pending Get() abort its request and return, and
+    // every later Get() fail with "cancelled".
+    void Cancel();
+    bool IsCancelled() const { return cancelled_; }
+
+    static std::wstring Widen(const std::string& utf8);
+
+private:
+    static void CALLBACK OnStatus(HINTERNET handle, DWORD_PTR context, DWORD status,
+                                  LPVOID info, DWORD length);
+
+    // Issues one asynchronous call and waits for its completion. False on
+    // error, cancellation or timeout; *info receives the completion value.
+    bool Await(const std::function<BOOL()>& call, DWORD* info, DWORD* error);
+    void CloseRequest(HINTERNET request);
+    void CloseConnection();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    HINTERNET session_;
+    HINTERNET connect_;
+    std::wstring target_;  // proxy|scheme://host:port the session and connection serve
+    std::atomic<bool> cancelled_;
+
+    // Completion state of the one outstanding call, guarded by mutex_
+    DWORD status_;
+    DWORD info_;
+    DWORD error_;
+    bool closing_;
+
+    int timeoutMs_;
+    std::string userAgent_;
+    std::string proxy_;
+    std::vector<std::string> headers_;
+};
+
+#endif  // HTTP_FETCH_H_
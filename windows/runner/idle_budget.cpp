@@ -0,0 +1,251 @@
+// idle_budget.cpp - Idle wakeup and CPU budget measurement implementation
+#include "idle_budget.h"
+#include "flight_recorder.h"
+#include "mihomo_core.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// SystemProcessInformation, with the layouts documented in winternl.h
+// filled out to the fields the kernel actually returns
+constexpr int kSystemProcessInformation = 5;
+constexpr NTSTATUS kStatusInfoLengthMismatch = static_cast<NTSTATUS>(0xC0000004L);
+
+struct ThreadInformation {
+    LARGE_INTEGER kernelTime;
+    LARGE_INTEGER userTime;
+    LARGE_INTEGER createTime;
+    ULONG waitTime;
+    void* startAddress;
+    HANDLE uniqueProcess;
+    HANDLE uniqueThread;
+    LONG priority;
+    LONG basePriority;
+    ULONG contextSwitches;
+    ULONG threadState;
+    ULONG waitReason;
+};
+
+struct ProcessInformation {
+    ULONG nextEntryOffset;
+    ULONG numberOfThreads;
+    LARGE_INTEGER workingSetPrivateSize;
+    ULONG hardFaultCount;
+    ULONG numberOfThreadsHighWatermark;
+    ULONGLONG cycleTime;
+    LARGE_INTEGER createTime;
+    LARGE_INTEGER userTime;
+    LARGE_INTEGER kernelTime;
+    USHORT imageNameLength;
+    USHORT imageNameMaximumLength;
+    wchar_t* imageNameBuffer;
+    LONG basePriority;
+    HANDLE uniqueProcessId;
+    HANDLE inheritedFromUniqueProcessId;
+    ULONG handleCount;
+    ULONG sessionId;
+    ULONG_PTR uniqueProcessKey;
+    SIZE_T peakVirtualSize;
+    SIZE_T virtualSize;
+    ULONG pageFaultCount;
+    SIZE_T peakWorkingSetSize;
+    SIZE_T workingSetSize;
+    SIZE_T quotaPeakPagedPoolUsage;
+    SIZE_T quotaPagedPoolUsage;
+    SIZE_T quotaPeakNonPagedPoolUsage;
+    SIZE_T quotaNonPagedPoolUsage;
+    SIZE_T pagefileUsage;
+    SIZE_T peakPagefileUsage;
+    SIZE_T privatePageCount;
+    LARGE_INTEGER readOperationCount;
+    LARGE_INTEGER writeOperationCount;
+    LARGE_INTEGER otherOperationCount;
+    LARGE_INTEGER readTransferCount;
+    LARGE_INTEGER writeTransferCount;
+    LARGE_INTEGER otherTransferCount;
+    // ThreadInformation[numberOfThreads] follows
+};
+
+using NtQuerySystemInformationPtr = NTSTATUS(WINAPI*)(int, void*, ULONG, ULONG*);
+
+constexpr char kUntagged[] = "untagged";
+constexpr char kCore[] = "core";
+
+std::mutex g_tagsMutex;
+std::unordered_map<DWORD, std::string> g_tags;
+
+struct ThreadCounters {
+    uint64_t switches = 0;
+    int64_t cpu = 0;  // 100 ns units
+};
+
+struct ProcessCounters {
+    bool found = false;
+    std::unordered_map<DWORD, ThreadCounters> threads;
+    int64_t ioOperations = 0;
+};
+
+// One kernel snapshot, reduced to the runner and the core
+bool Snapshot(DWORD runnerPid, DWORD corePid, ProcessCounters* runner, ProcessCounters* core) {
+    static auto query = reinterpret_cast<NtQuerySystemInformationPtr>(
+        GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQuerySystemInformation"));
+    if (!query) return false;
+
+    std::vector<uint8_t> buffer(512 * 1024);
+    NTSTATUS status;
+    for (int attempt = 0; attempt < 4; attempt++) {
+        ULONG needed = 0;
+        status = query(kSystemProcessInformation, buffer.data(), static_cast<ULONG>(buffer.size()), &needed);
+        if (status != kStatusInfoLengthMismatch) break;
+        buffer.resize(std::max<size_t>(buffer.size() * 2, needed + 64 * 1024));
+    }
+    if (status < 0) return false;
+
+    size_t offset = 0;
+    for (;;) {
+        const auto* process = reinterpret_cast<const ProcessInformation*>(buffer.data() + offset);
+        DWORD pid = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(process->uniqueProcessId));
+        ProcessCounters* target = pid == runnerPid ? runner : (corePid && pid == corePid ? core : nullptr);
+        if (target) {
+            target->found = true;
+            target->ioOperations = process->readOperationCount.QuadPart +
+                process->writeOperationCount.QuadPart + process->otherOperationCount.QuadPart;
+            const auto* threads = reinterpret_cast<const ThreadInformation*>(process + 1);
+            for (ULONG i = 0; i < process->numberOfThreads; i++) {
+                DWORD tid = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(threads[i].uniqueThread));
+                ThreadCounters& counters = target->threads[tid];
+                counters.switches = threads[i].contextSwitches;
+                counters.cpu = threads[i].kernelTime.QuadPart + threads[i].userTime.QuadPart;
+            }
+        }
+        if (process->nextEntryOffset == 0) break;
+        offset += process->nextEntryOffset;
+    }
+    return true;
+}
+
+// Per-thread deltas summed into subsystems. Threads started inside the
+// window count from zero; threads that ended are lost with their counts.
+void Accumulate(const ProcessCounters& before, const ProcessCounters& after,
+                const std::unordered_map<DWORD, std::string>& tags, const char* fallback,
+                std::map<std::string, IdleBudget::Subsystem>* subsystems,
+                std::map<std::string, uint64_t>* switches, std::map<std::string, int64_t>* cpu) {
+    for (const auto& [tid, counters] : after.threads) {
+        auto tag = tags.find(tid);
+        const std::string& name = tag != tags.end() ? tag->second : fallback;
+        auto previous = before.threads.find(tid);
+        ThreadCounters base = previous != before.threads.end() ? previous->second : ThreadCounters();
+
+        auto& subsystem = (*subsystems)[name];
+        subsystem.name = name;
+        subsystem.threads++;
+        (*switches)[name] += counters.switches >= base.switches ? counters.switches - base.switches : 0;
+        (*cpu)[name] += std::max<int64_t>(0, counters.cpu - base.cpu);
+    }
+}
+
+}  // namespace
+
+const std::map<std::string, IdleBudget::Budget>& IdleBudget::DefaultBudgets() {
+    // The controller streams wake for /traffic once a second plus whatever
+    // the UI follows; the other native threads wait on events and should
+    // stay close to zero
+    static const std::map<std::string, Budget> budgets = {
+        {"controller_streams", {4.0, 0.5}},
+        {"core_job", {0.2, 0.1}},
+        {"event_loop", {0.2, 0.1}},
+        {"memory_monitor", {0.2, 0.1}},
+        {"proxy_topology", {0.2, 0.2}},
+        {"worker_pool", {0.5, 0.2}},
+        {kUntagged, {20.0, 1.0}},
+        {kCore, {30.0, 2.0}},
+    };
+    return budgets;
+}
+
+void IdleBudget::TagThread(const char* subsystem) {
+    std::lock_guard<std::mutex> lock(g_tagsMutex);
+    g_tags[GetCurrentThreadId()] = subsystem;
+}
+
+IdleBudget::Report IdleBudget::Measure(const Options& options) {
+    Report report;
+    auto& core = MihomoCore::GetInstance();
+    report.connected = core.GetState() == "connected";
+    if (options.requireConnected && !report.connected) {
+        report.error = "Core is not connected";
+        return report;
+    }
+
+    DWORD runnerPid = GetCurrentProcessId();
+    DWORD corePid = report.connected ? core.GetCoreProcessId() : 0;
+
+    ProcessCounters runnerBefore, coreBefore;
+    if (!Snapshot(runnerPid, corePid, &runnerBefore, &coreBefore)) {
+        report.error = "Process snapshot unavailable";
+        return report;
+    }
+    ULONGLONG started = GetTickCount64();
+    Sleep(static_cast<DWORD>(std::max(1000, options.windowMs)));
+
+    ProcessCounters runnerAfter, coreAfter;
+    if (!Snapshot(runnerPid, corePid, &runnerAfter, &coreAfter)) {
+        report.error = "Process snapshot unavailable";
+        return report;
+    }
+    report.windowMs = static_cast<int64_t>(GetTickCount64() - started);
+    double seconds = report.windowMs / 1000.0;
+
+    std::unordered_map<DWORD, std::string> tags;
+    {
+        // Forget threads that have exited so a reused id is not mislabelled
+        std::lock_guard<std::mutex> lock(g_tagsMutex);
+        for (auto it = g_tags.begin(); it != g_tags.end();) {
+            it = runnerAfter.threads.count(it->first) ? std::next(it) : g_tags.erase(it);
+        }
+        tags = g_tags;
+    }
+
+    std::map<std::string, Subsystem> subsystems;
+    std::map<std::string, uint64_t> switches;
+    std::map<std::string, int64_t> cpu;
+    Accumulate(runnerBefore, runnerAfter, tags, kUntagged, &subsystems, &switches, &cpu);
+    if (coreBefore.found && coreAfter.found) {
+        Accumulate(coreBefore, coreAfter, {}, kCore, &subsystems, &switches, &cpu);
+        report.coreIoPerSec = (coreAfter.ioOperations - coreBefore.ioOperations) / seconds;
+    }
+    report.runnerIoPerSec = (runnerAfter.ioOperations - runnerBefore.ioOperations) / seconds;
+
+    std::map<std::string, Budget> budgets = DefaultBudgets();
+    for (const auto& [name, budget] : options.budgets) budgets[name] = budget;
+
+    report.passed = true;
+    for (auto& [name, subsystem] : subsystems) {
+        subsystem.wakeupsPerSec = switches[name] / seconds;
+        // 100 ns units over the window, as percent of one core
+        subsystem.cpuPercent = cpu[name] / (seconds * 1e7) * 100;
+        auto budget = budgets.find(name);
+        if (budget != budgets.end()) {
+            subsystem.budget = budget->second;
+            subsystem.hasBudget = true;
+            subsystem.overBudget = subsystem.wakeupsPerSec > budget->second.wakeupsPerSec ||
+                                   subsystem.cpuPercent > budget->second.cpuPercent;
+        }
+        if (subsystem.overBudget) {
+            report.passed = false;
+            FlightRecorder::Record(FlightRecorder::Category::Supervisor, FlightRecorder::Level::Warning,
+                                   "idle budget exceeded by " + name,
+                                   static_cast<int64_t>(subsystem.wakeupsPerSec * 1000));
+        }
+        report.subsystems.push_back(subsystem);
+    }
+    std::sort(report.subsystems.begin(), report.subsystems.end(), [](const Subsystem& a, const Subsystem& b) {
+        return a.wakeupsPerSec > b.wakeupsPerSec;
+    });
+    return report;
+}
@@ -0,0 +1,67 @@
+// idle_budget.h - Idle wakeup and CPU budget measurement for Windows
+#ifndef IDLE_BUDGET_H_
+#define IDLE_BUDGET_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Measures what the runner costs while it sits in the tray: over a fixed
+// window it reads every thread's context switch count and CPU time from the
+// kernel's process snapshot (NtQuerySystemInformation, no ETW session
+// needed), for the runner and for the core process, and checks each
+// subsystem against its budget.
+//
+// Long-lived native threads tag themselves with TagThread at the top of
+// their loop; that tag is the subsystem their wakeups are charged to.
+// Threads without a tag (the Flutter engine, the UI thread, WinHTTP's pool)
+// share the "untagged" budget. A new poller shows up either as a tagged
+// subsystem over budget or as untagged growth, so new threads should tag
+// themselves and get a budget entry here.
+//
+// Windows keeps no per-thread syscall counter outside ETW; I/O operations
+// per second of each process stand in for syscall rates.
+class IdleBudget {
+public:
+    struct Budget {
+        double wakeupsPerSec = 0;  // Context switches per second, all threads
+        double cpuPercent = 0;     // Of one core
+    };
+
+    struct Options {
+        int windowMs = 30000;
+        bool requireConnected = true;          // Fail unless the core is connected
+        std::map<std::string, Budget> budgets;  // Overrides DefaultBudgets()
+    };
+
+    struct Subsystem {
+        std::string name;  // A thread tag, "untagged" or "core"
+        int threads = 0;
+        double wakeupsPerSec = 0;
+        double cpuPercent = 0;
+        Budget budget;
+        bool hasBudget = false;
+        bool overBudget = false;
+    };
+
+    struct Report {
+        std::vector<Subsystem> subsystems;  // Most wakeups first
+        bool connected = false;
+        double runnerIoPerSec = 0;
+        double coreIoPerSec = 0;
+        int64_t windowMs = 0;
+        bool passed = false;
+        std::string error;
+    };
+
+    static const std::map<std::string, Budget>& DefaultBudgets();
+
+    // Charges the calling thread's wakeups to subsystem
+    static void TagThread(const char* subsystem);
+
+    // Blocks for the window
+    static Report Measure(const Options& options);
+};
+
+#endif  // IDLE_BUDGET_H_
@@ -0,0 +1,156 @@
+// json_reader.cpp - Minimal pull reader for controller JSON implementation
+#include "json_reader.h"
+
+#include <algorithm>
+
+namespace {
+
+void AppendUtf8(uint32_t code, std::string* out) {
+    if (code < 0x80) {
+        out->push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+}  // namespace
+
+bool JsonReader::String(std::string* out) {
+    SkipSpace();
+    if (at_ >= end_ || *at_ != '"') return false;
+    out->clear();
+    for (at_++; at_ < end_; at_++) {
+        char c = *at_;
+        if (c == '"') {
+            at_++;
+            return true;
+        }
+        if (c != '\\') {
+            out->push_back(c);
+            continue;
+        }
+        if (++at_ >= end_) return false;
+        switch (*at_) {
+            case 'n': out->push_back('\n'); break;
+            case 't': out->push_back('\t'); break;
+            case 'r': out->push_back('\r'); break;
+            case 'b': out->push_back('\b'); break;
+            case 'f': out->push_back('\f'); break;
+            case 'u': {
+                uint32_t code = 0;
+                if (!Hex4(&code)) return false;
+                // Surrogate pair
+                if (code >= 0xD800 && code < 0xDC00 && end_ - at_ > 2 && at_[1] == '\\' && at_[2] == 'u') {
+                    at_ += 2;
+                    uint32_t low = 0;
+                    if (!Hex4(&low)) return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(code, out);
+                break;
+            }
+            default: out->push_back(*at_); break;
+        }
+    }
+    return false;
+}
+
+bool JsonReader::Int(int64_t* out) {
+    SkipSpace();
+    bool negative = at_ < end_ && *at_ == '-';
+    if (negative) at_++;
+    if (at_ >= end_ || *at_ < '0' || *at_ > '9') return false;
+    int64_t value = 0;
+    while (at_ < end_ && *at_ >= '0' && *at_ <= '9') value = value * 10 + (*at_++ - '0');
+    *out = negative ? -value : value;
+    return Peek(',') || Peek('}') || Peek(']') || at_ >= end_ || Skip();
+}
+
+bool JsonReader::Skip() {
+    SkipSpace();
+    if (at_ >= end_) return false;
+    if (*at_ == '"') {
+        std::string ignored;
+        return String(&ignored);
+    }
+    if (*at_ == '{' || *at_ == '[') {
+        char close = *at_ == '{' ? '}' : ']';
+        bool object = *at_ == '{';
+        at_++;
+        if (Consume(close)) return true;
+        do {
+            if (object) {
+                std::string key;
+                if (!String(&key) || !Consume(':')) return false;
+            }
+            if (!Skip()) return false;
+        } while (Consume(','));
+        return Consume(close);
+    }
+    // Number, true, false or null
+    const char* start = at_;
+    while (at_ < end_ && *at_ != ',' && *at_ != '}' && *at_ != ']' &&
+           *at_ != ' ' && *at_ != '\n' && *at_ != '\r' && *at_ != '\t') {
+        at_++;
+    }
+    return at_ > start;
+}
+
+bool JsonReader::StringArray(std::vector<std::string>* out) {
+    if (!Consume('[')) return Skip();
+    if (Consume(']')) return true;
+    do {
+        std::string item;
+        if (Peek('"')) {
+            if (!String(&item)) return false;
+            out->push_back(std::move(item));
+        } else if (!Skip()) {
+            return false;
+        }
+    } while (Consume(','));
+    return Consume(']');
+}
+
+bool JsonReader::Hex4(uint32_t* code) {
+    if (end_ - at_ < 5) return false;
+    *code = 0;
+    for (int i = 1; i <= 4; i++) {
+        char c = at_[i];
+        *code <<= 4;
+        if (c >= '0' && c <= '9') *code |= c - '0';
+        else if (c >= 'a' && c <= 'f') *code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') *code |= c - 'A' + 10;
+        else return false;
+    }
+    at_ += 4;
+    return true;
+}
+
+const char* ReadJsonString(const char* at, const char* end, std::string* out) {
+    if (at >= end || *at != '"') return nullptr;
+    JsonReader reader(at, end);
+    return reader.String(out) ? reader.Position() : nullptr;
+}
+
+bool FindJsonString(const char* at, const char* end, std::string_view key, std::string* out) {
+    std::string needle;
+    needle.reserve(key.size() + 3);
+    needle.push_back('"');
+    needle.append(key);
+    needle.append("\":");
+    const char* found = std::search(at, end, needle.begin(), needle.end());
+    if (found == end) return false;
+    found += needle.size();
+    while (found < end && *found == ' ') found++;
+    return ReadJsonString(found, end, out) != nullptr;
+}
@@ -0,0 +1,63 @@
+// json_reader.h - Minimal pull reader for controller JSON for Windows
+#ifndef JSON_READER_H_
+#define JSON_READER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Just enough of a JSON reader to walk controller responses without building
+// a document: strings are decoded, integers read, every other value skipped.
+// Callers drive it with Consume/Peek and stop at the first false.
+class JsonReader {
+public:
+    JsonReader(const char* at, const char* end) : at_(at), end_(end) {}
+
+    const char* Position() const { return at_; }
+
+    void SkipSpace() {
+        while (at_ < end_ && (*at_ == ' ' || *at_ == '\n' || *at_ == '\r' || *at_ == '\t')) at_++;
+    }
+
+    bool Consume(char c) {
+        SkipSpace();
+        if (at_ < end_ && *at_ == c) {
+            at_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool Peek(char c) {
+        SkipSpace();
+        return at_ < end_ && *at_ == c;
+    }
+
+    bool String(std::string* out);
+
+    // A fraction or exponent is dropped
+    bool Int(int64_t* out);
+
+    // Skips one value of any type, nested ones included
+    bool Skip();
+
+    // Keeps the string items of an array; a non-array value is skipped
+    bool StringArray(std::vector<std::string>* out);
+
+private:
+    bool Hex4(uint32_t* code);
+
+    const char* at_;
+    const char* end_;
+};
+
+// Reads the JSON string starting at the opening quote; returns the position
+// after the closing quote, or nullptr on malformed input
+const char* ReadJsonString(const char* at, const char* end, std::string* out);
+
+// Finds the first "key":"value" within [at, end) at any depth. Only for
+// flat objects such as one /connections entry or one /logs line.
+bool FindJsonString(const char* at, const char* end, std::string_view key, std::string* out);
+
+#endif  // JSON_READER_H_
@@ -2,11 +2,17 @@
 #include <flutter/flutter_view_controller.h>
 #include <windows.h>
 
+#include "core_job.h"
 #include "flutter_window.h"
 #include "utils.h"
 
 int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
                       _In_ wchar_t *command_line, _In_ int show_command) {
+  // Stand-in core for the containment self-check; never opens a window
+  if (wcsstr(command_line, CoreJob::kStubArgument)) {
+    return CoreJob::RunAllocatingStub();
+  }
+
   // Attach to console when present (e.g., 'flutter run') or create a
   // new console when running with a debugger.
   if (!::AttachConsole(ATTACH_PARENT_PROCESS) && ::IsDebuggerPresent()) {
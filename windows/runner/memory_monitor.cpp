@@ -0,0 +1,171 @@
+// memory_monitor.cpp - System memory pressure responder implementation
+#include "memory_monitor.h"
+#include "flight_recorder.h"
+#include "idle_budget.h"
+#include "mihomo_core.h"
+
+#include <psapi.h>
+
+namespace {
+
+// How often a persisting low-memory state is re-checked
+constexpr DWORD kRecheckMs = 5000;
+
+// Minimum spacing between two responses while memory stays low
+constexpr ULONGLONG kCooldownMs = 60000;
+
+int64_t CurrentWorkingSet() {
+    PROCESS_MEMORY_COUNTERS counters = {};
+    counters.cb = sizeof(counters);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return static_cast<int64_t>(counters.WorkingSetSize);
+}
+
+void FillSystemStatus(MemoryMonitor::Event* event) {
+    MEMORYSTATUSEX status = {};
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        event->memoryLoad = static_cast<int>(status.dwMemoryLoad);
+        event->availablePhysMb = static_cast<int64_t>(status.ullAvailPhys / (1024 * 1024));
+    }
+}
+
+}  // namespace
+
+MemoryMonitor& MemoryMonitor::GetInstance() {
+    static MemoryMonitor instance;
+    return instance;
+}
+
+MemoryMonitor::~MemoryMonitor() {
+    Stop();
+}
+
+bool MemoryMonitor::Start() {
+    if (running_) return true;
+
+    lowHandle_ = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+    if (!lowHandle_) return false;
+
+    stopEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!stopEvent_) {
+        CloseHandle(lowHandle_);
+        lowHandle_ = nullptr;
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+}
+
+void MemoryMonitor::Stop() {
+    if (!running_) return;
+
+    running_ = false;
+    SetEvent(stopEvent_);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    CloseHandle(stopEvent_);
+    CloseHandle(lowHandle_);
+    stopEvent_ = nullptr;
+    lowHandle_ = nullptr;
+}
+
+void MemoryMonitor::AddTrimHandler(const std::string& name, TrimHandler handler) {
+    std::lock_guard<std::mutex> lock(handlersMutex_);
+    handlers_.emplace_back(name, handler);
+}
+
+void MemoryMonitor::SetPressureCallback(PressureCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    callback_ = callback;
+}
+
+MemoryMonitor::Event MemoryMonitor::TrimNow() {
+    Event event = Respond("manual");
+    Notify(event);
+    return event;
+}
+
+void MemoryMonitor::Run() {
+    IdleBudget::TagThread("memory_monitor");
+    HANDLE handles[2] = {stopEvent_, lowHandle_};
+
+    while (running_) {
+        DWORD signaled = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        if (signaled != WAIT_OBJECT_0 + 1) break;
+
+        Notify(Respond("low"));
+        ULONGLONG lastResponse = GetTickCount64();
+
+        // The notification stays signaled until memory recovers
+        while (WaitForSingleObject(stopEvent_, kRecheckMs) == WAIT_TIMEOUT) {
+            BOOL low = FALSE;
+            if (!QueryMemoryResourceNotification(lowHandle_, &low)) break;
+
+            if (!low) {
+                Event event;
+                event.level = "normal";
+                FillSystemStatus(&event);
+                event.workingSetBefore = event.workingSetAfter = CurrentWorkingSet();
+                Notify(event);
+                break;
+            }
+
+            if (GetTickCount64() - lastResponse >= kCooldownMs) {
+                Notify(Respond("low"));
+                lastResponse = GetTickCount64();
+            }
+        }
+    }
+}
+
+MemoryMonitor::Event MemoryMonitor::Respond(const std::string& level) {
+    std::lock_guard<std::mutex> respondLock(respondMutex_);
+
+    Event event;
+    event.level = level;
+    event.workingSetBefore = CurrentWorkingSet();
+
+    std::vector<std::pair<std::string, TrimHandler>> handlers;
+    {
+        std::lock_guard<std::mutex> lock(handlersMutex_);
+        handlers = handlers_;
+    }
+    for (const auto& handler : handlers) {
+        if (handler.second) {
+            event.trimmedBytes += static_cast<int64_t>(handler.second());
+        }
+    }
+
+    // Ask the core to run GC and return its free heap before trimming our
+    // own pages, so both processes shrink in the same pass
+    MihomoCore& core = MihomoCore::GetInstance();
+    if (core.IsRunning()) {
+        event.coreGc = core.FreeMemory(&event.coreGcError);
+    }
+
+    SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1));
+    event.workingSetAfter = CurrentWorkingSet();
+    FillSystemStatus(&event);
+
+    FlightRecorder::Record(FlightRecorder::Category::Memory, FlightRecorder::Level::Warning,
+                           "trim " + level, event.workingSetBefore - event.workingSetAfter);
+    return event;
+}
+
+void MemoryMonitor::Notify(const Event& event) {
+    PressureCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        callback = callback_;
+    }
+    if (callback) {
+        callback(event);
+    }
+}
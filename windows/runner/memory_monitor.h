@@ -0,0 +1,75 @@
+// memory_monitor.h - System memory pressure responder for Windows
+#ifndef MEMORY_MONITOR_H_
+#define MEMORY_MONITOR_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Waits on the system low-memory notification and, when it fires, releases
+// what the runner can give back: registered native caches are trimmed, the
+// runner's working set is emptied and the core is asked to return freed heap
+// to the OS. The low-memory state is level triggered, so while it persists
+// the response is repeated at most once per cooldown period.
+class MemoryMonitor {
+public:
+    // Returns an estimate of the bytes released
+    using TrimHandler = std::function<size_t()>;
+
+    struct Event {
+        std::string level;             // "low", "normal" or "manual"
+        int memoryLoad = 0;            // Percent of physical memory in use
+        int64_t availablePhysMb = 0;
+        int64_t workingSetBefore = 0;  // Runner working set, bytes
+        int64_t workingSetAfter = 0;
+        int64_t trimmedBytes = 0;      // Sum reported by trim handlers
+        bool coreGc = false;           // Core accepted the GC request
+        std::string coreGcError;       // Why it did not, empty when not attempted
+    };
+
+    using PressureCallback = std::function<void(const Event& event)>;
+
+    static MemoryMonitor& GetInstance();
+
+    bool Start();
+    void Stop();
+
+    // Handlers run on the monitor thread and must be thread-safe
+    void AddTrimHandler(const std::string& name, TrimHandler handler);
+
+    // Run the response immediately regardless of system state
+    Event TrimNow();
+
+    void SetPressureCallback(PressureCallback callback);
+
+private:
+    MemoryMonitor() = default;
+    ~MemoryMonitor();
+    MemoryMonitor(const MemoryMonitor&) = delete;
+    MemoryMonitor& operator=(const MemoryMonitor&) = delete;
+
+    void Run();
+    Event Respond(const std::string& level);
+    void Notify(const Event& event);
+
+    HANDLE lowHandle_ = nullptr;
+    HANDLE stopEvent_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex handlersMutex_;
+    std::vector<std::pair<std::string, TrimHandler>> handlers_;
+
+    std::mutex callbackMutex_;
+    PressureCallback callback_;
+
+    std::mutex respondMutex_;
+};
+
+#endif  // MEMORY_MONITOR_H_
@@ -1,14 +1,134 @@
 // MihomoCore.cpp - Mihomo Core Manager Implementation for Windows
 #include "mihomo_core.h"
+#include "connection_stats.h"
+#include "controller_streams.h"
+#include "controller_trace.h"
+#include "flight_recorder.h"
+#include "json_reader.h"
+#include "path_warmer.h"
+#include "rule_compiler.h"
+#include "rule_stats.h"
+#include "tracer.h"
 
 #include <winhttp.h>
 #include <shlwapi.h>
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <regex>
 #include <chrono>
+#include <condition_variable>
 #include <iostream>
 
+namespace {
+
+// Supervised restarts: at most kMaxRestarts within kRestartWindowMs, each
+// delayed twice as long as the previous one
+constexpr size_t kMaxRestarts = 3;
+constexpr ULONGLONG kRestartWindowMs = 10 * 60 * 1000;
+constexpr int kRestartBaseDelayMs = 1000;
+
+// Counts an exit against the restart budget at now; false once the budget
+// is spent
+bool CountRestart(std::deque<ULONGLONG>* times, ULONGLONG now) {
+    while (!times->empty() && now - times->front() > kRestartWindowMs) {
+        times->pop_front();
+    }
+    if (times->size() >= kMaxRestarts) return false;
+    times->push_back(now);
+    return true;
+}
+
+// Memory limit of the containment check's job
+constexpr int64_t kStubLimitMb = 96;
+
+// One run of the allocating stub, as the job reported it
+struct StubRun {
+    bool started = false;
+    bool limitReported = false;
+    bool exitReported = false;
+    DWORD exitCode = STILL_ACTIVE;
+    int64_t peakBytes = 0;
+};
+
+StubRun RunStub(const std::wstring& exePath) {
+    StubRun run;
+    std::mutex mutex;
+    std::condition_variable changed;
+    DWORD processId = 0;
+
+    CoreJob job;
+    CoreJob::Limits limits;
+    limits.memoryMb = kStubLimitMb;
+    bool created = job.Create(limits, [&](const CoreJob::Event& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (event.processId != processId) return;
+        if (event.type == "memory_limit") {
+            run.limitReported = true;
+        } else {
+            run.exitReported = true;
+        }
+        run.peakBytes = std::max(run.peakBytes, event.peakBytes);
+        changed.notify_all();
+    });
+    if (!created) return run;
+
+    std::wstring cmdLine = L"\"" + exePath + L"\" " + CoreJob::kStubArgument;
+    STARTUPINFOW si = {0};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {0};
+    if (!CreateProcessW(nullptr, &cmdLine[0], nullptr, nullptr, FALSE,
+                        CREATE_NO_WINDOW | CREATE_SUSPENDED, nullptr, nullptr, &si, &pi)) {
+        return run;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        processId = pi.dwProcessId;
+    }
+    run.started = job.Assign(pi.hProcess);
+    if (run.started) {
+        ResumeThread(pi.hThread);
+        WaitForSingleObject(pi.hProcess, 10000);
+        GetExitCodeProcess(pi.hProcess, &run.exitCode);
+
+        // The exit notification trails the process handle
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, std::chrono::seconds(2), [&run]() { return run.exitReported; });
+    }
+
+    // Kills the stub if it is still running or was never assigned
+    job.Close();
+    TerminateProcess(pi.hProcess, 0);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    return run;
+}
+
+// Subscription name for the runner's own /traffic stream
+constexpr char kTrafficStream[] = "core.traffic";
+
+// Reads a non-negative integer field from a flat JSON object. Cheaper than
+// std::regex for messages that arrive every second.
+bool ReadJsonInt(const char* data, size_t size, const char* key, int64_t* value) {
+    std::string needle = std::string("\"") + key + "\"";
+    const char* end = data + size;
+    const char* at = std::search(data, end, needle.begin(), needle.end());
+    if (at == end) return false;
+    at += needle.size();
+    while (at < end && (*at == ' ' || *at == ':')) at++;
+    if (at == end || *at < '0' || *at > '9') return false;
+    int64_t result = 0;
+    while (at < end && *at >= '0' && *at <= '9') {
+        result = result * 10 + (*at - '0');
+        at++;
+    }
+    *value = result;
+    return true;
+}
+
+}  // namespace
+
 #pragma comment(lib, "winhttp.lib")
 #pragma comment(lib, "shlwapi.lib")
 
@@ -17,19 +137,74 @@ MihomoCore& MihomoCore::GetInstance() {
     return instance;
 }
 
+MihomoCore::CheckReport MihomoCore::CheckContainment() {
+    CheckReport report;
+    auto started = std::chrono::steady_clock::now();
+
+    wchar_t exePath[MAX_PATH];
+    DWORD length = GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) {
+        report.error = "runner path unavailable";
+        return report;
+    }
+
+    auto check = [&](const std::string& name, bool passed, const std::string& detail) {
+        report.checks.push_back({name, passed, detail});
+    };
+    auto megabytes = [](int64_t bytes) { return std::to_string(bytes / (1024 * 1024)) + " MB"; };
+
+    // Every run of the stub stands for one crash of the core, counted the
+    // way OnCoreExit counts it; one run more than the budget allows
+    std::deque<ULONGLONG> restarts;
+    ULONGLONG now = GetTickCount64();
+    std::string counted;
+    bool gaveUp = false;
+    for (size_t attempt = 0; attempt <= kMaxRestarts && !gaveUp; attempt++) {
+        StubRun run = RunStub(exePath);
+        if (attempt == 0) {
+            check("stub runs in the job", run.started, "");
+            check("memory limit reported",
+                  run.limitReported && run.peakBytes <= kStubLimitMb * 1024 * 1024,
+                  "peak " + megabytes(run.peakBytes) + " of " + std::to_string(kStubLimitMb) + " MB");
+            check("limit stops the stub",
+                  run.exitReported && run.exitCode == static_cast<DWORD>(CoreJob::kStubOutOfMemory),
+                  "exit code " + std::to_string(run.exitCode));
+        }
+        if (!run.exitReported) break;
+
+        if (CountRestart(&restarts, now)) {
+            counted += (counted.empty() ? "" : ",") + std::to_string(restarts.size());
+        } else {
+            gaveUp = true;
+        }
+    }
+    check("budget counts each exit", gaveUp && restarts.size() == kMaxRestarts,
+          "attempts " + counted + (gaveUp ? ", then gave up" : ""));
+    check("budget refills after the window", CountRestart(&restarts, now + kRestartWindowMs + 1),
+          std::to_string(kRestartWindowMs / 60000) + " min window");
+
+    report.passed = std::all_of(report.checks.begin(), report.checks.end(),
+                                [](const Check& item) { return item.passed; });
+    report.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return report;
+}
+
 MihomoCore::MihomoCore()
     : controllerHost_("127.0.0.1"),
       controllerPort_(9090),
+      proxyPort_(0),
       processHandle_(nullptr),
       processThread_(nullptr),
       processId_(0),
       isRunning_(false),
       stopMonitoring_(false),
       isStarting_(false),
-      lastUpload_(0),
-      lastDownload_(0),
-      lastTime_(0),
-      state_("disconnected") {}
+      lastTraffic_{0, 0, 0, 0},
+      state_("disconnected"),
+      generation_(0),
+      exitHandled_(0),
+      memoryLimitHit_(false) {}
 
 MihomoCore::~MihomoCore() {
     Stop();
@@ -43,6 +218,7 @@ bool MihomoCore::Init(const std::string& workDir) {
 
     // Core binary path in work directory
     corePath_ = workDir + "\\mihomo.exe";
+    RuleCompiler::GetInstance().Init(workDir, corePath_);
 
     // Check if core exists in work directory
     if (GetFileAttributesA(corePath_.c_str()) == INVALID_FILE_ATTRIBUTES) {
@@ -88,6 +264,7 @@ bool MihomoCore::Init(const std::string& workDir) {
 
 bool MihomoCore::Start(const std::string& configPath) {
     // Synchronous start - calls internal implementation directly
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
     return StartInternal(configPath);
 }
 
@@ -99,10 +276,7 @@ void MihomoCore::StartAsync(const std::string& configPath, StartCallback callbac
     }
 
     isStarting_ = true;
-    state_ = "connecting";
-    if (stateCallback_) {
-        stateCallback_(state_);
-    }
+    SetState("connecting");
 
     // Detach any previous start thread
     if (startThread_.joinable()) {
@@ -110,8 +284,14 @@ void MihomoCore::StartAsync(const std::string& configPath, StartCallback callbac
     }
 
     // Launch background thread for startup
-    startThread_ = std::thread([this, configPath, callback]() {
-        bool success = StartInternal(configPath);
+    Tracer::Context trace = Tracer::Current();
+    startThread_ = std::thread([this, configPath, callback, trace]() {
+        Tracer::Adopt adopt(trace);
+        bool success;
+        {
+            std::lock_guard<std::mutex> lock(lifecycleMutex_);
+            success = StartInternal(configPath);
+        }
         isStarting_ = false;
 
         // Invoke callback on completion
@@ -129,11 +309,17 @@ bool MihomoCore::StartInternal(const std::string& configPath) {
         return true;
     }
 
+    Tracer::Span span("core", "start");
     configPath_ = configPath;
     ParseControllerSettings(configPath);
 
     // Build command line
-    std::string cmdLine = "\"" + corePath_ + "\" -d \"" + workDir_ + "\" -f \"" + configPath + "\"";
+    std::string runPath;
+    {
+        Tracer::Span prepare("core", "prepare config");
+        runPath = PrepareConfig(configPath);
+    }
+    std::string cmdLine = "\"" + corePath_ + "\" -d \"" + workDir_ + "\" -f \"" + runPath + "\"";
 
     STARTUPINFOA si = {0};
     si.cb = sizeof(si);
@@ -142,25 +328,30 @@ bool MihomoCore::StartInternal(const std::string& configPath) {
 
     PROCESS_INFORMATION pi = {0};
 
-    // Create process
+    // Contain the core in a Job Object; without one it still runs, just
+    // without limits or supervision
+    bool contained = job_.Create(GetResourceLimits(), [this](const CoreJob::Event& event) {
+        OnJobEvent(event);
+    });
+    memoryLimitHit_ = false;
+
+    // Create process (suspended when contained, so it never runs outside the job)
     if (!CreateProcessA(
             nullptr,
             const_cast<char*>(cmdLine.c_str()),
             nullptr,
             nullptr,
             FALSE,
-            CREATE_NO_WINDOW,
+            CREATE_NO_WINDOW | (contained ? CREATE_SUSPENDED : 0),
             nullptr,
             workDir_.c_str(),
             &si,
             &pi)) {
+        job_.Close();
         if (errorCallback_) {
             errorCallback_("Failed to start core process");
         }
-        state_ = "error";
-        if (stateCallback_) {
-            stateCallback_(state_);
-        }
+        SetState("error");
         return false;
     }
 
@@ -168,8 +359,21 @@ bool MihomoCore::StartInternal(const std::string& configPath) {
     processThread_ = pi.hThread;
     processId_ = pi.dwProcessId;
 
+    if (contained) {
+        if (!job_.Assign(processHandle_)) {
+            job_.Close();
+            if (logCallback_) {
+                logCallback_("Failed to assign core to job object, running without limits");
+            }
+        }
+        ResumeThread(processThread_);
+    }
+
     // Wait for core to start (this is now in background thread, won't block UI)
-    Sleep(500);
+    {
+        Tracer::Span wait("core", "wait for process");
+        Sleep(500);
+    }
 
     // Check if process is still running
     DWORD exitCode;
@@ -177,42 +381,66 @@ bool MihomoCore::StartInternal(const std::string& configPath) {
         if (errorCallback_) {
             errorCallback_("Core process exited immediately");
         }
+        job_.Close();
         CloseHandle(processHandle_);
         CloseHandle(processThread_);
         processHandle_ = nullptr;
         processThread_ = nullptr;
-        state_ = "error";
-        if (stateCallback_) {
-            stateCallback_(state_);
-        }
+        SetState("error");
         return false;
     }
 
+    generation_++;
     isRunning_ = true;
-    state_ = "connected";
     stopMonitoring_ = false;
-
-    if (stateCallback_) {
-        stateCallback_(state_);
-    }
+    SetState("connected");
 
     // Start monitoring
     StartTrafficMonitor();
 
+    // Set up the path to the selected node before the first real request;
+    // without a local port there is nothing to warm through
+    int proxyPort = proxyPort_;
+    if (proxyPort > 0) {
+        PathWarmer::GetInstance().Warm("connect", "", proxyPort);
+    }
+
     return true;
 }
 
 bool MihomoCore::Stop() {
+    // Checked under the lock: a start or supervised restart in progress
+    // finishes first and is then stopped, instead of coming up afterwards
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
     if (!isRunning_) {
         return true;
     }
 
-    state_ = "disconnecting";
+    SetState("disconnecting");
+
+    StopMonitoring();
+    TeardownProcess();
+    restartTimes_.clear();
+
+    isRunning_ = false;
+    SetState("disconnected");
+
+    return true;
+}
+
+void MihomoCore::SetState(const std::string& state) {
+    state_ = state;
+    FlightRecorder::Record(FlightRecorder::Category::State,
+                           state == "error" ? FlightRecorder::Level::Error : FlightRecorder::Level::Info,
+                           state);
     if (stateCallback_) {
         stateCallback_(state_);
     }
+}
 
-    StopMonitoring();
+void MihomoCore::TeardownProcess() {
+    // Close the job first so the exit it would report is never taken for a crash
+    job_.Close();
 
     // Terminate process
     if (processHandle_) {
@@ -228,18 +456,137 @@ bool MihomoCore::Stop() {
     }
 
     processId_ = 0;
+}
+
+void MihomoCore::OnJobEvent(const CoreJob::Event& event) {
+    // Runs on the job notification thread. Stop joins that thread while
+    // holding lifecycleMutex_, so everything needing the lock moves to its
+    // own thread.
+    SupervisorEvent report;
+    report.limitBytes = event.limitBytes;
+    report.peakBytes = event.peakBytes;
+
+    FlightRecorder::Record(FlightRecorder::Category::Supervisor,
+                           event.type == "exit" ? FlightRecorder::Level::Info : FlightRecorder::Level::Warning,
+                           "job " + event.type, event.peakBytes);
+
+    if (event.type == "memory_limit") {
+        memoryLimitHit_ = true;
+        report.type = "memory_limit";
+        if (supervisorCallback_) {
+            supervisorCallback_(report);
+        }
+        return;
+    }
+
+    // Exits during start or stop are not crashes
+    if (!isRunning_) {
+        return;
+    }
+
+    uint64_t generation = generation_;
+    std::thread([this, generation, event]() {
+        OnCoreExit(generation, event);
+    }).detach();
+}
+
+void MihomoCore::OnCoreExit(uint64_t generation, const CoreJob::Event& event) {
+    std::unique_lock<std::mutex> lock(lifecycleMutex_);
+    // A user stop or a restart got here first, another process exited, or
+    // this exit was already counted (a crash reports exit and abnormal_exit)
+    if (!isRunning_ || generation_ != generation || processId_ != event.processId ||
+        exitHandled_ == generation) {
+        return;
+    }
+    exitHandled_ = generation;
+
+    SupervisorEvent report;
+    report.limitBytes = event.limitBytes;
+    report.peakBytes = event.peakBytes;
+    DWORD exitCode = 0;
+    GetExitCodeProcess(processHandle_, &exitCode);
+    report.type = "exited";
+    report.exitCode = static_cast<int>(exitCode);
+    FlightRecorder::Record(FlightRecorder::Category::Supervisor, FlightRecorder::Level::Error,
+                           "core exited", exitCode);
+    if (supervisorCallback_) {
+        supervisorCallback_(report);
+    }
+    if (logCallback_) {
+        logCallback_(std::string("Core exited unexpectedly") +
+                     (memoryLimitHit_ ? " after hitting its memory limit" : "") +
+                     ", code " + std::to_string(exitCode));
+    }
+
+    if (!CountRestart(&restartTimes_, GetTickCount64())) {
+        report.type = "gave_up";
+        FlightRecorder::Record(FlightRecorder::Category::Supervisor, FlightRecorder::Level::Error,
+                               "restart budget exhausted");
+        report.attempt = static_cast<int>(restartTimes_.size());
+        if (supervisorCallback_) {
+            supervisorCallback_(report);
+        }
+
+        StopMonitoring();
+        TeardownProcess();
+        isRunning_ = false;
+        SetState("error");
+        if (errorCallback_) {
+            errorCallback_("Core keeps exiting, automatic restart stopped");
+        }
+        return;
+    }
+
+    report.type = "restarting";
+    report.attempt = static_cast<int>(restartTimes_.size());
+    report.delayMs = kRestartBaseDelayMs << (report.attempt - 1);
+    FlightRecorder::Record(FlightRecorder::Category::Supervisor, FlightRecorder::Level::Warning,
+                           "restarting core", report.attempt);
+    if (supervisorCallback_) {
+        supervisorCallback_(report);
+    }
+
+    // The delay runs unlocked so a user stop is not held up by it
+    lock.unlock();
+    RestartAfterExit(generation, report.delayMs);
+}
+
+void MihomoCore::RestartAfterExit(uint64_t generation, int delayMs) {
+    Sleep(static_cast<DWORD>(delayMs));
+
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    // A user stop or another start got here first
+    if (!isRunning_ || generation_ != generation || isStarting_) return;
+
+    isStarting_ = true;
+    StopMonitoring();
+    TeardownProcess();
     isRunning_ = false;
-    state_ = "disconnected";
 
-    if (stateCallback_) {
-        stateCallback_(state_);
+    SetState("connecting");
+
+    StartInternal(configPath_);
+    isStarting_ = false;
+}
+
+bool MihomoCore::SetResourceLimits(const CoreJob::Limits& limits) {
+    {
+        std::lock_guard<std::mutex> lock(limitsMutex_);
+        limits_ = limits;
     }
+    // A start or stop in progress is creating or closing the job; a start
+    // reads limits_ when it creates the next one
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    return !job_.IsActive() || job_.Update(limits);
+}
 
-    return true;
+CoreJob::Limits MihomoCore::GetResourceLimits() {
+    std::lock_guard<std::mutex> lock(limitsMutex_);
+    return limits_;
 }
 
 bool MihomoCore::ReloadConfig(const std::string& configPath) {
-    std::string body = "{\"path\":\"" + configPath + "\"}";
+    std::string body = "{\"path\":\"" + PrepareConfig(configPath) + "\"}";
     std::string response = HttpPut("/configs?force=true", body);
     if (!response.empty()) {
         configPath_ = configPath;
@@ -275,24 +622,9 @@ std::string MihomoCore::GetVersion() {
 }
 
 MihomoCore::TrafficStats MihomoCore::GetTrafficStats() {
-    TrafficStats stats = {0, 0, 0, 0};
-
-    std::string response = HttpGet("/traffic");
-    if (!response.empty()) {
-        // Parse JSON
-        std::regex upRegex("\"up\"\\s*:\\s*(\\d+)");
-        std::regex downRegex("\"down\"\\s*:\\s*(\\d+)");
-        std::smatch match;
-
-        if (std::regex_search(response, match, upRegex)) {
-            stats.upload = std::stoll(match[1].str());
-        }
-        if (std::regex_search(response, match, downRegex)) {
-            stats.download = std::stoll(match[1].str());
-        }
-    }
-
-    return stats;
+    // /traffic is a stream, a plain GET would never complete
+    std::lock_guard<std::mutex> lock(trafficMutex_);
+    return lastTraffic_;
 }
 
 int MihomoCore::TestDelay(const std::string& proxy, const std::string& url, int timeout) {
@@ -312,13 +644,47 @@ int MihomoCore::TestDelay(const std::string& proxy, const std::string& url, int
 bool MihomoCore::SwitchProxy(const std::string& selector, const std::string& proxy) {
     std::string body = "{\"name\":\"" + proxy + "\"}";
     std::string response = HttpPut("/proxies/" + selector, body);
-    return !response.empty();
+    if (response.empty()) return false;
+
+    PathWarmer::GetInstance().Warm("switch", proxy, proxyPort_);
+    return true;
 }
 
 std::string MihomoCore::GetConnections() {
     return HttpGet("/connections");
 }
 
+std::string MihomoCore::GetProxies() {
+    return HttpGet("/proxies");
+}
+
+std::string MihomoCore::QueryDns(const std::string& name, const std::string& type) {
+    DWORD statusCode = 0;
+    std::string body = ControllerRequest(L"GET", "/dns/query?name=" + name + "&type=" + type, "", &statusCode);
+    return statusCode == 200 ? body : "";
+}
+
+bool MihomoCore::FreeMemory(std::string* error) {
+    // mihomo only mounts /debug while its log level is debug; any other level
+    // answers 404, so check first rather than report a GC that never ran
+    std::string config = HttpGet("/configs");
+    std::string level;
+    if (!FindJsonString(config.data(), config.data() + config.size(), "log-level", &level)) {
+        if (error) *error = "controller unreachable";
+        return false;
+    }
+    if (level != "debug") {
+        if (error) *error = "needs log-level debug (core is at " + level + ")";
+        return false;
+    }
+
+    DWORD statusCode = 0;
+    ControllerRequest(L"PUT", "/debug/gc", "", &statusCode);
+    if (statusCode >= 200 && statusCode < 300) return true;
+    if (error) *error = statusCode == 0 ? "controller unreachable" : "HTTP " + std::to_string(statusCode);
+    return false;
+}
+
 std::string MihomoCore::GetLogs() {
     std::string logPath = workDir_ + "\\logs\\mihomo.log";
     std::ifstream file(logPath);
@@ -332,6 +698,8 @@ std::string MihomoCore::GetLogs() {
 
 std::string MihomoCore::ExportLogs() {
     std::string logs = GetLogs();
+    logs += "\n\n===== Flight recorder =====\n";
+    logs += FlightRecorder::GetInstance().Decode();
     auto now = std::chrono::system_clock::now();
     auto time = std::chrono::system_clock::to_time_t(now);
 
@@ -361,7 +729,14 @@ void MihomoCore::SetErrorCallback(ErrorCallback callback) {
     errorCallback_ = callback;
 }
 
+void MihomoCore::SetSupervisorCallback(SupervisorCallback callback) {
+    supervisorCallback_ = callback;
+}
+
 void MihomoCore::ParseControllerSettings(const std::string& configPath) {
+    // A config without a port must not inherit the previous config's
+    proxyPort_ = 0;
+
     std::ifstream file(configPath);
     if (!file.is_open()) return;
 
@@ -384,83 +759,207 @@ void MihomoCore::ParseControllerSettings(const std::string& configPath) {
     if (std::regex_search(content, match, secretRegex)) {
         controllerSecret_ = match[1].str();
     }
+
+    // Parse the local proxy port used for path warmup
+    std::regex mixedPortRegex("(^|\n)mixed-port:\\s*['\"]?(\\d+)");
+    std::regex portRegex("(^|\n)port:\\s*['\"]?(\\d+)");
+    if (std::regex_search(content, match, mixedPortRegex) ||
+        std::regex_search(content, match, portRegex)) {
+        proxyPort_ = std::stoi(match[2].str());
+    }
+
+    ControllerStreams::GetInstance().SetEndpoint(controllerHost_, controllerPort_, controllerSecret_);
 }
 
-void MihomoCore::StartTrafficMonitor() {
-    trafficThread_ = std::thread([this]() {
-        while (!stopMonitoring_) {
-            if (isRunning_ && trafficCallback_) {
-                TrafficStats stats = GetTrafficStats();
+std::string MihomoCore::PrepareConfig(const std::string& configPath) {
+    std::ifstream file(configPath, std::ios::binary);
+    if (!file.is_open()) return configPath;
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+    file.close();
 
-                ULONGLONG now = GetTickCount64();
-                double timeDelta = (now - lastTime_) / 1000.0;
+    RuleStats::Report order;
+    bool reordered = RuleStats::GetInstance().OptimizeConfig(&content, &order);
 
-                if (lastTime_ > 0 && timeDelta > 0) {
-                    stats.uploadSpeed = static_cast<int64_t>((stats.upload - lastUpload_) / timeDelta);
-                    stats.downloadSpeed = static_cast<int64_t>((stats.download - lastDownload_) / timeDelta);
+    // Long inline lists become rule sets the core loads without YAML parsing;
+    // a stand-in core gets them inline
+    RuleCompiler::Report compiled;
+    bool standIn = corePath_ != workDir_ + "\\mihomo.exe";
+    bool extracted = !standIn && RuleCompiler::GetInstance().CompileConfig(&content, &compiled);
 
-                    trafficCallback_(stats);
-                }
+    if (!reordered && !extracted) {
+        return configPath;
+    }
+
+    // The user's file is left as written; the core runs a rewritten copy
+    std::string runPath = workDir_ + "\\config.run.yaml";
+    std::ofstream out(runPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return configPath;
+    out << content;
+    out.close();
+    if (!out) return configPath;
+
+    if (logCallback_) {
+        if (reordered) {
+            char depth[64];
+            snprintf(depth, sizeof(depth), "%.2f -> %.2f", order.depthBefore, order.depthAfter);
+            logCallback_("Rule order optimized: moved " + std::to_string(order.moved) +
+                         " rules, mean depth " + depth);
+        }
+        if (extracted) {
+            logCallback_("Rule sets compiled: " + std::to_string(compiled.extracted) + " rules into " +
+                         std::to_string(compiled.providers) + " sets (" +
+                         std::to_string(compiled.reused) + " cached, " +
+                         (compiled.binary ? "mrs" : "text") + ") in " +
+                         std::to_string(compiled.elapsedMs) + " ms");
+        }
+    }
+    return runPath;
+}
+
+void MihomoCore::StartTrafficMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(trafficMutex_);
+        lastTraffic_ = {0, 0, 0, 0};
+    }
 
-                lastUpload_ = stats.upload;
-                lastDownload_ = stats.download;
-                lastTime_ = now;
+    // Streams left waiting while the core was down retry right away
+    ControllerStreams::GetInstance().Reconnect();
+
+    // The core pushes one sample per second; keep only the newest
+    ControllerStreams::StreamOptions options;
+    options.path = "/traffic";
+    options.mode = ControllerStreams::Mode::Latest;
+    ControllerStreams::GetInstance().Subscribe(kTrafficStream, options,
+        [this](const ControllerStreams::Batch& batch) {
+            for (const auto& message : batch.messages) {
+                OnTrafficMessage(message.data(), message.size());
             }
+        });
 
-            Sleep(1000);
-        }
-    });
+    RuleStats::GetInstance().Start();
+    ConnectionStats::GetInstance().Start();
+}
+
+void MihomoCore::OnTrafficMessage(const char* data, size_t size) {
+    TrafficStats stats;
+    {
+        std::lock_guard<std::mutex> lock(trafficMutex_);
+        int64_t up = 0;
+        int64_t down = 0;
+        ReadJsonInt(data, size, "up", &up);
+        ReadJsonInt(data, size, "down", &down);
+        lastTraffic_.uploadSpeed = up;
+        lastTraffic_.downloadSpeed = down;
+
+        // Newer cores report totals; otherwise sum the per-second rates
+        int64_t total = 0;
+        lastTraffic_.upload = ReadJsonInt(data, size, "upTotal", &total) ? total : lastTraffic_.upload + up;
+        lastTraffic_.download = ReadJsonInt(data, size, "downTotal", &total) ? total : lastTraffic_.download + down;
+        stats = lastTraffic_;
+    }
+
+    if (isRunning_ && trafficCallback_) {
+        trafficCallback_(stats);
+    }
 }
 
 void MihomoCore::StopMonitoring() {
     stopMonitoring_ = true;
 
-    if (trafficThread_.joinable()) {
-        trafficThread_.join();
-    }
+    ControllerStreams::GetInstance().Unsubscribe(kTrafficStream);
+    RuleStats::GetInstance().Stop();
+    ConnectionStats::GetInstance().Stop();
+    PathWarmer::GetInstance().Cancel();
     if (logThread_.joinable()) {
         logThread_.join();
     }
 }
 
 std::string MihomoCore::HttpGet(const std::string& path) {
+    return ControllerRequest(L"GET", path, "", nullptr);
+}
+
+std::string MihomoCore::HttpPut(const std::string& path, const std::string& body) {
+    DWORD statusCode = 0;
+    ControllerRequest(L"PUT", path, body, &statusCode);
+    return statusCode >= 200 && statusCode < 300 ? "success" : "";
+}
+
+std::string MihomoCore::ControllerRequest(const wchar_t* verb, const std::string& path,
+                                          const std::string& body, DWORD* statusCode) {
     HINTERNET hSession = nullptr;
     HINTERNET hConnect = nullptr;
     HINTERNET hRequest = nullptr;
     std::string result;
+    const char* failedStep = nullptr;
 
-    try {
-        hSession = WinHttpOpen(L"Vortex/1.0",
-            WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-            WINHTTP_NO_PROXY_NAME,
-            WINHTTP_NO_PROXY_BYPASS, 0);
+    if (statusCode) *statusCode = 0;
+    Tracer::Span span("controller", std::string(verb, verb + wcslen(verb)) + " " + path);
+    auto started = std::chrono::steady_clock::now();
+    DWORD status = 0;
 
-        if (!hSession) throw std::runtime_error("WinHttpOpen failed");
+    hSession = WinHttpOpen(L"Vortex/1.0",
+        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+        WINHTTP_NO_PROXY_NAME,
+        WINHTTP_NO_PROXY_BYPASS, 0);
 
+    if (!hSession) {
+        failedStep = "open";
+    }
+
+    if (!failedStep) {
         std::wstring wHost(controllerHost_.begin(), controllerHost_.end());
         hConnect = WinHttpConnect(hSession, wHost.c_str(), static_cast<INTERNET_PORT>(controllerPort_), 0);
-        if (!hConnect) throw std::runtime_error("WinHttpConnect failed");
+        if (!hConnect) failedStep = "connect";
+    }
 
+    if (!failedStep) {
         std::wstring wPath(path.begin(), path.end());
-        hRequest = WinHttpOpenRequest(hConnect, L"GET", wPath.c_str(),
+        hRequest = WinHttpOpenRequest(hConnect, verb, wPath.c_str(),
             nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
-        if (!hRequest) throw std::runtime_error("WinHttpOpenRequest failed");
+        if (!hRequest) failedStep = "open request";
+    }
 
-        // Add authorization header if secret is set
+    if (!failedStep) {
+        // Add headers
+        std::wstring headers;
+        if (!body.empty()) {
+            headers += L"Content-Type: application/json\r\n";
+        }
         if (!controllerSecret_.empty()) {
-            std::wstring authHeader = L"Authorization: Bearer " +
-                std::wstring(controllerSecret_.begin(), controllerSecret_.end());
-            WinHttpAddRequestHeaders(hRequest, authHeader.c_str(), static_cast<DWORD>(-1),
-                WINHTTP_ADDREQ_FLAG_ADD);
+            headers += L"Authorization: Bearer " +
+                std::wstring(controllerSecret_.begin(), controllerSecret_.end()) + L"\r\n";
+        }
+        if (span.context()) {
+            std::string trace = Tracer::Header(span.context());
+            headers += L"X-Vortex-Trace: " + std::wstring(trace.begin(), trace.end()) + L"\r\n";
+        }
+        if (!headers.empty()) {
+            WinHttpAddRequestHeaders(hRequest, headers.c_str(), static_cast<DWORD>(-1), WINHTTP_ADDREQ_FLAG_ADD);
         }
 
+        DWORD length = static_cast<DWORD>(body.length());
         if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-            WINHTTP_NO_REQUEST_DATA, 0, 0, 0)) {
-            throw std::runtime_error("WinHttpSendRequest failed");
+                length ? const_cast<char*>(body.c_str()) : WINHTTP_NO_REQUEST_DATA, length, length, 0)) {
+            failedStep = "send";
+        } else if (!WinHttpReceiveResponse(hRequest, nullptr)) {
+            failedStep = "receive";
         }
+    }
+
+    DWORD errorCode = failedStep ? GetLastError() : 0;
 
-        if (!WinHttpReceiveResponse(hRequest, nullptr)) {
-            throw std::runtime_error("WinHttpReceiveResponse failed");
+    if (!failedStep) {
+        DWORD statusSize = sizeof(status);
+        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+            WINHTTP_HEADER_NAME_BY_INDEX, &status, &statusSize, WINHTTP_NO_HEADER_INDEX);
+        if (statusCode) *statusCode = status;
+        if (status >= 400) {
+            FlightRecorder::Record(FlightRecorder::Category::Controller, FlightRecorder::Level::Warning,
+                                   "HTTP " + std::to_string(status) + " " + path, status);
         }
 
         DWORD size = 0;
@@ -474,75 +973,16 @@ std::string MihomoCore::HttpGet(const std::string& path) {
                 result.append(buffer.data(), downloaded);
             }
         } while (size > 0);
-
-    } catch (...) {
-        // Ignore errors
-    }
-
-    if (hRequest) WinHttpCloseHandle(hRequest);
-    if (hConnect) WinHttpCloseHandle(hConnect);
-    if (hSession) WinHttpCloseHandle(hSession);
-
-    return result;
-}
-
-std::string MihomoCore::HttpPut(const std::string& path, const std::string& body) {
-    HINTERNET hSession = nullptr;
-    HINTERNET hConnect = nullptr;
-    HINTERNET hRequest = nullptr;
-    std::string result;
-
-    try {
-        hSession = WinHttpOpen(L"Vortex/1.0",
-            WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-            WINHTTP_NO_PROXY_NAME,
-            WINHTTP_NO_PROXY_BYPASS, 0);
-
-        if (!hSession) throw std::runtime_error("WinHttpOpen failed");
-
-        std::wstring wHost(controllerHost_.begin(), controllerHost_.end());
-        hConnect = WinHttpConnect(hSession, wHost.c_str(), static_cast<INTERNET_PORT>(controllerPort_), 0);
-        if (!hConnect) throw std::runtime_error("WinHttpConnect failed");
-
-        std::wstring wPath(path.begin(), path.end());
-        hRequest = WinHttpOpenRequest(hConnect, L"PUT", wPath.c_str(),
-            nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
-        if (!hRequest) throw std::runtime_error("WinHttpOpenRequest failed");
-
-        // Add headers
-        std::wstring headers = L"Content-Type: application/json\r\n";
-        if (!controllerSecret_.empty()) {
-            headers += L"Authorization: Bearer " +
-                std::wstring(controllerSecret_.begin(), controllerSecret_.end()) + L"\r\n";
-        }
-        WinHttpAddRequestHeaders(hRequest, headers.c_str(), static_cast<DWORD>(-1), WINHTTP_ADDREQ_FLAG_ADD);
-
-        if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-            (LPVOID)body.c_str(), static_cast<DWORD>(body.length()), static_cast<DWORD>(body.length()), 0)) {
-            throw std::runtime_error("WinHttpSendRequest failed");
-        }
-
-        if (!WinHttpReceiveResponse(hRequest, nullptr)) {
-            throw std::runtime_error("WinHttpReceiveResponse failed");
-        }
-
-        // Check status code
-        DWORD statusCode = 0;
-        DWORD size = sizeof(statusCode);
-        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-            WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &size, WINHTTP_NO_HEADER_INDEX);
-
-        if (statusCode >= 200 && statusCode < 300) {
-            result = "success";
-        }
-
-    } catch (...) {
-        // Ignore errors
+    } else {
+        FlightRecorder::Record(FlightRecorder::Category::Controller, FlightRecorder::Level::Error,
+                               std::string(failedStep) + " " + path, errorCode);
     }
 
     if (hRequest) WinHttpCloseHandle(hRequest);
     if (hConnect) WinHttpCloseHandle(hConnect);
     if (hSession) WinHttpCloseHandle(hSession);
 
+    ControllerTrace::RecordRequest(verb, path, static_cast<int>(status), body, result,
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
     return result;
 }
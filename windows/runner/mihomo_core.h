@@ -2,12 +2,17 @@
 #ifndef MIHOMO_CORE_H_
 #define MIHOMO_CORE_H_
 
+#include "core_job.h"
+
 #include <windows.h>
 #include <string>
 #include <functional>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
 
 class MihomoCore {
 public:
@@ -24,8 +29,39 @@ public:
     using ErrorCallback = std::function<void(const std::string&)>;
     using StartCallback = std::function<void(bool success)>;
 
+    struct SupervisorEvent {
+        std::string type;  // "memory_limit", "exited", "restarting" or "gave_up"
+        int64_t limitBytes = 0;
+        int64_t peakBytes = 0;
+        int exitCode = 0;
+        int attempt = 0;   // Restarts within the current window
+        int delayMs = 0;   // Until the next restart attempt
+    };
+
+    using SupervisorCallback = std::function<void(const SupervisorEvent&)>;
+
+    struct Check {
+        std::string name;
+        bool passed = false;
+        std::string detail;
+    };
+
+    struct CheckReport {
+        std::vector<Check> checks;
+        bool passed = false;
+        int64_t elapsedMs = 0;
+        std::string error;
+    };
+
     static MihomoCore& GetInstance();
 
+    // Runs the runner's allocating stub in a private job with a small memory
+    // limit, once per restart the budget allows and once more, and checks
+    // that the limit is reported and stops the stub and that the budget
+    // counts each of those exits and then gives up. Leaves the running core
+    // and its budget alone.
+    static CheckReport CheckContainment();
+
     // Initialize core
     bool Init(const std::string& workDir);
 
@@ -60,6 +96,27 @@ public:
     // Get connections
     std::string GetConnections();
 
+    // Get proxies and groups as reported by /proxies
+    std::string GetProxies();
+
+    // Resolve through the core's DNS resolver (/dns/query). name must be
+    // URL-safe. Returns the JSON answer, empty on failure.
+    std::string QueryDns(const std::string& name, const std::string& type);
+
+    std::string GetConfigPath() const { return configPath_; }
+
+    // Core binary launched by the next start; the soak test swaps in a stand-in.
+    // Any other binary than the work directory's mihomo.exe runs its config
+    // without compiled rule sets: RuleCompiler converts with the real core,
+    // and a replayed controller never loads them.
+    std::string GetCorePath() const { return corePath_; }
+    void SetCorePath(const std::string& path) { corePath_ = path; }
+
+    // Ask the core to run GC and return free memory to the OS. The core only
+    // serves /debug/gc at log-level debug; otherwise this fails without
+    // trying and error says why.
+    bool FreeMemory(std::string* error = nullptr);
+
     // Get logs
     std::string GetLogs();
 
@@ -71,9 +128,18 @@ public:
     void SetTrafficCallback(TrafficCallback callback);
     void SetLogCallback(LogCallback callback);
     void SetErrorCallback(ErrorCallback callback);
+    void SetSupervisorCallback(SupervisorCallback callback);
+
+    // Resource limits for the core's Job Object. Applied immediately to a
+    // running core and to every later start. Waits for a start or stop in
+    // progress, so call it off the platform thread.
+    bool SetResourceLimits(const CoreJob::Limits& limits);
+    CoreJob::Limits GetResourceLimits();
 
     // Get current state
     std::string GetState() const { return state_; }
+    int GetProxyPort() const { return proxyPort_; }
+    DWORD GetCoreProcessId() const { return processId_; }
 
 private:
     MihomoCore();
@@ -82,12 +148,21 @@ private:
     MihomoCore& operator=(const MihomoCore&) = delete;
 
     void ParseControllerSettings(const std::string& configPath);
+    std::string PrepareConfig(const std::string& configPath);  // Path the core should load
     void StartLogReader();
     void StartTrafficMonitor();
+    void OnTrafficMessage(const char* data, size_t size);
     void StopMonitoring();
     bool StartInternal(const std::string& configPath);  // Internal start logic
+    void SetState(const std::string& state);
+    void TeardownProcess();
+    void OnJobEvent(const CoreJob::Event& event);
+    void OnCoreExit(uint64_t generation, const CoreJob::Event& event);
+    void RestartAfterExit(uint64_t generation, int delayMs);
     std::string HttpGet(const std::string& path);
     std::string HttpPut(const std::string& path, const std::string& body);
+    std::string ControllerRequest(const wchar_t* verb, const std::string& path,
+                                  const std::string& body, DWORD* statusCode);
 
     std::string workDir_;
     std::string corePath_;
@@ -97,6 +172,7 @@ private:
     std::string controllerHost_;
     int controllerPort_;
     std::string controllerSecret_;
+    std::atomic<int> proxyPort_;  // mixed-port, or port when there is none; 0 without either
 
     HANDLE processHandle_;
     HANDLE processThread_;
@@ -107,17 +183,29 @@ private:
     std::atomic<bool> isStarting_;  // Prevent concurrent starts
 
     std::thread logThread_;
-    std::thread trafficThread_;
     std::thread startThread_;  // Background thread for async start
 
-    int64_t lastUpload_;
-    int64_t lastDownload_;
-    ULONGLONG lastTime_;
+    // Latest /traffic sample, pushed by the controller WebSocket
+    std::mutex trafficMutex_;
+    TrafficStats lastTraffic_;
 
     StateCallback stateCallback_;
     TrafficCallback trafficCallback_;
     LogCallback logCallback_;
     ErrorCallback errorCallback_;
+    SupervisorCallback supervisorCallback_;
+
+    // Supervision of unexpected core exits
+    CoreJob job_;
+    std::mutex limitsMutex_;
+    CoreJob::Limits limits_;
+    // Serializes start, stop, supervised restarts, the restart budget and
+    // job updates. Never taken on the job notification thread.
+    std::mutex lifecycleMutex_;
+    std::atomic<uint64_t> generation_;   // Bumped on every successful start
+    uint64_t exitHandled_;               // Generation whose exit was handled
+    std::atomic<bool> memoryLimitHit_;
+    std::deque<ULONGLONG> restartTimes_;  // Recent restarts, for the budget
 };
 
 #endif  // MIHOMO_CORE_H_
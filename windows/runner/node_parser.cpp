@@ -0,0 +1,675 @@
+// node_parser.cpp - Proxy URI and Clash proxy parser implementation
+#include "node_parser.h"
+#include "protocol_schema.h"
+#include "utils.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+bool StartsWith(const std::string& value, const char* prefix) {
+    return value.compare(0, strlen(prefix), prefix) == 0;
+}
+
+std::string Unquote(const std::string& value) {
+    if (value.size() >= 2 &&
+        ((value.front() == '"' && value.back() == '"') ||
+         (value.front() == '\'' && value.back() == '\''))) {
+        return value.substr(1, value.size() - 2);
+    }
+    return value;
+}
+
+bool IsQuoted(const std::string& value) {
+    return value.size() >= 2 && (value.front() == '"' || value.front() == '\'') &&
+           value.back() == value.front();
+}
+
+bool ParsePort(const std::string& text, int* port) {
+    if (text.empty() || text.size() > 5) return false;
+    int value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    if (value <= 0 || value > 65535) return false;
+    *port = value;
+    return true;
+}
+
+// Splits "host:port", "[v6]:port" or a bare v6 literal with a trailing port
+bool SplitHostPort(const std::string& hostPort, std::string* host, int* port) {
+    if (!hostPort.empty() && hostPort[0] == '[') {
+        size_t close = hostPort.find(']');
+        if (close == std::string::npos || close + 1 >= hostPort.size() || hostPort[close + 1] != ':') {
+            return false;
+        }
+        *host = hostPort.substr(1, close - 1);
+        return ParsePort(hostPort.substr(close + 2), port);
+    }
+    size_t colon = hostPort.rfind(':');
+    if (colon == std::string::npos) return false;
+    *host = hostPort.substr(0, colon);
+    return !host->empty() && ParsePort(hostPort.substr(colon + 1), port);
+}
+
+struct UriParts {
+    std::string userInfo;  // Decoded
+    std::string host;
+    int port = 0;
+    std::map<std::string, std::string> query;
+    std::string fragment;  // Decoded
+};
+
+// scheme://userinfo@host:port/path?query#fragment
+bool SplitUri(const std::string& uri, UriParts* parts) {
+    size_t schemeEnd = uri.find("://");
+    if (schemeEnd == std::string::npos) return false;
+    std::string rest = uri.substr(schemeEnd + 3);
+
+    size_t hash = rest.find('#');
+    if (hash != std::string::npos) {
+        parts->fragment = NodeParser::UrlDecode(rest.substr(hash + 1));
+        rest.resize(hash);
+    }
+    size_t question = rest.find('?');
+    if (question != std::string::npos) {
+        parts->query = NodeParser::ParseQuery(rest.substr(question + 1));
+        rest.resize(question);
+    }
+    size_t slash = rest.find('/');
+    if (slash != std::string::npos) rest.resize(slash);
+
+    size_t at = rest.rfind('@');
+    if (at != std::string::npos) {
+        parts->userInfo = NodeParser::UrlDecode(rest.substr(0, at));
+        rest = rest.substr(at + 1);
+    }
+    return SplitHostPort(rest, &parts->host, &parts->port);
+}
+
+void SetParam(NodeRecord* record, const char* key, const std::map<std::string, std::string>& query,
+              const char* param) {
+    auto it = query.find(param);
+    if (it != query.end()) record->settings[key] = it->second;
+}
+
+void SetParamOr(NodeRecord* record, const char* key, const std::map<std::string, std::string>& query,
+                const char* param, const char* fallback) {
+    auto it = query.find(param);
+    record->settings[key] = it != query.end() ? it->second : std::string(fallback);
+}
+
+bool ParamIs(const std::map<std::string, std::string>& query, const char* param, const char* value) {
+    auto it = query.find(param);
+    return it != query.end() && it->second == value;
+}
+
+// Minimal flat JSON object reader for vmess share links. Nested values are
+// skipped; strings, numbers and booleans are kept.
+bool ParseFlatJson(const std::string& json, std::map<std::string, NodeValue>* out) {
+    size_t i = json.find('{');
+    if (i == std::string::npos) return false;
+    i++;
+
+    auto skipSpace = [&]() {
+        while (i < json.size() && isspace(static_cast<unsigned char>(json[i]))) i++;
+    };
+    auto readString = [&](std::string* value) -> bool {
+        if (i >= json.size() || json[i] != '"') return false;
+        i++;
+        while (i < json.size() && json[i] != '"') {
+            char c = json[i++];
+            if (c == '\\' && i < json.size()) {
+                char escaped = json[i++];
+                switch (escaped) {
+                    case 'n': value->push_back('\n'); break;
+                    case 't': value->push_back('\t'); break;
+                    case 'r': value->push_back('\r'); break;
+                    case 'u':
+                        // Share links only escape ASCII; keep anything else verbatim
+                        if (i + 4 <= json.size()) {
+                            unsigned long code = strtoul(json.substr(i, 4).c_str(), nullptr, 16);
+                            if (code < 0x80) value->push_back(static_cast<char>(code));
+                            i += 4;
+                        }
+                        break;
+                    default: value->push_back(escaped);
+                }
+            } else {
+                value->push_back(c);
+            }
+        }
+        if (i >= json.size()) return false;
+        i++;
+        return true;
+    };
+
+    for (;;) {
+        skipSpace();
+        if (i >= json.size()) return false;
+        if (json[i] == '}') return true;
+        if (json[i] == ',') {
+            i++;
+            continue;
+        }
+
+        std::string key;
+        if (!readString(&key)) return false;
+        skipSpace();
+        if (i >= json.size() || json[i] != ':') return false;
+        i++;
+        skipSpace();
+        if (i >= json.size()) return false;
+
+        if (json[i] == '"') {
+            std::string value;
+            if (!readString(&value)) return false;
+            (*out)[key] = value;
+        } else if (json[i] == '{' || json[i] == '[') {
+            int depth = 0;
+            bool inString = false;
+            for (; i < json.size(); i++) {
+                char c = json[i];
+                if (inString) {
+                    if (c == '\\') i++;
+                    else if (c == '"') inString = false;
+                } else if (c == '"') {
+                    inString = true;
+                } else if (c == '{' || c == '[') {
+                    depth++;
+                } else if ((c == '}' || c == ']') && --depth == 0) {
+                    i++;
+                    break;
+                }
+            }
+        } else {
+            size_t end = i;
+            while (end < json.size() && json[end] != ',' && json[end] != '}') end++;
+            std::string token = Trim(json.substr(i, end - i));
+            i = end;
+            if (token != "null") (*out)[key] = NodeParser::ScalarValue(token);
+        }
+    }
+}
+
+std::string ValueToString(const NodeValue& value) {
+    if (const auto* text = std::get_if<std::string>(&value)) return *text;
+    if (const auto* number = std::get_if<int64_t>(&value)) return std::to_string(*number);
+    if (const auto* real = std::get_if<double>(&value)) return std::to_string(*real);
+    if (const auto* flag = std::get_if<bool>(&value)) return *flag ? "true" : "false";
+    return std::string();
+}
+
+bool ValueToInt(const NodeValue& value, int64_t* out) {
+    if (const auto* number = std::get_if<int64_t>(&value)) {
+        *out = *number;
+        return true;
+    }
+    if (const auto* text = std::get_if<std::string>(&value)) {
+        char* end = nullptr;
+        long long parsed = strtoll(text->c_str(), &end, 10);
+        if (!text->empty() && end && *end == '\0') {
+            *out = parsed;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseShadowsocks(const std::string& uri, NodeRecord* out) {
+    std::string rest = uri.substr(5);
+    std::string name;
+    size_t hash = rest.rfind('#');
+    if (hash != std::string::npos) {
+        name = NodeParser::UrlDecode(rest.substr(hash + 1));
+        rest.resize(hash);
+    }
+
+    std::string plugin;
+    size_t question = rest.find('?');
+    if (question != std::string::npos) {
+        auto query = NodeParser::ParseQuery(rest.substr(question + 1));
+        if (query.count("plugin")) plugin = query["plugin"];
+        rest.resize(question);
+    }
+    while (!rest.empty() && rest.back() == '/') rest.pop_back();
+
+    std::string userInfo;
+    std::string serverInfo;
+    size_t at = rest.rfind('@');
+    if (at != std::string::npos) {
+        // SIP002: base64(method:password)@server:port, or plain
+        // method:password for 2022 ciphers
+        std::string encoded = rest.substr(0, at);
+        if (!NodeParser::Base64Decode(encoded, &userInfo) || userInfo.find(':') == std::string::npos) {
+            userInfo = NodeParser::UrlDecode(encoded);
+        }
+        serverInfo = rest.substr(at + 1);
+    } else {
+        // Legacy: base64(method:password@server:port)
+        std::string decoded;
+        if (!NodeParser::Base64Decode(rest, &decoded)) return false;
+        size_t innerAt = decoded.rfind('@');
+        if (innerAt == std::string::npos) return false;
+        userInfo = decoded.substr(0, innerAt);
+        serverInfo = decoded.substr(innerAt + 1);
+    }
+
+    size_t colon = userInfo.find(':');
+    if (colon == std::string::npos) return false;
+    if (!SplitHostPort(serverInfo, &out->server, &out->port)) return false;
+
+    out->type = "ss";
+    out->name = name.empty() ? out->server : name;
+    out->settings["method"] = userInfo.substr(0, colon);
+    out->settings["password"] = userInfo.substr(colon + 1);
+    if (!plugin.empty()) {
+        size_t semicolon = plugin.find(';');
+        out->settings["plugin"] = plugin.substr(0, semicolon);
+        if (semicolon != std::string::npos) {
+            out->settings["plugin_opts"] = plugin.substr(semicolon + 1);
+        }
+    }
+    return true;
+}
+
+bool ParseShadowsocksR(const std::string& uri, NodeRecord* out) {
+    std::string decoded;
+    if (!NodeParser::Base64Decode(uri.substr(6), &decoded)) return false;
+
+    // server:port:protocol:method:obfs:base64(password)/?params
+    size_t paramsAt = decoded.find("/?");
+    std::string main = decoded.substr(0, paramsAt);
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        size_t colon = main.find(':', start);
+        fields.push_back(main.substr(start, colon - start));
+        if (colon == std::string::npos) break;
+        start = colon + 1;
+    }
+    if (fields.size() < 6) return false;
+
+    std::string password;
+    if (!NodeParser::Base64Decode(fields[5], &password)) return false;
+    if (!ParsePort(fields[1], &out->port)) return false;
+    out->server = fields[0];
+    out->type = "ssr";
+
+    std::string name;
+    if (paramsAt != std::string::npos) {
+        auto params = NodeParser::ParseQuery(decoded.substr(paramsAt + 2));
+        std::string value;
+        if (params.count("remarks") && NodeParser::Base64Decode(params["remarks"], &value)) {
+            name = value;
+        }
+        if (params.count("obfsparam") && NodeParser::Base64Decode(params["obfsparam"], &value)) {
+            out->settings["obfs_param"] = value;
+        }
+        if (params.count("protoparam") && NodeParser::Base64Decode(params["protoparam"], &value)) {
+            out->settings["protocol_param"] = value;
+        }
+    }
+
+    out->name = name.empty() ? out->server : name;
+    out->settings["method"] = fields[3];
+    out->settings["password"] = password;
+    out->settings["protocol"] = fields[2];
+    out->settings["obfs"] = fields[4];
+    return true;
+}
+
+bool ParseVmess(const std::string& uri, NodeRecord* out) {
+    std::string decoded;
+    if (!NodeParser::Base64Decode(uri.substr(8), &decoded)) return false;
+
+    std::map<std::string, NodeValue> json;
+    if (!ParseFlatJson(decoded, &json)) return false;
+    auto get = [&](const char* key) -> std::string {
+        auto it = json.find(key);
+        return it == json.end() ? std::string() : ValueToString(it->second);
+    };
+
+    int64_t port = 0;
+    if (!json.count("port") || !ValueToInt(json["port"], &port) || port <= 0 || port > 65535) {
+        return false;
+    }
+    out->type = "vmess";
+    out->server = get("add");
+    out->port = static_cast<int>(port);
+    if (out->server.empty()) return false;
+
+    std::string name = json.count("ps") ? get("ps") : get("remarks");
+    out->name = name.empty() ? out->server : name;
+
+    int64_t alterId = 0;
+    if (json.count("aid")) ValueToInt(json["aid"], &alterId);
+    out->settings["uuid"] = get("id");
+    out->settings["alter_id"] = alterId;
+    out->settings["cipher"] = json.count("scy") ? get("scy")
+        : json.count("security") ? get("security") : std::string("auto");
+    out->settings["network"] = json.count("net") ? get("net") : std::string("tcp");
+    out->settings["tls"] = get("tls") == "tls";
+    if (json.count("sni")) out->settings["sni"] = get("sni");
+    else if (json.count("host")) out->settings["sni"] = get("host");
+    if (json.count("path")) out->settings["ws_path"] = get("path");
+    if (json.count("host")) out->settings["ws_host"] = get("host");
+    return true;
+}
+
+bool ParseVless(const std::string& uri, NodeRecord* out) {
+    UriParts parts;
+    if (!SplitUri(uri, &parts)) return false;
+    out->type = "vless";
+    out->server = parts.host;
+    out->port = parts.port;
+    out->name = parts.fragment.empty() ? parts.host : parts.fragment;
+    out->settings["uuid"] = parts.userInfo;
+    SetParam(out, "flow", parts.query, "flow");
+    SetParamOr(out, "encryption", parts.query, "encryption", "none");
+    SetParamOr(out, "network", parts.query, "type", "tcp");
+    SetParamOr(out, "security", parts.query, "security", "none");
+    SetParam(out, "sni", parts.query, "sni");
+    SetParam(out, "fp", parts.query, "fp");
+    SetParam(out, "pbk", parts.query, "pbk");
+    SetParam(out, "sid", parts.query, "sid");
+    SetParam(out, "path", parts.query, "path");
+    SetParam(out, "host", parts.query, "host");
+    return true;
+}
+
+bool ParseTrojan(const std::string& uri, NodeRecord* out) {
+    UriParts parts;
+    if (!SplitUri(uri, &parts)) return false;
+    out->type = "trojan";
+    out->server = parts.host;
+    out->port = parts.port;
+    out->name = parts.fragment.empty() ? parts.host : parts.fragment;
+    out->settings["password"] = parts.userInfo;
+    if (parts.query.count("sni")) SetParam(out, "sni", parts.query, "sni");
+    else SetParam(out, "sni", parts.query, "peer");
+    out->settings["skip_cert_verify"] = ParamIs(parts.query, "allowInsecure", "1");
+    SetParamOr(out, "network", parts.query, "type", "tcp");
+    SetParam(out, "path", parts.query, "path");
+    SetParam(out, "host", parts.query, "host");
+    return true;
+}
+
+bool ParseHysteria(const std::string& uri, NodeRecord* out) {
+    UriParts parts;
+    if (!SplitUri(uri, &parts)) return false;
+    out->type = "hysteria";
+    out->server = parts.host;
+    out->port = parts.port;
+    out->name = parts.fragment.empty() ? parts.host : parts.fragment;
+    SetParam(out, "auth", parts.query, "auth");
+    SetParam(out, "auth_str", parts.query, "auth_str");
+    SetParam(out, "obfs", parts.query, "obfs");
+    SetParam(out, "alpn", parts.query, "alpn");
+    SetParamOr(out, "protocol", parts.query, "protocol", "udp");
+    SetParam(out, "up", parts.query, "upmbps");
+    SetParam(out, "down", parts.query, "downmbps");
+    if (parts.query.count("peer")) SetParam(out, "sni", parts.query, "peer");
+    else SetParam(out, "sni", parts.query, "sni");
+    out->settings["skip_cert_verify"] = ParamIs(parts.query, "insecure", "1");
+    return true;
+}
+
+bool ParseHysteria2(const std::string& uri, NodeRecord* out) {
+    UriParts parts;
+    if (!SplitUri(uri, &parts)) return false;
+    out->type = "hysteria2";
+    out->server = parts.host;
+    out->port = parts.port;
+    out->name = parts.fragment.empty() ? parts.host : parts.fragment;
+    out->settings["password"] = parts.userInfo;
+    SetParam(out, "obfs", parts.query, "obfs");
+    SetParam(out, "obfs_password", parts.query, "obfs-password");
+    SetParam(out, "sni", parts.query, "sni");
+    out->settings["skip_cert_verify"] = ParamIs(parts.query, "insecure", "1");
+    return true;
+}
+
+bool ParseTuic(const std::string& uri, NodeRecord* out) {
+    UriParts parts;
+    if (!SplitUri(uri, &parts)) return false;
+    out->type = "tuic";
+    out->server = parts.host;
+    out->port = parts.port;
+    out->name = parts.fragment.empty() ? parts.host : parts.fragment;
+
+    size_t colon = parts.userInfo.find(':');
+    out->settings["uuid"] = parts.userInfo.substr(0, colon);
+    out->settings["password"] = colon == std::string::npos ? std::string() : parts.userInfo.substr(colon + 1);
+    SetParamOr(out, "congestion_control", parts.query, "congestion_control", "bbr");
+    auto alpn = parts.query.find("alpn");
+    if (alpn != parts.query.end()) {
+        std::vector<std::string> protocols;
+        size_t start = 0;
+        for (;;) {
+            size_t comma = alpn->second.find(',', start);
+            protocols.push_back(alpn->second.substr(start, comma - start));
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        out->settings["alpn"] = protocols;
+    }
+    SetParam(out, "sni", parts.query, "sni");
+    out->settings["skip_cert_verify"] = ParamIs(parts.query, "insecure", "1");
+    SetParam(out, "udp_relay_mode", parts.query, "udp_relay_mode");
+    return true;
+}
+
+// Splits a flow mapping body on top-level commas, honouring quotes and
+// nested [] / {}
+std::vector<std::string> SplitFlow(const std::string& body) {
+    std::vector<std::string> items;
+    std::string current;
+    int depth = 0;
+    char quote = 0;
+    for (char c : body) {
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '[' || c == '{') {
+            depth++;
+        } else if (c == ']' || c == '}') {
+            depth--;
+        } else if (c == ',' && depth == 0) {
+            items.push_back(current);
+            current.clear();
+            continue;
+        }
+        current.push_back(c);
+    }
+    if (!Trim(current).empty()) items.push_back(current);
+    return items;
+}
+
+NodeValue FlowValue(const std::string& raw) {
+    std::string value = Trim(raw);
+    if (value.size() >= 2 && value.front() == '[' && value.back() == ']') {
+        std::vector<std::string> list;
+        for (const auto& item : SplitFlow(value.substr(1, value.size() - 2))) {
+            list.push_back(Unquote(Trim(item)));
+        }
+        return list;
+    }
+    if (IsQuoted(value)) return Unquote(value);
+    return NodeParser::ScalarValue(value);
+}
+
+}  // namespace
+
+bool NodeParser::ParseUri(const std::string& uri, NodeRecord* out) {
+    std::string line = Trim(uri);
+    bool parsed = false;
+    if (StartsWith(line, "ss://")) parsed = ParseShadowsocks(line, out);
+    else if (StartsWith(line, "ssr://")) parsed = ParseShadowsocksR(line, out);
+    else if (StartsWith(line, "vmess://")) parsed = ParseVmess(line, out);
+    else if (StartsWith(line, "vless://")) parsed = ParseVless(line, out);
+    else if (StartsWith(line, "trojan://")) parsed = ParseTrojan(line, out);
+    else if (StartsWith(line, "hysteria://")) parsed = ParseHysteria(line, out);
+    else if (StartsWith(line, "hysteria2://") || StartsWith(line, "hy2://")) parsed = ParseHysteria2(line, out);
+    else if (StartsWith(line, "tuic://")) parsed = ParseTuic(line, out);
+    // A link missing what mihomo requires would fail the whole config later
+    return parsed && ProxySchema::Validate(*out, nullptr);
+}
+
+bool NodeParser::ParseClashProxy(const std::string& block, NodeRecord* out) {
+    std::map<std::string, NodeValue> props;
+    std::string trimmed = Trim(block);
+
+    if (!trimmed.empty() && trimmed.front() == '{' && trimmed.back() == '}') {
+        for (const auto& item : SplitFlow(trimmed.substr(1, trimmed.size() - 2))) {
+            size_t colon = item.find(':');
+            if (colon == std::string::npos) continue;
+            std::string key = Unquote(Trim(item.substr(0, colon)));
+            if (!key.empty()) props[key] = FlowValue(item.substr(colon + 1));
+        }
+    } else {
+        // Block style. Nested mappings are flattened the same way the Dart
+        // parser does; "- item" lines under an empty key become a list.
+        std::string lastKey;
+        size_t start = 0;
+        while (start <= block.size()) {
+            size_t newline = block.find('\n', start);
+            if (newline == std::string::npos) newline = block.size();
+            std::string line = Trim(block.substr(start, newline - start));
+            start = newline + 1;
+            if (line.empty() || line[0] == '#') continue;
+
+            if (StartsWith(line, "- ") && !lastKey.empty()) {
+                auto& value = props[lastKey];
+                if (!std::holds_alternative<std::vector<std::string>>(value)) {
+                    value = std::vector<std::string>();
+                }
+                std::get<std::vector<std::string>>(value).push_back(Unquote(Trim(line.substr(2))));
+                continue;
+            }
+
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string key = Unquote(Trim(line.substr(0, colon)));
+            std::string value = Trim(line.substr(colon + 1));
+            if (value.empty()) {
+                lastKey = key;
+                continue;
+            }
+            lastKey.clear();
+            props[key] = FlowValue(value);
+        }
+    }
+
+    return ClashPropsToRecord(std::move(props), out);
+}
+
+bool NodeParser::ClashPropsToRecord(std::map<std::string, NodeValue> props, NodeRecord* out) {
+    auto take = [&](const char* key) -> std::string {
+        auto it = props.find(key);
+        if (it == props.end()) return std::string();
+        std::string value = ValueToString(it->second);
+        props.erase(it);
+        return value;
+    };
+
+    out->type = take("type");
+    out->name = take("name");
+    out->server = take("server");
+    if (!ParsePort(take("port"), &out->port)) return false;
+    if (out->type.empty() || out->server.empty()) return false;
+
+    for (auto& prop : props) {
+        // Empty nested-mapping parents carry no value
+        if (const auto* list = std::get_if<std::vector<std::string>>(&prop.second)) {
+            if (list->empty()) continue;
+        }
+        out->settings[prop.first] = std::move(prop.second);
+    }
+    return ProxySchema::Validate(*out, nullptr);
+}
+
+bool NodeParser::Base64Decode(const std::string& input, std::string* out) {
+    out->clear();
+    out->reserve(input.size() * 3 / 4);
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : input) {
+        int value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '+' || c == '-') value = 62;
+        else if (c == '/' || c == '_') value = 63;
+        else if (c == '=' || isspace(static_cast<unsigned char>(c))) continue;
+        else return false;
+
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out->push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+std::string NodeParser::UrlDecode(const std::string& input) {
+    std::string output;
+    output.reserve(input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        char c = input[i];
+        if (c == '%' && i + 2 < input.size() &&
+            isxdigit(static_cast<unsigned char>(input[i + 1])) &&
+            isxdigit(static_cast<unsigned char>(input[i + 2]))) {
+            output.push_back(static_cast<char>(strtol(input.substr(i + 1, 2).c_str(), nullptr, 16)));
+            i += 2;
+        } else {
+            output.push_back(c);
+        }
+    }
+    return output;
+}
+
+std::map<std::string, std::string> NodeParser::ParseQuery(const std::string& query) {
+    std::map<std::string, std::string> params;
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t amp = query.find('&', start);
+        if (amp == std::string::npos) amp = query.size();
+        std::string pair = query.substr(start, amp - start);
+        // Form encoding: '+' is a space in query strings only
+        for (char& c : pair) {
+            if (c == '+') c = ' ';
+        }
+        size_t eq = pair.find('=');
+        if (!pair.empty()) {
+            if (eq == std::string::npos) {
+                params[UrlDecode(pair)] = "";
+            } else {
+                params[UrlDecode(pair.substr(0, eq))] = UrlDecode(pair.substr(eq + 1));
+            }
+        }
+        start = amp + 1;
+    }
+    return params;
+}
+
+NodeValue NodeParser::ScalarValue(const std::string& token) {
+    if (token == "true") return true;
+    if (token == "false") return false;
+    if (!token.empty() && (isdigit(static_cast<unsigned char>(token[0])) ||
+                           token[0] == '-' || token[0] == '.')) {
+        char* end = nullptr;
+        long long integer = strtoll(token.c_str(), &end, 10);
+        if (end && *end == '\0') return static_cast<int64_t>(integer);
+        double real = strtod(token.c_str(), &end);
+        if (end && *end == '\0') return real;
+    }
+    return token;
+}
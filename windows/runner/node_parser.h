@@ -0,0 +1,41 @@
+// node_parser.h - Proxy URI and Clash proxy parsers for Windows
+#ifndef NODE_PARSER_H_
+#define NODE_PARSER_H_
+
+#include "node_table.h"
+
+#include <map>
+#include <string>
+
+// Native counterparts of the Dart SubscriptionParser branches. Setting keys
+// match what the Dart parser produces so records convert to ProxyNode as-is.
+class NodeParser {
+public:
+    // ss://, ssr://, vmess://, vless://, trojan://, hysteria://,
+    // hysteria2:// (hy2://) and tuic:// share links. Like the Clash parsers
+    // below, fails for records ProxySchema::Validate rejects.
+    static bool ParseUri(const std::string& uri, NodeRecord* out);
+
+    // One item of a Clash `proxies:` list, block or flow style, with the
+    // leading "- " already removed
+    static bool ParseClashProxy(const std::string& block, NodeRecord* out);
+
+    // Builds a record from the flattened keys of one Clash proxy: name,
+    // type, server and port are taken out, everything else becomes a setting
+    static bool ClashPropsToRecord(std::map<std::string, NodeValue> props, NodeRecord* out);
+
+    // Tolerant standard/url-safe Base64 decode; padding and whitespace are
+    // optional. Returns false on characters outside the alphabet.
+    static bool Base64Decode(const std::string& input, std::string* out);
+
+    static std::string UrlDecode(const std::string& input);
+
+    // Parses "a=1&b=2" into a map with decoded keys and values
+    static std::map<std::string, std::string> ParseQuery(const std::string& query);
+
+    // Converts a scalar YAML/JSON token to the typed value the Dart parser
+    // would have produced (bool, int, double or string)
+    static NodeValue ScalarValue(const std::string& token);
+};
+
+#endif  // NODE_PARSER_H_
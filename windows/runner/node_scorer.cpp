@@ -0,0 +1,162 @@
+// node_scorer.cpp - Weighted node scoring implementation
+#include "node_scorer.h"
+
+#include <algorithm>
+
+namespace {
+
+// Weight of a new throughput sample in the moving average
+constexpr double kThroughputAlpha = 0.3;
+
+constexpr double kMaxScoredMbps = 100.0;
+
+}  // namespace
+
+NodeScorer& NodeScorer::GetInstance() {
+    static NodeScorer instance;
+    return instance;
+}
+
+void NodeScorer::SetNodes(const std::vector<NodeInfo>& nodes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::unordered_map<std::string, Node> next;
+    next.reserve(nodes.size());
+    for (const auto& info : nodes) {
+        if (info.id.empty()) continue;
+        auto existing = nodes_.find(info.id);
+        Node& node = next[info.id];
+        if (existing != nodes_.end()) node = existing->second;
+        node.info = info;
+    }
+
+    // Scores depend on the multiplier, which may have changed
+    nodes_.swap(next);
+    ranking_.clear();
+    for (auto& item : nodes_) {
+        item.second.ranked = false;
+        Rescore(item.second);
+    }
+}
+
+void NodeScorer::AddLatencySample(const std::string& id, int64_t latencyMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = nodes_.find(id);
+    if (it == nodes_.end()) return;
+
+    Node& node = it->second;
+    node.latencies[node.next] = latencyMs > 0 ? latencyMs : 0;
+    node.next = (node.next + 1) % kHistory;
+    if (node.count < kHistory) node.count++;
+    Rescore(node);
+}
+
+void NodeScorer::AddThroughputSample(const std::string& id, double bytesPerSecond) {
+    if (bytesPerSecond < 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = nodes_.find(id);
+    if (it == nodes_.end()) return;
+
+    Node& node = it->second;
+    node.throughput = node.throughput < 0
+        ? bytesPerSecond
+        : node.throughput + kThroughputAlpha * (bytesPerSecond - node.throughput);
+    Rescore(node);
+}
+
+void NodeScorer::SetWeights(const Weights& weights) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    weights_ = weights;
+    ranking_.clear();
+    for (auto& item : nodes_) {
+        item.second.ranked = false;
+        Rescore(item.second);
+    }
+}
+
+NodeScorer::Weights NodeScorer::GetWeights() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return weights_;
+}
+
+std::vector<NodeScorer::Ranked> NodeScorer::GetTop(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Ranked> result;
+    result.reserve(std::min(limit, ranking_.size()));
+
+    for (const auto& entry : ranking_) {
+        if (result.size() >= limit) break;
+        const Node& node = nodes_.at(entry.second);
+
+        Ranked ranked;
+        ranked.id = node.info.id;
+        ranked.name = node.info.name;
+        ranked.score = node.score;
+        ranked.rank = static_cast<int>(result.size()) + 1;
+        ranked.p50Ms = node.p50Ms;
+        ranked.p90Ms = node.p90Ms;
+        ranked.loss = node.loss;
+        ranked.throughputMbps = node.throughput < 0 ? -1 : node.throughput * 8 / 1e6;
+        ranked.multiplier = node.info.multiplier;
+        ranked.samples = static_cast<int>(node.count);
+        result.push_back(std::move(ranked));
+    }
+    return result;
+}
+
+std::string NodeScorer::GetBest() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ranking_.empty() ? std::string() : ranking_.begin()->second;
+}
+
+void NodeScorer::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ranking_.clear();
+    for (auto& item : nodes_) {
+        NodeInfo info = item.second.info;
+        item.second = Node();
+        item.second.info = info;
+    }
+}
+
+void NodeScorer::Rescore(Node& node) {
+    Unrank(node);
+
+    std::vector<int64_t> answered;
+    answered.reserve(node.count);
+    for (size_t i = 0; i < node.count; i++) {
+        if (node.latencies[i] > 0) answered.push_back(node.latencies[i]);
+    }
+    node.loss = node.count > 0
+        ? 1.0 - static_cast<double>(answered.size()) / static_cast<double>(node.count)
+        : 0;
+    if (answered.empty()) {
+        node.p50Ms = -1;
+        node.p90Ms = -1;
+        return;
+    }
+
+    // Nearest-rank percentiles over at most kHistory samples
+    std::sort(answered.begin(), answered.end());
+    node.p50Ms = answered[(answered.size() - 1) / 2];
+    node.p90Ms = answered[(answered.size() * 9 + 9) / 10 - 1];
+
+    double score = weights_.latency * static_cast<double>(node.p50Ms) +
+                   weights_.jitter * static_cast<double>(node.p90Ms - node.p50Ms) +
+                   weights_.loss * node.loss +
+                   weights_.multiplier * (node.info.multiplier - 1.0);
+    if (node.throughput >= 0) {
+        score -= weights_.throughput * std::min(node.throughput * 8 / 1e6, kMaxScoredMbps);
+    }
+
+    node.score = score;
+    node.ranked = true;
+    ranking_.emplace(score, node.info.id);
+}
+
+void NodeScorer::Unrank(Node& node) {
+    if (!node.ranked) return;
+    ranking_.erase({node.score, node.info.id});
+    node.ranked = false;
+}
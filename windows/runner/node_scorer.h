@@ -0,0 +1,99 @@
+// node_scorer.h - Weighted node scoring and ranking for Windows
+#ifndef NODE_SCORER_H_
+#define NODE_SCORER_H_
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Ranks nodes by a weighted score built from their recent delay tests
+// (median and tail latency, loss), optional throughput samples and their
+// billing multiplier. Lower scores are better.
+//
+// The ranking is kept as an ordered index that is updated one node at a
+// time as samples arrive, so asking for the best node or the top K never
+// sorts the whole list. Nodes that have never answered a test are unranked.
+class NodeScorer {
+public:
+    struct Weights {
+        double latency = 1.0;       // Per ms of median latency
+        double jitter = 0.5;        // Per ms between the median and p90
+        double loss = 1000.0;       // Per unit of loss, 1.0 when every test failed
+        double throughput = 2.0;    // Subtracted per Mbps, counted up to 100
+        double multiplier = 100.0;  // Per unit of billing rate away from 1x: a penalty
+                                    // above it, a bonus below it
+    };
+
+    struct NodeInfo {
+        std::string id;
+        std::string name;
+        double multiplier = 1.0;
+    };
+
+    struct Ranked {
+        std::string id;
+        std::string name;
+        double score = 0;
+        int rank = 0;             // 1-based
+        int64_t p50Ms = -1;
+        int64_t p90Ms = -1;
+        double loss = 0;
+        double throughputMbps = -1;  // -1 without samples
+        double multiplier = 1.0;
+        int samples = 0;
+    };
+
+    static NodeScorer& GetInstance();
+
+    // Replaces the node list; history is kept for ids that remain
+    void SetNodes(const std::vector<NodeInfo>& nodes);
+
+    // latencyMs <= 0 records a failed test
+    void AddLatencySample(const std::string& id, int64_t latencyMs);
+    void AddThroughputSample(const std::string& id, double bytesPerSecond);
+
+    void SetWeights(const Weights& weights);
+    Weights GetWeights();
+
+    std::vector<Ranked> GetTop(size_t limit);
+
+    // Empty when no node has answered a test yet
+    std::string GetBest();
+
+    void Reset();
+
+private:
+    static constexpr size_t kHistory = 32;
+
+    struct Node {
+        NodeInfo info;
+        int64_t latencies[kHistory] = {};  // Ring of recent tests, <= 0 for failures
+        size_t count = 0;
+        size_t next = 0;
+        double throughput = -1;  // EWMA, bytes per second
+        bool ranked = false;
+        double score = 0;
+        int64_t p50Ms = -1;
+        int64_t p90Ms = -1;
+        double loss = 0;
+    };
+
+    NodeScorer() = default;
+    NodeScorer(const NodeScorer&) = delete;
+    NodeScorer& operator=(const NodeScorer&) = delete;
+
+    // Recomputes one node's score and moves it within the ranking
+    void Rescore(Node& node);
+    void Unrank(Node& node);
+
+    std::mutex mutex_;
+    Weights weights_;
+    std::unordered_map<std::string, Node> nodes_;
+    std::set<std::pair<double, std::string>> ranking_;  // (score, id)
+};
+
+#endif  // NODE_SCORER_H_
@@ -0,0 +1,87 @@
+// node_table.cpp - Native proxy node table implementation
+#include "node_table.h"
+
+#include <algorithm>
+
+namespace {
+
+// Settings that identify the account on a server, in lookup order
+const char* const kCredentialKeys[] = {"uuid", "password", "auth", "auth_str", "private-key"};
+
+}  // namespace
+
+std::string NodeRecord::Key() const {
+    std::string identity = type + "|" + server + "|" + std::to_string(port);
+    for (const char* key : kCredentialKeys) {
+        auto it = settings.find(key);
+        if (it != settings.end()) {
+            if (const auto* value = std::get_if<std::string>(&it->second)) {
+                identity += "|" + *value;
+                break;
+            }
+        }
+    }
+    return identity;
+}
+
+bool NodeRecord::SameAs(const NodeRecord& other) const {
+    return name == other.name && type == other.type && server == other.server &&
+           port == other.port && settings == other.settings;
+}
+
+bool NodeTable::Insert(NodeRecord record) {
+    std::string key = record.Key();
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        NodeRecord& existing = records_[it->second];
+        for (const auto& source : record.sources) {
+            if (std::find(existing.sources.begin(), existing.sources.end(), source) ==
+                existing.sources.end()) {
+                existing.sources.push_back(source);
+            }
+        }
+        return false;
+    }
+    index_.emplace(std::move(key), records_.size());
+    records_.push_back(std::move(record));
+    return true;
+}
+
+const NodeRecord* NodeTable::Find(const std::string& key) const {
+    auto it = index_.find(key);
+    return it == index_.end() ? nullptr : &records_[it->second];
+}
+
+void NodeTable::Clear() {
+    records_.clear();
+    index_.clear();
+}
+
+size_t NodeTable::ShrinkToFit() {
+    size_t bytes = (records_.capacity() - records_.size()) * sizeof(NodeRecord);
+    records_.shrink_to_fit();
+    size_t buckets = index_.bucket_count();
+    index_.rehash(0);
+    if (buckets > index_.bucket_count()) bytes += (buckets - index_.bucket_count()) * sizeof(void*);
+    return bytes;
+}
+
+NodeTable::Diff NodeTable::DiffFrom(const NodeTable& previous) const {
+    Diff diff;
+    for (const auto& record : records_) {
+        const NodeRecord* old = previous.Find(record.Key());
+        if (!old) {
+            diff.added.push_back(record.name);
+        } else if (!record.SameAs(*old)) {
+            diff.changed.push_back(record.name);
+        } else {
+            diff.unchanged++;
+        }
+    }
+    for (const auto& record : previous.records_) {
+        if (index_.find(record.Key()) == index_.end()) {
+            diff.removed.push_back(record.name);
+        }
+    }
+    return diff;
+}
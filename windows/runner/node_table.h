@@ -0,0 +1,64 @@
+// node_table.h - Native proxy node table for Windows
+#ifndef NODE_TABLE_H_
+#define NODE_TABLE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Setting values keep the types the Dart ProxyNode.settings map expects
+using NodeValue = std::variant<std::string, int64_t, double, bool, std::vector<std::string>>;
+
+struct NodeRecord {
+    std::string name;
+    std::string type;  // mihomo proxy type: ss, ssr, vmess, vless, trojan, ...
+    std::string server;
+    int port = 0;
+    std::map<std::string, NodeValue> settings;
+    std::vector<std::string> sources;  // Tags of the subscriptions carrying this node
+
+    // Identity used for deduplication across subscriptions: the same
+    // endpoint with the same credential is the same node, whatever it is
+    // called in each source.
+    std::string Key() const;
+
+    // Content equality, ignoring sources
+    bool SameAs(const NodeRecord& other) const;
+};
+
+// Ordered, deduplicated node table. Insertion order is preserved so the
+// merged list keeps the order of the first source that listed each node.
+class NodeTable {
+public:
+    struct Diff {
+        std::vector<std::string> added;    // Node names
+        std::vector<std::string> removed;
+        std::vector<std::string> changed;  // Same key, different name or settings
+        size_t unchanged = 0;
+    };
+
+    // Returns false when the node was already present; its source tags are
+    // merged into the existing record.
+    bool Insert(NodeRecord record);
+
+    const std::vector<NodeRecord>& Records() const { return records_; }
+    size_t Size() const { return records_.size(); }
+    const NodeRecord* Find(const std::string& key) const;
+    void Clear();
+
+    // Releases capacity left over from building the table; returns the
+    // approximate bytes released
+    size_t ShrinkToFit();
+
+    // Changes needed to turn previous into this table
+    Diff DiffFrom(const NodeTable& previous) const;
+
+private:
+    std::vector<NodeRecord> records_;
+    std::unordered_map<std::string, size_t> index_;
+};
+
+#endif  // NODE_TABLE_H_
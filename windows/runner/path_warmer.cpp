@@ -0,0 +1,170 @@
+// path_warmer.cpp - Post-switch path warmup implementation
+#include "path_warmer.h"
+#include "flight_recorder.h"
+#include "http_fetch.h"
+#include "tracer.h"
+
+#include <chrono>
+#include <thread>
+
+PathWarmer& PathWarmer::GetInstance() {
+    static PathWarmer instance;
+    return instance;
+}
+
+void PathWarmer::SetOptions(const Options& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    if (options_.timeoutMs <= 0) options_.timeoutMs = Options().timeoutMs;
+}
+
+PathWarmer::Options PathWarmer::GetOptions() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+bool PathWarmer::Warm(const std::string& trigger, const std::string& node, int proxyPort) {
+    if (proxyPort <= 0) return false;
+
+    Result result;
+    Options options;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!options_.enabled || options_.targets.empty()) return false;
+
+        generation_++;
+        for (auto& fetch : active_) fetch->Cancel();
+        active_.clear();
+
+        options = options_;
+        result.id = generation_;
+        result.trigger = trigger;
+        result.node = node;
+        result.state = "warming";
+        result.attempted = static_cast<int>(options.targets.size());
+        lastResult_ = result;
+    }
+    Publish(result);
+
+    std::string proxy = "127.0.0.1:" + std::to_string(proxyPort);
+    Tracer::Context trace = Tracer::Current();
+    std::thread([this, result, options, proxy, trace]() {
+        Tracer::Span span("warmup", "warm " + proxy, trace);
+        Run(result, options, proxy);
+    }).detach();
+    return true;
+}
+
+void PathWarmer::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_++;
+    for (auto& fetch : active_) fetch->Cancel();
+    active_.clear();
+}
+
+PathWarmer::Result PathWarmer::GetLastResult() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastResult_;
+}
+
+void PathWarmer::SetCallback(ResultCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = std::move(callback);
+}
+
+void PathWarmer::Run(Result result, Options options, std::string proxy) {
+    auto started = std::chrono::steady_clock::now();
+
+    struct Probe {
+        int64_t coldMs = -1;
+        int64_t warmMs = -1;
+        std::string error;
+    };
+    std::vector<Probe> probes(options.targets.size());
+
+    // Targets are warmed in parallel, each with a cold then a warm request.
+    // Both go through one fetch so the warm pass rides the keep-alive
+    // connection to the proxy, as a browser's next request would.
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < options.targets.size(); i++) {
+        threads.emplace_back([this, &probes, &options, &proxy, &result, i]() {
+            Probe& probe = probes[i];
+            auto fetch = std::make_shared<HttpFetch>();
+            fetch->SetProxy(proxy);
+            fetch->SetTimeout(options.timeoutMs);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (generation_ != result.id) return;
+                active_.push_back(fetch);
+            }
+
+            for (int pass = 0; pass < 2; pass++) {
+                auto response = fetch->Get(options.targets[i]);
+                if (!response.error.empty() || response.statusCode < 200 || response.statusCode >= 400) {
+                    probe.error = response.error.empty()
+                        ? "HTTP " + std::to_string(response.statusCode)
+                        : response.error;
+                    return;
+                }
+                (pass == 0 ? probe.coldMs : probe.warmMs) = response.firstByteMs;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // A newer warmup has taken over and reports for itself
+    if (!Current(result.id)) return;
+
+    const Probe* best = nullptr;
+    for (const auto& probe : probes) {
+        if (probe.coldMs < 0) continue;
+        result.succeeded++;
+        if (!best || probe.coldMs < best->coldMs) best = &probe;
+    }
+
+    if (best) {
+        result.state = "ready";
+        result.coldMs = best->coldMs;
+        result.warmMs = best->warmMs;
+        if (best->warmMs >= 0) {
+            result.handshakeMs = best->coldMs > best->warmMs ? best->coldMs - best->warmMs : 0;
+        }
+    } else {
+        result.state = "failed";
+        for (const auto& probe : probes) {
+            if (!probe.error.empty()) {
+                result.error = probe.error;
+                break;
+            }
+        }
+    }
+    result.totalMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation_ != result.id) return;
+        active_.clear();
+        lastResult_ = result;
+    }
+
+    FlightRecorder::Record(FlightRecorder::Category::Network,
+                           best ? FlightRecorder::Level::Info : FlightRecorder::Level::Warning,
+                           "path warmup " + result.state + " " + result.node,
+                           best ? result.handshakeMs : -1);
+    Publish(result);
+}
+
+bool PathWarmer::Current(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_ == id;
+}
+
+void PathWarmer::Publish(const Result& result) {
+    ResultCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = callback_;
+    }
+    if (callback) callback(result);
+}
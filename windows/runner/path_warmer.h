@@ -0,0 +1,82 @@
+// path_warmer.h - Post-switch path warmup through the local proxy for Windows
+#ifndef PATH_WARMER_H_
+#define PATH_WARMER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class HttpFetch;
+
+// After a node switch or a fresh connect, sends a few small requests through
+// the core's mixed port so the DNS lookup, the TCP/TLS handshake to the node
+// and any mux session are already set up when the first real request goes
+// out. Each target is fetched twice: the first, cold request pays for the
+// whole path, the second shows what a warm one costs, and the difference is
+// reported as the handshake time.
+//
+// A new warmup cancels the one in flight. Results are delivered through the
+// callback, first as "warming", then as "ready" or "failed".
+class PathWarmer {
+public:
+    struct Options {
+        bool enabled = true;
+        std::vector<std::string> targets = {
+            "https://www.gstatic.com/generate_204",
+            "https://cp.cloudflare.com/generate_204",
+        };
+        int timeoutMs = 5000;  // Per request
+    };
+
+    struct Result {
+        uint64_t id = 0;
+        std::string trigger;   // "switch" or "connect"
+        std::string node;      // Empty when not known
+        std::string state;     // "warming", "ready" or "failed"
+        int attempted = 0;     // Targets tried
+        int succeeded = 0;
+        int64_t coldMs = -1;   // Fastest first response through a cold path
+        int64_t warmMs = -1;   // The same target once warm
+        int64_t handshakeMs = -1;
+        int64_t totalMs = 0;
+        std::string error;
+    };
+
+    using ResultCallback = std::function<void(const Result& result)>;
+
+    static PathWarmer& GetInstance();
+
+    void SetOptions(const Options& options);
+    Options GetOptions();
+
+    // Returns false when disabled or no proxy port is known
+    bool Warm(const std::string& trigger, const std::string& node, int proxyPort);
+
+    // Aborts the warmup in flight, e.g. when the core stops
+    void Cancel();
+
+    Result GetLastResult();
+
+    void SetCallback(ResultCallback callback);
+
+private:
+    PathWarmer() = default;
+    PathWarmer(const PathWarmer&) = delete;
+    PathWarmer& operator=(const PathWarmer&) = delete;
+
+    void Run(Result result, Options options, std::string proxy);
+    bool Current(uint64_t id);
+    void Publish(const Result& result);
+
+    std::mutex mutex_;
+    Options options_;
+    uint64_t generation_ = 0;
+    std::vector<std::shared_ptr<HttpFetch>> active_;  // Fetches of the current warmup
+    Result lastResult_;
+    ResultCallback callback_;
+};
+
+#endif  // PATH_WARMER_H_
@@ -1,21 +1,525 @@
 // platform_channel.cpp - Platform Channel Implementation for Windows
 #include "platform_channel.h"
 #include "mihomo_core.h"
+#include "chain_prober.h"
+#include "clash_yaml.h"
+#include "connection_stats.h"
+#include "controller_streams.h"
+#include "controller_trace.h"
+#include "core_async.h"
+#include "dns_benchmark.h"
+#include "endpoint_racer.h"
+#include "flight_recorder.h"
+#include "idle_budget.h"
+#include "memory_monitor.h"
+#include "node_scorer.h"
+#include "path_warmer.h"
+#include "protocol_schema.h"
+#include "proxy_topology.h"
+#include "rule_compiler.h"
+#include "rule_stats.h"
+#include "soak_test.h"
+#include "subscription_pipeline.h"
+#include "tcp_prober.h"
+#include "tracer.h"
+#include "worker_pool.h"
 
 #include <shlobj.h>
 #include <shlwapi.h>
 #include <wininet.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <map>
+#include <thread>
 
 #pragma comment(lib, "shell32.lib")
 #pragma comment(lib, "shlwapi.lib")
 #pragma comment(lib, "wininet.lib")
 
 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> PlatformChannel::event_sink_;
+std::mutex PlatformChannel::event_mutex_;
+uint64_t PlatformChannel::event_seq_ = 0;
+flutter::EncodableValue PlatformChannel::cached_traffic_;
+flutter::EncodableValue PlatformChannel::cached_error_;
+std::deque<flutter::EncodableValue> PlatformChannel::cached_logs_;
+HWND PlatformChannel::platform_window_ = nullptr;
+std::mutex PlatformChannel::platform_tasks_mutex_;
+std::deque<std::function<void()>> PlatformChannel::platform_tasks_;
+
+namespace {
+
+// Log lines kept for replay to a new listener
+constexpr size_t kReplayLogLines = 100;
+
+// Argument helpers for the newer methods. Dart ints arrive as int32 or int64
+// depending on magnitude, so both are accepted.
+std::string GetStringArg(const flutter::EncodableMap& args, const char* key,
+                         const std::string& fallback = "") {
+    auto it = args.find(flutter::EncodableValue(key));
+    if (it != args.end()) {
+        if (const auto* value = std::get_if<std::string>(&it->second)) return *value;
+    }
+    return fallback;
+}
+
+int64_t GetIntArg(const flutter::EncodableMap& args, const char* key, int64_t fallback) {
+    auto it = args.find(flutter::EncodableValue(key));
+    if (it != args.end()) {
+        if (const auto* value = std::get_if<int32_t>(&it->second)) return *value;
+        if (const auto* value = std::get_if<int64_t>(&it->second)) return *value;
+    }
+    return fallback;
+}
+
+bool GetBoolArg(const flutter::EncodableMap& args, const char* key, bool fallback) {
+    auto it = args.find(flutter::EncodableValue(key));
+    if (it != args.end()) {
+        if (const auto* value = std::get_if<bool>(&it->second)) return *value;
+    }
+    return fallback;
+}
+
+double GetDoubleArg(const flutter::EncodableMap& args, const char* key, double fallback) {
+    auto it = args.find(flutter::EncodableValue(key));
+    if (it != args.end()) {
+        if (const auto* value = std::get_if<double>(&it->second)) return *value;
+        if (const auto* value = std::get_if<int32_t>(&it->second)) return *value;
+        if (const auto* value = std::get_if<int64_t>(&it->second)) return static_cast<double>(*value);
+    }
+    return fallback;
+}
+
+std::vector<std::string> GetStringListArg(const flutter::EncodableMap& args, const char* key) {
+    std::vector<std::string> values;
+    auto it = args.find(flutter::EncodableValue(key));
+    if (it != args.end()) {
+        if (const auto* list = std::get_if<flutter::EncodableList>(&it->second)) {
+            for (const auto& item : *list) {
+                if (const auto* value = std::get_if<std::string>(&item)) values.push_back(*value);
+            }
+        }
+    }
+    return values;
+}
+
+flutter::EncodableValue EncodeNodeValue(const NodeValue& value) {
+    if (const auto* text = std::get_if<std::string>(&value)) return flutter::EncodableValue(*text);
+    if (const auto* number = std::get_if<int64_t>(&value)) return flutter::EncodableValue(*number);
+    if (const auto* real = std::get_if<double>(&value)) return flutter::EncodableValue(*real);
+    if (const auto* flag = std::get_if<bool>(&value)) return flutter::EncodableValue(*flag);
+    flutter::EncodableList list;
+    for (const auto& item : std::get<std::vector<std::string>>(value)) {
+        list.push_back(flutter::EncodableValue(item));
+    }
+    return flutter::EncodableValue(list);
+}
+
+flutter::EncodableMap EncodeNodeRecord(const NodeRecord& node) {
+    flutter::EncodableMap settings;
+    for (const auto& setting : node.settings) {
+        settings[flutter::EncodableValue(setting.first)] = EncodeNodeValue(setting.second);
+    }
+    flutter::EncodableList sources;
+    for (const auto& source : node.sources) {
+        sources.push_back(flutter::EncodableValue(source));
+    }
+
+    flutter::EncodableMap item;
+    item[flutter::EncodableValue("name")] = flutter::EncodableValue(node.name);
+    item[flutter::EncodableValue("type")] = flutter::EncodableValue(node.type);
+    item[flutter::EncodableValue("server")] = flutter::EncodableValue(node.server);
+    item[flutter::EncodableValue("port")] = flutter::EncodableValue(node.port);
+    item[flutter::EncodableValue("settings")] = flutter::EncodableValue(settings);
+    item[flutter::EncodableValue("sources")] = flutter::EncodableValue(sources);
+    return item;
+}
+
+// Settings as ProxyNode stores them; nested maps have no NodeValue and are
+// dropped (DecodeNodeRecord reports them)
+bool DecodeNodeValue(const flutter::EncodableValue& value, NodeValue* out) {
+    if (const auto* text = std::get_if<std::string>(&value)) {
+        *out = *text;
+    } else if (const auto* number32 = std::get_if<int32_t>(&value)) {
+        *out = static_cast<int64_t>(*number32);
+    } else if (const auto* number = std::get_if<int64_t>(&value)) {
+        *out = *number;
+    } else if (const auto* real = std::get_if<double>(&value)) {
+        *out = *real;
+    } else if (const auto* flag = std::get_if<bool>(&value)) {
+        *out = *flag;
+    } else if (const auto* list = std::get_if<flutter::EncodableList>(&value)) {
+        std::vector<std::string> items;
+        for (const auto& item : *list) {
+            if (const auto* itemText = std::get_if<std::string>(&item)) items.push_back(*itemText);
+            else if (const auto* itemNumber = std::get_if<int32_t>(&item)) items.push_back(std::to_string(*itemNumber));
+            else if (const auto* itemNumber64 = std::get_if<int64_t>(&item)) items.push_back(std::to_string(*itemNumber64));
+        }
+        *out = std::move(items);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// dropped receives the keys of nested-map settings that were left out
+NodeRecord DecodeNodeRecord(const flutter::EncodableMap& item, std::vector<std::string>* dropped = nullptr) {
+    NodeRecord node;
+    node.name = GetStringArg(item, "name");
+    node.type = GetStringArg(item, "type");
+    node.server = GetStringArg(item, "server");
+    node.port = static_cast<int>(GetIntArg(item, "port", 0));
+    auto settings = item.find(flutter::EncodableValue("settings"));
+    if (settings != item.end()) {
+        if (const auto* map = std::get_if<flutter::EncodableMap>(&settings->second)) {
+            for (const auto& entry : *map) {
+                const auto* key = std::get_if<std::string>(&entry.first);
+                NodeValue value;
+                if (!key) continue;
+                if (DecodeNodeValue(entry.second, &value)) {
+                    node.settings[*key] = std::move(value);
+                } else if (dropped && std::holds_alternative<flutter::EncodableMap>(entry.second)) {
+                    dropped->push_back(*key);
+                }
+            }
+        }
+    }
+    return node;
+}
+
+flutter::EncodableList EncodeStringList(const std::vector<std::string>& values) {
+    flutter::EncodableList list;
+    for (const auto& value : values) {
+        list.push_back(flutter::EncodableValue(value));
+    }
+    return list;
+}
+
+// Posted to the platform window when tasks are queued
+constexpr UINT kRunPlatformTasks = WM_APP + 1;
+
+// Read-only entries of one invokeBatch running at once. Most of them wait on
+// the controller, so they get their own pool instead of WorkerPool::Shared,
+// which is for CPU-bound work.
+constexpr size_t kBatchParallelism = 4;
+
+WorkerPool& BatchPool() {
+    static WorkerPool pool(kBatchParallelism);
+    return pool;
+}
+
+// Read-only methods adjacent invokeBatch entries may run concurrently
+bool IsBatchParallel(const std::string& method) {
+    return method == "isCoreRunning" || method == "getCoreVersion" ||
+           method == "getVpnState" || method == "getTrafficStats" ||
+           method == "getConnections" || method == "getDeviceInfo" ||
+           method == "isAutoStartEnabled" || method == "getEndpointHealth" ||
+           method == "getCoreLimits" || method == "getFlightRecorder" ||
+           method == "getStreamStatus" || method == "getRuleStats" ||
+           method == "getPathWarmup" || method == "getTopNodes" ||
+           method == "getBestNode" || method == "getConnectionStats" ||
+           method == "getConnectionMetrics" ||
+           method == "getControllerTrace" || method == "exportTraceEvents" ||
+           method == "testProxyDelay" || method == "getProxyTopology" ||
+           method == "serializeProxies";
+}
+
+// Gathers the replies of one invokeBatch call. The outer result is answered
+// when the last entry completes, on whichever thread that happens.
+class BatchCollector {
+public:
+    BatchCollector(size_t count, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result)
+        : replies_(count), remaining_(count), result_(std::move(result)) {}
+
+    void Complete(size_t index, flutter::EncodableMap reply) {
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            replies_[index] = flutter::EncodableValue(std::move(reply));
+            last = --remaining_ == 0;
+        }
+        cv_.notify_all();
+        if (last) {
+            result_->Success(flutter::EncodableValue(flutter::EncodableList(replies_.begin(), replies_.end())));
+        }
+    }
+
+    // Blocks until count entries in total have answered
+    void WaitForCompleted(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this, count]() { return replies_.size() - remaining_ >= count; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<flutter::EncodableValue> replies_;
+    size_t remaining_;
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result_;
+};
+
+// Stands in for the channel's result so batch entries go through the normal
+// handler unchanged
+class BatchEntryResult : public flutter::MethodResult<flutter::EncodableValue> {
+public:
+    BatchEntryResult(std::shared_ptr<BatchCollector> collector, size_t index)
+        : collector_(std::move(collector)), index_(index) {}
+
+protected:
+    void SuccessInternal(const flutter::EncodableValue* result) override {
+        flutter::EncodableMap reply;
+        reply[flutter::EncodableValue("ok")] = flutter::EncodableValue(true);
+        reply[flutter::EncodableValue("value")] = result ? *result : flutter::EncodableValue();
+        collector_->Complete(index_, std::move(reply));
+    }
+
+    void ErrorInternal(const std::string& code, const std::string& message,
+                       const flutter::EncodableValue* details) override {
+        flutter::EncodableMap reply;
+        reply[flutter::EncodableValue("ok")] = flutter::EncodableValue(false);
+        reply[flutter::EncodableValue("code")] = flutter::EncodableValue(code);
+        reply[flutter::EncodableValue("message")] = flutter::EncodableValue(message);
+        collector_->Complete(index_, std::move(reply));
+    }
+
+    void NotImplementedInternal() override {
+        ErrorInternal("NOT_IMPLEMENTED", "Method not implemented", nullptr);
+    }
+
+private:
+    std::shared_ptr<BatchCollector> collector_;
+    size_t index_;
+};
+
+flutter::EncodableMap EncodeMemoryEvent(const MemoryMonitor::Event& event) {
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("level")] = flutter::EncodableValue(event.level);
+    data[flutter::EncodableValue("memoryLoad")] = flutter::EncodableValue(event.memoryLoad);
+    data[flutter::EncodableValue("availableMb")] = flutter::EncodableValue(event.availablePhysMb);
+    data[flutter::EncodableValue("workingSetBefore")] = flutter::EncodableValue(event.workingSetBefore);
+    data[flutter::EncodableValue("workingSetAfter")] = flutter::EncodableValue(event.workingSetAfter);
+    data[flutter::EncodableValue("trimmed")] = flutter::EncodableValue(event.trimmedBytes);
+    data[flutter::EncodableValue("coreGc")] = flutter::EncodableValue(event.coreGc);
+    data[flutter::EncodableValue("coreGcError")] = flutter::EncodableValue(event.coreGcError);
+    return data;
+}
+
+flutter::EncodableMap EncodeNodeDiff(const NodeTable::Diff& diff, size_t total) {
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("added")] = flutter::EncodableValue(EncodeStringList(diff.added));
+    data[flutter::EncodableValue("removed")] = flutter::EncodableValue(EncodeStringList(diff.removed));
+    data[flutter::EncodableValue("changed")] = flutter::EncodableValue(EncodeStringList(diff.changed));
+    data[flutter::EncodableValue("unchanged")] = flutter::EncodableValue(static_cast<int64_t>(diff.unchanged));
+    data[flutter::EncodableValue("total")] = flutter::EncodableValue(static_cast<int64_t>(total));
+    return data;
+}
+
+flutter::EncodableMap EncodeWarmupResult(const PathWarmer::Result& warmup) {
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("id")] = flutter::EncodableValue(static_cast<int64_t>(warmup.id));
+    data[flutter::EncodableValue("trigger")] = flutter::EncodableValue(warmup.trigger);
+    data[flutter::EncodableValue("node")] = flutter::EncodableValue(warmup.node);
+    data[flutter::EncodableValue("state")] = flutter::EncodableValue(warmup.state);
+    data[flutter::EncodableValue("attempted")] = flutter::EncodableValue(warmup.attempted);
+    data[flutter::EncodableValue("succeeded")] = flutter::EncodableValue(warmup.succeeded);
+    data[flutter::EncodableValue("coldMs")] = flutter::EncodableValue(warmup.coldMs);
+    data[flutter::EncodableValue("warmMs")] = flutter::EncodableValue(warmup.warmMs);
+    data[flutter::EncodableValue("handshakeMs")] = flutter::EncodableValue(warmup.handshakeMs);
+    data[flutter::EncodableValue("totalMs")] = flutter::EncodableValue(warmup.totalMs);
+    data[flutter::EncodableValue("error")] = flutter::EncodableValue(warmup.error);
+    return data;
+}
+
+flutter::EncodableMap EncodeTraceStatus(const ControllerTrace::Status& status) {
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("recording")] = flutter::EncodableValue(status.recording);
+    data[flutter::EncodableValue("path")] = flutter::EncodableValue(status.path);
+    data[flutter::EncodableValue("records")] = flutter::EncodableValue(status.records);
+    data[flutter::EncodableValue("bytes")] = flutter::EncodableValue(status.bytes);
+    data[flutter::EncodableValue("dropped")] = flutter::EncodableValue(status.dropped);
+    data[flutter::EncodableValue("redact")] = flutter::EncodableValue(status.redact);
+    return data;
+}
+
+flutter::EncodableMap EncodeSoakSample(const SoakTest::Sample& sample) {
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("cycle")] = flutter::EncodableValue(sample.cycle);
+    data[flutter::EncodableValue("workingSet")] = flutter::EncodableValue(sample.workingSet);
+    data[flutter::EncodableValue("privateBytes")] = flutter::EncodableValue(sample.privateBytes);
+    data[flutter::EncodableValue("handles")] = flutter::EncodableValue(sample.handles);
+    data[flutter::EncodableValue("threads")] = flutter::EncodableValue(sample.threads);
+    data[flutter::EncodableValue("poolPending")] = flutter::EncodableValue(sample.poolPending);
+    data[flutter::EncodableValue("streams")] = flutter::EncodableValue(sample.streams);
+    return data;
+}
+
+flutter::EncodableMap EncodeConnectionSummary(const ConnectionStats::Summary& summary) {
+    flutter::EncodableList durations;
+    for (int64_t count : summary.durations) durations.push_back(flutter::EncodableValue(count));
+    flutter::EncodableList bytes;
+    for (int64_t count : summary.bytes) bytes.push_back(flutter::EncodableValue(count));
+
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("key")] = flutter::EncodableValue(summary.key);
+    data[flutter::EncodableValue("topProcess")] = flutter::EncodableValue(summary.topProcess);
+    data[flutter::EncodableValue("opened")] = flutter::EncodableValue(summary.opened);
+    data[flutter::EncodableValue("closed")] = flutter::EncodableValue(summary.closed);
+    data[flutter::EncodableValue("active")] = flutter::EncodableValue(summary.active);
+    data[flutter::EncodableValue("openRate")] = flutter::EncodableValue(summary.openRate);
+    data[flutter::EncodableValue("shortLived")] = flutter::EncodableValue(summary.shortLived);
+    data[flutter::EncodableValue("meanDurationMs")] = flutter::EncodableValue(summary.meanDurationMs);
+    data[flutter::EncodableValue("meanBytes")] = flutter::EncodableValue(summary.meanBytes);
+    data[flutter::EncodableValue("durations")] = flutter::EncodableValue(durations);
+    data[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
+    data[flutter::EncodableValue("churning")] = flutter::EncodableValue(summary.churning);
+    data[flutter::EncodableValue("lastSeen")] = flutter::EncodableValue(summary.lastSeen);
+    return data;
+}
+
+flutter::EncodableMap EncodeTopologyChanges(const ProxyTopology::Changes& changes) {
+    flutter::EncodableList groups;
+    for (const auto& group : changes.groups) {
+        flutter::EncodableMap item;
+        item[flutter::EncodableValue("name")] = flutter::EncodableValue(group.name);
+        item[flutter::EncodableValue("type")] = flutter::EncodableValue(group.type);
+        item[flutter::EncodableValue("now")] = flutter::EncodableValue(group.now);
+        item[flutter::EncodableValue("members")] = flutter::EncodableValue(EncodeStringList(group.members));
+        groups.push_back(flutter::EncodableValue(item));
+    }
+    flutter::EncodableMap selections;
+    for (const auto& selection : changes.selections) {
+        selections[flutter::EncodableValue(selection.group)] = flutter::EncodableValue(selection.now);
+    }
+    flutter::EncodableList proxies;
+    for (const auto& proxy : changes.proxies) {
+        flutter::EncodableMap item;
+        item[flutter::EncodableValue("name")] = flutter::EncodableValue(proxy.name);
+        item[flutter::EncodableValue("type")] = flutter::EncodableValue(proxy.type);
+        item[flutter::EncodableValue("delay")] = flutter::EncodableValue(proxy.delay);
+        proxies.push_back(flutter::EncodableValue(item));
+    }
+    flutter::EncodableMap delays;
+    for (const auto& [name, delay] : changes.delays) {
+        delays[flutter::EncodableValue(name)] = flutter::EncodableValue(delay);
+    }
+
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("base")] = flutter::EncodableValue(static_cast<int64_t>(changes.base));
+    data[flutter::EncodableValue("version")] = flutter::EncodableValue(static_cast<int64_t>(changes.version));
+    data[flutter::EncodableValue("groups")] = flutter::EncodableValue(groups);
+    data[flutter::EncodableValue("removedGroups")] = flutter::EncodableValue(EncodeStringList(changes.removedGroups));
+    data[flutter::EncodableValue("selections")] = flutter::EncodableValue(selections);
+    data[flutter::EncodableValue("proxies")] = flutter::EncodableValue(proxies);
+    data[flutter::EncodableValue("removedProxies")] = flutter::EncodableValue(EncodeStringList(changes.removedProxies));
+    data[flutter::EncodableValue("delays")] = flutter::EncodableValue(delays);
+    return data;
+}
+
+flutter::EncodableMap EncodeDnsStats(const DnsBenchmark::Stats& stats) {
+    flutter::EncodableList histogram;
+    for (int count : stats.histogram) histogram.push_back(flutter::EncodableValue(count));
+
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("queries")] = flutter::EncodableValue(stats.queries);
+    data[flutter::EncodableValue("failures")] = flutter::EncodableValue(stats.failures);
+    data[flutter::EncodableValue("failureRate")] = flutter::EncodableValue(stats.failureRate);
+    data[flutter::EncodableValue("p50")] = flutter::EncodableValue(stats.p50Ms);
+    data[flutter::EncodableValue("p90")] = flutter::EncodableValue(stats.p90Ms);
+    data[flutter::EncodableValue("p99")] = flutter::EncodableValue(stats.p99Ms);
+    data[flutter::EncodableValue("mean")] = flutter::EncodableValue(stats.meanMs);
+    data[flutter::EncodableValue("histogram")] = flutter::EncodableValue(histogram);
+    return data;
+}
+
+flutter::EncodableMap EncodeDnsTarget(const DnsBenchmark::Target& target) {
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("name")] = flutter::EncodableValue(target.name);
+    data[flutter::EncodableValue("section")] = flutter::EncodableValue(target.section);
+    data[flutter::EncodableValue("protocol")] = flutter::EncodableValue(target.protocol);
+    data[flutter::EncodableValue("supported")] = flutter::EncodableValue(target.supported);
+    data[flutter::EncodableValue("cold")] = flutter::EncodableValue(EncodeDnsStats(target.cold));
+    data[flutter::EncodableValue("warm")] = flutter::EncodableValue(EncodeDnsStats(target.warm));
+    data[flutter::EncodableValue("cacheHitRate")] = flutter::EncodableValue(target.cacheHitRate);
+    data[flutter::EncodableValue("score")] = flutter::EncodableValue(target.score);
+    data[flutter::EncodableValue("rank")] = flutter::EncodableValue(target.rank);
+    data[flutter::EncodableValue("error")] = flutter::EncodableValue(target.lastError);
+    return data;
+}
+
+// Coroutine flows started over the channel, so cancelCoreTasks can reach them
+std::mutex g_coreTasksMutex;
+std::map<uint64_t, CancelSource> g_coreTasks;
+uint64_t g_nextCoreTask = 1;
+
+CancelToken BeginCoreTask(int deadlineMs, uint64_t* id) {
+    CancelSource source;
+    if (deadlineMs > 0) source.CancelAfter(deadlineMs);
+    std::lock_guard<std::mutex> lock(g_coreTasksMutex);
+    *id = g_nextCoreTask++;
+    g_coreTasks.emplace(*id, source);
+    return source.Token();
+}
+
+void EndCoreTask(uint64_t id) {
+    std::lock_guard<std::mutex> lock(g_coreTasksMutex);
+    g_coreTasks.erase(id);
+}
+
+// Summary of a sweep; latencies are sent separately, in target order
+flutter::EncodableMap EncodeTcpProbeReport(const TcpProber::Report& report) {
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("backend")] = flutter::EncodableValue(report.backend);
+    data[flutter::EncodableValue("probes")] = flutter::EncodableValue(report.probes);
+    data[flutter::EncodableValue("succeeded")] = flutter::EncodableValue(report.succeeded);
+    data[flutter::EncodableValue("timedOut")] = flutter::EncodableValue(report.timedOut);
+    data[flutter::EncodableValue("resolveMs")] = flutter::EncodableValue(report.resolveMs);
+    data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(report.elapsedMs);
+    data[flutter::EncodableValue("cpuMs")] = flutter::EncodableValue(report.cpuMs);
+    data[flutter::EncodableValue("waits")] = flutter::EncodableValue(report.waits);
+    data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+    return data;
+}
+
+// Self-check reports share one shape: passed, checks(name, passed, detail),
+// elapsed and error
+template <typename Report>
+flutter::EncodableMap EncodeCheckReport(const Report& report) {
+    flutter::EncodableList checks;
+    for (const auto& check : report.checks) {
+        flutter::EncodableMap item;
+        item[flutter::EncodableValue("name")] = flutter::EncodableValue(check.name);
+        item[flutter::EncodableValue("passed")] = flutter::EncodableValue(check.passed);
+        item[flutter::EncodableValue("detail")] = flutter::EncodableValue(check.detail);
+        checks.push_back(flutter::EncodableValue(item));
+    }
+
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("passed")] = flutter::EncodableValue(report.passed);
+    data[flutter::EncodableValue("checks")] = flutter::EncodableValue(checks);
+    data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(report.elapsedMs);
+    data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+    return data;
+}
+
+}  // namespace
 
 void PlatformChannel::Register(flutter::FlutterEngine* engine) {
+    // Start recording before anything else can fail
+    FlightRecorder::GetInstance().Init(GetConfigDirectory());
+
+    // Register runs on the platform thread, so the window's messages do too
+    WNDCLASSW windowClass = {};
+    windowClass.lpfnWndProc = PlatformWindowProc;
+    windowClass.hInstance = GetModuleHandleW(nullptr);
+    windowClass.lpszClassName = L"VortexPlatformTasks";
+    RegisterClassW(&windowClass);
+    platform_window_ = CreateWindowExW(0, windowClass.lpszClassName, L"", 0, 0, 0, 0, 0,
+                                       HWND_MESSAGE, nullptr, windowClass.hInstance, nullptr);
+
     // Method Channel
     auto method_channel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
         engine->messenger(), "com.vortex.app/core",
@@ -36,7 +540,13 @@ void PlatformChannel::Register(flutter::FlutterEngine* engine) {
         [](const flutter::EncodableValue* arguments,
            std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
             -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
-            event_sink_ = std::move(events);
+            {
+                std::lock_guard<std::mutex> lock(event_mutex_);
+                event_sink_ = std::move(events);
+            }
+
+            // Bring the new listener up to date before any live event
+            ReplayCachedEvents();
 
             // Setup callbacks from MihomoCore
             auto& core = MihomoCore::GetInstance();
@@ -62,18 +572,53 @@ void PlatformChannel::Register(flutter::FlutterEngine* engine) {
                 SendEvent("error", flutter::EncodableValue(error));
             });
 
+            core.SetSupervisorCallback([](const MihomoCore::SupervisorEvent& event) {
+                flutter::EncodableMap data;
+                data[flutter::EncodableValue("type")] = flutter::EncodableValue(event.type);
+                data[flutter::EncodableValue("limitBytes")] = flutter::EncodableValue(event.limitBytes);
+                data[flutter::EncodableValue("peakBytes")] = flutter::EncodableValue(event.peakBytes);
+                data[flutter::EncodableValue("exitCode")] = flutter::EncodableValue(event.exitCode);
+                data[flutter::EncodableValue("attempt")] = flutter::EncodableValue(event.attempt);
+                data[flutter::EncodableValue("delay")] = flutter::EncodableValue(event.delayMs);
+                SendEvent("core_supervisor", flutter::EncodableValue(data));
+            });
+
+            SubscriptionPipeline::GetInstance().SetMergeCallback(
+                [](const SubscriptionPipeline::Result& merged) {
+                    SendEvent("subscriptions_merged", flutter::EncodableValue(
+                        EncodeNodeDiff(merged.diff, merged.nodes.size())));
+                });
+
+            MemoryMonitor::GetInstance().SetPressureCallback(
+                [](const MemoryMonitor::Event& event) {
+                    SendEvent("memory_pressure", flutter::EncodableValue(EncodeMemoryEvent(event)));
+                });
+
+            PathWarmer::GetInstance().SetCallback([](const PathWarmer::Result& warmup) {
+                SendEvent("path_warmup", flutter::EncodableValue(EncodeWarmupResult(warmup)));
+            });
+
+            ConnectionStats::GetInstance().SetCallback([](const ConnectionStats::ChurnEvent& event) {
+                flutter::EncodableMap data = EncodeConnectionSummary(event.summary);
+                data[flutter::EncodableValue("group")] = flutter::EncodableValue(
+                    event.group == ConnectionStats::Group::Host ? "host" : "process");
+                SendEvent("connection_churn", flutter::EncodableValue(data));
+            });
+
+            ProxyTopology::GetInstance().SetCallback([](const ProxyTopology::Changes& changes) {
+                SendEvent("proxy_topology", flutter::EncodableValue(EncodeTopologyChanges(changes)));
+            });
+
             return nullptr;
         },
         [](const flutter::EncodableValue* arguments)
             -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            // Callbacks stay installed: SendEvent only fills the replay
+            // cache while there is no sink, so the next listener starts
+            // from the latest values rather than from whatever was current
+            // when this one left
+            std::lock_guard<std::mutex> lock(event_mutex_);
             event_sink_ = nullptr;
-
-            auto& core = MihomoCore::GetInstance();
-            core.SetStateCallback(nullptr);
-            core.SetTrafficCallback(nullptr);
-            core.SetLogCallback(nullptr);
-            core.SetErrorCallback(nullptr);
-
             return nullptr;
         });
 
@@ -82,6 +627,27 @@ void PlatformChannel::Register(flutter::FlutterEngine* engine) {
     // Initialize MihomoCore
     auto& core = MihomoCore::GetInstance();
     core.Init(GetConfigDirectory());
+
+    EndpointRacer::GetInstance().Init(GetConfigDirectory());
+    RuleStats::GetInstance().Init(GetConfigDirectory());
+
+    // Release native caches when the system runs low on memory
+    auto& memory = MemoryMonitor::GetInstance();
+    memory.AddTrimHandler("subscriptions", []() {
+        return SubscriptionPipeline::GetInstance().TrimCache();
+    });
+    memory.AddTrimHandler("replay_logs", []() { return TrimCachedEvents(); });
+    memory.AddTrimHandler("controller_streams", []() {
+        return ControllerStreams::GetInstance().Trim();
+    });
+    memory.AddTrimHandler("tracer", []() { return Tracer::Trim(); });
+    memory.AddTrimHandler("proxy_topology", []() {
+        return ProxyTopology::GetInstance().Trim();
+    });
+    memory.AddTrimHandler("connection_stats", []() {
+        return ConnectionStats::GetInstance().Trim();
+    });
+    memory.Start();
 }
 
 void PlatformChannel::HandleMethodCall(
@@ -92,6 +658,29 @@ void PlatformChannel::HandleMethodCall(
     const auto* arguments = method_call.arguments();
     auto& core = MihomoCore::GetInstance();
 
+    FlightRecorder::Record(FlightRecorder::Category::Method, FlightRecorder::Level::Info, method);
+
+    // Traced calls carry Dart's context next to their arguments
+    Tracer::Context trace;
+    if (const auto* args = std::get_if<flutter::EncodableMap>(arguments)) {
+        auto trace_it = args->find(flutter::EncodableValue("_trace"));
+        const auto* context = trace_it != args->end()
+            ? std::get_if<flutter::EncodableMap>(&trace_it->second) : nullptr;
+        if (context) {
+            trace = Tracer::FromHex(GetStringArg(*context, "id"), GetStringArg(*context, "parent"));
+        }
+    }
+    Tracer::Span span("channel", method, trace);
+
+    // A running soak test owns the core; the app must not start, stop or
+    // reconfigure it underneath
+    if (SoakTest::IsRunning() &&
+        (method == "startCore" || method == "stopCore" || method == "reloadConfig" ||
+         method == "switchProxy" || method == "hotSwap")) {
+        result->Error("SOAK_RUNNING", "A soak test is driving the core");
+        return;
+    }
+
     if (method == "startCore") {
         const auto* args = std::get_if<flutter::EncodableMap>(arguments);
         if (args) {
@@ -104,6 +693,7 @@ void PlatformChannel::HandleMethodCall(
                 core.StartAsync(configPath, [result = std::move(result)](bool success) mutable {
                     // This callback runs in background thread
                     // Flutter MethodResult is thread-safe
+                    if (success) ProxyTopology::GetInstance().RequestRefresh();
                     result->Success(flutter::EncodableValue(success));
                 });
                 return;
@@ -112,8 +702,11 @@ void PlatformChannel::HandleMethodCall(
         result->Success(flutter::EncodableValue(false));
 
     } else if (method == "stopCore") {
-        bool success = core.Stop();
-        result->Success(flutter::EncodableValue(success));
+        // Stop waits for a start or supervised restart in progress
+        std::thread([result = std::move(result)]() mutable {
+            bool success = MihomoCore::GetInstance().Stop();
+            result->Success(flutter::EncodableValue(success));
+        }).detach();
 
     } else if (method == "reloadConfig") {
         const auto* args = std::get_if<flutter::EncodableMap>(arguments);
@@ -122,6 +715,7 @@ void PlatformChannel::HandleMethodCall(
             if (config_it != args->end()) {
                 std::string configPath = std::get<std::string>(config_it->second);
                 bool success = core.ReloadConfig(configPath);
+                if (success) ProxyTopology::GetInstance().RequestRefresh();
                 result->Success(flutter::EncodableValue(success));
                 return;
             }
@@ -195,8 +789,12 @@ void PlatformChannel::HandleMethodCall(
                 timeout = std::get<int>(timeout_it->second);
             }
 
-            int delay = core.TestDelay(proxy, url, timeout);
-            result->Success(flutter::EncodableValue(delay));
+            // Waits up to timeout for the core; keep it off the platform thread
+            std::thread([proxy, url, timeout, result = std::move(result)]() mutable {
+                int delay = MihomoCore::GetInstance().TestDelay(proxy, url, timeout);
+                ProxyTopology::GetInstance().RequestRefresh();
+                result->Success(flutter::EncodableValue(delay));
+            }).detach();
             return;
         }
         result->Success(flutter::EncodableValue(-1));
@@ -217,6 +815,7 @@ void PlatformChannel::HandleMethodCall(
             }
 
             bool success = core.SwitchProxy(selector, proxy);
+            if (success) ProxyTopology::GetInstance().RequestRefresh();
             result->Success(flutter::EncodableValue(success));
             return;
         }
@@ -274,6 +873,967 @@ void PlatformChannel::HandleMethodCall(
         // Windows doesn't have app settings page
         result->Success(flutter::EncodableValue(true));
 
+    } else if (method == "raceEndpoints") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args) {
+            result->Success(flutter::EncodableValue());
+            return;
+        }
+
+        std::vector<std::string> endpoints = GetStringListArg(*args, "endpoints");
+        EndpointRacer::Options options;
+        options.probePath = GetStringArg(*args, "probePath");
+        options.requiredKeys = GetStringListArg(*args, "requiredKeys");
+        options.userAgent = GetStringArg(*args, "userAgent", options.userAgent);
+        options.timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", options.timeoutMs));
+        options.staggerMs = static_cast<int>(GetIntArg(*args, "stagger", options.staggerMs));
+
+        // Racing blocks for up to one timeout, keep it off the platform thread
+        std::thread([endpoints, options, result = std::move(result)]() mutable {
+            auto race = EndpointRacer::GetInstance().Race(endpoints, options);
+
+            flutter::EncodableList attempts;
+            for (const auto& attempt : race.attempts) {
+                flutter::EncodableMap item;
+                item[flutter::EncodableValue("url")] = flutter::EncodableValue(attempt.url);
+                item[flutter::EncodableValue("order")] = flutter::EncodableValue(attempt.order);
+                item[flutter::EncodableValue("started")] = flutter::EncodableValue(attempt.started);
+                item[flutter::EncodableValue("valid")] = flutter::EncodableValue(attempt.valid);
+                item[flutter::EncodableValue("cancelled")] = flutter::EncodableValue(attempt.cancelled);
+                item[flutter::EncodableValue("statusCode")] = flutter::EncodableValue(attempt.statusCode);
+                item[flutter::EncodableValue("startOffset")] = flutter::EncodableValue(attempt.startOffsetMs);
+                item[flutter::EncodableValue("latency")] = flutter::EncodableValue(attempt.latencyMs);
+                item[flutter::EncodableValue("error")] = flutter::EncodableValue(attempt.error);
+                attempts.push_back(flutter::EncodableValue(item));
+            }
+
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("winner")] = flutter::EncodableValue(race.winner);
+            data[flutter::EncodableValue("url")] = flutter::EncodableValue(race.url);
+            data[flutter::EncodableValue("latency")] = flutter::EncodableValue(race.latencyMs);
+            data[flutter::EncodableValue("total")] = flutter::EncodableValue(race.totalMs);
+            data[flutter::EncodableValue("attempts")] = flutter::EncodableValue(attempts);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "getEndpointHealth") {
+        flutter::EncodableList entries;
+        for (const auto& health : EndpointRacer::GetInstance().GetHealth()) {
+            flutter::EncodableMap item;
+            item[flutter::EncodableValue("url")] = flutter::EncodableValue(health.url);
+            item[flutter::EncodableValue("successes")] = flutter::EncodableValue(health.successes);
+            item[flutter::EncodableValue("failures")] = flutter::EncodableValue(health.failures);
+            item[flutter::EncodableValue("consecutiveFailures")] = flutter::EncodableValue(health.consecutiveFailures);
+            item[flutter::EncodableValue("latency")] = flutter::EncodableValue(static_cast<int64_t>(health.latencyMs));
+            item[flutter::EncodableValue("lastSuccess")] = flutter::EncodableValue(health.lastSuccess);
+            item[flutter::EncodableValue("lastFailure")] = flutter::EncodableValue(health.lastFailure);
+            entries.push_back(flutter::EncodableValue(item));
+        }
+        result->Success(flutter::EncodableValue(entries));
+
+    } else if (method == "resetEndpointHealth") {
+        EndpointRacer::GetInstance().ResetHealth();
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "checkEndpointRacer") {
+        // The stand-in races take a few seconds; keep them off the platform thread
+        std::string workDir = GetConfigDirectory() + "\\racer_check";
+        CreateDirectoryA(workDir.c_str(), nullptr);
+        std::thread([workDir, result = std::move(result)]() mutable {
+            auto report = EndpointRacer::SelfCheck(workDir);
+            result->Success(flutter::EncodableValue(EncodeCheckReport(report)));
+        }).detach();
+
+    } else if (method == "checkCoreContainment") {
+        // Runs the allocating stub several times; keep it off the platform thread
+        std::thread([result = std::move(result)]() mutable {
+            auto report = MihomoCore::CheckContainment();
+            result->Success(flutter::EncodableValue(EncodeCheckReport(report)));
+        }).detach();
+
+    } else if (method == "fetchSubscriptions") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args) {
+            result->Success(flutter::EncodableValue());
+            return;
+        }
+
+        std::vector<std::string> urls = GetStringListArg(*args, "urls");
+        std::vector<std::string> tags = GetStringListArg(*args, "tags");
+        std::vector<SubscriptionPipeline::Source> sources;
+        for (size_t i = 0; i < urls.size(); i++) {
+            sources.push_back({urls[i], i < tags.size() ? tags[i] : std::string()});
+        }
+        SubscriptionPipeline::Options options;
+        options.userAgent = GetStringArg(*args, "userAgent", options.userAgent);
+        options.timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", options.timeoutMs));
+
+        std::thread([sources, options, result = std::move(result)]() mutable {
+            auto merged = SubscriptionPipeline::GetInstance().Run(sources, options);
+
+            flutter::EncodableList nodes;
+            for (const auto& node : merged.nodes) {
+                nodes.push_back(flutter::EncodableValue(EncodeNodeRecord(node)));
+            }
+            flutter::EncodableList sourceResults;
+            for (const auto& source : merged.sources) {
+                flutter::EncodableMap item;
+                item[flutter::EncodableValue("url")] = flutter::EncodableValue(source.url);
+                item[flutter::EncodableValue("tag")] = flutter::EncodableValue(source.tag);
+                item[flutter::EncodableValue("format")] = flutter::EncodableValue(source.format);
+                item[flutter::EncodableValue("error")] = flutter::EncodableValue(source.error);
+                item[flutter::EncodableValue("statusCode")] = flutter::EncodableValue(source.statusCode);
+                item[flutter::EncodableValue("bytes")] = flutter::EncodableValue(source.bytes);
+                item[flutter::EncodableValue("firstByte")] = flutter::EncodableValue(source.firstByteMs);
+                item[flutter::EncodableValue("fetch")] = flutter::EncodableValue(source.fetchMs);
+                item[flutter::EncodableValue("done")] = flutter::EncodableValue(source.doneMs);
+                item[flutter::EncodableValue("nodes")] = flutter::EncodableValue(static_cast<int64_t>(source.nodes));
+                item[flutter::EncodableValue("stale")] = flutter::EncodableValue(source.stale);
+                sourceResults.push_back(flutter::EncodableValue(item));
+            }
+
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("nodes")] = flutter::EncodableValue(nodes);
+            data[flutter::EncodableValue("sources")] = flutter::EncodableValue(sourceResults);
+            data[flutter::EncodableValue("diff")] = flutter::EncodableValue(
+                EncodeNodeDiff(merged.diff, merged.nodes.size()));
+            data[flutter::EncodableValue("duplicates")] = flutter::EncodableValue(static_cast<int64_t>(merged.duplicates));
+            data[flutter::EncodableValue("total")] = flutter::EncodableValue(merged.totalMs);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "parseClashYaml") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args) {
+            result->Success(flutter::EncodableValue());
+            return;
+        }
+        std::string content = GetStringArg(*args, "content");
+        std::string source = GetStringArg(*args, "source");
+
+        // Goes through the pipeline so the imported nodes become the table
+        // the next subscription refresh is diffed against
+        std::thread([content = std::move(content), source, result = std::move(result)]() mutable {
+            ClashYamlReader::Stats stats;
+            auto imported = SubscriptionPipeline::GetInstance().Import(
+                content, source, SubscriptionPipeline::Options(), &stats);
+            if (!imported.sources[0].error.empty()) {
+                result->Success(flutter::EncodableValue());
+                return;
+            }
+
+            flutter::EncodableList nodes;
+            for (const auto& node : imported.nodes) {
+                nodes.push_back(flutter::EncodableValue(EncodeNodeRecord(node)));
+            }
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("nodes")] = flutter::EncodableValue(nodes);
+            data[flutter::EncodableValue("diff")] = flutter::EncodableValue(
+                EncodeNodeDiff(imported.diff, imported.nodes.size()));
+            data[flutter::EncodableValue("items")] = flutter::EncodableValue(static_cast<int64_t>(stats.items));
+            data[flutter::EncodableValue("parsed")] = flutter::EncodableValue(static_cast<int64_t>(stats.nodes));
+            data[flutter::EncodableValue("anchors")] = flutter::EncodableValue(static_cast<int64_t>(stats.anchors));
+            data[flutter::EncodableValue("bytes")] = flutter::EncodableValue(stats.bytes);
+            data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(imported.totalMs);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "benchmarkClashYaml") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        size_t count = static_cast<size_t>(args ? std::max<int64_t>(1, GetIntArg(*args, "count", 10000)) : 10000);
+
+        std::thread([count, result = std::move(result)]() {
+            flutter::EncodableList runs;
+            for (const auto& run : ClashYamlReader::Benchmark(count)) {
+                flutter::EncodableMap item;
+                item[flutter::EncodableValue("style")] = flutter::EncodableValue(run.style);
+                item[flutter::EncodableValue("bytes")] = flutter::EncodableValue(run.bytes);
+                item[flutter::EncodableValue("proxies")] = flutter::EncodableValue(static_cast<int64_t>(run.proxies));
+                item[flutter::EncodableValue("nodes")] = flutter::EncodableValue(static_cast<int64_t>(run.nodes));
+                item[flutter::EncodableValue("elapsedMs")] = flutter::EncodableValue(run.elapsedMs);
+                item[flutter::EncodableValue("mbPerSec")] = flutter::EncodableValue(run.mbPerSec);
+                runs.push_back(flutter::EncodableValue(item));
+            }
+            result->Success(flutter::EncodableValue(runs));
+        }).detach();
+
+    } else if (method == "serializeProxies") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        const flutter::EncodableList* list = nullptr;
+        if (args) {
+            auto it = args->find(flutter::EncodableValue("nodes"));
+            if (it != args->end()) list = std::get_if<flutter::EncodableList>(&it->second);
+        }
+        if (!list) {
+            result->Success(flutter::EncodableValue());
+            return;
+        }
+
+        std::string yaml;
+        flutter::EncodableList names;
+        flutter::EncodableList errors;
+        for (const auto& entry : *list) {
+            const auto* item = std::get_if<flutter::EncodableMap>(&entry);
+            if (!item) continue;
+            std::vector<std::string> dropped;
+            NodeRecord node = DecodeNodeRecord(*item, &dropped);
+            std::string error;
+            if (ProxySchema::Serialize(node, &yaml, &error)) {
+                names.push_back(flutter::EncodableValue(node.name));
+                // Written, but without these settings
+                for (const auto& key : dropped) {
+                    flutter::EncodableMap warning;
+                    warning[flutter::EncodableValue("name")] = flutter::EncodableValue(node.name);
+                    warning[flutter::EncodableValue("type")] = flutter::EncodableValue(node.type);
+                    warning[flutter::EncodableValue("error")] = flutter::EncodableValue(
+                        key + ": nested map dropped");
+                    warning[flutter::EncodableValue("warning")] = flutter::EncodableValue(true);
+                    errors.push_back(flutter::EncodableValue(warning));
+                }
+            } else {
+                flutter::EncodableMap failure;
+                failure[flutter::EncodableValue("name")] = flutter::EncodableValue(node.name);
+                failure[flutter::EncodableValue("type")] = flutter::EncodableValue(node.type);
+                failure[flutter::EncodableValue("error")] = flutter::EncodableValue(error);
+                errors.push_back(flutter::EncodableValue(failure));
+            }
+        }
+        flutter::EncodableMap data;
+        data[flutter::EncodableValue("yaml")] = flutter::EncodableValue(yaml);
+        data[flutter::EncodableValue("names")] = flutter::EncodableValue(names);
+        data[flutter::EncodableValue("errors")] = flutter::EncodableValue(errors);
+        result->Success(flutter::EncodableValue(data));
+
+    } else if (method == "setCoreLimits") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        CoreJob::Limits limits;
+        if (args) {
+            limits.memoryMb = GetIntArg(*args, "memoryMb", 0);
+            limits.cpuPercent = static_cast<int>(GetIntArg(*args, "cpuPercent", 0));
+        }
+        // Waits for a start or stop in progress
+        std::thread([limits, result = std::move(result)]() mutable {
+            result->Success(flutter::EncodableValue(MihomoCore::GetInstance().SetResourceLimits(limits)));
+        }).detach();
+
+    } else if (method == "getCoreLimits") {
+        CoreJob::Limits limits = core.GetResourceLimits();
+        flutter::EncodableMap data;
+        data[flutter::EncodableValue("memoryMb")] = flutter::EncodableValue(limits.memoryMb);
+        data[flutter::EncodableValue("cpuPercent")] = flutter::EncodableValue(limits.cpuPercent);
+        result->Success(flutter::EncodableValue(data));
+
+    } else if (method == "configurePathWarmup") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        auto options = PathWarmer::GetInstance().GetOptions();
+        options.enabled = GetBoolArg(*args, "enabled", options.enabled);
+        options.timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", options.timeoutMs));
+        if (args->find(flutter::EncodableValue("targets")) != args->end()) {
+            options.targets = GetStringListArg(*args, "targets");
+        }
+        PathWarmer::GetInstance().SetOptions(options);
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "warmPath") {
+        // Returns once the warmup has started; progress arrives as path_warmup events
+        std::string node;
+        if (const auto* args = std::get_if<flutter::EncodableMap>(arguments)) {
+            node = GetStringArg(*args, "node");
+        }
+        bool started = core.IsRunning() &&
+                       PathWarmer::GetInstance().Warm("switch", node, core.GetProxyPort());
+        result->Success(flutter::EncodableValue(started));
+
+    } else if (method == "getPathWarmup") {
+        result->Success(flutter::EncodableValue(
+            EncodeWarmupResult(PathWarmer::GetInstance().GetLastResult())));
+
+    } else if (method == "setScoredNodes") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        const flutter::EncodableList* list = nullptr;
+        if (args) {
+            auto it = args->find(flutter::EncodableValue("nodes"));
+            if (it != args->end()) list = std::get_if<flutter::EncodableList>(&it->second);
+        }
+        if (!list) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        std::vector<NodeScorer::NodeInfo> nodes;
+        nodes.reserve(list->size());
+        for (const auto& item : *list) {
+            const auto* node = std::get_if<flutter::EncodableMap>(&item);
+            if (!node) continue;
+            NodeScorer::NodeInfo info;
+            info.id = GetStringArg(*node, "id");
+            info.name = GetStringArg(*node, "name");
+            info.multiplier = GetDoubleArg(*node, "multiplier", 1.0);
+            nodes.push_back(std::move(info));
+        }
+        NodeScorer::GetInstance().SetNodes(nodes);
+        result->Success(flutter::EncodableValue(static_cast<int64_t>(nodes.size())));
+
+    } else if (method == "addNodeSamples") {
+        // [{id, latency?, throughput?}]; latency <= 0 is a failed test and
+        // throughput is in bytes per second
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        const flutter::EncodableList* list = nullptr;
+        if (args) {
+            auto it = args->find(flutter::EncodableValue("samples"));
+            if (it != args->end()) list = std::get_if<flutter::EncodableList>(&it->second);
+        }
+        if (!list) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        auto& scorer = NodeScorer::GetInstance();
+        for (const auto& item : *list) {
+            const auto* sample = std::get_if<flutter::EncodableMap>(&item);
+            if (!sample) continue;
+            std::string id = GetStringArg(*sample, "id");
+            if (sample->find(flutter::EncodableValue("latency")) != sample->end()) {
+                scorer.AddLatencySample(id, GetIntArg(*sample, "latency", -1));
+            }
+            if (sample->find(flutter::EncodableValue("throughput")) != sample->end()) {
+                scorer.AddThroughputSample(id, GetDoubleArg(*sample, "throughput", -1));
+            }
+        }
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "setScoreWeights") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        auto weights = NodeScorer::GetInstance().GetWeights();
+        weights.latency = GetDoubleArg(*args, "latency", weights.latency);
+        weights.jitter = GetDoubleArg(*args, "jitter", weights.jitter);
+        weights.loss = GetDoubleArg(*args, "loss", weights.loss);
+        weights.throughput = GetDoubleArg(*args, "throughput", weights.throughput);
+        weights.multiplier = GetDoubleArg(*args, "multiplier", weights.multiplier);
+        NodeScorer::GetInstance().SetWeights(weights);
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "getTopNodes") {
+        size_t limit = 10;
+        if (const auto* args = std::get_if<flutter::EncodableMap>(arguments)) {
+            limit = static_cast<size_t>(std::max<int64_t>(GetIntArg(*args, "limit", 10), 0));
+        }
+        flutter::EncodableList list;
+        for (const auto& ranked : NodeScorer::GetInstance().GetTop(limit)) {
+            flutter::EncodableMap item;
+            item[flutter::EncodableValue("id")] = flutter::EncodableValue(ranked.id);
+            item[flutter::EncodableValue("name")] = flutter::EncodableValue(ranked.name);
+            item[flutter::EncodableValue("rank")] = flutter::EncodableValue(ranked.rank);
+            item[flutter::EncodableValue("score")] = flutter::EncodableValue(ranked.score);
+            item[flutter::EncodableValue("p50")] = flutter::EncodableValue(ranked.p50Ms);
+            item[flutter::EncodableValue("p90")] = flutter::EncodableValue(ranked.p90Ms);
+            item[flutter::EncodableValue("loss")] = flutter::EncodableValue(ranked.loss);
+            item[flutter::EncodableValue("throughputMbps")] = flutter::EncodableValue(ranked.throughputMbps);
+            item[flutter::EncodableValue("multiplier")] = flutter::EncodableValue(ranked.multiplier);
+            item[flutter::EncodableValue("samples")] = flutter::EncodableValue(ranked.samples);
+            list.push_back(flutter::EncodableValue(item));
+        }
+        result->Success(flutter::EncodableValue(list));
+
+    } else if (method == "getBestNode") {
+        std::string best = NodeScorer::GetInstance().GetBest();
+        result->Success(best.empty() ? flutter::EncodableValue() : flutter::EncodableValue(best));
+
+    } else if (method == "resetNodeScores") {
+        NodeScorer::GetInstance().Reset();
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "probeChain") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args || GetStringArg(*args, "target").empty()) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        std::string target = GetStringArg(*args, "target");
+        std::string url = GetStringArg(*args, "url", "http://www.gstatic.com/generate_204");
+        int timeout = static_cast<int>(GetIntArg(*args, "timeout", 5000));
+        int samples = static_cast<int>(GetIntArg(*args, "samples", 3));
+
+        // Each hop takes several delay tests; keep them off the platform thread
+        std::thread([target, url, timeout, samples, result = std::move(result)]() mutable {
+            auto probe = ChainProber::Probe(target, url, timeout, samples);
+
+            flutter::EncodableList hops;
+            for (const auto& hop : probe.hops) {
+                flutter::EncodableMap item;
+                item[flutter::EncodableValue("name")] = flutter::EncodableValue(hop.name);
+                item[flutter::EncodableValue("type")] = flutter::EncodableValue(hop.type);
+                item[flutter::EncodableValue("dialer")] = flutter::EncodableValue(hop.dialer);
+                item[flutter::EncodableValue("standalone")] = flutter::EncodableValue(hop.standaloneMs);
+                item[flutter::EncodableValue("standaloneStart")] = flutter::EncodableValue(hop.standaloneStart);
+                item[flutter::EncodableValue("cumulative")] = flutter::EncodableValue(hop.cumulativeMs);
+                item[flutter::EncodableValue("leg")] = flutter::EncodableValue(hop.legMs);
+                item[flutter::EncodableValue("legStart")] = flutter::EncodableValue(hop.legStart);
+                hops.push_back(flutter::EncodableValue(item));
+            }
+
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("target")] = flutter::EncodableValue(probe.target);
+            data[flutter::EncodableValue("hops")] = flutter::EncodableValue(hops);
+            data[flutter::EncodableValue("total")] = flutter::EncodableValue(probe.totalMs);
+            data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(probe.elapsedMs);
+            data[flutter::EncodableValue("error")] = flutter::EncodableValue(probe.error);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "benchmarkDns") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        DnsBenchmark::Options options;
+        if (args) {
+            options.domains = GetStringListArg(*args, "domains");
+            options.type = GetStringArg(*args, "type", "A");
+            options.concurrency = static_cast<int>(GetIntArg(*args, "concurrency", options.concurrency));
+            options.timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", options.timeoutMs));
+            options.direct = GetBoolArg(*args, "direct", true);
+            options.nameservers = GetStringListArg(*args, "nameservers");
+        }
+
+        // Two passes per resolver, each bounded by the timeout
+        std::thread([options, result = std::move(result)]() mutable {
+            auto report = DnsBenchmark::Run(options);
+
+            flutter::EncodableList nameservers;
+            for (const auto& target : report.nameservers) {
+                nameservers.push_back(flutter::EncodableValue(EncodeDnsTarget(target)));
+            }
+            flutter::EncodableList bounds;
+            for (int bound : DnsBenchmark::HistogramBounds()) bounds.push_back(flutter::EncodableValue(bound));
+
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("core")] = flutter::EncodableValue(EncodeDnsTarget(report.core));
+            data[flutter::EncodableValue("nameservers")] = flutter::EncodableValue(nameservers);
+            data[flutter::EncodableValue("histogramBounds")] = flutter::EncodableValue(bounds);
+            data[flutter::EncodableValue("domains")] = flutter::EncodableValue(report.domains);
+            data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(report.elapsedMs);
+            data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "tcpPing") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        std::vector<TcpProber::Target> targets;
+        TcpProber::Options options;
+        if (args) {
+            // "host:port", with IPv6 hosts optionally in brackets
+            for (const auto& entry : GetStringListArg(*args, "targets")) {
+                size_t colon = entry.rfind(':');
+                TcpProber::Target target;
+                if (colon != std::string::npos) {
+                    target.host = entry.substr(0, colon);
+                    target.port = atoi(entry.c_str() + colon + 1);
+                }
+                if (target.host.size() >= 2 && target.host.front() == '[' && target.host.back() == ']') {
+                    target.host = target.host.substr(1, target.host.size() - 2);
+                }
+                targets.push_back(target);
+            }
+            options.timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", options.timeoutMs));
+            options.concurrency = static_cast<int>(GetIntArg(*args, "concurrency", options.concurrency));
+            options.backend = TcpProber::ParseBackend(GetStringArg(*args, "backend", "auto"));
+        }
+
+        std::thread([targets = std::move(targets), options, result = std::move(result)]() mutable {
+            auto report = TcpProber::Probe(targets, options);
+
+            flutter::EncodableList latencies;
+            for (const auto& probe : report.results) latencies.push_back(flutter::EncodableValue(probe.latencyMs));
+
+            flutter::EncodableMap data = EncodeTcpProbeReport(report);
+            data[flutter::EncodableValue("latencies")] = flutter::EncodableValue(latencies);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "benchmarkTcpPing") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        std::vector<int> counts;
+        int timeoutMs = 10000;
+        if (args) {
+            auto it = args->find(flutter::EncodableValue("counts"));
+            if (it != args->end()) {
+                if (const auto* list = std::get_if<flutter::EncodableList>(&it->second)) {
+                    for (const auto& value : *list) {
+                        if (const auto* count = std::get_if<int32_t>(&value)) counts.push_back(*count);
+                    }
+                }
+            }
+            timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", timeoutMs));
+        }
+        if (counts.empty()) counts = {1000, 10000};
+
+        std::thread([counts, timeoutMs, result = std::move(result)]() {
+            auto report = TcpProber::Benchmark(counts, timeoutMs);
+
+            flutter::EncodableList runs;
+            for (const auto& run : report.runs) runs.push_back(flutter::EncodableValue(EncodeTcpProbeReport(run)));
+
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("runs")] = flutter::EncodableValue(runs);
+            data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "startControllerTrace") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        std::string path = args ? GetStringArg(*args, "path") : "";
+        bool redact = args ? GetBoolArg(*args, "redact", true) : true;
+        int64_t maxMb = args ? GetIntArg(*args, "maxMb", 256) : 256;
+        if (path.empty()) {
+            path = GetConfigDirectory() + "\\traces\\controller-" +
+                   std::to_string(static_cast<int64_t>(std::time(nullptr))) + ".vxtr";
+        }
+        if (!ControllerTrace::GetInstance().Start(path, redact, maxMb * 1024 * 1024)) {
+            result->Error("TRACE_FAILED", "Cannot create " + path);
+            return;
+        }
+        result->Success(flutter::EncodableValue(EncodeTraceStatus(ControllerTrace::GetInstance().GetStatus())));
+
+    } else if (method == "stopControllerTrace") {
+        result->Success(flutter::EncodableValue(EncodeTraceStatus(ControllerTrace::GetInstance().Stop())));
+
+    } else if (method == "getControllerTrace") {
+        result->Success(flutter::EncodableValue(EncodeTraceStatus(ControllerTrace::GetInstance().GetStatus())));
+
+    } else if (method == "checkControllerTrace") {
+        // In memory and quick; runs on the platform thread
+        result->Success(flutter::EncodableValue(EncodeCheckReport(ControllerTrace::SelfCheck())));
+
+    } else if (method == "runSoakTest") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        SoakTest::Options options;
+        if (args) {
+            options.configPath = GetStringArg(*args, "configPath");
+            options.corePath = GetStringArg(*args, "corePath");
+            options.cycles = static_cast<int>(GetIntArg(*args, "cycles", options.cycles));
+            options.cycleMs = static_cast<int>(GetIntArg(*args, "cycleMs", options.cycleMs));
+            options.selector = GetStringArg(*args, "selector");
+            options.proxies = GetStringListArg(*args, "proxies");
+            options.warmup = GetDoubleArg(*args, "warmup", options.warmup);
+        }
+
+        // Runs for cycles * (cycleMs + start time); progress arrives as events
+        std::thread([options, result = std::move(result)]() mutable {
+            auto report = SoakTest::Run(options, [](const SoakTest::Sample& sample, int total) {
+                flutter::EncodableMap data = EncodeSoakSample(sample);
+                data[flutter::EncodableValue("total")] = flutter::EncodableValue(total);
+                SendEvent("soak_progress", flutter::EncodableValue(data));
+            });
+
+            flutter::EncodableList samples;
+            for (const auto& sample : report.samples) {
+                samples.push_back(flutter::EncodableValue(EncodeSoakSample(sample)));
+            }
+            flutter::EncodableList trends;
+            for (const auto& trend : report.trends) {
+                flutter::EncodableMap entry;
+                entry[flutter::EncodableValue("metric")] = flutter::EncodableValue(trend.metric);
+                entry[flutter::EncodableValue("first")] = flutter::EncodableValue(trend.first);
+                entry[flutter::EncodableValue("last")] = flutter::EncodableValue(trend.last);
+                entry[flutter::EncodableValue("tolerance")] = flutter::EncodableValue(trend.tolerance);
+                entry[flutter::EncodableValue("growing")] = flutter::EncodableValue(trend.growing);
+                trends.push_back(flutter::EncodableValue(entry));
+            }
+
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("samples")] = flutter::EncodableValue(samples);
+            data[flutter::EncodableValue("trends")] = flutter::EncodableValue(trends);
+            data[flutter::EncodableValue("cycles")] = flutter::EncodableValue(report.cycles);
+            data[flutter::EncodableValue("failedStarts")] = flutter::EncodableValue(report.failedStarts);
+            data[flutter::EncodableValue("failedCalls")] = flutter::EncodableValue(report.failedCalls);
+            data[flutter::EncodableValue("streamMessages")] = flutter::EncodableValue(report.streamMessages);
+            data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(report.elapsedMs);
+            data[flutter::EncodableValue("passed")] = flutter::EncodableValue(report.passed);
+            data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "cancelSoakTest") {
+        SoakTest::Cancel();
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "hotSwap") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        CoreAsync::HotSwapOptions options;
+        int deadlineMs = 30000;
+        if (args) {
+            options.configPath = GetStringArg(*args, "configPath");
+            options.selector = GetStringArg(*args, "selector");
+            options.proxy = GetStringArg(*args, "proxy");
+            options.url = GetStringArg(*args, "url", options.url);
+            options.timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", options.timeoutMs));
+            options.warm = GetBoolArg(*args, "warm", options.warm);
+            deadlineMs = static_cast<int>(GetIntArg(*args, "deadline", deadlineMs));
+        }
+
+        uint64_t id;
+        CancelToken token = BeginCoreTask(deadlineMs, &id);
+        std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> reply = std::move(result);
+        CoreAsync::Spawn<CoreAsync::HotSwapReport>(
+            CoreAsync::HotSwap(options, token), [reply, id](CoreAsync::HotSwapReport report) {
+                EndCoreTask(id);
+                ProxyTopology::GetInstance().RequestRefresh();
+                flutter::EncodableMap data;
+                data[flutter::EncodableValue("started")] = flutter::EncodableValue(report.started);
+                data[flutter::EncodableValue("reloaded")] = flutter::EncodableValue(report.reloaded);
+                data[flutter::EncodableValue("switched")] = flutter::EncodableValue(report.switched);
+                data[flutter::EncodableValue("delay")] = flutter::EncodableValue(report.delayMs);
+                data[flutter::EncodableValue("warming")] = flutter::EncodableValue(report.warming);
+                data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(report.elapsedMs);
+                data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+                reply->Success(flutter::EncodableValue(data));
+            });
+
+    } else if (method == "probeDelays") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        CoreAsync::ProbeOptions options;
+        int deadlineMs = 60000;
+        if (args) {
+            options.proxies = GetStringListArg(*args, "proxies");
+            options.url = GetStringArg(*args, "url", options.url);
+            options.timeoutMs = static_cast<int>(GetIntArg(*args, "timeout", options.timeoutMs));
+            options.concurrency = static_cast<int>(GetIntArg(*args, "concurrency", options.concurrency));
+            deadlineMs = static_cast<int>(GetIntArg(*args, "deadline", deadlineMs));
+        }
+
+        uint64_t id;
+        CancelToken token = BeginCoreTask(deadlineMs, &id);
+        std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> reply = std::move(result);
+        CoreAsync::Spawn<CoreAsync::ProbeReport>(
+            CoreAsync::ProbeDelays(options, token), [reply, id](CoreAsync::ProbeReport report) {
+                EndCoreTask(id);
+                ProxyTopology::GetInstance().RequestRefresh();
+                flutter::EncodableList delays;
+                for (int delay : report.delays) delays.push_back(flutter::EncodableValue(delay));
+
+                flutter::EncodableMap data;
+                data[flutter::EncodableValue("delays")] = flutter::EncodableValue(delays);
+                data[flutter::EncodableValue("probed")] = flutter::EncodableValue(report.probed);
+                data[flutter::EncodableValue("elapsed")] = flutter::EncodableValue(report.elapsedMs);
+                data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+                reply->Success(flutter::EncodableValue(data));
+            });
+
+    } else if (method == "getProxyTopology") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        bool refresh = !args || GetBoolArg(*args, "refresh", true);
+        std::thread([result = std::move(result), refresh]() mutable {
+            auto& topology = ProxyTopology::GetInstance();
+            if (refresh) topology.Refresh();
+            result->Success(flutter::EncodableValue(topology.Snapshot()));
+        }).detach();
+
+    } else if (method == "watchProxyTopology") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        int interval = args ? static_cast<int>(GetIntArg(*args, "interval", 30000)) : 30000;
+        ProxyTopology::GetInstance().Watch(interval);
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "unwatchProxyTopology") {
+        ProxyTopology::GetInstance().Unwatch();
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "cancelCoreTasks") {
+        std::map<uint64_t, CancelSource> tasks;
+        {
+            std::lock_guard<std::mutex> lock(g_coreTasksMutex);
+            tasks.swap(g_coreTasks);
+        }
+        for (auto& [id, source] : tasks) source.Cancel();
+        result->Success(flutter::EncodableValue(static_cast<int>(tasks.size())));
+
+    } else if (method == "measureIdleBudget") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        IdleBudget::Options options;
+        if (args) {
+            options.windowMs = static_cast<int>(GetIntArg(*args, "window", options.windowMs));
+            options.requireConnected = GetBoolArg(*args, "requireConnected", true);
+            auto budgets = args->find(flutter::EncodableValue("budgets"));
+            const auto* entries = budgets != args->end()
+                ? std::get_if<flutter::EncodableMap>(&budgets->second) : nullptr;
+            if (entries) {
+                for (const auto& [key, value] : *entries) {
+                    const auto* name = std::get_if<std::string>(&key);
+                    const auto* limits = std::get_if<flutter::EncodableMap>(&value);
+                    if (!name || !limits) continue;
+                    IdleBudget::Budget budget;
+                    budget.wakeupsPerSec = GetDoubleArg(*limits, "wakeups", 0);
+                    budget.cpuPercent = GetDoubleArg(*limits, "cpu", 0);
+                    options.budgets[*name] = budget;
+                }
+            }
+        }
+
+        // Sleeps for the whole window
+        std::thread([options, result = std::move(result)]() mutable {
+            auto report = IdleBudget::Measure(options);
+
+            flutter::EncodableList subsystems;
+            for (const auto& subsystem : report.subsystems) {
+                flutter::EncodableMap entry;
+                entry[flutter::EncodableValue("name")] = flutter::EncodableValue(subsystem.name);
+                entry[flutter::EncodableValue("threads")] = flutter::EncodableValue(subsystem.threads);
+                entry[flutter::EncodableValue("wakeups")] = flutter::EncodableValue(subsystem.wakeupsPerSec);
+                entry[flutter::EncodableValue("cpu")] = flutter::EncodableValue(subsystem.cpuPercent);
+                if (subsystem.hasBudget) {
+                    entry[flutter::EncodableValue("budgetWakeups")] = flutter::EncodableValue(subsystem.budget.wakeupsPerSec);
+                    entry[flutter::EncodableValue("budgetCpu")] = flutter::EncodableValue(subsystem.budget.cpuPercent);
+                }
+                entry[flutter::EncodableValue("overBudget")] = flutter::EncodableValue(subsystem.overBudget);
+                subsystems.push_back(flutter::EncodableValue(entry));
+            }
+
+            flutter::EncodableMap data;
+            data[flutter::EncodableValue("subsystems")] = flutter::EncodableValue(subsystems);
+            data[flutter::EncodableValue("connected")] = flutter::EncodableValue(report.connected);
+            data[flutter::EncodableValue("runnerIo")] = flutter::EncodableValue(report.runnerIoPerSec);
+            data[flutter::EncodableValue("coreIo")] = flutter::EncodableValue(report.coreIoPerSec);
+            data[flutter::EncodableValue("window")] = flutter::EncodableValue(report.windowMs);
+            data[flutter::EncodableValue("passed")] = flutter::EncodableValue(report.passed);
+            data[flutter::EncodableValue("error")] = flutter::EncodableValue(report.error);
+            result->Success(flutter::EncodableValue(data));
+        }).detach();
+
+    } else if (method == "setTracing") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        bool enabled = args && GetBoolArg(*args, "enabled", false);
+        Tracer::SetEnabled(enabled);
+        if (args && GetBoolArg(*args, "clear", false)) Tracer::Clear();
+        result->Success(flutter::EncodableValue(enabled));
+
+    } else if (method == "exportTraceEvents") {
+        result->Success(flutter::EncodableValue(Tracer::ExportChromeJson()));
+
+    } else if (method == "getFlightRecorder") {
+        result->Success(flutter::EncodableValue(FlightRecorder::GetInstance().Decode()));
+
+    } else if (method == "subscribeStream") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        std::string name = GetStringArg(*args, "name");
+        ControllerStreams::StreamOptions options;
+        options.path = GetStringArg(*args, "path");
+        options.mode = GetStringArg(*args, "mode", "latest") == "queue"
+            ? ControllerStreams::Mode::Queue : ControllerStreams::Mode::Latest;
+        options.minIntervalMs = static_cast<int>(GetIntArg(*args, "interval", 0));
+        options.maxPending = static_cast<size_t>(GetIntArg(*args, "maxPending", 256));
+
+        bool ok = ControllerStreams::GetInstance().Subscribe(name, options,
+            [](const ControllerStreams::Batch& batch) {
+                flutter::EncodableList messages;
+                messages.reserve(batch.messages.size());
+                for (const auto& message : batch.messages) {
+                    messages.push_back(flutter::EncodableValue(message));
+                }
+                flutter::EncodableMap data;
+                data[flutter::EncodableValue("name")] = flutter::EncodableValue(batch.name);
+                data[flutter::EncodableValue("messages")] = flutter::EncodableValue(messages);
+                data[flutter::EncodableValue("dropped")] = flutter::EncodableValue(batch.dropped);
+                SendEvent("controller_stream", flutter::EncodableValue(data));
+            });
+        result->Success(flutter::EncodableValue(ok));
+
+    } else if (method == "unsubscribeStream") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (args) {
+            ControllerStreams::GetInstance().Unsubscribe(GetStringArg(*args, "name"));
+        }
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "getStreamStatus") {
+        flutter::EncodableList list;
+        for (const auto& status : ControllerStreams::GetInstance().GetStatus()) {
+            flutter::EncodableMap item;
+            item[flutter::EncodableValue("name")] = flutter::EncodableValue(status.name);
+            item[flutter::EncodableValue("path")] = flutter::EncodableValue(status.path);
+            item[flutter::EncodableValue("state")] = flutter::EncodableValue(status.state);
+            item[flutter::EncodableValue("deflate")] = flutter::EncodableValue(status.deflate);
+            item[flutter::EncodableValue("paused")] = flutter::EncodableValue(status.paused);
+            item[flutter::EncodableValue("messages")] = flutter::EncodableValue(status.messages);
+            item[flutter::EncodableValue("wireBytes")] = flutter::EncodableValue(status.wireBytes);
+            item[flutter::EncodableValue("messageBytes")] = flutter::EncodableValue(status.messageBytes);
+            item[flutter::EncodableValue("dropped")] = flutter::EncodableValue(status.dropped);
+            item[flutter::EncodableValue("reconnects")] = flutter::EncodableValue(status.reconnects);
+            item[flutter::EncodableValue("lastError")] = flutter::EncodableValue(status.lastError);
+            list.push_back(flutter::EncodableValue(item));
+        }
+        result->Success(flutter::EncodableValue(list));
+
+    } else if (method == "getRuleStats") {
+        auto& stats = RuleStats::GetInstance();
+        flutter::EncodableList hits;
+        for (const auto& hit : stats.GetTopHits(50)) {
+            flutter::EncodableMap item;
+            item[flutter::EncodableValue("rule")] = flutter::EncodableValue(hit.rule);
+            item[flutter::EncodableValue("payload")] = flutter::EncodableValue(hit.payload);
+            item[flutter::EncodableValue("hits")] = flutter::EncodableValue(hit.hits);
+            item[flutter::EncodableValue("lastSeen")] = flutter::EncodableValue(hit.lastSeen);
+            hits.push_back(flutter::EncodableValue(item));
+        }
+
+        auto report = stats.GetLastReport();
+        flutter::EncodableMap reportMap;
+        reportMap[flutter::EncodableValue("rules")] = flutter::EncodableValue(report.rules);
+        reportMap[flutter::EncodableValue("runs")] = flutter::EncodableValue(report.runs);
+        reportMap[flutter::EncodableValue("moved")] = flutter::EncodableValue(report.moved);
+        reportMap[flutter::EncodableValue("sampledHits")] = flutter::EncodableValue(report.sampledHits);
+        reportMap[flutter::EncodableValue("depthBefore")] = flutter::EncodableValue(report.depthBefore);
+        reportMap[flutter::EncodableValue("depthAfter")] = flutter::EncodableValue(report.depthAfter);
+
+        auto compiled = RuleCompiler::GetInstance().GetLastReport();
+        flutter::EncodableMap compilerMap;
+        compilerMap[flutter::EncodableValue("rules")] = flutter::EncodableValue(compiled.rules);
+        compilerMap[flutter::EncodableValue("extracted")] = flutter::EncodableValue(compiled.extracted);
+        compilerMap[flutter::EncodableValue("providers")] = flutter::EncodableValue(compiled.providers);
+        compilerMap[flutter::EncodableValue("reused")] = flutter::EncodableValue(compiled.reused);
+        compilerMap[flutter::EncodableValue("compiled")] = flutter::EncodableValue(compiled.compiled);
+        compilerMap[flutter::EncodableValue("binary")] = flutter::EncodableValue(compiled.binary);
+        compilerMap[flutter::EncodableValue("elapsedMs")] = flutter::EncodableValue(compiled.elapsedMs);
+
+        flutter::EncodableMap response;
+        response[flutter::EncodableValue("hits")] = flutter::EncodableValue(hits);
+        response[flutter::EncodableValue("report")] = flutter::EncodableValue(reportMap);
+        response[flutter::EncodableValue("compiler")] = flutter::EncodableValue(compilerMap);
+        result->Success(flutter::EncodableValue(response));
+
+    } else if (method == "resetRuleStats") {
+        RuleStats::GetInstance().Reset();
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "getConnectionStats") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        size_t limit = static_cast<size_t>(args ? GetIntArg(*args, "limit", 20) : 20);
+        auto& stats = ConnectionStats::GetInstance();
+
+        auto encodeList = [](const std::vector<ConnectionStats::Summary>& summaries) {
+            flutter::EncodableList list;
+            for (const auto& summary : summaries) {
+                list.push_back(flutter::EncodableValue(EncodeConnectionSummary(summary)));
+            }
+            return list;
+        };
+        flutter::EncodableList durationBounds;
+        for (int64_t bound : ConnectionStats::DurationBounds()) durationBounds.push_back(flutter::EncodableValue(bound));
+        flutter::EncodableList bytesBounds;
+        for (int64_t bound : ConnectionStats::BytesBounds()) bytesBounds.push_back(flutter::EncodableValue(bound));
+
+        flutter::EncodableMap response;
+        response[flutter::EncodableValue("totals")] = flutter::EncodableValue(EncodeConnectionSummary(stats.GetTotals()));
+        response[flutter::EncodableValue("hosts")] = flutter::EncodableValue(
+            encodeList(stats.GetTop(ConnectionStats::Group::Host, limit)));
+        response[flutter::EncodableValue("processes")] = flutter::EncodableValue(
+            encodeList(stats.GetTop(ConnectionStats::Group::Process, limit)));
+        response[flutter::EncodableValue("churningHosts")] = flutter::EncodableValue(
+            encodeList(stats.GetChurning(ConnectionStats::Group::Host)));
+        response[flutter::EncodableValue("churningProcesses")] = flutter::EncodableValue(
+            encodeList(stats.GetChurning(ConnectionStats::Group::Process)));
+        response[flutter::EncodableValue("durationBounds")] = flutter::EncodableValue(durationBounds);
+        response[flutter::EncodableValue("bytesBounds")] = flutter::EncodableValue(bytesBounds);
+        result->Success(flutter::EncodableValue(response));
+
+    } else if (method == "getConnectionMetrics") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        size_t limit = static_cast<size_t>(args ? GetIntArg(*args, "limit", 20) : 20);
+        result->Success(flutter::EncodableValue(ConnectionStats::GetInstance().ExportMetrics(limit)));
+
+    } else if (method == "configureChurnDetection") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        if (!args) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        auto& stats = ConnectionStats::GetInstance();
+        auto options = stats.GetOptions();
+        options.minOpenRate = GetDoubleArg(*args, "minOpenRate", options.minOpenRate);
+        options.minShortLived = GetDoubleArg(*args, "minShortLived", options.minShortLived);
+        options.shortLivedMs = GetIntArg(*args, "shortLivedMs", options.shortLivedMs);
+        stats.SetOptions(options);
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "resetConnectionStats") {
+        ConnectionStats::GetInstance().Reset();
+        result->Success(flutter::EncodableValue(true));
+
+    } else if (method == "invokeBatch") {
+        const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+        const flutter::EncodableList* calls = nullptr;
+        if (args) {
+            auto it = args->find(flutter::EncodableValue("calls"));
+            if (it != args->end()) calls = std::get_if<flutter::EncodableList>(&it->second);
+        }
+        if (!calls) {
+            result->Error("INVALID_ARGS", "Invalid arguments");
+            return;
+        }
+        if (calls->empty()) {
+            result->Success(flutter::EncodableValue(flutter::EncodableList()));
+            return;
+        }
+
+        // Entries run in order, each after every earlier one has answered,
+        // exactly as separate awaited calls would. Single entries go back to
+        // the platform thread, where a separate call would have run; only a
+        // run of adjacent read-only entries overlaps, on the batch pool. The
+        // driver thread does nothing but wait, so the platform thread stays
+        // free while entries do.
+        auto collector = std::make_shared<BatchCollector>(calls->size(), std::move(result));
+        auto entries = std::make_shared<flutter::EncodableList>(*calls);
+        std::thread([collector, entries]() {
+            auto methodOf = [&entries](size_t index) {
+                const auto* entry = std::get_if<flutter::EncodableMap>(&(*entries)[index]);
+                return entry ? GetStringArg(*entry, "method") : std::string();
+            };
+            auto run = [collector, entries](size_t index, const std::string& name) {
+                if (name.empty() || name == "invokeBatch") {
+                    BatchEntryResult(collector, index).Error("INVALID_ARGS", "Invalid batch entry");
+                    return;
+                }
+                const auto& entry = std::get<flutter::EncodableMap>((*entries)[index]);
+                auto argsIt = entry.find(flutter::EncodableValue("args"));
+                flutter::MethodCall<flutter::EncodableValue> call(
+                    name, std::make_unique<flutter::EncodableValue>(
+                        argsIt != entry.end() ? argsIt->second : flutter::EncodableValue()));
+                HandleMethodCall(call, std::make_unique<BatchEntryResult>(collector, index));
+            };
+
+            WorkerPool& pool = BatchPool();
+            size_t next = 0;
+            while (next < entries->size()) {
+                std::string name = methodOf(next);
+                size_t end = next + 1;
+                if (IsBatchParallel(name)) {
+                    while (end < entries->size() && IsBatchParallel(methodOf(end))) end++;
+                }
+                if (end - next == 1) {
+                    PostToPlatformThread([run, next, name]() { run(next, name); });
+                } else {
+                    for (size_t i = next; i < end; i++) {
+                        pool.Submit([run, i, name = methodOf(i)]() { run(i, name); });
+                    }
+                }
+                collector->WaitForCompleted(end);
+                next = end;
+            }
+        }).detach();
+
+    } else if (method == "trimMemory") {
+        std::thread([result = std::move(result)]() mutable {
+            auto event = MemoryMonitor::GetInstance().TrimNow();
+            result->Success(flutter::EncodableValue(EncodeMemoryEvent(event)));
+        }).detach();
+
     } else if (method == "startVpn" || method == "stopVpn" ||
                method == "requestVpnPermission" ||
                method == "checkBatteryOptimization" ||
@@ -416,6 +1976,39 @@ flutter::EncodableMap PlatformChannel::GetDeviceInfo() {
     return info;
 }
 
+void PlatformChannel::PostToPlatformThread(std::function<void()> task) {
+    // Without the window a posted message would land on the calling thread
+    if (!platform_window_) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(platform_tasks_mutex_);
+        platform_tasks_.push_back(std::move(task));
+    }
+    PostMessageW(platform_window_, kRunPlatformTasks, 0, 0);
+}
+
+LRESULT CALLBACK PlatformChannel::PlatformWindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                                     LPARAM lparam) {
+    if (message != kRunPlatformTasks) {
+        return DefWindowProcW(hwnd, message, wparam, lparam);
+    }
+
+    // One message may find several tasks queued; later messages then find none
+    while (true) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(platform_tasks_mutex_);
+            if (platform_tasks_.empty()) break;
+            task = std::move(platform_tasks_.front());
+            platform_tasks_.pop_front();
+        }
+        task();
+    }
+    return 0;
+}
+
 std::string PlatformChannel::GetConfigDirectory() {
     wchar_t* appData = nullptr;
     std::string configDir;
@@ -436,10 +2029,62 @@ std::string PlatformChannel::GetConfigDirectory() {
 }
 
 void PlatformChannel::SendEvent(const std::string& type, const flutter::EncodableValue& data) {
+    // Periodic events would push everything else out of the ring
+    if (type != "traffic_update" && type != "log" && type != "controller_stream" &&
+        type != "soak_progress") {
+        FlightRecorder::Record(FlightRecorder::Category::Event, FlightRecorder::Level::Info, type);
+    }
+
+    std::lock_guard<std::mutex> lock(event_mutex_);
+    uint64_t seq = ++event_seq_;
+    if (type == "traffic_update") {
+        cached_traffic_ = data;
+    } else if (type == "error") {
+        cached_error_ = data;
+    } else if (type == "log") {
+        cached_logs_.push_back(data);
+        if (cached_logs_.size() > kReplayLogLines) cached_logs_.pop_front();
+    }
+
     if (event_sink_) {
         flutter::EncodableMap event;
         event[flutter::EncodableValue("type")] = flutter::EncodableValue(type);
         event[flutter::EncodableValue("data")] = data;
+        event[flutter::EncodableValue("seq")] = flutter::EncodableValue(static_cast<int64_t>(seq));
         event_sink_->Success(flutter::EncodableValue(event));
     }
 }
+
+size_t PlatformChannel::TrimCachedEvents() {
+    std::lock_guard<std::mutex> lock(event_mutex_);
+    size_t bytes = 0;
+    for (const auto& line : cached_logs_) {
+        bytes += sizeof(flutter::EncodableValue);
+        if (const auto* text = std::get_if<std::string>(&line)) bytes += text->capacity();
+    }
+    std::deque<flutter::EncodableValue>().swap(cached_logs_);
+    return bytes;
+}
+
+void PlatformChannel::ReplayCachedEvents() {
+    auto& core = MihomoCore::GetInstance();
+
+    std::lock_guard<std::mutex> lock(event_mutex_);
+    if (!event_sink_) return;
+
+    // State is read live; everything else is the last value sent
+    flutter::EncodableMap data;
+    data[flutter::EncodableValue("state")] = flutter::EncodableValue(core.GetState());
+    data[flutter::EncodableValue("running")] = flutter::EncodableValue(core.IsRunning());
+    data[flutter::EncodableValue("traffic")] = cached_traffic_;
+    data[flutter::EncodableValue("lastError")] = cached_error_;
+    data[flutter::EncodableValue("logs")] = flutter::EncodableValue(
+        flutter::EncodableList(cached_logs_.begin(), cached_logs_.end()));
+
+    // Carries the current sequence number: the next live event is seq + 1
+    flutter::EncodableMap event;
+    event[flutter::EncodableValue("type")] = flutter::EncodableValue("replay");
+    event[flutter::EncodableValue("data")] = flutter::EncodableValue(data);
+    event[flutter::EncodableValue("seq")] = flutter::EncodableValue(static_cast<int64_t>(event_seq_));
+    event_sink_->Success(flutter::EncodableValue(event));
+}
@@ -8,7 +8,11 @@
 #include <flutter/event_stream_handler_functions.h>
 #include <flutter/flutter_engine.h>
 #include <windows.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 
 class PlatformChannel {
@@ -26,8 +30,29 @@ private:
     static flutter::EncodableMap GetDeviceInfo();
     static std::string GetConfigDirectory();
 
+    // Runs task on the platform thread, in posting order, from any thread.
+    // Backed by a message-only window the runner's message loop pumps.
+    static void PostToPlatformThread(std::function<void()> task);
+    static LRESULT CALLBACK PlatformWindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+    static HWND platform_window_;
+    static std::mutex platform_tasks_mutex_;
+    static std::deque<std::function<void()>> platform_tasks_;
+
     static std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
     static void SendEvent(const std::string& type, const flutter::EncodableValue& data);
+
+    // Every event carries a sequence number so Dart can detect gaps. The last
+    // value of each topic is kept and replayed as one "replay" event when a
+    // listener attaches, under the same lock that orders live events.
+    static std::mutex event_mutex_;
+    static uint64_t event_seq_;
+    static flutter::EncodableValue cached_traffic_;
+    static flutter::EncodableValue cached_error_;
+    static std::deque<flutter::EncodableValue> cached_logs_;
+    static void ReplayCachedEvents();
+
+    // Drops the log lines kept for replay; returns the approximate bytes
+    static size_t TrimCachedEvents();
 };
 
 #endif  // PLATFORM_CHANNEL_H_
@@ -0,0 +1,671 @@
+// protocol_schema.cpp - Per-protocol proxy descriptors implementation
+#include "protocol_schema.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+
+using Setting = std::pair<const std::string, NodeValue>;
+
+// Deepest key nesting a table may use (ws-opts.headers.Host is 2)
+constexpr size_t kMaxNesting = 3;
+
+// Protocol tables. Fields sharing a parent mapping must be adjacent, and a
+// `when` must name another field of the same table; both are checked at
+// compile time.
+
+constexpr auto kShadowsocks = MakeSchema("ss", {
+    {.key = "cipher", .setting = "method", .required = true},
+    {.key = "password", .required = true},
+    {.key = "udp", .type = FieldType::Bool},
+    {.key = "udp-over-tcp", .type = FieldType::Bool},
+    {.key = "client-fingerprint"},
+    {.key = "plugin"},
+    {.key = "plugin-opts.mode"},
+    {.key = "plugin-opts.host"},
+    {.key = "plugin-opts.path"},
+    {.key = "plugin-opts.tls", .type = FieldType::Bool},
+});
+
+constexpr auto kShadowsocksR = MakeSchema("ssr", {
+    {.key = "cipher", .setting = "method", .required = true},
+    {.key = "password", .required = true},
+    {.key = "protocol", .required = true},
+    {.key = "protocol-param", .setting = "protocol_param"},
+    {.key = "obfs", .required = true},
+    {.key = "obfs-param", .setting = "obfs_param"},
+    {.key = "udp", .type = FieldType::Bool},
+});
+
+constexpr auto kVmess = MakeSchema("vmess", {
+    {.key = "uuid", .required = true},
+    {.key = "alterId", .type = FieldType::Int, .setting = "alter_id", .fallback = "0"},
+    {.key = "cipher", .fallback = "auto"},
+    {.key = "udp", .type = FieldType::Bool},
+    {.key = "tls", .type = FieldType::Bool},
+    {.key = "servername", .setting = "sni"},
+    {.key = "skip-cert-verify", .type = FieldType::Bool, .setting = "skip_cert_verify"},
+    {.key = "client-fingerprint", .setting = "fp"},
+    {.key = "network"},
+    {.key = "ws-opts.path", .setting = "ws_path", .when = "network=ws"},
+    {.key = "ws-opts.headers.Host", .setting = "ws_host", .when = "network=ws"},
+    {.key = "grpc-opts.grpc-service-name", .setting = "serviceName", .when = "network=grpc"},
+});
+
+constexpr auto kVless = MakeSchema("vless", {
+    {.key = "uuid", .required = true},
+    {.key = "flow"},
+    {.key = "encryption"},
+    {.key = "udp", .type = FieldType::Bool},
+    {.key = "tls", .type = FieldType::Bool, .setting = "security"},
+    {.key = "servername", .setting = "sni"},
+    {.key = "skip-cert-verify", .type = FieldType::Bool, .setting = "skip_cert_verify"},
+    {.key = "client-fingerprint", .setting = "fp"},
+    {.key = "reality-opts.public-key", .setting = "pbk"},
+    {.key = "reality-opts.short-id", .setting = "sid"},
+    {.key = "network"},
+    {.key = "ws-opts.path", .when = "network=ws"},
+    {.key = "ws-opts.headers.Host", .setting = "host", .when = "network=ws"},
+    {.key = "grpc-opts.grpc-service-name", .setting = "serviceName", .when = "network=grpc"},
+});
+
+constexpr auto kTrojan = MakeSchema("trojan", {
+    {.key = "password", .required = true},
+    {.key = "udp", .type = FieldType::Bool},
+    {.key = "sni"},
+    {.key = "skip-cert-verify", .type = FieldType::Bool, .setting = "skip_cert_verify"},
+    {.key = "client-fingerprint", .setting = "fp"},
+    {.key = "alpn", .type = FieldType::List},
+    {.key = "network"},
+    {.key = "ws-opts.path", .when = "network=ws"},
+    {.key = "ws-opts.headers.Host", .setting = "host", .when = "network=ws"},
+    {.key = "grpc-opts.grpc-service-name", .setting = "serviceName", .when = "network=grpc"},
+});
+
+constexpr auto kHysteria = MakeSchema("hysteria", {
+    {.key = "auth-str", .setting = "auth_str"},
+    {.key = "auth"},
+    {.key = "obfs"},
+    {.key = "protocol"},
+    {.key = "up"},
+    {.key = "down"},
+    {.key = "alpn", .type = FieldType::List},
+    {.key = "sni"},
+    {.key = "skip-cert-verify", .type = FieldType::Bool, .setting = "skip_cert_verify"},
+});
+
+constexpr auto kHysteria2 = MakeSchema("hysteria2", {
+    {.key = "password", .required = true},
+    {.key = "ports"},
+    {.key = "obfs"},
+    {.key = "obfs-password", .setting = "obfs_password"},
+    {.key = "up"},
+    {.key = "down"},
+    {.key = "alpn", .type = FieldType::List},
+    {.key = "sni"},
+    {.key = "skip-cert-verify", .type = FieldType::Bool, .setting = "skip_cert_verify"},
+});
+
+constexpr auto kTuic = MakeSchema("tuic", {
+    {.key = "uuid"},
+    {.key = "password"},
+    {.key = "token"},
+    {.key = "congestion-controller", .setting = "congestion_control"},
+    {.key = "udp-relay-mode", .setting = "udp_relay_mode"},
+    {.key = "reduce-rtt", .type = FieldType::Bool},
+    {.key = "heartbeat-interval", .type = FieldType::Int},
+    {.key = "alpn", .type = FieldType::List},
+    {.key = "sni"},
+    {.key = "disable-sni", .type = FieldType::Bool},
+    {.key = "skip-cert-verify", .type = FieldType::Bool, .setting = "skip_cert_verify"},
+});
+
+constexpr auto kWireGuard = MakeSchema("wireguard", {
+    {.key = "private-key", .required = true},
+    {.key = "public-key"},
+    {.key = "pre-shared-key"},
+    {.key = "ip"},
+    {.key = "ipv6"},
+    {.key = "allowed-ips", .type = FieldType::List},
+    {.key = "mtu", .type = FieldType::Int},
+    {.key = "udp", .type = FieldType::Bool},
+});
+
+constexpr auto kAnyTls = MakeSchema("anytls", {
+    {.key = "password", .required = true},
+    {.key = "udp", .type = FieldType::Bool},
+    {.key = "sni"},
+    {.key = "skip-cert-verify", .type = FieldType::Bool, .setting = "skip_cert_verify"},
+    {.key = "client-fingerprint", .setting = "fp"},
+    {.key = "alpn", .type = FieldType::List},
+});
+
+// Key helpers, usable at compile time
+
+constexpr std::string_view Leaf(std::string_view key) {
+    size_t dot = key.rfind('.');
+    return dot == std::string_view::npos ? key : key.substr(dot + 1);
+}
+
+constexpr std::string_view Parent(std::string_view key) {
+    size_t dot = key.rfind('.');
+    return dot == std::string_view::npos ? std::string_view() : key.substr(0, dot);
+}
+
+// Segment i of a dotted path
+constexpr std::string_view Segment(std::string_view path, size_t i) {
+    for (; i > 0; i--) {
+        size_t dot = path.find('.');
+        if (dot == std::string_view::npos) return std::string_view();
+        path.remove_prefix(dot + 1);
+    }
+    return path.substr(0, path.find('.'));
+}
+
+constexpr size_t Depth(std::string_view path) {
+    if (path.empty()) return 0;
+    size_t depth = 1;
+    for (char c : path) {
+        if (c == '.') depth++;
+    }
+    return depth;
+}
+
+// Number of leading segments two paths share
+constexpr size_t CommonDepth(std::string_view a, std::string_view b) {
+    size_t depth = 0;
+    while (depth < Depth(a) && depth < Depth(b) && Segment(a, depth) == Segment(b, depth)) depth++;
+    return depth;
+}
+
+constexpr std::string_view WhenField(std::string_view when) { return when.substr(0, when.find('=')); }
+
+constexpr std::string_view WhenValue(std::string_view when) {
+    size_t equals = when.find('=');
+    return equals == std::string_view::npos ? std::string_view() : when.substr(equals + 1);
+}
+
+template <const auto& Schema>
+constexpr bool FieldsGrouped() {
+    const auto& fields = Schema.fields;
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (Depth(Parent(fields[i].key)) > kMaxNesting) return false;
+        for (size_t j = i + 2; j < fields.size(); j++) {
+            size_t shared = CommonDepth(Parent(fields[i].key), Parent(fields[j].key));
+            for (size_t k = i + 1; k < j; k++) {
+                if (CommonDepth(Parent(fields[i].key), Parent(fields[k].key)) < shared) return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <const auto& Schema>
+constexpr int FieldIndex(std::string_view key) {
+    for (size_t i = 0; i < Schema.fields.size(); i++) {
+        if (Schema.fields[i].key == key) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+template <const auto& Schema>
+constexpr bool GatesResolve() {
+    for (const auto& field : Schema.fields) {
+        if (field.when.empty()) continue;
+        int gate = FieldIndex<Schema>(WhenField(field.when));
+        if (gate < 0 || !Schema.fields[gate].when.empty() || WhenValue(field.when).empty()) return false;
+    }
+    return true;
+}
+
+// Value conversions. Settings come typed from YAML, untyped from share
+// links, and as whatever Dart stored, so each field type accepts the
+// spellings the others produce.
+
+bool AsString(const NodeValue& value, std::string* out) {
+    if (const auto* text = std::get_if<std::string>(&value)) {
+        *out = *text;
+    } else if (const auto* number = std::get_if<int64_t>(&value)) {
+        *out = std::to_string(*number);
+    } else if (const auto* real = std::get_if<double>(&value)) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%g", *real);
+        *out = buffer;
+    } else if (const auto* flag = std::get_if<bool>(&value)) {
+        *out = *flag ? "true" : "false";
+    } else {
+        const auto& list = std::get<std::vector<std::string>>(value);
+        out->clear();
+        for (size_t i = 0; i < list.size(); i++) {
+            if (i > 0) out->push_back(',');
+            out->append(list[i]);
+        }
+    }
+    return true;
+}
+
+bool AsInt(const NodeValue& value, int64_t* out) {
+    if (const auto* number = std::get_if<int64_t>(&value)) {
+        *out = *number;
+        return true;
+    }
+    if (const auto* real = std::get_if<double>(&value)) {
+        *out = static_cast<int64_t>(*real);
+        return static_cast<double>(*out) == *real;
+    }
+    if (const auto* text = std::get_if<std::string>(&value)) {
+        char* end = nullptr;
+        long long parsed = strtoll(text->c_str(), &end, 10);
+        if (text->empty() || !end || *end != '\0') return false;
+        *out = parsed;
+        return true;
+    }
+    return false;
+}
+
+// Strings are true unless empty or a word for off; share links spell TLS
+// as security=tls or reality
+bool AsBool(const NodeValue& value) {
+    if (const auto* flag = std::get_if<bool>(&value)) return *flag;
+    if (const auto* number = std::get_if<int64_t>(&value)) return *number != 0;
+    if (const auto* text = std::get_if<std::string>(&value)) {
+        return !(text->empty() || *text == "false" || *text == "0" || *text == "no" ||
+                 *text == "off" || *text == "none");
+    }
+    return false;
+}
+
+// Comma-separated strings split, as alpn=h3,h2 in a share link
+std::vector<std::string> AsList(const NodeValue& value) {
+    if (const auto* list = std::get_if<std::vector<std::string>>(&value)) return *list;
+    std::string text;
+    AsString(value, &text);
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        size_t first = text.find_first_not_of(' ', start);
+        size_t last = text.find_last_not_of(' ', comma - 1);
+        if (first < comma && last != std::string::npos && last >= first) {
+            items.push_back(text.substr(first, last - first + 1));
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+// Written by ItemWriter::Begin from the record itself
+const char* const kReservedKeys[] = {"name", "type", "server", "port"};
+
+bool IsReservedKey(const std::string& key) {
+    for (const char* reserved : kReservedKeys) {
+        if (key == reserved) return true;
+    }
+    return false;
+}
+
+bool IsPlainKey(const std::string& key) {
+    if (key.empty()) return false;
+    for (char c : key) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') return false;
+    }
+    return true;
+}
+
+// Writes one `proxies:` item, opening nested mappings as keys need them
+class ItemWriter {
+public:
+    explicit ItemWriter(std::string* out) : out_(out) {}
+
+    void Begin(const NodeRecord& record) {
+        out_->append("  - name: ");
+        Quoted(record.name);
+        out_->append("\n    type: ");
+        Quoted(record.type);
+        out_->append("\n    server: ");
+        Quoted(record.server);
+        out_->append("\n    port: ");
+        out_->append(std::to_string(record.port));
+        out_->push_back('\n');
+    }
+
+    void Key(std::string_view parent, std::string_view leaf) {
+        size_t depth = Depth(parent);
+        if (parent != open_) {
+            for (size_t i = CommonDepth(open_, parent); i < depth; i++) {
+                Indent(i);
+                out_->append(Segment(parent, i));
+                out_->append(":\n");
+            }
+            open_ = parent;
+        }
+        Indent(depth);
+        out_->append(leaf);
+        out_->append(": ");
+    }
+
+    void String(const std::string& value) {
+        Quoted(value);
+        out_->push_back('\n');
+    }
+
+    void Int(int64_t value) {
+        out_->append(std::to_string(value));
+        out_->push_back('\n');
+    }
+
+    void Bool(bool value) { out_->append(value ? "true\n" : "false\n"); }
+
+    void List(const std::vector<std::string>& values) {
+        out_->push_back('[');
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0) out_->append(", ");
+            Quoted(values[i]);
+        }
+        out_->append("]\n");
+    }
+
+    // A setting no field claims, written as it is typed. Keys Begin already
+    // wrote and empty strings are left out, as a table field would be.
+    void Extra(const Setting& setting) {
+        if (!IsPlainKey(setting.first) || IsReservedKey(setting.first)) return;
+        const NodeValue& value = setting.second;
+        const auto* text = std::get_if<std::string>(&value);
+        if (text && text->empty()) return;
+
+        Key(std::string_view(), setting.first);
+        if (text) {
+            String(*text);
+        } else if (const auto* number = std::get_if<int64_t>(&value)) {
+            Int(*number);
+        } else if (const auto* flag = std::get_if<bool>(&value)) {
+            Bool(*flag);
+        } else if (const auto* list = std::get_if<std::vector<std::string>>(&value)) {
+            List(*list);
+        } else {
+            std::string formatted;
+            AsString(value, &formatted);
+            out_->append(formatted);
+            out_->push_back('\n');
+        }
+    }
+
+private:
+    void Indent(size_t depth) { out_->append(4 + depth * 2, ' '); }
+
+    void Quoted(const std::string& value) {
+        out_->push_back('"');
+        for (char c : value) {
+            switch (c) {
+                case '"': out_->append("\\\""); break;
+                case '\\': out_->append("\\\\"); break;
+                case '\n': out_->append("\\n"); break;
+                case '\r': out_->append("\\r"); break;
+                case '\t': out_->append("\\t"); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char escape[8];
+                        snprintf(escape, sizeof(escape), "\\x%02x", static_cast<unsigned char>(c));
+                        out_->append(escape);
+                    } else {
+                        out_->push_back(c);
+                    }
+                    break;
+            }
+        }
+        out_->push_back('"');
+    }
+
+    std::string* out_;
+    std::string_view open_;  // Parent mapping of the last key written
+};
+
+bool CheckEndpoint(const NodeRecord& record, std::string* error) {
+    const char* problem = record.name.empty() ? "name is required"
+        : record.server.empty() ? "server is required"
+        : record.port <= 0 || record.port > 65535 ? "port is out of range" : nullptr;
+    if (!problem) return true;
+    if (error) *error = problem;
+    return false;
+}
+
+// Everything about one protocol, generated from its table
+template <const auto& Schema>
+class ProtocolCodec {
+public:
+    static constexpr std::string_view kType = Schema.type;
+
+    static bool Validate(const NodeRecord& record, std::string* error) {
+        if (!CheckEndpoint(record, error)) return false;
+        Slots slots{};
+        Bind(record, &slots, nullptr);
+        return CheckAll(slots, error, std::make_index_sequence<kCount>());
+    }
+
+    static bool Serialize(const NodeRecord& record, std::string* out, std::string* error) {
+        if (!CheckEndpoint(record, error)) return false;
+        Slots slots{};
+        std::vector<const Setting*> extras;
+        Bind(record, &slots, &extras);
+        if (!CheckAll(slots, error, std::make_index_sequence<kCount>())) return false;
+
+        ItemWriter writer(out);
+        writer.Begin(record);
+        WriteAll(slots, &writer, std::make_index_sequence<kCount>());
+        for (const Setting* setting : extras) {
+            if (!IsMapping(setting->first)) writer.Extra(*setting);
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t kCount = Schema.fields.size();
+    using Slots = std::array<const NodeValue*, kCount>;
+
+    static_assert(FieldsGrouped<Schema>(), "fields sharing a parent mapping must be adjacent");
+    static_assert(GatesResolve<Schema>(), "a `when` must name an ungated field of the same table");
+
+    // A top-level mapping the table writes (ws-opts, plugin-opts). A setting
+    // of that name, e.g. a nested map kept as text, would repeat the key.
+    static bool IsMapping(std::string_view name) {
+        for (const auto& field : Schema.fields) {
+            if (Depth(Parent(field.key)) > 0 && Segment(Parent(field.key), 0) == name) return true;
+        }
+        return false;
+    }
+
+    struct Alias {
+        std::string_view name;
+        size_t field = 0;
+    };
+
+    static constexpr size_t kAliasCount = [] {
+        size_t count = 0;
+        for (const auto& field : Schema.fields) {
+            count += !field.setting.empty() && field.setting != Leaf(field.key) ? 2 : 1;
+        }
+        return count;
+    }();
+
+    // Every name a field answers to, sorted so binding is a merge with the
+    // record's (sorted) settings
+    static constexpr std::array<Alias, kAliasCount> kAliases = [] {
+        std::array<Alias, kAliasCount> aliases{};
+        size_t count = 0;
+        for (size_t i = 0; i < kCount; i++) {
+            const auto& field = Schema.fields[i];
+            aliases[count++] = {Leaf(field.key), i};
+            if (!field.setting.empty() && field.setting != Leaf(field.key)) aliases[count++] = {field.setting, i};
+        }
+        for (size_t i = 1; i < count; i++) {
+            Alias alias = aliases[i];
+            size_t j = i;
+            for (; j > 0 && alias.name < aliases[j - 1].name; j--) aliases[j] = aliases[j - 1];
+            aliases[j] = alias;
+        }
+        return aliases;
+    }();
+
+    // Points each field at its setting; unclaimed settings go to extras
+    static void Bind(const NodeRecord& record, Slots* slots, std::vector<const Setting*>* extras) {
+        auto it = record.settings.begin();
+        size_t alias = 0;
+        while (it != record.settings.end()) {
+            int order = alias < kAliasCount ? kAliases[alias].name.compare(it->first) : 1;
+            if (order < 0) {
+                alias++;
+                continue;
+            }
+            if (order > 0) {
+                if (extras) extras->push_back(&*it);
+                ++it;
+                continue;
+            }
+            // One name may feed several fields (path under ws-opts and h2-opts)
+            for (; alias < kAliasCount && kAliases[alias].name == it->first; alias++) {
+                const NodeValue*& slot = (*slots)[kAliases[alias].field];
+                if (!slot) slot = &it->second;
+            }
+            ++it;
+        }
+    }
+
+    template <size_t I>
+    static bool Enabled(const Slots& slots) {
+        constexpr ProxyField kField = Schema.fields[I];
+        if constexpr (kField.when.empty()) {
+            return true;
+        } else {
+            constexpr int kGate = FieldIndex<Schema>(WhenField(kField.when));
+            std::string value(Schema.fields[kGate].fallback);
+            if (slots[kGate]) AsString(*slots[kGate], &value);
+            return value == WhenValue(kField.when);
+        }
+    }
+
+    template <size_t I>
+    static bool Check(const Slots& slots, std::string* error) {
+        constexpr ProxyField kField = Schema.fields[I];
+        if (!Enabled<I>(slots)) return true;
+        const NodeValue* value = slots[I];
+
+        const char* problem = nullptr;
+        if constexpr (kField.required && kField.fallback.empty()) {
+            std::string text;
+            if (value) AsString(*value, &text);
+            if (text.empty()) problem = " is required";
+        }
+        if constexpr (kField.type == FieldType::Int) {
+            int64_t number = 0;
+            if (value && !AsInt(*value, &number)) problem = " is not an integer";
+        }
+        if (!problem) return true;
+        if (error) *error = std::string(kField.key) + problem;
+        return false;
+    }
+
+    template <size_t... I>
+    static bool CheckAll(const Slots& slots, std::string* error, std::index_sequence<I...>) {
+        return (Check<I>(slots, error) && ...);
+    }
+
+    template <size_t I>
+    static void Write(const Slots& slots, ItemWriter* writer) {
+        constexpr ProxyField kField = Schema.fields[I];
+        constexpr std::string_view kParent = Parent(kField.key);
+        constexpr std::string_view kLeaf = Leaf(kField.key);
+        if (!Enabled<I>(slots)) return;
+
+        NodeValue fallback;
+        const NodeValue* value = slots[I];
+        if (!value) {
+            if constexpr (kField.fallback.empty()) {
+                return;
+            } else {
+                fallback = std::string(kField.fallback);
+                value = &fallback;
+            }
+        }
+
+        if constexpr (kField.type == FieldType::String) {
+            std::string text;
+            AsString(*value, &text);
+            if (text.empty()) return;
+            writer->Key(kParent, kLeaf);
+            writer->String(text);
+        } else if constexpr (kField.type == FieldType::Int) {
+            int64_t number = 0;
+            if (!AsInt(*value, &number)) return;
+            writer->Key(kParent, kLeaf);
+            writer->Int(number);
+        } else if constexpr (kField.type == FieldType::Bool) {
+            writer->Key(kParent, kLeaf);
+            writer->Bool(AsBool(*value));
+        } else {
+            std::vector<std::string> list = AsList(*value);
+            if (list.empty()) return;
+            writer->Key(kParent, kLeaf);
+            writer->List(list);
+        }
+    }
+
+    template <size_t... I>
+    static void WriteAll(const Slots& slots, ItemWriter* writer, std::index_sequence<I...>) {
+        (Write<I>(slots, writer), ...);
+    }
+};
+
+struct Protocol {
+    std::string_view type;
+    bool (*validate)(const NodeRecord& record, std::string* error);
+    bool (*serialize)(const NodeRecord& record, std::string* out, std::string* error);
+};
+
+template <const auto&... Schemas>
+constexpr std::array<Protocol, sizeof...(Schemas)> MakeRegistry() {
+    return {Protocol{ProtocolCodec<Schemas>::kType, &ProtocolCodec<Schemas>::Validate,
+                     &ProtocolCodec<Schemas>::Serialize}...};
+}
+
+constexpr auto kProtocols = MakeRegistry<kShadowsocks, kShadowsocksR, kVmess, kVless, kTrojan,
+                                         kHysteria, kHysteria2, kTuic, kWireGuard, kAnyTls>();
+
+const Protocol* Find(const std::string& type) {
+    for (const auto& protocol : kProtocols) {
+        if (protocol.type == type) return &protocol;
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+bool ProxySchema::Has(const std::string& type) {
+    return Find(type) != nullptr;
+}
+
+std::vector<std::string> ProxySchema::Types() {
+    std::vector<std::string> types;
+    for (const auto& protocol : kProtocols) types.emplace_back(protocol.type);
+    return types;
+}
+
+bool ProxySchema::Validate(const NodeRecord& record, std::string* error) {
+    const Protocol* protocol = Find(record.type);
+    if (!protocol) return CheckEndpoint(record, error);
+    return protocol->validate(record, error);
+}
+
+bool ProxySchema::Serialize(const NodeRecord& record, std::string* out, std::string* error) {
+    const Protocol* protocol = Find(record.type);
+    if (protocol) return protocol->serialize(record, out, error);
+
+    if (!CheckEndpoint(record, error)) return false;
+    ItemWriter writer(out);
+    writer.Begin(record);
+    for (const auto& setting : record.settings) writer.Extra(setting);
+    return true;
+}
@@ -0,0 +1,66 @@
+// protocol_schema.h - Per-protocol proxy descriptors for Windows
+#ifndef PROTOCOL_SCHEMA_H_
+#define PROTOCOL_SCHEMA_H_
+
+#include "node_table.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class FieldType { String, Int, Bool, List };
+
+// One field of a mihomo proxy. Records carry settings under two kinds of
+// names: a Clash item keeps the last segment of each key (path, Host,
+// skip-cert-verify) and a share link keeps the Dart parser's name
+// (ws_path, skip_cert_verify). A field answers to both.
+struct ProxyField {
+    std::string_view key;            // mihomo key; '.' separates nested mappings
+    FieldType type = FieldType::String;
+    std::string_view setting = {};   // Name the share-link parsers store it under, when it differs
+                                     // from the last key segment; they are not generated from it
+    bool required = false;
+    std::string_view fallback = {};  // Written when the record has no value
+    std::string_view when = {};      // "network=ws": used only when that field has that value
+};
+
+template <size_t N>
+struct ProtocolSchema {
+    std::string_view type;
+    std::array<ProxyField, N> fields;
+};
+
+template <size_t N>
+constexpr ProtocolSchema<N> MakeSchema(std::string_view type, const ProxyField (&fields)[N]) {
+    ProtocolSchema<N> schema{type, {}};
+    for (size_t i = 0; i < N; i++) schema.fields[i] = fields[i];
+    return schema;
+}
+
+// Validation and mihomo serialization of node records, generated per
+// protocol from the constexpr tables in protocol_schema.cpp. Each field of
+// a table becomes its own step with the key, type and conditions folded in
+// at compile time, and settings are matched to fields in one pass over the
+// record in key order, so no step searches a map. Adding a protocol means
+// adding its table and listing it in the registry there; reading its share
+// links is still hand-written in NodeParser::ParseUri.
+class ProxySchema {
+public:
+    static bool Has(const std::string& type);
+    static std::vector<std::string> Types();
+
+    // Checks server, port, required fields and value types against the
+    // type's table. Records of types without a table only need a server
+    // and a port.
+    static bool Validate(const NodeRecord& record, std::string* error);
+
+    // Appends the record as one item of a mihomo `proxies:` list, indented
+    // for a top-level key: table fields under their mihomo keys with values
+    // converted to the field type, then settings no field claims under
+    // their own names. Appends nothing when the record does not validate.
+    static bool Serialize(const NodeRecord& record, std::string* out, std::string* error);
+};
+
+#endif  // PROTOCOL_SCHEMA_H_
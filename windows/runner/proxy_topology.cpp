@@ -0,0 +1,358 @@
+// proxy_topology.cpp - Incremental proxy-group topology implementation
+#include "proxy_topology.h"
+#include "flight_recorder.h"
+#include "idle_budget.h"
+#include "json_reader.h"
+#include "mihomo_core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+constexpr char kSnapshotMagic[4] = {'V', 'P', 'T', '1'};
+
+// The delay of the last entry of a history array, -1 when it is empty
+bool LastDelay(JsonReader* reader, int* out) {
+    *out = -1;
+    if (!reader->Consume('[')) return reader->Skip();
+    if (reader->Consume(']')) return true;
+    do {
+        if (!reader->Consume('{')) {
+            if (!reader->Skip()) return false;
+            continue;
+        }
+        if (reader->Consume('}')) continue;
+        do {
+            std::string field;
+            if (!reader->String(&field) || !reader->Consume(':')) return false;
+            int64_t delay = 0;
+            if (field == "delay" && !reader->Peek('"') && !reader->Peek('n')) {
+                if (!reader->Int(&delay)) return false;
+                *out = static_cast<int>(delay);
+            } else if (!reader->Skip()) {
+                return false;
+            }
+        } while (reader->Consume(','));
+        if (!reader->Consume('}')) return false;
+    } while (reader->Consume(','));
+    return reader->Consume(']');
+}
+
+void WriteVarint(std::vector<uint8_t>* out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<uint8_t>(value));
+}
+
+void WriteString(std::vector<uint8_t>* out, const std::string& text) {
+    WriteVarint(out, text.size());
+    out->insert(out->end(), text.begin(), text.end());
+}
+
+}  // namespace
+
+ProxyTopology& ProxyTopology::GetInstance() {
+    static ProxyTopology instance;
+    return instance;
+}
+
+ProxyTopology::~ProxyTopology() {
+    // The watch thread touches this object until it has seen the stop
+    std::unique_lock<std::mutex> lock(watchMutex_);
+    watching_ = false;
+    watchCv_.notify_all();
+    watchCv_.wait(lock, [this]() { return !running_; });
+}
+
+bool ProxyTopology::Update(const std::string& proxiesJson, Changes* changes) {
+    auto model = std::make_shared<Model>();
+    std::vector<std::vector<std::string>> members;
+
+    JsonReader reader(proxiesJson.data(), proxiesJson.data() + proxiesJson.size());
+    bool ok = reader.Consume('{');
+    if (ok && !reader.Consume('}')) {
+        do {
+            std::string key;
+            if (!reader.String(&key) || !reader.Consume(':')) {
+                ok = false;
+                break;
+            }
+            if (key != "proxies") {
+                ok = reader.Skip();
+                continue;
+            }
+            if (!reader.Consume('{')) {
+                ok = false;
+                break;
+            }
+            if (reader.Consume('}')) continue;
+            do {
+                std::string name;
+                if (!reader.String(&name) || !reader.Consume(':') || !reader.Consume('{')) {
+                    ok = false;
+                    break;
+                }
+                // A repeated name keeps its first slot
+                auto slot = model->index.emplace(name, static_cast<uint32_t>(model->names.size()));
+                if (slot.second) {
+                    model->names.push_back(std::move(name));
+                    model->entries.emplace_back();
+                    members.emplace_back();
+                }
+                uint32_t at = slot.first->second;
+                Entry& entry = model->entries[at];
+                if (reader.Consume('}')) continue;
+                do {
+                    std::string field;
+                    if (!reader.String(&field) || !reader.Consume(':')) {
+                        ok = false;
+                        break;
+                    }
+                    if (field == "type" && reader.Peek('"')) ok = reader.String(&entry.type);
+                    else if (field == "now" && reader.Peek('"')) ok = reader.String(&entry.now);
+                    else if (field == "history") ok = LastDelay(&reader, &entry.delay);
+                    else if (field == "all") {
+                        entry.group = true;
+                        ok = reader.StringArray(&members[at]);
+                    } else ok = reader.Skip();
+                } while (ok && reader.Consume(','));
+                ok = ok && reader.Consume('}');
+            } while (ok && reader.Consume(','));
+            ok = ok && reader.Consume('}');
+        } while (ok && reader.Consume(','));
+        ok = ok && reader.Consume('}');
+    }
+    if (!ok) {
+        FlightRecorder::Record(FlightRecorder::Category::Controller, FlightRecorder::Level::Warning,
+                               "proxy topology: /proxies did not parse",
+                               static_cast<int64_t>(proxiesJson.size()));
+        return false;
+    }
+
+    // Members resolve to table slots once every proxy is known; a member the
+    // response does not list gets an empty slot of its own
+    for (size_t i = 0; i < members.size(); i++) {
+        if (!model->entries[i].group) continue;
+        std::vector<uint32_t> indices;
+        indices.reserve(members[i].size());
+        for (auto& member : members[i]) {
+            auto found = model->index.find(member);
+            if (found == model->index.end()) {
+                found = model->index.emplace(member, static_cast<uint32_t>(model->names.size())).first;
+                model->names.push_back(std::move(member));
+                model->entries.emplace_back();
+            }
+            indices.push_back(found->second);
+        }
+        model->entries[i].members = std::move(indices);
+    }
+
+    Changes local;
+    Changes* out = changes ? changes : &local;
+    std::lock_guard<std::mutex> lock(mutex_);
+    static const Model kEmpty;
+    Diff(model_ ? *model_ : kEmpty, *model, out);
+    out->base = version_;
+    if (!out->Empty()) version_++;
+    out->version = version_;
+    model_ = std::move(model);
+    return true;
+}
+
+void ProxyTopology::Diff(const Model& before, const Model& after, Changes* changes) {
+    auto sameMembers = [&](const Entry& a, const Entry& b) {
+        if (a.members.size() != b.members.size()) return false;
+        for (size_t k = 0; k < a.members.size(); k++) {
+            if (before.names[a.members[k]] != after.names[b.members[k]]) return false;
+        }
+        return true;
+    };
+
+    for (size_t i = 0; i < after.names.size(); i++) {
+        const std::string& name = after.names[i];
+        const Entry& entry = after.entries[i];
+        auto found = before.index.find(name);
+        const Entry* previous = found == before.index.end() ? nullptr : &before.entries[found->second];
+
+        if (!previous || previous->type != entry.type) {
+            changes->proxies.push_back({name, entry.type, entry.delay});
+        } else if (previous->delay != entry.delay) {
+            changes->delays.emplace_back(name, entry.delay);
+        }
+
+        if (entry.group) {
+            if (!previous || !previous->group || previous->type != entry.type || !sameMembers(*previous, entry)) {
+                Group group;
+                group.name = name;
+                group.type = entry.type;
+                group.now = entry.now;
+                group.members.reserve(entry.members.size());
+                for (uint32_t member : entry.members) group.members.push_back(after.names[member]);
+                changes->groups.push_back(std::move(group));
+            } else if (previous->now != entry.now) {
+                changes->selections.push_back({name, entry.now});
+            }
+        } else if (previous && previous->group) {
+            changes->removedGroups.push_back(name);
+        }
+    }
+
+    for (size_t i = 0; i < before.names.size(); i++) {
+        if (after.index.count(before.names[i]) != 0) continue;
+        changes->removedProxies.push_back(before.names[i]);
+        if (before.entries[i].group) changes->removedGroups.push_back(before.names[i]);
+    }
+}
+
+bool ProxyTopology::Refresh() {
+    std::lock_guard<std::mutex> refreshLock(refreshMutex_);
+    auto& core = MihomoCore::GetInstance();
+    Changes changes;
+    bool ok = false;
+    if (!core.IsRunning()) {
+        // The groups went with the core
+        ok = Update("{}", &changes);
+    } else {
+        std::string json = core.GetProxies();
+        if (json.empty()) return false;
+        ok = Update(json, &changes);
+    }
+    if (!ok || changes.Empty()) return ok;
+
+    ChangeCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        callback = callback_;
+    }
+    if (callback) callback(changes);
+    return true;
+}
+
+void ProxyTopology::RequestRefresh() {
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        if (!watching_) return;
+        pending_ = true;
+    }
+    watchCv_.notify_one();
+}
+
+void ProxyTopology::Watch(int intervalMs) {
+    std::lock_guard<std::mutex> lock(watchMutex_);
+    intervalMs_ = std::max(intervalMs, kMinIntervalMs);
+    watching_ = true;
+    if (running_) {
+        // Also picks up a thread that is still finishing after an Unwatch
+        watchCv_.notify_one();
+        return;
+    }
+    running_ = true;
+    std::thread([this]() { Run(); }).detach();
+}
+
+void ProxyTopology::Unwatch() {
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        watching_ = false;
+    }
+    // Not joined: the thread may be waiting on the controller
+    watchCv_.notify_one();
+}
+
+void ProxyTopology::Run() {
+    IdleBudget::TagThread("proxy_topology");
+    std::unique_lock<std::mutex> lock(watchMutex_);
+    while (watching_) {
+        watchCv_.wait_for(lock, std::chrono::milliseconds(intervalMs_),
+                          [this]() { return !watching_ || pending_; });
+        if (!watching_) break;
+        pending_ = false;
+        lock.unlock();
+        Refresh();
+        lock.lock();
+    }
+    running_ = false;
+    watchCv_.notify_all();
+}
+
+std::vector<uint8_t> ProxyTopology::Snapshot() {
+    std::shared_ptr<const Model> model;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        model = model_;
+        version = version_;
+    }
+
+    std::vector<uint8_t> out(kSnapshotMagic, kSnapshotMagic + sizeof(kSnapshotMagic));
+    WriteVarint(&out, version);
+    if (!model) {
+        WriteVarint(&out, 0);
+        WriteVarint(&out, 0);
+        return out;
+    }
+
+    size_t groups = 0;
+    WriteVarint(&out, model->names.size());
+    for (size_t i = 0; i < model->names.size(); i++) {
+        const Entry& entry = model->entries[i];
+        WriteString(&out, model->names[i]);
+        WriteString(&out, entry.type);
+        WriteVarint(&out, static_cast<uint64_t>(std::max(entry.delay, -1) + 1));
+        if (entry.group) groups++;
+    }
+    WriteVarint(&out, groups);
+    for (size_t i = 0; i < model->names.size(); i++) {
+        const Entry& entry = model->entries[i];
+        if (!entry.group) continue;
+        WriteVarint(&out, i);
+        auto now = model->index.find(entry.now);
+        WriteVarint(&out, now == model->index.end() ? 0 : now->second + 1);
+        WriteVarint(&out, entry.members.size());
+        for (uint32_t member : entry.members) WriteVarint(&out, member);
+    }
+    return out;
+}
+
+uint64_t ProxyTopology::Version() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return version_;
+}
+
+void ProxyTopology::SetCallback(ChangeCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    callback_ = std::move(callback);
+}
+
+size_t ProxyTopology::Trim() {
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        if (watching_) return 0;
+    }
+
+    std::lock_guard<std::mutex> refreshLock(refreshMutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!model_) return 0;
+    size_t bytes = sizeof(Model);
+    for (size_t i = 0; i < model_->names.size(); i++) {
+        const Entry& entry = model_->entries[i];
+        bytes += sizeof(std::string) + sizeof(Entry) + model_->names[i].capacity() +
+                 entry.type.capacity() + entry.now.capacity() +
+                 entry.members.capacity() * sizeof(uint32_t) +
+                 sizeof(std::pair<std::string, uint32_t>) + sizeof(void*);
+    }
+    model_.reset();
+    version_++;
+    return bytes;
+}
+
+void ProxyTopology::Reset() {
+    std::lock_guard<std::mutex> refreshLock(refreshMutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    model_.reset();
+    version_++;
+}
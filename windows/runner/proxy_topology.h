@@ -0,0 +1,150 @@
+// proxy_topology.h - Incremental proxy-group topology for Windows
+#ifndef PROXY_TOPOLOGY_H_
+#define PROXY_TOPOLOGY_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Native model of the core's proxy groups: every proxy with its type and
+// last delay, and every group with its members and current selection.
+//
+// The model is refreshed from /proxies and each refresh is diffed against
+// the previous one, so a listener is sent only what changed: the groups
+// whose type or members changed (in full), the selections that moved and
+// the delays that changed. With a few thousand proxies in dozens of groups
+// a switch or a delay test produces a change set of a few entries instead
+// of the whole tree. A listener loads the model once from the binary
+// snapshot and then applies change sets whose base matches its version,
+// fetching a new snapshot when one does not.
+//
+// Refreshes run on request (after a switch, a reload or a delay test) and
+// on a slow poll while something is watching, which catches url-test and
+// fallback groups moving on their own.
+class ProxyTopology {
+public:
+    struct Proxy {
+        std::string name;
+        std::string type;
+        int delay = -1;  // Last history entry; 0 when it failed, -1 when never tested
+    };
+
+    struct Group {
+        std::string name;
+        std::string type;
+        std::string now;
+        std::vector<std::string> members;
+    };
+
+    struct Selection {
+        std::string group;
+        std::string now;
+    };
+
+    struct Changes {
+        uint64_t base = 0;     // Version the changes apply to
+        uint64_t version = 0;  // Version after applying them
+        std::vector<Group> groups;           // Added, or type or members changed
+        std::vector<std::string> removedGroups;
+        std::vector<Selection> selections;   // Groups not listed in groups
+        std::vector<Proxy> proxies;          // Added, or type changed
+        std::vector<std::string> removedProxies;
+        std::vector<std::pair<std::string, int>> delays;  // Proxies not listed in proxies
+
+        bool Empty() const {
+            return groups.empty() && removedGroups.empty() && selections.empty() &&
+                   proxies.empty() && removedProxies.empty() && delays.empty();
+        }
+    };
+
+    using ChangeCallback = std::function<void(const Changes& changes)>;
+
+    static ProxyTopology& GetInstance();
+
+    // Diffs a /proxies response against the model and adopts it. Returns
+    // false, leaving the model alone, when the response does not parse.
+    bool Update(const std::string& proxiesJson, Changes* changes);
+
+    // Fetches /proxies and updates, reporting any changes to the callback.
+    // Returns false when the core did not answer or the response did not parse.
+    bool Refresh();
+
+    // Refreshes soon on the watch thread; does nothing while not watching
+    void RequestRefresh();
+
+    // Polls every intervalMs (at least kMinIntervalMs) on a thread of its
+    // own until Unwatch; neither call waits for a refresh in progress
+    void Watch(int intervalMs);
+    void Unwatch();
+
+    // Compact encoding of the whole model, little endian with LEB128
+    // integers:
+    //   "VPT1", version
+    //   proxy count, then per proxy: name, type, delay + 1
+    //   group count, then per group: proxy index of the group, index of
+    //     now + 1 (0 when none), member count, member indices
+    // Strings are a length followed by UTF-8 bytes.
+    std::vector<uint8_t> Snapshot();
+
+    uint64_t Version();
+    void SetCallback(ChangeCallback callback);
+
+    // Forgets the model, e.g. when the core stops
+    void Reset();
+
+    // Forgets the model while nobody watches; the next Refresh rebuilds it.
+    // Returns the approximate bytes released.
+    size_t Trim();
+
+    static constexpr int kMinIntervalMs = 5000;
+
+private:
+    struct Entry {
+        std::string type;
+        std::string now;
+        int delay = -1;
+        bool group = false;
+        std::vector<uint32_t> members;  // Indices into Model::names
+    };
+
+    // Proxies in the order /proxies lists them; groups are the entries that
+    // have members
+    struct Model {
+        std::vector<std::string> names;
+        std::vector<Entry> entries;
+        std::unordered_map<std::string, uint32_t> index;
+    };
+
+    ProxyTopology() = default;
+    ~ProxyTopology();
+    ProxyTopology(const ProxyTopology&) = delete;
+    ProxyTopology& operator=(const ProxyTopology&) = delete;
+
+    void Run();
+    static void Diff(const Model& before, const Model& after, Changes* changes);
+
+    std::mutex mutex_;
+    std::shared_ptr<const Model> model_;
+    uint64_t version_ = 0;
+
+    std::mutex callbackMutex_;
+    ChangeCallback callback_;
+
+    // Serializes fetch and adopt so responses are applied in order
+    std::mutex refreshMutex_;
+
+    std::mutex watchMutex_;
+    std::condition_variable watchCv_;
+    bool watching_ = false;
+    bool running_ = false;
+    bool pending_ = false;
+    int intervalMs_ = 30000;
+};
+
+#endif  // PROXY_TOPOLOGY_H_
@@ -0,0 +1,263 @@
+// raw_inflate.cpp - Raw DEFLATE decoder implementation
+#include "raw_inflate.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr size_t kWindowSize = 32768;
+constexpr int kMaxBits = 15;
+
+// Canonical Huffman table: code counts per length and symbols in code order
+struct Huffman {
+    uint16_t count[kMaxBits + 1];
+    uint16_t symbol[288];
+};
+
+const uint8_t kSyncTail[4] = {0x00, 0x00, 0xff, 0xff};
+
+const uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint16_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577};
+const uint16_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+class Decoder {
+public:
+    Decoder(const uint8_t* data, size_t size, bool syncTail, std::string* out)
+        : data_(data), dataSize_(size), size_(size + (syncTail ? sizeof(kSyncTail) : 0)), out_(out) {}
+
+    // Decodes blocks until BFINAL or until the input is used up at a block
+    // boundary (sync-flushed permessage-deflate messages have no BFINAL)
+    bool Run() {
+        while (true) {
+            if (pos_ >= size_ && bitCount_ == 0) return true;
+            int last = Bits(1);
+            int type = Bits(2);
+            if (error_) return false;
+
+            bool ok = false;
+            switch (type) {
+                case 0: ok = Stored(); break;
+                case 1: ok = Fixed(); break;
+                case 2: ok = Dynamic(); break;
+                default: return false;
+            }
+            if (!ok || error_) return false;
+            if (last) return true;
+            // The tail ends on a byte boundary; leftover padding bits are zero
+            if (pos_ >= size_) return true;
+        }
+    }
+
+private:
+    uint8_t At(size_t index) const {
+        return index < dataSize_ ? data_[index] : kSyncTail[index - dataSize_];
+    }
+
+    int Bits(int need) {
+        uint32_t value = bitBuffer_;
+        while (bitCount_ < need) {
+            if (pos_ >= size_) {
+                error_ = true;
+                return 0;
+            }
+            value |= static_cast<uint32_t>(At(pos_++)) << bitCount_;
+            bitCount_ += 8;
+        }
+        bitBuffer_ = value >> need;
+        bitCount_ -= need;
+        return static_cast<int>(value & ((1u << need) - 1));
+    }
+
+    bool Stored() {
+        bitBuffer_ = 0;
+        bitCount_ = 0;
+        if (pos_ + 4 > size_) return false;
+        unsigned length = At(pos_) | (At(pos_ + 1) << 8);
+        unsigned check = At(pos_ + 2) | (At(pos_ + 3) << 8);
+        pos_ += 4;
+        if (length != (~check & 0xffff)) return false;
+        if (pos_ + length > size_) return false;
+        // Copy straight from the input; only a stored block that runs into the
+        // virtual tail needs the byte-wise path
+        size_t direct = pos_ < dataSize_ ? std::min<size_t>(length, dataSize_ - pos_) : 0;
+        out_->append(reinterpret_cast<const char*>(data_ + pos_), direct);
+        for (size_t i = direct; i < length; i++) out_->push_back(static_cast<char>(At(pos_ + i)));
+        pos_ += length;
+        return true;
+    }
+
+    int Decode(const Huffman& h) {
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int len = 1; len <= kMaxBits; len++) {
+            code |= Bits(1);
+            if (error_) return -1;
+            int count = h.count[len];
+            if (code - count < first) {
+                return h.symbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    static bool Build(Huffman* h, const uint8_t* lengths, int n) {
+        for (int len = 0; len <= kMaxBits; len++) h->count[len] = 0;
+        for (int symbol = 0; symbol < n; symbol++) h->count[lengths[symbol]]++;
+        if (h->count[0] == n) return true;
+
+        int left = 1;
+        for (int len = 1; len <= kMaxBits; len++) {
+            left <<= 1;
+            left -= h->count[len];
+            if (left < 0) return false;  // Over-subscribed
+        }
+
+        uint16_t offsets[kMaxBits + 1];
+        offsets[1] = 0;
+        for (int len = 1; len < kMaxBits; len++) {
+            offsets[len + 1] = offsets[len] + h->count[len];
+        }
+        for (int symbol = 0; symbol < n; symbol++) {
+            if (lengths[symbol] != 0) h->symbol[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+        }
+        return true;
+    }
+
+    bool Codes(const Huffman& lengthCode, const Huffman& distCode) {
+        while (true) {
+            int symbol = Decode(lengthCode);
+            if (symbol < 0) return false;
+            if (symbol < 256) {
+                out_->push_back(static_cast<char>(symbol));
+                continue;
+            }
+            if (symbol == 256) return true;
+
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            size_t length = kLengthBase[symbol] + Bits(kLengthExtra[symbol]);
+
+            int distSymbol = Decode(distCode);
+            if (distSymbol < 0 || distSymbol >= 30) return false;
+            size_t distance = kDistBase[distSymbol] + Bits(kDistExtra[distSymbol]);
+            if (error_ || distance > out_->size()) return false;
+
+            // Byte by byte: the source may overlap what is being written
+            size_t from = out_->size() - distance;
+            for (size_t i = 0; i < length; i++) {
+                out_->push_back((*out_)[from + i]);
+            }
+        }
+    }
+
+    bool Fixed() {
+        static Huffman lengthCode;
+        static Huffman distCode;
+        static bool built = [] {
+            uint8_t lengths[288];
+            int symbol = 0;
+            for (; symbol < 144; symbol++) lengths[symbol] = 8;
+            for (; symbol < 256; symbol++) lengths[symbol] = 9;
+            for (; symbol < 280; symbol++) lengths[symbol] = 7;
+            for (; symbol < 288; symbol++) lengths[symbol] = 8;
+            Build(&lengthCode, lengths, 288);
+            for (symbol = 0; symbol < 30; symbol++) lengths[symbol] = 5;
+            Build(&distCode, lengths, 30);
+            return true;
+        }();
+        (void)built;
+        return Codes(lengthCode, distCode);
+    }
+
+    bool Dynamic() {
+        static const uint8_t kOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        int nlen = Bits(5) + 257;
+        int ndist = Bits(5) + 1;
+        int ncode = Bits(4) + 4;
+        if (error_ || nlen > 286 || ndist > 30) return false;
+
+        uint8_t lengths[320] = {};
+        for (int i = 0; i < ncode; i++) lengths[kOrder[i]] = static_cast<uint8_t>(Bits(3));
+
+        Huffman codeLengths;
+        if (!Build(&codeLengths, lengths, 19)) return false;
+
+        int index = 0;
+        while (index < nlen + ndist) {
+            int symbol = Decode(codeLengths);
+            if (symbol < 0) return false;
+            if (symbol < 16) {
+                lengths[index++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            uint8_t value = 0;
+            int repeat;
+            if (symbol == 16) {
+                if (index == 0) return false;
+                value = lengths[index - 1];
+                repeat = 3 + Bits(2);
+            } else if (symbol == 17) {
+                repeat = 3 + Bits(3);
+            } else {
+                repeat = 11 + Bits(7);
+            }
+            if (index + repeat > nlen + ndist) return false;
+            while (repeat--) lengths[index++] = value;
+        }
+        if (lengths[256] == 0) return false;
+
+        Huffman lengthCode;
+        Huffman distCode;
+        if (!Build(&lengthCode, lengths, nlen)) return false;
+        if (!Build(&distCode, lengths + nlen, ndist)) return false;
+        return Codes(lengthCode, distCode);
+    }
+
+    const uint8_t* data_;
+    size_t dataSize_;
+    size_t size_;
+    size_t pos_ = 0;
+    uint32_t bitBuffer_ = 0;
+    int bitCount_ = 0;
+    bool error_ = false;
+    std::string* out_;
+};
+
+}  // namespace
+
+bool RawInflater::Inflate(const uint8_t* data, size_t size, bool syncTail, std::string* out) {
+    // Decode after the window so back references can reach into it
+    std::string buffer;
+    buffer.swap(window_);
+    size_t base = buffer.size();
+
+    Decoder decoder(data, size, syncTail, &buffer);
+    if (!decoder.Run()) {
+        window_.clear();
+        return false;
+    }
+
+    out->append(buffer, base, std::string::npos);
+
+    if (keepWindow_) {
+        if (buffer.size() > kWindowSize) buffer.erase(0, buffer.size() - kWindowSize);
+        window_.swap(buffer);
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+// raw_inflate.h - Raw DEFLATE decoder for permessage-deflate
+#ifndef RAW_INFLATE_H_
+#define RAW_INFLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal RFC 1951 decoder (stored, fixed and dynamic Huffman blocks) for
+// the server-to-client direction of permessage-deflate. Input is one
+// message as received; the 00 00 FF FF tail the sender stripped is supplied
+// virtually so the payload can be decoded straight out of the receive
+// buffer. Unless the server agreed to no context takeover, the last 32 KB of
+// output stays as the window for the next message.
+class RawInflater {
+public:
+    void SetKeepWindow(bool keep) { keepWindow_ = keep; }
+
+    // Appends the decoded message to *out. Returns false on corrupt input,
+    // after which the window is reset. With syncTail the stripped
+    // 00 00 FF FF is appended to the input.
+    bool Inflate(const uint8_t* data, size_t size, bool syncTail, std::string* out);
+
+    void Reset() { window_.clear(); }
+
+private:
+    bool keepWindow_ = true;
+    std::string window_;
+};
+
+#endif  // RAW_INFLATE_H_
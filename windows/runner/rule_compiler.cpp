@@ -0,0 +1,407 @@
+// rule_compiler.cpp - Rule-set compiler implementation
+#include "rule_compiler.h"
+#include "flight_recorder.h"
+#include "utils.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const char kRuleSetDir[] = "ruleset";
+const char kProviderPrefix[] = "vortex-";
+
+// Shorter runs parse quickly enough inline
+constexpr size_t kMinRunRules = 256;
+
+constexpr DWORD kConvertTimeoutMs = 60000;
+
+// Sets no config has referenced for this long are deleted
+constexpr auto kPruneAge = std::chrono::hours(24 * 14);
+
+enum class RuleKind { Other, Domain, Ip, IpNoResolve };
+
+struct RuleEntry {
+    size_t line = 0;
+    RuleKind kind = RuleKind::Other;
+    std::string target;
+    std::string payload;  // As written in a text rule set
+};
+
+std::string ToLower(std::string value) {
+    for (char& c : value) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return value;
+}
+
+// Parses one rule list item; the text after "- "
+RuleEntry ParseRule(const std::string& item) {
+    RuleEntry entry;
+
+    std::string text = item;
+    size_t comment = text.find(" #");
+    if (comment != std::string::npos) text = text.substr(0, comment);
+    text = Trim(text);
+    if (text.size() >= 2 && (text.front() == '\'' || text.front() == '"') && text.back() == text.front()) {
+        text = text.substr(1, text.size() - 2);
+    }
+
+    std::vector<std::string> fields;
+    std::stringstream stream(text);
+    std::string field;
+    while (std::getline(stream, field, ',')) fields.push_back(Trim(field));
+    if (fields.size() < 3 || fields[1].empty()) return entry;
+
+    bool noResolve = false;
+    for (size_t i = 3; i < fields.size(); i++) {
+        if (fields[i] == "no-resolve") {
+            noResolve = true;
+        } else {
+            return entry;  // Other parameters have no rule-set equivalent
+        }
+    }
+
+    const std::string& type = fields[0];
+    const std::string& payload = fields[1];
+    if (type == "DOMAIN" || type == "DOMAIN-SUFFIX") {
+        // Wildcards mean something else inside a domain set
+        if (payload.find_first_of("*+ ") != std::string::npos || payload[0] == '.') return entry;
+        entry.kind = RuleKind::Domain;
+        entry.payload = (type == "DOMAIN-SUFFIX" ? "+." : "") + ToLower(payload);
+    } else if (type == "IP-CIDR" || type == "IP-CIDR6") {
+        if (payload.find('/') == std::string::npos) return entry;
+        entry.kind = noResolve ? RuleKind::IpNoResolve : RuleKind::Ip;
+        entry.payload = payload;
+    } else {
+        return entry;
+    }
+    entry.target = fields[2];
+    return entry;
+}
+
+uint64_t HashSet(const char* behavior, const std::vector<std::string>& payloads) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const std::string& text) {
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= '\n';
+        hash *= 1099511628211ULL;
+    };
+    mix(behavior);
+    for (const auto& payload : payloads) mix(payload);
+    return hash;
+}
+
+bool FileExists(const std::string& path) {
+    return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+// Prune goes by modification time, so a set still in use is touched each
+// time a config picks it up again
+void Touch(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+}
+
+}  // namespace
+
+RuleCompiler& RuleCompiler::GetInstance() {
+    static RuleCompiler instance;
+    return instance;
+}
+
+void RuleCompiler::Init(const std::string& workDir, const std::string& corePath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dir_ = workDir + "\\" + kRuleSetDir;
+    corePath_ = corePath;
+    converterFailed_ = false;
+    CreateDirectoryA(dir_.c_str(), nullptr);
+}
+
+RuleCompiler::Report RuleCompiler::GetLastReport() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastReport_;
+}
+
+bool RuleCompiler::CompileConfig(std::string* content, Report* report) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto started = std::chrono::steady_clock::now();
+    Report result;
+    converterRetry_ = converterFailed_;
+
+    std::vector<std::string> lines;
+    {
+        std::string line;
+        std::istringstream stream(*content);
+        while (std::getline(stream, line)) lines.push_back(line);
+    }
+
+    // Locate the top-level rules: list and any rule-providers: map
+    size_t first = lines.size();
+    size_t providersLine = lines.size();
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].compare(0, 6, "rules:") == 0) {
+            std::string rest = Trim(lines[i].substr(6));
+            if (rest.empty() || rest[0] == '#') first = i + 1;
+        } else if (lines[i].compare(0, 15, "rule-providers:") == 0) {
+            std::string rest = Trim(lines[i].substr(15));
+            if (!rest.empty() && rest[0] != '#' && rest != "{}") return false;  // Inline map
+            providersLine = i;
+        }
+    }
+
+    // New providers follow the indentation of the existing ones: the first
+    // entry sets the key indent, the first deeper line the field indent
+    std::string keyIndent = "  ";
+    std::string fieldIndent = "    ";
+    if (providersLine < lines.size()) {
+        bool haveKey = false;
+        for (size_t i = providersLine + 1; i < lines.size(); i++) {
+            const std::string& line = lines[i];
+            size_t width = line.find_first_not_of(' ');
+            if (width == std::string::npos || line[width] == '#') continue;
+            if (width == 0) break;
+            if (!haveKey) {
+                keyIndent.assign(width, ' ');
+                fieldIndent.assign(width * 2, ' ');
+                haveKey = true;
+            } else if (width > keyIndent.size()) {
+                fieldIndent.assign(width, ' ');
+                break;
+            }
+        }
+    }
+
+    std::vector<RuleEntry> entries;
+    for (size_t i = first; i < lines.size(); i++) {
+        const std::string& line = lines[i];
+        std::string trimmed = Trim(line);
+        if (trimmed.empty() || trimmed[0] == '#') continue;
+        if (line[0] != ' ' && line[0] != '\t' && line[0] != '-') break;
+        if (trimmed[0] != '-') break;
+
+        RuleEntry entry = ParseRule(trimmed.substr(1));
+        entry.line = i;
+        entries.push_back(std::move(entry));
+    }
+    result.rules = static_cast<int>(entries.size());
+
+    // Replace each long run with one RULE-SET rule on the run's first line
+    std::vector<bool> dropped(lines.size(), false);
+    std::vector<std::string> providers;
+    std::unordered_set<std::string> keep;
+    size_t start = 0;
+    while (start < entries.size()) {
+        size_t end = start + 1;
+        if (entries[start].kind != RuleKind::Other) {
+            while (end < entries.size() &&
+                   entries[end].kind == entries[start].kind &&
+                   entries[end].target == entries[start].target) {
+                end++;
+            }
+        }
+        if (end - start < kMinRunRules) {
+            start = end;
+            continue;
+        }
+
+        const char* behavior = entries[start].kind == RuleKind::Domain ? "domain" : "ipcidr";
+        std::vector<std::string> payloads;
+        payloads.reserve(end - start);
+        for (size_t i = start; i < end; i++) payloads.push_back(entries[i].payload);
+
+        std::string name;
+        bool reused = false;
+        std::string file = CompileSet(behavior, &payloads, &name, &reused);
+        if (file.empty()) {
+            start = end;
+            continue;
+        }
+        keep.insert(file);
+
+        bool binary = file.size() > 4 && file.compare(file.size() - 4, 4, ".mrs") == 0;
+        if (!binary) result.binary = false;
+        if (reused) {
+            result.reused++;
+        } else {
+            result.compiled++;
+        }
+        result.providers++;
+        result.extracted += static_cast<int>(end - start);
+
+        providers.push_back(keyIndent + name + ":");
+        providers.push_back(fieldIndent + "type: file");
+        providers.push_back(fieldIndent + "behavior: " + behavior);
+        providers.push_back(fieldIndent + "format: " + (binary ? "mrs" : "text"));
+        providers.push_back(fieldIndent + "path: ./" + kRuleSetDir + "/" + file);
+
+        const std::string& firstLine = lines[entries[start].line];
+        std::string indent = firstLine.substr(0, firstLine.find('-'));
+        std::string rule = indent + "- RULE-SET," + name + "," + entries[start].target;
+        if (entries[start].kind == RuleKind::IpNoResolve) rule += ",no-resolve";
+        lines[entries[start].line] = rule;
+        for (size_t i = entries[start].line + 1; i <= entries[end - 1].line; i++) dropped[i] = true;
+
+        start = end;
+    }
+
+    Prune(keep);
+
+    result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    if (result.providers == 0) result.binary = false;
+    lastReport_ = result;
+    if (report) *report = result;
+    if (result.providers == 0) return false;
+
+    std::vector<std::string> output;
+    output.reserve(lines.size() + providers.size() + 1);
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (dropped[i]) continue;
+        if (i == providersLine) {
+            output.push_back("rule-providers:");
+            output.insert(output.end(), providers.begin(), providers.end());
+            continue;
+        }
+        output.push_back(lines[i]);
+    }
+    if (providersLine == lines.size()) {
+        output.push_back("rule-providers:");
+        output.insert(output.end(), providers.begin(), providers.end());
+    }
+
+    std::string rebuilt;
+    rebuilt.reserve(content->size() / 4);
+    for (const auto& line : output) {
+        rebuilt += line;
+        rebuilt += '\n';
+    }
+    content->swap(rebuilt);
+
+    FlightRecorder::Record(FlightRecorder::Category::Runner, FlightRecorder::Level::Info,
+                           "rule sets compiled", result.extracted);
+    return true;
+}
+
+std::string RuleCompiler::CompileSet(const char* behavior, std::vector<std::string>* payloads,
+                                     std::string* name, bool* reused) {
+    // Sorted so that reordering a run does not produce a new set
+    std::sort(payloads->begin(), payloads->end());
+    payloads->erase(std::unique(payloads->begin(), payloads->end()), payloads->end());
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(HashSet(behavior, *payloads)));
+    *name = std::string(kProviderPrefix) + hex;
+
+    std::string binaryFile = std::string(hex) + ".mrs";
+    std::string textFile = std::string(hex) + ".txt";
+    std::string binaryPath = dir_ + "\\" + binaryFile;
+    std::string textPath = dir_ + "\\" + textFile;
+
+    if (FileExists(binaryPath)) {
+        *reused = true;
+        Touch(binaryPath);
+        return binaryFile;
+    }
+
+    *reused = FileExists(textPath);
+    if (*reused) Touch(textPath);
+    if (!*reused) {
+        std::string tempPath = textPath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return "";
+            for (const auto& payload : *payloads) file << payload << '\n';
+            if (!file) return "";
+        }
+        if (!MoveFileExA(tempPath.c_str(), textPath.c_str(), MOVEFILE_REPLACE_EXISTING)) return "";
+    }
+
+    // After a failure the converter gets one attempt per compile, so a
+    // core that was missing or broken is picked up again once it works
+    if (!converterFailed_ || converterRetry_) {
+        converterRetry_ = false;
+        if (ConvertToBinary(behavior, textPath, binaryPath)) {
+            converterFailed_ = false;
+            *reused = false;
+            return binaryFile;
+        }
+    }
+    return textFile;
+}
+
+bool RuleCompiler::ConvertToBinary(const char* behavior, const std::string& textPath,
+                                   const std::string& binaryPath) {
+    if (corePath_.empty() || !FileExists(corePath_)) return false;
+
+    // Convert into a temp file so an interrupted run is never taken for a
+    // finished set
+    std::string tempPath = binaryPath + ".tmp";
+    std::string cmdLine = "\"" + corePath_ + "\" convert-ruleset " + behavior + " text \"" +
+                          textPath + "\" \"" + tempPath + "\"";
+
+    STARTUPINFOA si = {0};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_HIDE;
+
+    PROCESS_INFORMATION pi = {0};
+    if (!CreateProcessA(nullptr, &cmdLine[0], nullptr, nullptr, FALSE, CREATE_NO_WINDOW,
+                        nullptr, dir_.c_str(), &si, &pi)) {
+        converterFailed_ = true;
+        return false;
+    }
+
+    DWORD exitCode = 1;
+    if (WaitForSingleObject(pi.hProcess, kConvertTimeoutMs) == WAIT_OBJECT_0) {
+        GetExitCodeProcess(pi.hProcess, &exitCode);
+    } else {
+        TerminateProcess(pi.hProcess, 1);
+        WaitForSingleObject(pi.hProcess, 5000);
+    }
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+
+    if (exitCode != 0 || !FileExists(tempPath) ||
+        !MoveFileExA(tempPath.c_str(), binaryPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileA(tempPath.c_str());
+        converterFailed_ = true;
+        FlightRecorder::Record(FlightRecorder::Category::Runner, FlightRecorder::Level::Warning,
+                               "rule set conversion failed", static_cast<int64_t>(exitCode));
+        return false;
+    }
+    return true;
+}
+
+void RuleCompiler::Prune(const std::unordered_set<std::string>& keep) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::directory_iterator it(dir_, ec);
+    if (ec) return;
+
+    auto cutoff = fs::file_time_type::clock::now() - kPruneAge;
+    for (; it != fs::directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        std::string file = it->path().filename().string();
+        if (keep.count(file) != 0) continue;
+
+        // Only files this compiler names: 16 hex digits plus an extension
+        if (file.size() < 17 || file[16] != '.' ||
+            file.find_first_not_of("0123456789abcdef") < 16) {
+            continue;
+        }
+
+        auto modified = fs::last_write_time(it->path(), ec);
+        if (ec || modified > cutoff) continue;
+        fs::remove(it->path(), ec);
+    }
+}
@@ -0,0 +1,71 @@
+// rule_compiler.h - Compiles inline rule lists into rule-set providers for Windows
+#ifndef RULE_COMPILER_H_
+#define RULE_COMPILER_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Moves long runs of inline DOMAIN/DOMAIN-SUFFIX or IP-CIDR/IP-CIDR6 rules
+// out of a config into rule-set files, replacing each run with a single
+// RULE-SET rule. The core then loads those sets into its domain trie or
+// CIDR table instead of parsing thousands of YAML list items on every start
+// and reload.
+//
+// A run is a stretch of adjacent rules of one kind sending traffic to the
+// same target, so a single set matching any of them gives the same result.
+// IP rules with and without no-resolve never share a run.
+//
+// Sets are written in the text format and then converted to mihomo's
+// binary mrs format by the core binary itself (mihomo convert-ruleset).
+// Files are named after a hash of their content and reused as long as
+// they exist; if conversion fails the text file is used as is. Reuse
+// refreshes a file's modification time, and files left untouched for two
+// weeks are pruned.
+class RuleCompiler {
+public:
+    struct Report {
+        int rules = 0;       // Rule entries in the config
+        int extracted = 0;   // Rules moved into sets
+        int providers = 0;   // RULE-SET rules that replaced them
+        int reused = 0;      // Sets found already compiled
+        int compiled = 0;    // Sets written this time
+        bool binary = true;  // Every set is in mrs format
+        int64_t elapsedMs = 0;
+    };
+
+    static RuleCompiler& GetInstance();
+
+    // corePath is the mihomo binary used for conversion
+    void Init(const std::string& workDir, const std::string& corePath);
+
+    // Rewrites the rules: section. Returns false, leaving the content
+    // untouched, when no run is long enough to be worth a set.
+    bool CompileConfig(std::string* content, Report* report);
+
+    Report GetLastReport();
+
+private:
+    RuleCompiler() = default;
+    RuleCompiler(const RuleCompiler&) = delete;
+    RuleCompiler& operator=(const RuleCompiler&) = delete;
+
+    // Returns the file name of the set within the rule-set directory, or
+    // an empty string if it could not be written
+    std::string CompileSet(const char* behavior, std::vector<std::string>* payloads,
+                           std::string* name, bool* reused);
+    bool ConvertToBinary(const char* behavior, const std::string& textPath,
+                         const std::string& binaryPath);
+    void Prune(const std::unordered_set<std::string>& keep);
+
+    std::mutex mutex_;
+    std::string dir_;
+    std::string corePath_;
+    bool converterFailed_ = false;  // Skip conversion until a retry succeeds
+    bool converterRetry_ = false;   // The current compile may still retry once
+    Report lastReport_;
+};
+
+#endif  // RULE_COMPILER_H_
@@ -0,0 +1,364 @@
+// rule_stats.cpp - Rule hit statistics and rule-order optimizer implementation
+#include "rule_stats.h"
+#include "controller_streams.h"
+#include "flight_recorder.h"
+#include "json_reader.h"
+#include "utils.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const char kStatsFileName[] = "rule_stats.tsv";
+const char kStatsHeader[] = "# vortex rule stats v1";
+const char kStreamName[] = "core.rule_stats";
+
+// Counts older than this are dropped on load
+constexpr int64_t kMaxAgeSeconds = 30 * 24 * 3600;
+
+// Below this many sampled hits the order is left alone
+constexpr int64_t kMinSampledHits = 20;
+
+// Snapshots arrive about once per second
+constexpr int kSaveEverySnapshots = 300;
+
+// "DOMAIN-SUFFIX" in configs and "DomainSuffix" in /connections both
+// become "DOMAINSUFFIX"
+std::string NormalizeType(const std::string& type) {
+    std::string result;
+    result.reserve(type.size());
+    for (char c : type) {
+        if (c == '-' || c == '_') continue;
+        result.push_back(static_cast<char>(toupper(static_cast<unsigned char>(c))));
+    }
+    return result;
+}
+
+struct RuleEntry {
+    size_t line = 0;
+    std::string key;     // Normalized "TYPE,payload" as reported by the core
+    std::string target;
+    bool movable = false;
+    bool resolves = false;
+    int64_t hits = 0;
+};
+
+// Parses one rule list item; the text after "- "
+RuleEntry ParseRule(const std::string& item) {
+    RuleEntry entry;
+
+    std::string text = item;
+    size_t comment = text.find(" #");
+    if (comment != std::string::npos) text = text.substr(0, comment);
+    text = Trim(text);
+    if (text.size() >= 2 && (text.front() == '\'' || text.front() == '"') && text.back() == text.front()) {
+        text = text.substr(1, text.size() - 2);
+    }
+
+    std::vector<std::string> fields;
+    std::stringstream stream(text);
+    std::string field;
+    while (std::getline(stream, field, ',')) fields.push_back(Trim(field));
+    if (fields.empty()) return entry;
+
+    std::string type = NormalizeType(fields[0]);
+    if (type == "MATCH") {
+        entry.key = "MATCH,";
+        return entry;
+    }
+    entry.key = type + "," + (fields.size() > 1 ? fields[1] : "");
+
+    // Logic rules carry commas inside their payload and SUB-RULE jumps
+    // elsewhere; neither is safe to move
+    if (type == "AND" || type == "OR" || type == "NOT" || type == "SUBRULE" || fields.size() < 3) {
+        return entry;
+    }
+
+    entry.target = fields[2];
+    entry.movable = true;
+
+    bool noResolve = false;
+    for (size_t i = 3; i < fields.size(); i++) {
+        if (fields[i] == "no-resolve") noResolve = true;
+    }
+    bool ipRule = type == "IPCIDR" || type == "IPCIDR6" || type == "IPSUFFIX" ||
+                  type == "IPASN" || type == "GEOIP" || type == "RULESET";
+    entry.resolves = ipRule && !noResolve;
+    return entry;
+}
+
+double MeanDepth(const std::vector<int64_t>& hitsByPosition) {
+    int64_t total = 0;
+    double weighted = 0;
+    for (size_t i = 0; i < hitsByPosition.size(); i++) {
+        total += hitsByPosition[i];
+        weighted += static_cast<double>(hitsByPosition[i]) * static_cast<double>(i + 1);
+    }
+    return total > 0 ? weighted / static_cast<double>(total) : 0;
+}
+
+}  // namespace
+
+RuleStats& RuleStats::GetInstance() {
+    static RuleStats instance;
+    return instance;
+}
+
+void RuleStats::Init(const std::string& workDir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = workDir + "\\" + kStatsFileName;
+    loaded_ = false;
+}
+
+void RuleStats::Start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Load();
+        previousIds_.clear();
+    }
+
+    ControllerStreams::StreamOptions options;
+    options.path = "/connections";
+    options.mode = ControllerStreams::Mode::Latest;
+    ControllerStreams::GetInstance().Subscribe(kStreamName, options,
+        [this](const ControllerStreams::Batch& batch) {
+            for (const auto& message : batch.messages) {
+                OnConnections(message.data(), message.size());
+            }
+        });
+}
+
+void RuleStats::Stop() {
+    ControllerStreams::GetInstance().Unsubscribe(kStreamName);
+    Save();
+}
+
+std::vector<RuleStats::Hit> RuleStats::GetTopHits(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Load();
+    std::vector<Hit> result;
+    result.reserve(hits_.size());
+    for (const auto& item : hits_) result.push_back(item.second);
+    std::sort(result.begin(), result.end(), [](const Hit& a, const Hit& b) {
+        return a.hits > b.hits;
+    });
+    if (result.size() > limit) result.resize(limit);
+    return result;
+}
+
+void RuleStats::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hits_.clear();
+        loaded_ = true;
+        lastReport_ = Report();
+    }
+    Save();
+}
+
+RuleStats::Report RuleStats::GetLastReport() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastReport_;
+}
+
+void RuleStats::OnConnections(const char* data, size_t size) {
+    const char* end = data + size;
+    const std::string idKey = "\"id\":";
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    bool save = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unordered_set<std::string> currentIds;
+
+        // Each connection object starts with its id; its rule fields lie
+        // before the next id
+        const char* at = std::search(data, end, idKey.begin(), idKey.end());
+        while (at != end) {
+            std::string id;
+            const char* next = ReadJsonString(at + idKey.size(), end, &id);
+            if (!next) break;
+            const char* objectEnd = std::search(next, end, idKey.begin(), idKey.end());
+
+            // Only connections that were not in the previous snapshot count
+            if (previousIds_.count(id) == 0) {
+                std::string rule;
+                std::string payload;
+                if (FindJsonString(next, objectEnd, "rule", &rule)) {
+                    FindJsonString(next, objectEnd, "rulePayload", &payload);
+                    std::string type = NormalizeType(rule);
+                    Hit& hit = hits_[type + "," + payload];
+                    hit.rule = type;
+                    hit.payload = payload;
+                    hit.hits++;
+                    hit.lastSeen = now;
+                }
+            }
+            currentIds.insert(std::move(id));
+            at = objectEnd;
+        }
+
+        previousIds_.swap(currentIds);
+        if (++snapshotsSinceSave_ >= kSaveEverySnapshots) {
+            snapshotsSinceSave_ = 0;
+            save = true;
+        }
+    }
+
+    if (save) Save();
+}
+
+bool RuleStats::OptimizeConfig(std::string* content, Report* report) {
+    Report result;
+
+    std::vector<std::string> lines;
+    {
+        std::string line;
+        std::istringstream stream(*content);
+        while (std::getline(stream, line)) lines.push_back(line);
+    }
+
+    // Locate the top-level rules: list
+    size_t first = lines.size();
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].compare(0, 6, "rules:") == 0) {
+            std::string rest = Trim(lines[i].substr(6));
+            if (rest.empty() || rest[0] == '#') first = i + 1;
+            break;
+        }
+    }
+
+    std::vector<RuleEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Load();
+        for (size_t i = first; i < lines.size(); i++) {
+            const std::string& line = lines[i];
+            std::string trimmed = Trim(line);
+            if (trimmed.empty() || trimmed[0] == '#') continue;
+            if (line[0] != ' ' && line[0] != '\t' && line[0] != '-') break;
+            if (trimmed[0] != '-') break;
+
+            RuleEntry entry = ParseRule(trimmed.substr(1));
+            entry.line = i;
+            auto hit = hits_.find(entry.key);
+            entry.hits = hit != hits_.end() ? hit->second.hits : 0;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    result.rules = static_cast<int>(entries.size());
+    std::vector<int64_t> before;
+    for (const auto& entry : entries) {
+        before.push_back(entry.hits);
+        result.sampledHits += entry.hits;
+    }
+    result.depthBefore = MeanDepth(before);
+
+    // Sort each run of interchangeable neighbours, hottest first
+    std::vector<RuleEntry> reordered = entries;
+    size_t start = 0;
+    while (start < reordered.size()) {
+        size_t end = start + 1;
+        if (reordered[start].movable) {
+            while (end < reordered.size() &&
+                   reordered[end].movable &&
+                   reordered[end].line == reordered[end - 1].line + 1 &&
+                   reordered[end].target == reordered[start].target &&
+                   reordered[end].resolves == reordered[start].resolves) {
+                end++;
+            }
+        }
+        if (end - start >= 2) {
+            result.runs++;
+            std::stable_sort(reordered.begin() + start, reordered.begin() + end,
+                             [](const RuleEntry& a, const RuleEntry& b) { return a.hits > b.hits; });
+        }
+        start = end;
+    }
+
+    std::vector<int64_t> after;
+    for (size_t i = 0; i < reordered.size(); i++) {
+        after.push_back(reordered[i].hits);
+        if (reordered[i].line != entries[i].line) result.moved++;
+    }
+    result.depthAfter = MeanDepth(after);
+
+    bool worthIt = result.moved > 0 && result.sampledHits >= kMinSampledHits &&
+                   result.depthAfter < result.depthBefore;
+    if (!worthIt) {
+        result.moved = 0;
+        result.depthAfter = result.depthBefore;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastReport_ = result;
+    }
+    if (report) *report = result;
+    if (!worthIt) return false;
+
+    // Entries keep their line slots; only the text moves between them
+    std::vector<std::string> output = lines;
+    for (size_t i = 0; i < entries.size(); i++) {
+        output[entries[i].line] = lines[reordered[i].line];
+    }
+
+    std::string rebuilt;
+    rebuilt.reserve(content->size());
+    for (size_t i = 0; i < output.size(); i++) {
+        rebuilt += output[i];
+        if (i + 1 < output.size() || (!content->empty() && content->back() == '\n')) rebuilt += '\n';
+    }
+    content->swap(rebuilt);
+
+    FlightRecorder::Record(FlightRecorder::Category::Runner, FlightRecorder::Level::Info,
+                           "rules reordered", result.moved);
+    return true;
+}
+
+void RuleStats::Load() {
+    if (loaded_ || path_.empty()) return;
+    loaded_ = true;
+
+    std::ifstream file(path_);
+    if (!file.is_open()) return;
+
+    int64_t cutoff = static_cast<int64_t>(std::time(nullptr)) - kMaxAgeSeconds;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        Hit hit;
+        if (!std::getline(fields, hit.rule, '\t')) continue;
+        if (!std::getline(fields, hit.payload, '\t')) continue;
+        fields >> hit.hits >> hit.lastSeen;
+        if (fields.fail() || hit.lastSeen < cutoff) continue;
+        hits_[hit.rule + "," + hit.payload] = hit;
+    }
+}
+
+void RuleStats::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty() || !loaded_) return;
+
+    // Write to a temp file and swap it in so a crash never leaves half a file
+    std::string tempPath = path_ + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file.is_open()) return;
+        file << kStatsHeader << "\n";
+        for (const auto& item : hits_) {
+            const Hit& hit = item.second;
+            file << hit.rule << '\t' << hit.payload << '\t' << hit.hits << '\t' << hit.lastSeen << "\n";
+        }
+    }
+    MoveFileExA(tempPath.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING);
+}
@@ -0,0 +1,80 @@
+// rule_stats.h - Rule hit statistics and rule-order optimizer for Windows
+#ifndef RULE_STATS_H_
+#define RULE_STATS_H_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Counts which rule matched each new connection, using the rule and
+// rulePayload fields of the core's /connections stream, and uses the counts
+// to reorder the rules of a config before it is handed to the core. mihomo
+// evaluates rules top to bottom, so moving hot rules up shortens the scan
+// for most connections.
+//
+// Reordering is limited to runs of adjacent rules that send traffic to the
+// same target: whichever of them matches first, the outcome is the same.
+// Rules that make the core resolve the destination (IP rules without
+// no-resolve) never change places with rules that don't, and logic rules,
+// SUB-RULE and MATCH are never moved.
+//
+// The stream is a snapshot per second, so connections shorter than that
+// may be missed; the counts are a sample, which is all ordering needs.
+class RuleStats {
+public:
+    struct Hit {
+        std::string rule;     // Normalized type, e.g. "DOMAINSUFFIX"
+        std::string payload;
+        int64_t hits = 0;
+        int64_t lastSeen = 0;  // Unix seconds
+    };
+
+    struct Report {
+        int rules = 0;            // Rule entries in the config
+        int runs = 0;             // Reorderable runs of two or more rules
+        int moved = 0;            // Rules whose position changed
+        int64_t sampledHits = 0;  // Hits that matched a rule in the config
+        double depthBefore = 0;   // Hit-weighted mean rules evaluated per connection
+        double depthAfter = 0;
+    };
+
+    static RuleStats& GetInstance();
+
+    // Set the directory holding the stats file
+    void Init(const std::string& workDir);
+
+    // Start and stop counting; stopping saves the counts
+    void Start();
+    void Stop();
+
+    std::vector<Hit> GetTopHits(size_t limit);
+    void Reset();
+
+    // Reorders the rules: section of a config. Returns false, leaving the
+    // content untouched, when there is nothing worth moving.
+    bool OptimizeConfig(std::string* content, Report* report);
+
+    Report GetLastReport();
+
+private:
+    RuleStats() = default;
+    RuleStats(const RuleStats&) = delete;
+    RuleStats& operator=(const RuleStats&) = delete;
+
+    void OnConnections(const char* data, size_t size);
+    void Load();
+    void Save();
+
+    std::mutex mutex_;
+    std::string path_;
+    bool loaded_ = false;
+    std::map<std::string, Hit> hits_;            // Keyed by "RULE,payload"
+    std::unordered_set<std::string> previousIds_;  // Connections in the last snapshot
+    int snapshotsSinceSave_ = 0;
+    Report lastReport_;
+};
+
+#endif  // RULE_STATS_H_
@@ -0,0 +1,266 @@
+// soak_test.cpp - Long-run soak test implementation
+#include "soak_test.h"
+#include "controller_streams.h"
+#include "flight_recorder.h"
+#include "mihomo_core.h"
+#include "utils.h"
+#include "worker_pool.h"
+
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+// Subscription names used while a cycle is connected
+constexpr char kLogStream[] = "soak.logs";
+constexpr char kConnectionStream[] = "soak.connections";
+
+constexpr int kStartTimeoutMs = 15000;
+
+// Samples past the warmup are split into this many windows
+constexpr size_t kWindows = 8;
+constexpr size_t kMinSamplesPerWindow = 2;
+
+// Growth each metric may show across the run before it counts as a leak
+constexpr int64_t kWorkingSetTolerance = 16 * 1024 * 1024;
+constexpr int64_t kPrivateBytesTolerance = 16 * 1024 * 1024;
+constexpr int64_t kHandleTolerance = 64;
+constexpr int64_t kThreadTolerance = 4;
+constexpr int64_t kPoolTolerance = 32;
+constexpr int64_t kStreamTolerance = 1;
+
+std::atomic<bool> g_running{false};
+std::atomic<bool> g_cancel{false};
+
+int64_t CountThreads() {
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return 0;
+
+    DWORD pid = GetCurrentProcessId();
+    int64_t count = 0;
+    THREADENTRY32 entry = {};
+    entry.dwSize = sizeof(entry);
+    if (Thread32First(snapshot, &entry)) {
+        do {
+            if (entry.th32OwnerProcessID == pid) count++;
+        } while (Thread32Next(snapshot, &entry));
+    }
+    CloseHandle(snapshot);
+    return count;
+}
+
+SoakTest::Sample TakeSample(int cycle) {
+    SoakTest::Sample sample;
+    sample.cycle = cycle;
+
+    PROCESS_MEMORY_COUNTERS counters = {};
+    counters.cb = sizeof(counters);
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        sample.workingSet = static_cast<int64_t>(counters.WorkingSetSize);
+        sample.privateBytes = static_cast<int64_t>(counters.PagefileUsage);
+    }
+    DWORD handles = 0;
+    if (GetProcessHandleCount(GetCurrentProcess(), &handles)) {
+        sample.handles = handles;
+    }
+    sample.threads = CountThreads();
+    sample.poolPending = static_cast<int64_t>(WorkerPool::Shared().Pending());
+    sample.streams = static_cast<int64_t>(ControllerStreams::GetInstance().GetStatus().size());
+    return sample;
+}
+
+int64_t Median(std::vector<int64_t> values) {
+    if (values.empty()) return 0;
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+SoakTest::Trend Analyze(const std::vector<SoakTest::Sample>& samples, size_t skip,
+                        const char* metric, int64_t SoakTest::Sample::*field, int64_t tolerance) {
+    SoakTest::Trend trend;
+    trend.metric = metric;
+    trend.tolerance = tolerance;
+
+    size_t count = samples.size() > skip ? samples.size() - skip : 0;
+    if (count < kWindows * kMinSamplesPerWindow) return trend;
+
+    std::vector<int64_t> medians;
+    for (size_t window = 0; window < kWindows; window++) {
+        size_t begin = skip + count * window / kWindows;
+        size_t end = skip + count * (window + 1) / kWindows;
+        std::vector<int64_t> values;
+        for (size_t i = begin; i < end; i++) values.push_back(samples[i].*field);
+        medians.push_back(Median(std::move(values)));
+    }
+
+    trend.first = medians.front();
+    trend.last = medians.back();
+    bool monotonic = std::is_sorted(medians.begin(), medians.end());
+    trend.growing = monotonic && trend.last - trend.first > tolerance;
+    return trend;
+}
+
+// Starts the core through StartAsync, which is what the app uses, and waits
+// for its callback
+bool StartAndWait(const std::string& configPath) {
+    struct Waiter {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        bool success = false;
+    };
+    auto waiter = std::make_shared<Waiter>();
+
+    MihomoCore::GetInstance().StartAsync(configPath, [waiter](bool success) {
+        std::lock_guard<std::mutex> lock(waiter->mutex);
+        waiter->done = true;
+        waiter->success = success;
+        waiter->cv.notify_all();
+    });
+
+    std::unique_lock<std::mutex> lock(waiter->mutex);
+    waiter->cv.wait_for(lock, std::chrono::milliseconds(kStartTimeoutMs), [&] { return waiter->done; });
+    return waiter->done && waiter->success;
+}
+
+bool IsIdle(MihomoCore& core) {
+    std::string state = core.GetState();
+    return !core.IsRunning() && (state == "disconnected" || state == "error");
+}
+
+// Sleeps up to ms, returning early on cancel
+void Pause(int ms) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!g_cancel) {
+        int64_t remaining = -ElapsedMs(until);
+        if (remaining <= 0) return;
+        Sleep(static_cast<DWORD>(std::min<int64_t>(remaining, 100)));
+    }
+}
+
+}  // namespace
+
+SoakTest::Report SoakTest::Run(const Options& options, ProgressCallback progress) {
+    Report report;
+    auto& core = MihomoCore::GetInstance();
+
+    std::string configPath = options.configPath.empty() ? core.GetConfigPath() : options.configPath;
+    if (configPath.empty()) {
+        report.error = "No config to run";
+        return report;
+    }
+    if (g_running.exchange(true)) {
+        report.error = "A soak test is already running";
+        return report;
+    }
+    // Checked after claiming the core, so no app call can slip in between
+    if (!IsIdle(core)) {
+        g_running = false;
+        report.error = "Core is in use";
+        return report;
+    }
+    g_cancel = false;
+
+    std::string originalCore = core.GetCorePath();
+    if (!options.corePath.empty()) core.SetCorePath(options.corePath);
+
+    FlightRecorder::Record(FlightRecorder::Category::Supervisor, FlightRecorder::Level::Info,
+                           "soak started", options.cycles);
+
+    auto started = std::chrono::steady_clock::now();
+    std::atomic<int64_t> messages{0};
+    auto count = [&messages](const ControllerStreams::Batch& batch) {
+        messages += static_cast<int64_t>(batch.messages.size());
+    };
+
+    ControllerStreams::StreamOptions logs;
+    logs.path = "/logs?level=debug";
+    logs.mode = ControllerStreams::Mode::Queue;
+    ControllerStreams::StreamOptions connections;
+    connections.path = "/connections";
+    connections.minIntervalMs = 1000;
+
+    size_t nextProxy = 0;
+    int cycles = std::max(1, options.cycles);
+    for (int cycle = 0; cycle < cycles && !g_cancel; cycle++) {
+        // Every cycle ends stopped; anything else means something besides
+        // the channel, e.g. a supervised restart, is running the core
+        if (!IsIdle(core)) {
+            report.error = "Core was started outside the soak test";
+            break;
+        }
+        if (!StartAndWait(configPath)) {
+            report.failedStarts++;
+            core.Stop();
+        } else {
+            ControllerStreams::GetInstance().Subscribe(kLogStream, logs, count);
+            ControllerStreams::GetInstance().Subscribe(kConnectionStream, connections, count);
+            Pause(options.cycleMs / 2);
+
+            if (core.GetProxies().empty()) report.failedCalls++;
+            core.GetConnections();
+            core.GetTrafficStats();
+            if (!options.selector.empty() && !options.proxies.empty()) {
+                const std::string& proxy = options.proxies[nextProxy++ % options.proxies.size()];
+                if (!core.SwitchProxy(options.selector, proxy)) report.failedCalls++;
+            }
+            if (!core.ReloadConfig(configPath)) report.failedCalls++;
+            Pause(options.cycleMs - options.cycleMs / 2);
+
+            ControllerStreams::GetInstance().Unsubscribe(kLogStream);
+            ControllerStreams::GetInstance().Unsubscribe(kConnectionStream);
+            core.Stop();
+        }
+
+        report.cycles++;
+        report.samples.push_back(TakeSample(cycle));
+        if (progress) progress(report.samples.back(), cycles);
+    }
+
+    core.SetCorePath(originalCore);
+
+    size_t skip = static_cast<size_t>(report.samples.size() * std::clamp(options.warmup, 0.0, 0.9));
+    report.trends = {
+        Analyze(report.samples, skip, "workingSet", &Sample::workingSet, kWorkingSetTolerance),
+        Analyze(report.samples, skip, "privateBytes", &Sample::privateBytes, kPrivateBytesTolerance),
+        Analyze(report.samples, skip, "handles", &Sample::handles, kHandleTolerance),
+        Analyze(report.samples, skip, "threads", &Sample::threads, kThreadTolerance),
+        Analyze(report.samples, skip, "poolPending", &Sample::poolPending, kPoolTolerance),
+        Analyze(report.samples, skip, "streams", &Sample::streams, kStreamTolerance),
+    };
+
+    report.passed = report.failedStarts == 0 &&
+        std::none_of(report.trends.begin(), report.trends.end(), [](const Trend& trend) {
+            return trend.growing;
+        });
+    if (!report.error.empty()) {
+        report.passed = false;
+    } else if (report.samples.size() - skip < kWindows * kMinSamplesPerWindow) {
+        report.passed = false;
+        report.error = "Too few cycles to judge growth";
+    }
+    report.streamMessages = messages;
+    report.elapsedMs = ElapsedMs(started);
+
+    FlightRecorder::Record(FlightRecorder::Category::Supervisor,
+                           report.passed ? FlightRecorder::Level::Info : FlightRecorder::Level::Warning,
+                           report.passed ? "soak passed" : "soak failed", report.cycles);
+    g_running = false;
+    return report;
+}
+
+bool SoakTest::IsRunning() {
+    return g_running;
+}
+
+void SoakTest::Cancel() {
+    if (g_running) g_cancel = true;
+}
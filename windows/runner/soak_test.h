@@ -0,0 +1,92 @@
+// soak_test.h - Long-run soak test of the core manager for Windows
+#ifndef SOAK_TEST_H_
+#define SOAK_TEST_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs the core manager through many short connect cycles and checks that
+// the runner gives back what each cycle takes. A cycle starts the core
+// asynchronously, follows the streaming endpoints, queries /proxies and
+// /connections, switches a proxy, reloads the config and stops again.
+//
+// Nothing is accelerated: timers, stream intervals, restart budget windows,
+// rule-stat decay and the core's own clocks run in real time, and the
+// report gives the wall time the run took. Cycles stand for reconnects;
+// leaks that grow with time rather than with cycles need a run of matching
+// wall time.
+//
+// After every stop the runner's working set, private bytes, handle count,
+// thread count and queue depths are sampled; every sample sees the same
+// idle state. Past the warmup the samples are split into windows, and a
+// metric fails when its window medians never go down and the total growth
+// exceeds the metric's tolerance. Unjoined threads and leaked handles show
+// up as exactly that kind of staircase.
+//
+// The run drives the app's own MihomoCore. It refuses to start while the
+// core is in use; while it runs the channel rejects the app's start, stop,
+// reload, switch and hot swap calls, and it stops with an error if the core
+// still changes state between cycles.
+//
+// The core binary can be swapped for a stand-in for the duration of the run,
+// e.g. tool/trace/replay_server.dart compiled to an executable, which reads
+// the same -d/-f arguments and serves a recorded controller trace. A
+// stand-in runs the config without compiled rule sets (see SetCorePath).
+class SoakTest {
+public:
+    struct Options {
+        std::string configPath;           // Empty uses the core's last config
+        std::string corePath;             // Stand-in core; empty keeps mihomo.exe
+        int cycles = 500;
+        int cycleMs = 1000;               // Wall time spent connected per cycle
+        std::string selector;             // Group to switch; empty skips switching
+        std::vector<std::string> proxies; // Rotated through on the selector
+        double warmup = 0.1;              // Leading fraction of samples ignored
+    };
+
+    struct Sample {
+        int cycle = 0;
+        int64_t workingSet = 0;    // Bytes
+        int64_t privateBytes = 0;
+        int64_t handles = 0;
+        int64_t threads = 0;
+        int64_t poolPending = 0;   // Tasks waiting in the shared worker pool
+        int64_t streams = 0;       // Controller stream connections still held
+    };
+
+    struct Trend {
+        std::string metric;
+        int64_t first = 0;      // Median of the first window after warmup
+        int64_t last = 0;       // Median of the last window
+        int64_t tolerance = 0;
+        bool growing = false;   // Monotonic and beyond tolerance
+    };
+
+    struct Report {
+        std::vector<Sample> samples;
+        std::vector<Trend> trends;
+        int cycles = 0;             // Completed
+        int failedStarts = 0;
+        int failedCalls = 0;        // Reloads, switches and queries that failed
+        int64_t streamMessages = 0; // Received across all cycles
+        int64_t elapsedMs = 0;      // Wall time of the whole run
+        bool passed = false;
+        std::string error;
+    };
+
+    // Called on the soak thread after every sample
+    using ProgressCallback = std::function<void(const Sample& sample, int totalCycles)>;
+
+    // Blocks until every cycle has run or Cancel is called. Refuses to run
+    // while the core is in use, and only one run at a time.
+    static Report Run(const Options& options, ProgressCallback progress);
+
+    static bool IsRunning();
+
+    // Ends a running soak after its current cycle
+    static void Cancel();
+};
+
+#endif  // SOAK_TEST_H_
@@ -0,0 +1,412 @@
+// subscription_pipeline.cpp - Concurrent subscription fetch and merge implementation
+#include "subscription_pipeline.h"
+#include "clash_yaml.h"
+#include "flight_recorder.h"
+#include "http_fetch.h"
+#include "node_parser.h"
+#include "utils.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <thread>
+
+namespace {
+
+bool IsBase64Char(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '+' || c == '/' ||
+           c == '-' || c == '_' || c == '=';
+}
+
+std::string HostOf(const std::string& url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    size_t end = url.find_first_of(":/?#", start);
+    return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// Incremental parser for one subscription body. Bytes are fed as they
+// arrive; complete lines are batched and parsed on the worker pool, so
+// parsing overlaps the download. Clash documents go through the streaming
+// YAML reader instead, which parses each proxy as its last line arrives.
+class StreamingSource {
+public:
+    enum class Format { Unknown, UriList, Base64, Clash, Json };
+
+    StreamingSource(WorkerPool& pool, size_t batchSize)
+        : pool_(pool), batchSize_(batchSize) {}
+
+    ~StreamingSource() { Wait(); }
+
+    void Feed(const char* data, size_t size) {
+        if (format_ == Format::Unknown) {
+            sniff_.append(data, size);
+            size_t newline = sniff_.find('\n', sniff_.find_first_not_of(" \t\r\n"));
+            if (newline == std::string::npos && sniff_.size() < 512) return;
+            Sniff();
+            std::string buffered;
+            buffered.swap(sniff_);
+            Route(buffered.data(), buffered.size());
+            return;
+        }
+        Route(data, size);
+    }
+
+    void Finish() {
+        if (format_ == Format::Unknown) {
+            Sniff();
+            std::string buffered;
+            buffered.swap(sniff_);
+            Route(buffered.data(), buffered.size());
+        }
+        if (format_ == Format::Base64) {
+            std::string decoded;
+            if (NodeParser::Base64Decode(base64Carry_, &decoded)) AppendText(decoded.data(), decoded.size());
+            base64Carry_.clear();
+        }
+        if (!partialLine_.empty()) {
+            HandleLine(partialLine_);
+            partialLine_.clear();
+        }
+        if (clash_) clash_->Finish();
+        Dispatch();
+    }
+
+    // Blocks until every dispatched batch has been parsed
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return pending_ == 0; });
+    }
+
+    // Parsed nodes in document order. Call after Wait().
+    std::vector<NodeRecord> TakeNodes() {
+        std::vector<NodeRecord> nodes;
+        for (auto& batch : results_) {
+            for (auto& node : batch) nodes.push_back(std::move(node));
+        }
+        results_.clear();
+        for (auto& node : clashNodes_) nodes.push_back(std::move(node));
+        clashNodes_.clear();
+        return nodes;
+    }
+
+    Format format() const { return format_; }
+
+    ClashYamlReader::Stats ClashStats() const {
+        return clash_ ? clash_->GetStats() : ClashYamlReader::Stats();
+    }
+
+    static const char* FormatName(Format format) {
+        switch (format) {
+            case Format::UriList: return "uri";
+            case Format::Base64: return "base64";
+            case Format::Clash: return "clash";
+            case Format::Json: return "json";
+            default: return "unknown";
+        }
+    }
+
+private:
+    // Same detection order as the Dart parser, decided on the first line
+    void Sniff() {
+        size_t start = sniff_.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos) {
+            format_ = Format::Unknown;
+            return;
+        }
+        size_t end = sniff_.find('\n', start);
+        std::string first = sniff_.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        while (!first.empty() && first.back() == '\r') first.pop_back();
+
+        if (first[0] == '{' || first[0] == '[') {
+            format_ = Format::Json;
+        } else if (first.find("://") != std::string::npos) {
+            format_ = Format::UriList;
+        } else if (std::all_of(first.begin(), first.end(), IsBase64Char)) {
+            format_ = Format::Base64;
+        } else {
+            format_ = Format::Clash;
+            clash_ = std::make_unique<ClashYamlReader>(
+                [this](NodeRecord node) { clashNodes_.push_back(std::move(node)); });
+        }
+    }
+
+    void Route(const char* data, size_t size) {
+        switch (format_) {
+            case Format::Base64: {
+                for (size_t i = 0; i < size; i++) {
+                    if (IsBase64Char(data[i]) && data[i] != '=') base64Carry_.push_back(data[i]);
+                }
+                // Decode whole quanta only; the remainder waits for more bytes
+                size_t aligned = base64Carry_.size() / 4 * 4;
+                if (aligned == 0) return;
+                std::string decoded;
+                if (NodeParser::Base64Decode(base64Carry_.substr(0, aligned), &decoded)) {
+                    AppendText(decoded.data(), decoded.size());
+                }
+                base64Carry_.erase(0, aligned);
+                break;
+            }
+            case Format::UriList:
+                AppendText(data, size);
+                break;
+            case Format::Clash:
+                clash_->Feed(data, size);
+                break;
+            default:
+                // JSON (SIP008) is left to the Dart parser
+                break;
+        }
+    }
+
+    void AppendText(const char* data, size_t size) {
+        size_t start = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (data[i] != '\n') continue;
+            partialLine_.append(data + start, i - start);
+            HandleLine(partialLine_);
+            partialLine_.clear();
+            start = i + 1;
+        }
+        partialLine_.append(data + start, size - start);
+    }
+
+    void HandleLine(std::string line) {
+        while (!line.empty() && line.back() == '\r') line.pop_back();
+
+        if (line.find("://") != std::string::npos) {
+            batch_.push_back(std::move(line));
+            if (batch_.size() >= batchSize_) Dispatch();
+        }
+    }
+
+    void Dispatch() {
+        if (batch_.empty()) return;
+
+        size_t slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot = results_.size();
+            results_.emplace_back();
+            pending_++;
+        }
+
+        auto items = std::make_shared<std::vector<std::string>>(std::move(batch_));
+        batch_.clear();
+
+        pool_.Submit([this, items, slot]() {
+            std::vector<NodeRecord> nodes;
+            nodes.reserve(items->size());
+            for (const auto& item : *items) {
+                NodeRecord node;
+                if (NodeParser::ParseUri(item, &node)) nodes.push_back(std::move(node));
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            results_[slot] = std::move(nodes);
+            pending_--;
+            cv_.notify_all();
+        });
+    }
+
+    WorkerPool& pool_;
+    size_t batchSize_;
+    Format format_ = Format::Unknown;
+
+    std::string sniff_;
+    std::string base64Carry_;
+    std::string partialLine_;
+    std::vector<std::string> batch_;
+
+    // Clash only; fed and finished on the fetch thread
+    std::unique_ptr<ClashYamlReader> clash_;
+    std::vector<NodeRecord> clashNodes_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t pending_ = 0;
+    std::vector<std::vector<NodeRecord>> results_;  // One slot per batch, in order
+};
+
+}  // namespace
+
+SubscriptionPipeline& SubscriptionPipeline::GetInstance() {
+    static SubscriptionPipeline instance;
+    return instance;
+}
+
+void SubscriptionPipeline::SetMergeCallback(MergeCallback callback) {
+    mergeCallback_ = callback;
+}
+
+size_t SubscriptionPipeline::TrimCache() {
+    // Skip rather than wait while a run is using the table
+    std::unique_lock<std::mutex> runLock(runMutex_, std::try_to_lock);
+    if (!runLock.owns_lock()) return 0;
+
+    return lastTable_.ShrinkToFit();
+}
+
+SubscriptionPipeline::Result SubscriptionPipeline::Run(const std::vector<Source>& sources,
+                                                       const Options& options) {
+    std::lock_guard<std::mutex> runLock(runMutex_);
+
+    Result result;
+    auto started = std::chrono::steady_clock::now();
+    result.sources.resize(sources.size());
+
+    WorkerPool& pool = WorkerPool::Shared();
+    std::vector<std::unique_ptr<StreamingSource>> parsers;
+    std::vector<std::vector<NodeRecord>> parsed(sources.size());
+    std::vector<std::thread> fetchers;
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        SourceResult& sourceResult = result.sources[i];
+        sourceResult.url = sources[i].url;
+        sourceResult.tag = sources[i].tag.empty() ? HostOf(sources[i].url) : sources[i].tag;
+        if (sourceResult.tag.empty()) sourceResult.tag = "sub" + std::to_string(i + 1);
+        parsers.push_back(std::make_unique<StreamingSource>(pool, options.batchSize));
+    }
+
+    // Network I/O stays on dedicated threads; only parsing uses the pool
+    for (size_t i = 0; i < sources.size(); i++) {
+        fetchers.emplace_back([&, i]() {
+            SourceResult& sourceResult = result.sources[i];
+            StreamingSource& parser = *parsers[i];
+
+            HttpFetch fetch;
+            fetch.SetTimeout(options.timeoutMs);
+            fetch.SetUserAgent(options.userAgent);
+            HttpFetch::Response response = fetch.Get(sources[i].url,
+                [&](const char* data, size_t size) {
+                    sourceResult.bytes += static_cast<int64_t>(size);
+                    parser.Feed(data, size);
+                    return true;
+                });
+
+            sourceResult.statusCode = response.statusCode;
+            sourceResult.firstByteMs = response.firstByteMs;
+            sourceResult.fetchMs = ElapsedMs(started);
+            if (!response.error.empty()) {
+                sourceResult.error = response.error;
+            } else if (response.statusCode < 200 || response.statusCode >= 300) {
+                sourceResult.error = "HTTP " + std::to_string(response.statusCode);
+            }
+
+            parser.Finish();
+            parser.Wait();
+            sourceResult.format = StreamingSource::FormatName(parser.format());
+            if (sourceResult.error.empty() && parser.format() == StreamingSource::Format::Json) {
+                sourceResult.error = "unsupported format";
+            } else if (sourceResult.error.empty() && parser.format() == StreamingSource::Format::Unknown) {
+                sourceResult.error = "empty response";
+            }
+            if (!sourceResult.error.empty()) {
+                FlightRecorder::Record(FlightRecorder::Category::Network, FlightRecorder::Level::Warning,
+                                       sourceResult.tag + ": " + sourceResult.error, sourceResult.statusCode);
+            }
+            parsed[i] = parser.TakeNodes();
+            sourceResult.nodes = parsed[i].size();
+            sourceResult.doneMs = ElapsedMs(started);
+        });
+    }
+    for (auto& fetcher : fetchers) {
+        if (fetcher.joinable()) fetcher.join();
+    }
+
+    // Merge in source order so the first source listing a node decides its
+    // position; later duplicates only add their tag. A source that failed
+    // this time keeps its nodes from the previous run instead of showing up
+    // as a mass removal in the diff. Unsupported formats are not failures of
+    // the source and get no stale nodes: the caller parses those itself.
+    NodeTable table;
+    size_t total = 0;
+    for (size_t i = 0; i < parsed.size(); i++) {
+        SourceResult& sourceResult = result.sources[i];
+        const std::string& tag = sourceResult.tag;
+        if (!sourceResult.error.empty()) {
+            if (parsers[i]->format() == StreamingSource::Format::Json) continue;
+            sourceResult.stale = true;
+            sourceResult.nodes = 0;
+            for (const auto& previous : lastTable_.Records()) {
+                if (std::find(previous.sources.begin(), previous.sources.end(), tag) == previous.sources.end()) {
+                    continue;
+                }
+                NodeRecord node = previous;
+                node.sources = {tag};
+                table.Insert(std::move(node));
+                sourceResult.nodes++;
+                total++;
+            }
+            continue;
+        }
+        for (auto& node : parsed[i]) {
+            node.sources.push_back(tag);
+            table.Insert(std::move(node));
+            total++;
+        }
+    }
+    result.duplicates = total - table.Size();
+    result.diff = table.DiffFrom(lastTable_);
+    result.nodes = table.Records();
+    lastTable_ = std::move(table);
+    result.totalMs = ElapsedMs(started);
+
+    if (mergeCallback_) {
+        mergeCallback_(result);
+    }
+    return result;
+}
+
+SubscriptionPipeline::Result SubscriptionPipeline::Import(const std::string& content, const std::string& tag,
+                                                          const Options& options,
+                                                          ClashYamlReader::Stats* stats) {
+    std::lock_guard<std::mutex> runLock(runMutex_);
+
+    Result result;
+    auto started = std::chrono::steady_clock::now();
+    result.sources.resize(1);
+    SourceResult& sourceResult = result.sources[0];
+    sourceResult.tag = tag.empty() ? "local" : tag;
+    sourceResult.bytes = static_cast<int64_t>(content.size());
+
+    StreamingSource parser(WorkerPool::Shared(), options.batchSize);
+    parser.Feed(content.data(), content.size());
+    parser.Finish();
+    parser.Wait();
+    sourceResult.format = StreamingSource::FormatName(parser.format());
+    if (parser.format() == StreamingSource::Format::Json) {
+        sourceResult.error = "unsupported format";
+    } else if (parser.format() == StreamingSource::Format::Unknown) {
+        sourceResult.error = "empty content";
+    }
+    if (stats) *stats = parser.ClashStats();
+
+    // Nothing to replace the table with; the caller parses it itself
+    std::vector<NodeRecord> parsed = parser.TakeNodes();
+    if (!sourceResult.error.empty()) {
+        result.totalMs = ElapsedMs(started);
+        return result;
+    }
+
+    NodeTable table;
+    for (auto& node : parsed) {
+        node.sources.push_back(sourceResult.tag);
+        table.Insert(std::move(node));
+    }
+    sourceResult.nodes = parsed.size();
+    sourceResult.doneMs = ElapsedMs(started);
+    result.duplicates = parsed.size() - table.Size();
+    result.diff = table.DiffFrom(lastTable_);
+    result.nodes = table.Records();
+    lastTable_ = std::move(table);
+    result.totalMs = ElapsedMs(started);
+
+    if (mergeCallback_) {
+        mergeCallback_(result);
+    }
+    return result;
+}
@@ -0,0 +1,88 @@
+// subscription_pipeline.h - Concurrent subscription fetch and merge for Windows
+#ifndef SUBSCRIPTION_PIPELINE_H_
+#define SUBSCRIPTION_PIPELINE_H_
+
+#include "clash_yaml.h"
+#include "node_table.h"
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Fetches several subscription URLs at once, decodes and parses each body on
+// the shared worker pool while it is still downloading, and merges the
+// results into one deduplicated node table tagged with the source(s) of each
+// node. Total refresh time is bounded by the slowest source. A source that
+// fails to download keeps its nodes from the previous run; one in a format
+// the native parsers do not read (SIP008 JSON) is left out for the caller.
+class SubscriptionPipeline {
+public:
+    struct Source {
+        std::string url;  // Final request URL (flag/clash params already applied)
+        std::string tag;  // Defaults to the URL host
+    };
+
+    struct Options {
+        std::string userAgent = "Vortex/1.0";
+        int timeoutMs = 30000;
+        size_t batchSize = 128;  // URI lines per parse job
+    };
+
+    struct SourceResult {
+        std::string url;
+        std::string tag;
+        std::string format;  // uri, base64, clash, json, unknown
+        std::string error;   // Empty on success
+        int statusCode = 0;
+        int64_t bytes = 0;
+        int64_t firstByteMs = 0;
+        int64_t fetchMs = 0;  // Until the last byte arrived
+        int64_t doneMs = 0;   // Until the last parse job finished
+        size_t nodes = 0;
+        bool stale = false;  // Failed; nodes are the ones kept from the previous run
+    };
+
+    struct Result {
+        std::vector<SourceResult> sources;
+        std::vector<NodeRecord> nodes;  // Merged, deduplicated
+        NodeTable::Diff diff;           // Against the previous run
+        size_t duplicates = 0;
+        int64_t totalMs = 0;
+    };
+
+    using MergeCallback = std::function<void(const Result& result)>;
+
+    static SubscriptionPipeline& GetInstance();
+
+    // Blocks until every source has been fetched and parsed
+    Result Run(const std::vector<Source>& sources, const Options& options);
+
+    // Parses content the user supplied (pasted or loaded from a file) as the
+    // one source tagged tag. Like a run, the result replaces the table the
+    // next diff and stale fallback are taken against, and the merge callback
+    // fires. stats receives the Clash reader's counts for Clash content.
+    Result Import(const std::string& content, const std::string& tag, const Options& options,
+                  ClashYamlReader::Stats* stats = nullptr);
+
+    // Releases the spare capacity of the previous run's table. The table
+    // itself stays: failed sources fall back to it and the next diff is
+    // taken against it. Per-run buffers are freed when each run ends.
+    // Returns the approximate bytes released.
+    size_t TrimCache();
+
+    // Invoked once per run with the combined diff
+    void SetMergeCallback(MergeCallback callback);
+
+private:
+    SubscriptionPipeline() = default;
+    SubscriptionPipeline(const SubscriptionPipeline&) = delete;
+    SubscriptionPipeline& operator=(const SubscriptionPipeline&) = delete;
+
+    std::mutex runMutex_;
+    NodeTable lastTable_;
+    MergeCallback mergeCallback_;
+};
+
+#endif  // SUBSCRIPTION_PIPELINE_H_
@@ -0,0 +1,516 @@
+// tcp_prober.cpp - Batched TCP connect prober implementation
+#include "tcp_prober.h"
+
+// winsock2.h must come before anything that pulls in windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mswsock.h>
+
+#include "flight_recorder.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+constexpr int kMaxConcurrency = 16384;
+constexpr size_t kResolverThreads = 8;
+
+// Completions dequeued per GetQueuedCompletionStatusEx call
+constexpr ULONG kCompletionBatch = 128;
+
+using Clock = std::chrono::steady_clock;
+
+int64_t MsBetween(Clock::time_point since, Clock::time_point now) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - since).count();
+}
+
+int64_t ThreadCpuMs() {
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+    auto ticks = [](const FILETIME& time) {
+        return (static_cast<int64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) / 10000;
+}
+
+std::string ConnectError(int code) {
+    return "connect failed (" + std::to_string(code) + ")";
+}
+
+struct Address {
+    sockaddr_storage storage{};
+    int length = 0;  // 0 when the host did not resolve
+};
+
+// Each distinct host is resolved once, on a few threads; the sweep itself
+// starts only when every address is known
+std::vector<Address> Resolve(const std::vector<TcpProber::Target>& targets) {
+    std::unordered_map<std::string, size_t> index;
+    std::vector<std::string> hosts;
+    std::vector<size_t> hostOf(targets.size());
+    for (size_t i = 0; i < targets.size(); i++) {
+        auto [it, inserted] = index.emplace(targets[i].host, hosts.size());
+        if (inserted) hosts.push_back(targets[i].host);
+        hostOf[i] = it->second;
+    }
+
+    std::vector<Address> resolved(hosts.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < hosts.size();) {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_protocol = IPPROTO_TCP;
+            addrinfo* info = nullptr;
+            if (getaddrinfo(hosts[i].c_str(), nullptr, &hints, &info) != 0 || !info) continue;
+            if (info->ai_addrlen <= sizeof(sockaddr_storage)) {
+                memcpy(&resolved[i].storage, info->ai_addr, info->ai_addrlen);
+                resolved[i].length = static_cast<int>(info->ai_addrlen);
+            }
+            freeaddrinfo(info);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < std::min(kResolverThreads, hosts.size()); t++) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+
+    std::vector<Address> addresses(targets.size());
+    for (size_t i = 0; i < targets.size(); i++) {
+        Address& address = addresses[i];
+        address = resolved[hostOf[i]];
+        u_short port = htons(static_cast<u_short>(targets[i].port));
+        if (address.storage.ss_family == AF_INET6) {
+            reinterpret_cast<sockaddr_in6*>(&address.storage)->sin6_port = port;
+        } else if (address.storage.ss_family == AF_INET) {
+            reinterpret_cast<sockaddr_in*>(&address.storage)->sin_port = port;
+        }
+    }
+    return addresses;
+}
+
+// Reset instead of a graceful close, so a sweep leaves no TIME_WAIT entries
+// behind to eat into the ephemeral port range
+void Abort(SOCKET socket) {
+    linger option{1, 0};
+    setsockopt(socket, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&option), sizeof(option));
+    closesocket(socket);
+}
+
+// ConnectEx requires a bound socket
+bool BindAny(SOCKET socket, int family) {
+    sockaddr_storage local{};
+    local.ss_family = static_cast<ADDRESS_FAMILY>(family);
+    int length = family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+    return bind(socket, reinterpret_cast<sockaddr*>(&local), length) == 0;
+}
+
+LPFN_CONNECTEX LoadConnectEx(int family) {
+    SOCKET socket = WSASocketW(family, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+    if (socket == INVALID_SOCKET) return nullptr;
+    GUID guid = WSAID_CONNECTEX;
+    LPFN_CONNECTEX connectEx = nullptr;
+    DWORD bytes = 0;
+    if (WSAIoctl(socket, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), &connectEx,
+                 sizeof(connectEx), &bytes, nullptr, nullptr) != 0) {
+        connectEx = nullptr;
+    }
+    closesocket(socket);
+    return connectEx;
+}
+
+struct ConnectExTable {
+    LPFN_CONNECTEX v4 = nullptr;
+    LPFN_CONNECTEX v6 = nullptr;
+};
+
+struct CompletionSlot {
+    OVERLAPPED overlapped;  // First, so a dequeued OVERLAPPED* is its slot
+    SOCKET socket = INVALID_SOCKET;
+    size_t target = 0;
+    uint64_t generation = 0;
+    Clock::time_point started;
+    bool cancelled = false;
+};
+
+struct Deadline {
+    size_t slot;
+    uint64_t generation;  // Stale once the slot has moved on to another target
+    Clock::time_point at;
+};
+
+void RunCompletion(const std::vector<Address>& addresses, const TcpProber::Options& options,
+                   const ConnectExTable& table, TcpProber::Report* report) {
+    HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (!port) {
+        report->error = "completion port unavailable";
+        return;
+    }
+
+    const auto timeout = std::chrono::milliseconds(options.timeoutMs);
+    std::vector<CompletionSlot> slots(static_cast<size_t>(options.concurrency));
+    std::vector<size_t> idle;
+    for (size_t i = slots.size(); i > 0; i--) idle.push_back(i - 1);
+    std::deque<Deadline> deadlines;
+    size_t next = 0;
+    size_t inFlight = 0;
+
+    // True when the connect is pending and will complete on the port
+    auto launch = [&](size_t target) {
+        const Address& address = addresses[target];
+        TcpProber::Result& result = report->results[target];
+        int family = address.storage.ss_family;
+        SOCKET socket = WSASocketW(family, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+        if (socket == INVALID_SOCKET) {
+            result.error = "socket failed (" + std::to_string(WSAGetLastError()) + ")";
+            return false;
+        }
+        if (!BindAny(socket, family) ||
+            !CreateIoCompletionPort(reinterpret_cast<HANDLE>(socket), port, 0, 0)) {
+            result.error = "socket setup failed";
+            closesocket(socket);
+            return false;
+        }
+
+        size_t index = idle.back();
+        CompletionSlot& slot = slots[index];
+        ZeroMemory(&slot.overlapped, sizeof(slot.overlapped));
+        slot.socket = socket;
+        slot.target = target;
+        slot.generation++;
+        slot.cancelled = false;
+        slot.started = Clock::now();
+
+        LPFN_CONNECTEX connectEx = family == AF_INET6 ? table.v6 : table.v4;
+        if (!connectEx(socket, reinterpret_cast<const sockaddr*>(&address.storage), address.length,
+                       nullptr, 0, nullptr, &slot.overlapped)) {
+            int error = WSAGetLastError();
+            if (error != ERROR_IO_PENDING) {
+                result.error = ConnectError(error);
+                Abort(socket);
+                slot.socket = INVALID_SOCKET;
+                return false;
+            }
+        }
+        idle.pop_back();
+        deadlines.push_back({index, slot.generation, slot.started + timeout});
+        return true;
+    };
+
+    auto fill = [&]() {
+        while (!idle.empty() && next < addresses.size()) {
+            size_t target = next++;
+            if (addresses[target].length > 0 && launch(target)) inFlight++;
+        }
+    };
+
+    std::vector<OVERLAPPED_ENTRY> entries(kCompletionBatch);
+    fill();
+    while (inFlight > 0) {
+        auto now = Clock::now();
+        while (!deadlines.empty() && deadlines.front().at <= now) {
+            const Deadline& deadline = deadlines.front();
+            CompletionSlot& slot = slots[deadline.slot];
+            if (slot.generation == deadline.generation && slot.socket != INVALID_SOCKET && !slot.cancelled) {
+                // The aborted connect still completes on the port
+                slot.cancelled = true;
+                CancelIoEx(reinterpret_cast<HANDLE>(slot.socket), &slot.overlapped);
+            }
+            deadlines.pop_front();
+        }
+
+        DWORD wait = 1000;  // Only cancellations outstanding
+        if (!deadlines.empty()) {
+            wait = static_cast<DWORD>(std::max<int64_t>(0, -MsBetween(deadlines.front().at, now)) + 1);
+        }
+
+        ULONG removed = 0;
+        report->waits++;
+        if (!GetQueuedCompletionStatusEx(port, entries.data(), kCompletionBatch, &removed, wait, FALSE)) {
+            if (GetLastError() == WAIT_TIMEOUT) continue;
+            report->error = "completion wait failed";
+            break;
+        }
+
+        // One timestamp per batch; completions in it finished within the wait
+        now = Clock::now();
+        for (ULONG i = 0; i < removed; i++) {
+            auto* slot = reinterpret_cast<CompletionSlot*>(entries[i].lpOverlapped);
+            DWORD transferred = 0;
+            DWORD flags = 0;
+            bool connected = WSAGetOverlappedResult(slot->socket, &slot->overlapped, &transferred, FALSE, &flags);
+            int error = connected ? 0 : WSAGetLastError();
+
+            TcpProber::Result& result = report->results[slot->target];
+            if (slot->cancelled) {
+                result.error = "timeout";
+                report->timedOut++;
+            } else if (connected) {
+                setsockopt(slot->socket, SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, nullptr, 0);
+                result.latencyMs = MsBetween(slot->started, now);
+                report->succeeded++;
+            } else {
+                result.error = ConnectError(error);
+            }
+            Abort(slot->socket);
+            slot->socket = INVALID_SOCKET;
+            idle.push_back(static_cast<size_t>(slot - slots.data()));
+            inFlight--;
+        }
+        fill();
+    }
+
+    // After a failed wait: close what is left and let the aborted connects
+    // drain before the slots holding their OVERLAPPEDs go away
+    for (auto& slot : slots) {
+        if (slot.socket != INVALID_SOCKET) closesocket(slot.socket);
+    }
+    auto draining = Clock::now();
+    while (inFlight > 0 && ElapsedMs(draining) < 1000) {
+        ULONG removed = 0;
+        if (!GetQueuedCompletionStatusEx(port, entries.data(), kCompletionBatch, &removed, 100, FALSE)) continue;
+        inFlight -= std::min<size_t>(inFlight, removed);
+    }
+    CloseHandle(port);
+}
+
+struct PendingConnect {
+    size_t target;
+    Clock::time_point started;
+};
+
+void RunReadiness(const std::vector<Address>& addresses, const TcpProber::Options& options,
+                  TcpProber::Report* report) {
+    const auto timeout = std::chrono::milliseconds(options.timeoutMs);
+    const size_t concurrency = static_cast<size_t>(options.concurrency);
+    std::vector<WSAPOLLFD> fds;
+    std::vector<PendingConnect> pending;
+    fds.reserve(concurrency);
+    pending.reserve(concurrency);
+    size_t next = 0;
+
+    auto launch = [&](size_t target) {
+        const Address& address = addresses[target];
+        TcpProber::Result& result = report->results[target];
+        SOCKET socket = ::socket(address.storage.ss_family, SOCK_STREAM, IPPROTO_TCP);
+        if (socket == INVALID_SOCKET) {
+            result.error = "socket failed (" + std::to_string(WSAGetLastError()) + ")";
+            return;
+        }
+        u_long nonBlocking = 1;
+        ioctlsocket(socket, FIONBIO, &nonBlocking);
+
+        auto started = Clock::now();
+        if (connect(socket, reinterpret_cast<const sockaddr*>(&address.storage), address.length) == 0) {
+            result.latencyMs = ElapsedMs(started);
+            report->succeeded++;
+            Abort(socket);
+            return;
+        }
+        int error = WSAGetLastError();
+        if (error != WSAEWOULDBLOCK) {
+            result.error = ConnectError(error);
+            Abort(socket);
+            return;
+        }
+        WSAPOLLFD fd{};
+        fd.fd = socket;
+        fd.events = POLLWRNORM;
+        fds.push_back(fd);
+        pending.push_back({target, started});
+    };
+
+    auto fill = [&]() {
+        while (fds.size() < concurrency && next < addresses.size()) {
+            size_t target = next++;
+            if (addresses[target].length > 0) launch(target);
+        }
+    };
+
+    fill();
+    while (!fds.empty()) {
+        auto now = Clock::now();
+        auto earliest = pending.front().started;
+        for (const auto& entry : pending) earliest = std::min(earliest, entry.started);
+        int wait = static_cast<int>(std::max<int64_t>(0, -MsBetween(earliest + timeout, now)) + 1);
+
+        report->waits++;
+        if (WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), wait) == SOCKET_ERROR) {
+            report->error = "poll failed (" + std::to_string(WSAGetLastError()) + ")";
+            break;
+        }
+
+        // Every wake scans the whole in-flight set, the cost the completion
+        // backend avoids. Refused connects are only reported as POLLHUP or
+        // POLLERR since Windows 10 2004; older builds see them time out.
+        now = Clock::now();
+        for (size_t i = 0; i < fds.size();) {
+            SOCKET socket = fds[i].fd;
+            SHORT events = fds[i].revents;
+            const PendingConnect& entry = pending[i];
+            TcpProber::Result& result = report->results[entry.target];
+            if (events & (POLLERR | POLLHUP)) {
+                int error = 0;
+                int length = sizeof(error);
+                getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length);
+                result.error = ConnectError(error);
+            } else if (events & POLLWRNORM) {
+                result.latencyMs = MsBetween(entry.started, now);
+                report->succeeded++;
+            } else if (now - entry.started >= timeout) {
+                result.error = "timeout";
+                report->timedOut++;
+            } else {
+                i++;
+                continue;
+            }
+            Abort(socket);
+            fds[i] = fds.back();
+            fds.pop_back();
+            pending[i] = pending.back();
+            pending.pop_back();
+        }
+        fill();
+    }
+
+    for (const auto& fd : fds) Abort(fd.fd);
+}
+
+}  // namespace
+
+TcpProber::Backend TcpProber::ParseBackend(const std::string& name) {
+    if (name == "completion") return Backend::Completion;
+    if (name == "readiness") return Backend::Readiness;
+    return Backend::Auto;
+}
+
+TcpProber::Report TcpProber::Probe(const std::vector<Target>& targets, const Options& requested) {
+    Report report;
+    Options options = requested;
+    options.timeoutMs = std::max(100, options.timeoutMs);
+    options.concurrency = std::max(1, std::min(options.concurrency, kMaxConcurrency));
+    report.probes = static_cast<int>(targets.size());
+    report.results.resize(targets.size());
+
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        report.error = "winsock unavailable";
+        return report;
+    }
+
+    auto resolveStarted = Clock::now();
+    std::vector<Address> addresses = Resolve(targets);
+    report.resolveMs = ElapsedMs(resolveStarted);
+
+    bool v4 = false;
+    bool v6 = false;
+    for (size_t i = 0; i < addresses.size(); i++) {
+        if (addresses[i].length == 0) {
+            report.results[i].error = "resolve failed";
+        } else if (addresses[i].storage.ss_family == AF_INET6) {
+            v6 = true;
+        } else {
+            v4 = true;
+        }
+    }
+
+    ConnectExTable table;
+    bool completion = options.backend != Backend::Readiness;
+    if (completion) {
+        if (v4) table.v4 = LoadConnectEx(AF_INET);
+        if (v6) table.v6 = LoadConnectEx(AF_INET6);
+        if ((v4 && !table.v4) || (v6 && !table.v6)) {
+            if (options.backend == Backend::Completion) {
+                report.error = "ConnectEx unavailable";
+                WSACleanup();
+                return report;
+            }
+            completion = false;
+            FlightRecorder::Record(FlightRecorder::Category::Network, FlightRecorder::Level::Warning,
+                                   "ConnectEx unavailable, probing with WSAPoll", 0);
+        }
+    }
+    report.backend = completion ? "completion" : "readiness";
+
+    int64_t cpuStarted = ThreadCpuMs();
+    auto started = Clock::now();
+    if (completion) {
+        RunCompletion(addresses, options, table, &report);
+    } else {
+        RunReadiness(addresses, options, &report);
+    }
+    report.elapsedMs = ElapsedMs(started);
+    report.cpuMs = ThreadCpuMs() - cpuStarted;
+
+    WSACleanup();
+    return report;
+}
+
+TcpProber::BenchmarkReport TcpProber::Benchmark(const std::vector<int>& counts, int timeoutMs) {
+    BenchmarkReport report;
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        report.error = "winsock unavailable";
+        return report;
+    }
+
+    int largest = 1;
+    for (int count : counts) largest = std::max(largest, std::min(count, kMaxConcurrency));
+
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int length = sizeof(address);
+    // A backlog as deep as the largest burst, so the listener is not what
+    // the benchmark measures
+    if (listener == INVALID_SOCKET ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN_HINT(largest)) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        report.error = "loopback listener unavailable";
+        if (listener != INVALID_SOCKET) closesocket(listener);
+        WSACleanup();
+        return report;
+    }
+    int port = ntohs(address.sin_port);
+
+    // Accepts and drops; a probe may reset before its accept, which is not
+    // a reason to stop. Closing the listener ends the loop.
+    std::atomic<bool> stopping{false};
+    std::thread acceptor([listener, &stopping]() {
+        while (!stopping) {
+            SOCKET accepted = accept(listener, nullptr, nullptr);
+            if (accepted != INVALID_SOCKET) closesocket(accepted);
+        }
+    });
+
+    for (int count : counts) {
+        count = std::max(1, std::min(count, kMaxConcurrency));
+        std::vector<Target> targets(static_cast<size_t>(count), Target{"127.0.0.1", port});
+        for (Backend backend : {Backend::Readiness, Backend::Completion}) {
+            Options options;
+            options.timeoutMs = timeoutMs;
+            options.concurrency = count;
+            options.backend = backend;
+            Report run = Probe(targets, options);
+            if (run.backend.empty()) run.backend = backend == Backend::Completion ? "completion" : "readiness";
+            run.results.clear();
+            report.runs.push_back(std::move(run));
+        }
+    }
+
+    stopping = true;
+    closesocket(listener);
+    acceptor.join();
+    WSACleanup();
+    return report;
+}
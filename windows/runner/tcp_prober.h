@@ -0,0 +1,73 @@
+// tcp_prober.h - Batched TCP connect prober for Windows
+#ifndef TCP_PROBER_H_
+#define TCP_PROBER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Measures TCP connect latency to many endpoints from a single thread, for
+// the node list's quick latency sweep (no core needed).
+//
+// The completion backend issues every connect with ConnectEx on an
+// overlapped socket associated with one I/O completion port and drains
+// finished connects in batches with GetQueuedCompletionStatusEx, so a sweep
+// over thousands of nodes costs one wait per batch of completions instead
+// of a thread or a readiness scan per socket. All probes share one timeout,
+// so start order is deadline order and the deadlines are a plain FIFO; an
+// expired connect is cancelled with CancelIoEx and its slot is reused once
+// the cancellation has completed.
+//
+// The readiness backend (non-blocking connect, WSAPoll over the in-flight
+// set) is the fallback when ConnectEx cannot be loaded, e.g. behind a
+// layered provider that does not implement it, and the baseline Benchmark
+// measures the completion backend against.
+class TcpProber {
+public:
+    enum class Backend { Auto, Completion, Readiness };
+
+    struct Target {
+        std::string host;
+        int port = 0;
+    };
+
+    struct Options {
+        int timeoutMs = 5000;
+        int concurrency = 256;  // Connects in flight at once
+        Backend backend = Backend::Auto;
+    };
+
+    struct Result {
+        int64_t latencyMs = -1;  // -1 when the connect failed or timed out
+        std::string error;
+    };
+
+    struct Report {
+        std::vector<Result> results;  // In target order
+        std::string backend;          // "completion" or "readiness"
+        int probes = 0;
+        int succeeded = 0;
+        int timedOut = 0;
+        int64_t resolveMs = 0;
+        int64_t elapsedMs = 0;  // Connect phase only
+        int64_t cpuMs = 0;      // Of the probing thread during the connect phase
+        int64_t waits = 0;      // GetQueuedCompletionStatusEx or WSAPoll calls
+        std::string error;
+    };
+
+    // Blocks until every target has connected, failed or timed out
+    static Report Probe(const std::vector<Target>& targets, const Options& options);
+
+    struct BenchmarkReport {
+        std::vector<Report> runs;  // Per count, readiness then completion; results dropped
+        std::string error;
+    };
+
+    // Connects count times to a loopback listener with every probe in
+    // flight at once, on each backend
+    static BenchmarkReport Benchmark(const std::vector<int>& counts, int timeoutMs = 10000);
+
+    static Backend ParseBackend(const std::string& name);
+};
+
+#endif  // TCP_PROBER_H_
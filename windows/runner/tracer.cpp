@@ -0,0 +1,223 @@
+// tracer.cpp - Cross-layer request tracing implementation
+#include "tracer.h"
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t kCapacity = 4096;
+
+// FILETIME counts 100 ns intervals since 1601
+constexpr int64_t kUnixEpochFiletime = 116444736000000000LL;
+
+struct Event {
+    uint64_t traceId = 0;
+    uint64_t spanId = 0;
+    uint64_t parentId = 0;
+    int64_t startUs = 0;
+    int64_t durationUs = 0;
+    DWORD threadId = 0;
+    const char* category = "";
+    std::string name;
+};
+
+std::atomic<bool> g_enabled{false};
+thread_local Tracer::Context g_current;
+
+std::mutex g_mutex;
+std::vector<Event> g_ring;
+size_t g_next = 0;
+size_t g_count = 0;
+
+uint64_t NewId() {
+    thread_local std::mt19937_64 engine(std::random_device{}() ^
+                                        (static_cast<uint64_t>(GetCurrentThreadId()) << 32));
+    uint64_t id;
+    do {
+        id = engine();
+    } while (id == 0);
+    return id;
+}
+
+std::string Hex(uint64_t value) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+uint64_t ParseHex(const std::string& text) {
+    if (text.empty() || text.size() > 16) return 0;
+    uint64_t value = 0;
+    for (char c : text) {
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return 0;
+        value = (value << 4) | static_cast<uint64_t>(digit);
+    }
+    return value;
+}
+
+void AppendJsonString(std::string* out, const std::string& text) {
+    out->push_back('"');
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out->push_back('\\');
+            out->push_back(static_cast<char>(c));
+        } else if (c < 0x20) {
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out->append(escaped);
+        } else {
+            out->push_back(static_cast<char>(c));
+        }
+    }
+    out->push_back('"');
+}
+
+void Store(Event event) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_ring.empty()) g_ring.resize(kCapacity);
+    g_ring[g_next] = std::move(event);
+    g_next = (g_next + 1) % kCapacity;
+    if (g_count < kCapacity) g_count++;
+}
+
+}  // namespace
+
+void Tracer::SetEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+bool Tracer::IsEnabled() {
+    return g_enabled;
+}
+
+Tracer::Context Tracer::Current() {
+    return g_enabled ? g_current : Context();
+}
+
+Tracer::Context Tracer::FromHex(const std::string& traceId, const std::string& parentSpan) {
+    Context context;
+    if (!g_enabled) return context;
+    context.traceId = ParseHex(traceId);
+    context.spanId = context.traceId ? ParseHex(parentSpan) : 0;
+    return context;
+}
+
+std::string Tracer::Header(const Context& context) {
+    return Hex(context.traceId) + "-" + Hex(context.spanId);
+}
+
+int64_t Tracer::NowUs() {
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime(&now);
+    int64_t ticks = (static_cast<int64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+    return (ticks - kUnixEpochFiletime) / 10;
+}
+
+Tracer::Context Tracer::Record(const char* category, const std::string& name, const Context& parent,
+                               int64_t startUs, int64_t endUs) {
+    if (!g_enabled || !parent) return Context();
+
+    Event event;
+    event.traceId = parent.traceId;
+    event.spanId = NewId();
+    event.parentId = parent.spanId;
+    event.startUs = startUs;
+    event.durationUs = endUs > startUs ? endUs - startUs : 0;
+    event.threadId = GetCurrentThreadId();
+    event.category = category;
+    event.name = name;
+
+    Context context{event.traceId, event.spanId};
+    Store(std::move(event));
+    return context;
+}
+
+Tracer::Span::Span(const char* category, std::string name, const Context& parent)
+    : category_(category), name_(std::move(name)), parent_(parent) {
+    if (!g_enabled || !parent_) return;
+    context_ = {parent_.traceId, NewId()};
+    previous_ = g_current;
+    g_current = context_;
+    startUs_ = NowUs();
+}
+
+Tracer::Span::~Span() {
+    if (!context_) return;
+    g_current = previous_;
+
+    Event event;
+    event.traceId = context_.traceId;
+    event.spanId = context_.spanId;
+    event.parentId = parent_.spanId;
+    event.startUs = startUs_;
+    event.durationUs = NowUs() - startUs_;
+    event.threadId = GetCurrentThreadId();
+    event.category = category_;
+    event.name = std::move(name_);
+    Store(std::move(event));
+}
+
+Tracer::Adopt::Adopt(const Context& context) : previous_(g_current) {
+    g_current = context;
+}
+
+Tracer::Adopt::~Adopt() {
+    g_current = previous_;
+}
+
+std::string Tracer::ExportChromeJson() {
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        events.reserve(g_count);
+        size_t first = (g_next + kCapacity - g_count) % kCapacity;
+        for (size_t i = 0; i < g_count; i++) events.push_back(g_ring[(first + i) % kCapacity]);
+    }
+
+    DWORD pid = GetCurrentProcessId();
+    std::string out = "[";
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event& event = events[i];
+        if (i > 0) out.push_back(',');
+        out += "{\"ph\":\"X\",\"name\":";
+        AppendJsonString(&out, event.name);
+        out += ",\"cat\":";
+        AppendJsonString(&out, event.category);
+        out += ",\"ts\":" + std::to_string(event.startUs) +
+               ",\"dur\":" + std::to_string(event.durationUs) +
+               ",\"pid\":" + std::to_string(pid) +
+               ",\"tid\":" + std::to_string(event.threadId) +
+               ",\"args\":{\"trace\":\"" + Hex(event.traceId) +
+               "\",\"span\":\"" + Hex(event.spanId) +
+               "\",\"parent\":\"" + Hex(event.parentId) + "\"}}";
+    }
+    out.push_back(']');
+    return out;
+}
+
+size_t Tracer::Trim() {
+    if (g_enabled) return 0;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    size_t bytes = g_ring.capacity() * sizeof(Event);
+    for (const auto& event : g_ring) bytes += event.name.capacity();
+    std::vector<Event>().swap(g_ring);
+    g_next = 0;
+    g_count = 0;
+    return bytes;
+}
+
+void Tracer::Clear() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_next = 0;
+    g_count = 0;
+}
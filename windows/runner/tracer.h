@@ -0,0 +1,91 @@
+// tracer.h - Cross-layer request tracing for Windows
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <cstdint>
+#include <string>
+
+// Follows one user action (a connect, a node switch) across the layers it
+// crosses. Dart opens a trace and passes its context in the method-channel
+// arguments as "_trace": {"id": <trace hex>, "parent": <span hex>}. The
+// channel handler opens a span under it. Spans opened later on the same
+// thread nest under the current one, and the context is carried across
+// threads explicitly (Adopt) where work is handed to a detached thread or
+// the worker pool. Controller requests carry it to the core as an
+// X-Vortex-Trace header.
+//
+// Finished spans go into a fixed ring and are exported as Chrome trace
+// events (chrome://tracing, Perfetto). Timestamps are Unix microseconds, the
+// clock Dart's DateTime uses, so the Dart side can merge its own spans into
+// the same file. Nothing is recorded while tracing is disabled or for work
+// that is not part of a trace.
+class Tracer {
+public:
+    struct Context {
+        uint64_t traceId = 0;
+        uint64_t spanId = 0;
+
+        explicit operator bool() const { return traceId != 0; }
+    };
+
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    // The calling thread's innermost open span, or an empty context
+    static Context Current();
+
+    // From the hex strings Dart sends; empty when tracing is off or id is invalid
+    static Context FromHex(const std::string& traceId, const std::string& parentSpan);
+
+    // "<trace hex>-<span hex>", the X-Vortex-Trace header value
+    static std::string Header(const Context& context);
+
+    static int64_t NowUs();
+
+    // Records a finished span directly, for intervals that are not a scope
+    // (e.g. time spent queued). Returns its context.
+    static Context Record(const char* category, const std::string& name, const Context& parent,
+                          int64_t startUs, int64_t endUs);
+
+    // A span for the lifetime of the object, nested under parent and made
+    // current on this thread until it ends
+    class Span {
+    public:
+        Span(const char* category, std::string name, const Context& parent = Current());
+        ~Span();
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        const Context& context() const { return context_; }
+
+    private:
+        const char* category_;
+        std::string name_;
+        Context parent_;
+        Context context_;
+        Context previous_;
+        int64_t startUs_ = 0;
+    };
+
+    // Makes context current on this thread for the object's lifetime
+    class Adopt {
+    public:
+        explicit Adopt(const Context& context);
+        ~Adopt();
+        Adopt(const Adopt&) = delete;
+        Adopt& operator=(const Adopt&) = delete;
+
+    private:
+        Context previous_;
+    };
+
+    // The ring as a JSON array of Chrome "complete" events, oldest first
+    static std::string ExportChromeJson();
+    static void Clear();
+
+    // Frees the ring while tracing is off, dropping spans not yet exported;
+    // returns the approximate bytes released
+    static size_t Trim();
+};
+
+#endif  // TRACER_H_
@@ -1,6 +1,8 @@
 #ifndef RUNNER_UTILS_H_
 #define RUNNER_UTILS_H_
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -16,4 +18,14 @@ std::string Utf8FromUtf16(const wchar_t* utf16_string);
 // encoded in UTF-8. Returns an empty std::vector<std::string> on failure.
 std::vector<std::string> GetCommandLineArguments();
 
+// Strips leading and trailing spaces, tabs and line breaks.
+std::string Trim(const std::string& value);
+
+// Percent-encodes everything but RFC 3986 unreserved characters, for
+// controller path segments and query values.
+std::string PercentEncode(const std::string& value);
+
+// Milliseconds on the steady clock since the given point.
+int64_t ElapsedMs(std::chrono::steady_clock::time_point since);
+
 #endif  // RUNNER_UTILS_H_
@@ -0,0 +1,466 @@
+// websocket.cpp - Non-blocking RFC 6455 client connection implementation
+#include "websocket.h"
+
+// winsock2.h must come before anything that pulls in windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <random>
+
+namespace {
+
+constexpr size_t kReadChunk = 16 * 1024;
+constexpr size_t kMaxMessage = 16 * 1024 * 1024;
+constexpr char kAcceptGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+constexpr int kOpContinuation = 0x0;
+constexpr int kOpText = 0x1;
+constexpr int kOpBinary = 0x2;
+constexpr int kOpClose = 0x8;
+constexpr int kOpPing = 0x9;
+constexpr int kOpPong = 0xA;
+
+std::mt19937& Random() {
+    static thread_local std::mt19937 engine(std::random_device{}());
+    return engine;
+}
+
+std::string Base64Encode(const uint8_t* data, size_t size) {
+    static const char kAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < size) chunk |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < size) chunk |= data[i + 2];
+        out.push_back(kAlphabet[(chunk >> 18) & 63]);
+        out.push_back(kAlphabet[(chunk >> 12) & 63]);
+        out.push_back(i + 1 < size ? kAlphabet[(chunk >> 6) & 63] : '=');
+        out.push_back(i + 2 < size ? kAlphabet[chunk & 63] : '=');
+    }
+    return out;
+}
+
+// SHA-1 is only needed for the Sec-WebSocket-Accept check
+void Sha1(const std::string& input, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::string message = input;
+    uint64_t bitLength = static_cast<uint64_t>(input.size()) * 8;
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56) message.push_back('\0');
+    for (int i = 7; i >= 0; i--) message.push_back(static_cast<char>(bitLength >> (i * 8)));
+
+    auto rotl = [](uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); };
+
+    for (size_t offset = 0; offset < message.size(); offset += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const auto* p = reinterpret_cast<const uint8_t*>(message.data() + offset + i * 4);
+            w[i] = (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rotl(b, 30); b = a; a = temp;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+    }
+}
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return value;
+}
+
+// Value of a response header, matched case-insensitively; empty if absent
+std::string HeaderValue(const std::string& headers, const std::string& name) {
+    std::string lowered = Lower(headers);
+    std::string needle = "\r\n" + Lower(name) + ":";
+    size_t at = lowered.find(needle);
+    if (at == std::string::npos) return "";
+    size_t start = headers.find_first_not_of(" \t", at + needle.size());
+    size_t end = headers.find("\r\n", start);
+    if (start == std::string::npos || end == std::string::npos || end < start) return "";
+    return headers.substr(start, end - start);
+}
+
+}  // namespace
+
+WebSocketConnection::~WebSocketConnection() {
+    Close();
+}
+
+bool WebSocketConnection::Connect(const std::string& host, int port, const std::string& path,
+                                  const std::string& token, bool offerDeflate, void* event) {
+    Close();
+
+    host_ = host;
+    port_ = port;
+    path_ = path.empty() ? "/" : path;
+    token_ = token;
+    offerDeflate_ = offerDeflate;
+    deflate_ = false;
+    event_ = event;
+    error_.clear();
+    stats_ = Stats();
+    rxUsed_ = 0;
+    tx_.clear();
+    fragments_.clear();
+    fragmenting_ = false;
+    fragmentCompressed_ = false;
+    peerClosed_ = false;
+    inflater_.Reset();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* address = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &address) != 0 || !address) {
+        return Fail("resolve failed");
+    }
+
+    SOCKET sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (sock == INVALID_SOCKET) {
+        freeaddrinfo(address);
+        return Fail("socket failed");
+    }
+    socket_ = static_cast<uintptr_t>(sock);
+
+    BOOL noDelay = TRUE;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+    // Registering the event also makes the socket non-blocking
+    if (WSAEventSelect(sock, static_cast<WSAEVENT>(event_), FD_CONNECT | FD_READ | FD_WRITE | FD_CLOSE) != 0) {
+        freeaddrinfo(address);
+        return Fail("event select failed");
+    }
+
+    int result = connect(sock, address->ai_addr, static_cast<int>(address->ai_addrlen));
+    freeaddrinfo(address);
+    if (result != 0 && WSAGetLastError() != WSAEWOULDBLOCK) {
+        return Fail("connect failed");
+    }
+
+    state_ = State::Connecting;
+    return true;
+}
+
+bool WebSocketConnection::Process(const MessageHandler& handler, bool readAllowed) {
+    if (state_ == State::Closed) return false;
+
+    SOCKET sock = static_cast<SOCKET>(socket_);
+    WSANETWORKEVENTS events = {};
+    if (WSAEnumNetworkEvents(sock, static_cast<WSAEVENT>(event_), &events) != 0) {
+        return Fail("enum events failed");
+    }
+
+    if (events.lNetworkEvents & FD_CONNECT) {
+        if (events.iErrorCode[FD_CONNECT_BIT] != 0) {
+            return Fail("connect failed (" + std::to_string(events.iErrorCode[FD_CONNECT_BIT]) + ")");
+        }
+
+        uint8_t nonce[16];
+        for (auto& byte : nonce) byte = static_cast<uint8_t>(Random()() & 0xff);
+        key_ = Base64Encode(nonce, sizeof(nonce));
+
+        std::string request = "GET " + path_ + " HTTP/1.1\r\n";
+        request += "Host: " + host_ + ":" + std::to_string(port_) + "\r\n";
+        request += "Upgrade: websocket\r\n";
+        request += "Connection: Upgrade\r\n";
+        request += "Sec-WebSocket-Key: " + key_ + "\r\n";
+        request += "Sec-WebSocket-Version: 13\r\n";
+        if (offerDeflate_) {
+            request += "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n";
+        }
+        if (!token_.empty()) {
+            request += "Authorization: Bearer " + token_ + "\r\n";
+        }
+        request += "\r\n";
+
+        tx_ += request;
+        state_ = State::Handshaking;
+    }
+
+    if (!Flush()) return false;
+
+    if ((events.lNetworkEvents & FD_READ) && readAllowed) {
+        if (!Read(handler)) return false;
+    }
+
+    if (events.lNetworkEvents & FD_CLOSE) {
+        // Drain what the server sent before closing
+        if (readAllowed && !Read(handler)) return false;
+        peerClosed_ = true;
+        return Fail("closed by server");
+    }
+    return state_ != State::Closed;
+}
+
+bool WebSocketConnection::Resume(const MessageHandler& handler) {
+    if (state_ == State::Closed) return false;
+    return Read(handler);
+}
+
+bool WebSocketConnection::Read(const MessageHandler& handler) {
+    SOCKET sock = static_cast<SOCKET>(socket_);
+
+    // Bytes left over from a paused parse come first
+    bool paused = false;
+    if (state_ == State::Open && rxUsed_ > 0) {
+        if (!ParseFrames(handler, &paused)) return false;
+        if (paused) return true;
+    }
+
+    while (true) {
+        if (rx_.size() - rxUsed_ < kReadChunk) {
+            rx_.resize(rxUsed_ + kReadChunk);
+        }
+        int received = recv(sock, rx_.data() + rxUsed_, static_cast<int>(rx_.size() - rxUsed_), 0);
+        if (received == 0) {
+            peerClosed_ = true;
+            return Fail("closed by server");
+        }
+        if (received < 0) {
+            if (WSAGetLastError() == WSAEWOULDBLOCK) return true;
+            return Fail("recv failed (" + std::to_string(WSAGetLastError()) + ")");
+        }
+
+        rxUsed_ += static_cast<size_t>(received);
+        stats_.wireBytes += received;
+
+        if (state_ == State::Handshaking) {
+            if (!ParseHandshake()) return false;
+            if (state_ != State::Open) continue;
+        }
+        if (!ParseFrames(handler, &paused)) return false;
+        if (paused) return true;
+    }
+}
+
+bool WebSocketConnection::ParseHandshake() {
+    std::string head(rx_.data(), rxUsed_);
+    size_t end = head.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (rxUsed_ > 16 * 1024) return Fail("handshake too large");
+        return true;
+    }
+    std::string headers = head.substr(0, end + 2);
+
+    if (headers.compare(0, 12, "HTTP/1.1 101") != 0) {
+        size_t lineEnd = headers.find("\r\n");
+        return Fail("upgrade refused: " + headers.substr(0, lineEnd));
+    }
+
+    uint8_t digest[20];
+    Sha1(key_ + kAcceptGuid, digest);
+    if (HeaderValue(headers, "Sec-WebSocket-Accept") != Base64Encode(digest, sizeof(digest))) {
+        return Fail("bad Sec-WebSocket-Accept");
+    }
+
+    std::string extensions = Lower(HeaderValue(headers, "Sec-WebSocket-Extensions"));
+    if (extensions.find("permessage-deflate") != std::string::npos) {
+        if (!offerDeflate_) return Fail("unrequested extension");
+        deflate_ = true;
+        inflater_.SetKeepWindow(extensions.find("server_no_context_takeover") == std::string::npos);
+    }
+
+    // Frames may have arrived with the response
+    size_t consumed = end + 4;
+    memmove(rx_.data(), rx_.data() + consumed, rxUsed_ - consumed);
+    rxUsed_ -= consumed;
+    state_ = State::Open;
+    return true;
+}
+
+bool WebSocketConnection::ParseFrames(const MessageHandler& handler, bool* paused) {
+    const auto* buffer = reinterpret_cast<const uint8_t*>(rx_.data());
+    size_t offset = 0;
+
+    while (!*paused) {
+        size_t available = rxUsed_ - offset;
+        if (available < 2) break;
+
+        const uint8_t* frame = buffer + offset;
+        bool fin = (frame[0] & 0x80) != 0;
+        bool rsv1 = (frame[0] & 0x40) != 0;
+        int opcode = frame[0] & 0x0F;
+        if (frame[1] & 0x80) return Fail("masked server frame");
+
+        size_t header = 2;
+        uint64_t length = frame[1] & 0x7F;
+        if (length == 126) {
+            if (available < 4) break;
+            length = (static_cast<uint64_t>(frame[2]) << 8) | frame[3];
+            header = 4;
+        } else if (length == 127) {
+            if (available < 10) break;
+            length = 0;
+            for (int i = 0; i < 8; i++) length = (length << 8) | frame[2 + i];
+            header = 10;
+        }
+        if (length > kMaxMessage) return Fail("frame too large");
+        if (available < header + length) break;
+
+        const char* payload = reinterpret_cast<const char*>(frame + header);
+        size_t size = static_cast<size_t>(length);
+        offset += header + size;
+
+        switch (opcode) {
+            case kOpText:
+            case kOpBinary:
+                if (rsv1 && !deflate_) return Fail("unexpected RSV1");
+                if (fragmenting_) return Fail("interleaved message");
+                if (fin) {
+                    if (!Deliver(payload, size, rsv1, handler, paused)) return false;
+                } else {
+                    fragments_.assign(payload, size);
+                    fragmentCompressed_ = rsv1;
+                    fragmenting_ = true;
+                }
+                break;
+            case kOpContinuation:
+                if (!fragmenting_) return Fail("unexpected continuation");
+                if (fragments_.size() + size > kMaxMessage) return Fail("message too large");
+                fragments_.append(payload, size);
+                if (fin) {
+                    std::string message;
+                    message.swap(fragments_);
+                    bool compressed = fragmentCompressed_;
+                    fragmenting_ = false;
+                    fragmentCompressed_ = false;
+                    if (!Deliver(message.data(), message.size(), compressed, handler, paused)) return false;
+                }
+                break;
+            case kOpPing:
+                if (!SendFrame(kOpPong, payload, size)) return false;
+                break;
+            case kOpPong:
+                break;
+            case kOpClose:
+                // Echo the status code, then the server closes the TCP side
+                peerClosed_ = true;
+                SendFrame(kOpClose, payload, std::min<size_t>(size, 2));
+                return Fail("closed by server");
+            default:
+                return Fail("unknown opcode " + std::to_string(opcode));
+        }
+    }
+
+    // Keep only the incomplete tail
+    if (offset > 0) {
+        memmove(rx_.data(), rx_.data() + offset, rxUsed_ - offset);
+        rxUsed_ -= offset;
+    }
+    return true;
+}
+
+bool WebSocketConnection::Deliver(const char* data, size_t size, bool compressed,
+                                  const MessageHandler& handler, bool* paused) {
+    if (compressed) {
+        inflated_.clear();
+        if (!inflater_.Inflate(reinterpret_cast<const uint8_t*>(data), size, true, &inflated_)) {
+            return Fail("inflate failed");
+        }
+        data = inflated_.data();
+        size = inflated_.size();
+    }
+
+    stats_.messages++;
+    stats_.messageBytes += static_cast<int64_t>(size);
+    if (handler && !handler(data, size)) {
+        *paused = true;
+    }
+    return true;
+}
+
+bool WebSocketConnection::SendFrame(int opcode, const char* payload, size_t size) {
+    QueueFrame(opcode, payload, size);
+    return Flush();
+}
+
+void WebSocketConnection::QueueFrame(int opcode, const char* payload, size_t size) {
+    // Client frames are always masked
+    uint8_t header[14];
+    size_t length = 0;
+    header[length++] = static_cast<uint8_t>(0x80 | opcode);
+    if (size < 126) {
+        header[length++] = static_cast<uint8_t>(0x80 | size);
+    } else if (size <= 0xFFFF) {
+        header[length++] = 0x80 | 126;
+        header[length++] = static_cast<uint8_t>(size >> 8);
+        header[length++] = static_cast<uint8_t>(size);
+    } else {
+        header[length++] = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) header[length++] = static_cast<uint8_t>(static_cast<uint64_t>(size) >> (i * 8));
+    }
+
+    uint32_t maskValue = Random()();
+    uint8_t mask[4];
+    memcpy(mask, &maskValue, sizeof(mask));
+    memcpy(header + length, mask, sizeof(mask));
+    length += sizeof(mask);
+
+    tx_.append(reinterpret_cast<const char*>(header), length);
+    for (size_t i = 0; i < size; i++) {
+        tx_.push_back(static_cast<char>(payload[i] ^ mask[i & 3]));
+    }
+}
+
+bool WebSocketConnection::Flush() {
+    SOCKET sock = static_cast<SOCKET>(socket_);
+    while (!tx_.empty() && state_ != State::Connecting && state_ != State::Closed) {
+        int sent = send(sock, tx_.data(), static_cast<int>(tx_.size()), 0);
+        if (sent < 0) {
+            // FD_WRITE fires again once the socket drains
+            if (WSAGetLastError() == WSAEWOULDBLOCK) return true;
+            return Fail("send failed (" + std::to_string(WSAGetLastError()) + ")");
+        }
+        tx_.erase(0, static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+void WebSocketConnection::Close() {
+    if (socket_ != ~static_cast<uintptr_t>(0)) {
+        SOCKET sock = static_cast<SOCKET>(socket_);
+        if (state_ == State::Open && !peerClosed_) {
+            // Best effort, a failure here changes nothing
+            const char goingAway[2] = {static_cast<char>(0x03), static_cast<char>(0xE9)};  // 1001
+            tx_.clear();
+            QueueFrame(kOpClose, goingAway, sizeof(goingAway));
+            send(sock, tx_.data(), static_cast<int>(tx_.size()), 0);
+        }
+        tx_.clear();
+        if (event_) WSAEventSelect(sock, static_cast<WSAEVENT>(event_), 0);
+        closesocket(sock);
+        socket_ = ~static_cast<uintptr_t>(0);
+    }
+    state_ = State::Closed;
+}
+
+bool WebSocketConnection::Fail(const std::string& reason) {
+    if (error_.empty()) error_ = reason;
+    Close();
+    return false;
+}
@@ -0,0 +1,96 @@
+// websocket.h - Non-blocking RFC 6455 client connection for Windows
+#ifndef WEBSOCKET_H_
+#define WEBSOCKET_H_
+
+#include "raw_inflate.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One client connection, driven by an external event loop: Connect() binds
+// the socket to a WSA event and Process() handles whatever that event
+// signalled. Frames are parsed in place in the receive buffer; a complete
+// unfragmented message is handed to the handler without copying, and
+// compressed messages (permessage-deflate, RSV1) are inflated once into a
+// reused buffer. This header deliberately avoids winsock2.h so it can be
+// included after windows.h.
+class WebSocketConnection {
+public:
+    enum class State { Closed, Connecting, Handshaking, Open };
+
+    // Data is valid only during the call. Returning false pauses reading:
+    // unread bytes stay in the socket, which pushes back on the server.
+    using MessageHandler = std::function<bool(const char* data, size_t size)>;
+
+    struct Stats {
+        int64_t wireBytes = 0;     // Received from the socket
+        int64_t messageBytes = 0;  // Delivered to the handler, after inflate
+        int64_t messages = 0;
+    };
+
+    WebSocketConnection() = default;
+    ~WebSocketConnection();
+
+    // Starts a non-blocking connect signalling `event` (a WSAEVENT).
+    // `token` is sent as a Bearer Authorization header when not empty.
+    bool Connect(const std::string& host, int port, const std::string& path,
+                 const std::string& token, bool offerDeflate, void* event);
+
+    // Handles the network events signalled on the event. Returns false once
+    // the connection is closed or failed; error() says why.
+    bool Process(const MessageHandler& handler, bool readAllowed);
+
+    // Continues reading after the handler paused it
+    bool Resume(const MessageHandler& handler);
+
+    void Close();
+
+    State state() const { return state_; }
+    bool deflate() const { return deflate_; }
+    const std::string& error() const { return error_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    WebSocketConnection(const WebSocketConnection&) = delete;
+    WebSocketConnection& operator=(const WebSocketConnection&) = delete;
+
+    bool Read(const MessageHandler& handler);
+    bool ParseHandshake();
+    bool ParseFrames(const MessageHandler& handler, bool* paused);
+    bool Deliver(const char* data, size_t size, bool compressed,
+                 const MessageHandler& handler, bool* paused);
+    bool SendFrame(int opcode, const char* payload, size_t size);
+    void QueueFrame(int opcode, const char* payload, size_t size);
+    bool Flush();
+    bool Fail(const std::string& reason);
+
+    uintptr_t socket_ = ~static_cast<uintptr_t>(0);
+    void* event_ = nullptr;
+    State state_ = State::Closed;
+
+    std::string host_;
+    int port_ = 0;
+    std::string path_;
+    std::string token_;
+    std::string key_;
+    bool offerDeflate_ = false;
+    bool deflate_ = false;
+    RawInflater inflater_;
+
+    std::vector<char> rx_;
+    size_t rxUsed_ = 0;
+    std::string tx_;
+    bool peerClosed_ = false;
+
+    std::string fragments_;
+    bool fragmenting_ = false;
+    bool fragmentCompressed_ = false;
+    std::string inflated_;
+
+    std::string error_;
+    Stats stats_;
+};
+
+#endif  // WEBSOCKET_H_
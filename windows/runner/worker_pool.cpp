@@ -0,0 +1,72 @@
+// worker_pool.cpp - Fixed-size worker thread pool implementation
+#include "worker_pool.h"
+#include "idle_budget.h"
+#include "tracer.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t threadCount) : stopping_(false) {
+    if (threadCount == 0) {
+        size_t hardware = std::thread::hardware_concurrency();
+        threadCount = std::min<size_t>(std::max<size_t>(hardware, 2), 8);
+    }
+    threads_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+WorkerPool& WorkerPool::Shared() {
+    static WorkerPool instance;
+    return instance;
+}
+
+void WorkerPool::Submit(Task task) {
+    // Traced work records how long it waited for a worker
+    Tracer::Context trace = Tracer::Current();
+    if (trace) {
+        int64_t queuedUs = Tracer::NowUs();
+        task = [task = std::move(task), trace, queuedUs]() {
+            Tracer::Record("scheduler", "pool queue", trace, queuedUs, Tracer::NowUs());
+            Tracer::Span span("scheduler", "pool task", trace);
+            task();
+        };
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+size_t WorkerPool::Pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void WorkerPool::WorkerLoop() {
+    IdleBudget::TagThread("worker_pool");
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            // Drain queued work before exiting so submitters never hang
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
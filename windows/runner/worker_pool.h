@@ -0,0 +1,43 @@
+// worker_pool.h - Fixed-size worker thread pool for Windows
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small FIFO thread pool for CPU-bound native work (parsing, merging).
+// Blocking network I/O should stay on its own threads so it never starves
+// the pool.
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    // threadCount 0 picks hardware concurrency clamped to [2, 8]
+    explicit WorkerPool(size_t threadCount = 0);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Shared pool used by the runner's native subsystems
+    static WorkerPool& Shared();
+
+    void Submit(Task task);
+
+    size_t Size() const { return threads_.size(); }
+    size_t Pending();
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> threads_;
+    std::deque<Task> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+};
+
+#endif  // WORKER_POOL_H_